@@ -0,0 +1,50 @@
+#pragma once
+#include <QString>
+#include <QJsonObject>
+#include <QVector>
+
+// Headless validation and preprocessing of all OBJ models under a directory tree.
+// Every model runs through the same CGAL stages as the viewer and gets a JSON report,
+// optionally a GPU-ready cache file the viewer loads by mapping it.
+class BatchProcessor {
+public:
+	struct Options {
+		QString inputDir;
+		QString outputDir;
+		bool writeCache = false;
+		int jobs = 0;
+	};
+
+	struct FileReport {
+		QString filePath;
+		QString relativePath;
+		std::uint64_t fileSize = 0;
+		bool valid = false;
+		QString error;
+		std::uint64_t numVertices = 0;
+		std::uint64_t numFaces = 0;
+		std::uint64_t numEdges = 0;
+		// stage name and its duration in seconds, in execution order
+		QVector<QPair<QString, double>> timings;
+		double totalTime = 0.0;
+		std::uint64_t peakRss = 0;
+
+		QJsonObject toJson() const;
+	};
+
+	explicit BatchProcessor(const Options& options);
+
+	// processes the whole tree, returns the process exit code
+	int run();
+
+	inline const QVector<FileReport>& getReports() const { return this->m_reports; }
+
+private:
+	QStringList collectFiles() const;
+	FileReport processFile(const QString& file) const;
+	bool writeReport(const FileReport& report) const;
+	QString outputPath(const QString& relativePath, const QString& suffix) const;
+
+	Options m_options;
+	QVector<FileReport> m_reports;
+};
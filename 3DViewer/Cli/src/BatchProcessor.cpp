@@ -0,0 +1,239 @@
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <cstdio>
+
+#include "BatchProcessor.h"
+#include "CgalApi.h"
+#include "IndexedMesh.h"
+#include "JobSystem.h"
+#include "MeshCache.h"
+#include "MemoryInfo.h"
+
+namespace {
+    constexpr double BYTES_IN_MB = 1024.0 * 1024.0;
+
+    double seconds(const QElapsedTimer& timer)
+    {
+        return static_cast<double>(timer.nsecsElapsed()) / 1000000000.0;
+    }
+}
+
+QJsonObject BatchProcessor::FileReport::toJson() const
+{
+    QJsonObject stages;
+    for (const auto& timing : timings) {
+        stages.insert(timing.first, timing.second);
+    }
+    return QJsonObject{
+        { "file",        filePath },
+        { "fileSize",    static_cast<qint64>(fileSize) },
+        { "valid",       valid },
+        { "error",       error },
+        { "numVertices", static_cast<qint64>(numVertices) },
+        { "numFaces",    static_cast<qint64>(numFaces) },
+        { "numEdges",    static_cast<qint64>(numEdges) },
+        { "timings",     stages },
+        { "totalTime",   totalTime },
+        //process wide, other files processed at the same time contribute to it
+        { "peakRss",     static_cast<qint64>(peakRss) }
+    };
+}
+
+BatchProcessor::BatchProcessor(const Options& options) :
+    m_options(options)
+{
+    if (m_options.outputDir.isEmpty()) {
+        m_options.outputDir = m_options.inputDir;
+    }
+}
+
+int BatchProcessor::run()
+{
+    const QDir input_dir(m_options.inputDir);
+    if (!input_dir.exists()) {
+        qCritical() << "Critical: input directory does not exist " << m_options.inputDir;
+        return 2;
+    }
+    if (!QDir().mkpath(m_options.outputDir)) {
+        qCritical() << "Critical: cannot create output directory " << m_options.outputDir;
+        return 2;
+    }
+    if (m_options.jobs > 0) {
+        JobSystem::configure(static_cast<unsigned int>(m_options.jobs));
+    }
+    auto& scheduler = JobSystem::instance();
+    const auto files = collectFiles();
+    qDebug() << "Message: batch processing of" << files.size() << "files with"
+        << scheduler.getWorkerCount() << "threads";
+
+    QElapsedTimer timer;
+    timer.start();
+    scheduler.resetStats();
+    //one job per file, the normals and soup stages split further into the same pool,
+    //so the workers stay busy at the tail of the batch when only large models are left
+    m_reports.resize(files.size());
+    const auto reports = m_reports.data();
+    std::vector<JobSystem::JobHandle> jobs;
+    jobs.reserve(static_cast<std::size_t>(files.size()));
+    for (int i = 0; i < files.size(); ++i) {
+        jobs.push_back(scheduler.submit([this, &files, reports, i]() { reports[i] = processFile(files[i]); }));
+    }
+    scheduler.wait(jobs);
+    const double elapsed = seconds(timer);
+    const auto scheduler_stats = scheduler.statsReport();
+
+    int num_valid = 0;
+    std::uint64_t total_bytes = 0;
+    QJsonArray failed;
+    for (const auto& report : m_reports) {
+        total_bytes += report.fileSize;
+        if (report.valid) {
+            ++num_valid;
+        }
+        else {
+            failed.append(report.relativePath);
+        }
+    }
+    const double files_per_sec = elapsed > 0.0 ? m_reports.size() / elapsed : 0.0;
+    const double mb_per_sec = elapsed > 0.0 ? total_bytes / BYTES_IN_MB / elapsed : 0.0;
+    const QJsonObject summary{
+        { "files",       m_reports.size() },
+        { "valid",       num_valid },
+        { "failed",      failed },
+        { "totalBytes",  static_cast<qint64>(total_bytes) },
+        { "elapsed",     elapsed },
+        { "filesPerSec", files_per_sec },
+        { "mbPerSec",    mb_per_sec },
+        { "threads",     static_cast<int>(scheduler.getWorkerCount()) },
+        { "scheduler",   scheduler_stats },
+        { "peakRss",     static_cast<qint64>(MEMORY_API::peakRss()) }
+    };
+    QSaveFile summary_file(QDir(m_options.outputDir).filePath("summary.json"));
+    if (!summary_file.open(QIODevice::WriteOnly) ||
+        summary_file.write(QJsonDocument(summary).toJson()) < 0 || !summary_file.commit()) {
+        qCritical() << "Critical: cannot write batch summary to " << m_options.outputDir;
+    }
+    std::printf("%d files (%d valid, %d failed), %.2f MB in %.3f sec: %.2f files/s, %.2f MB/s, peak RSS %.1f MB, worker utilisation %.1f%%\n",
+        static_cast<int>(m_reports.size()), num_valid, static_cast<int>(m_reports.size()) - num_valid,
+        total_bytes / BYTES_IN_MB, elapsed, files_per_sec, mb_per_sec, MEMORY_API::peakRss() / BYTES_IN_MB,
+        scheduler_stats.value("utilisation").toDouble() * 100.0);
+    return failed.isEmpty() ? 0 : 1;
+}
+
+QStringList BatchProcessor::collectFiles() const
+{
+    QStringList files;
+    QDirIterator it(m_options.inputDir, { "*.obj", "*.OBJ" }, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        files.append(it.next());
+    }
+    //biggest first so a large model does not end up alone at the tail of the batch
+    std::sort(files.begin(), files.end(), [](const QString& lhs, const QString& rhs) {
+        return QFileInfo(lhs).size() > QFileInfo(rhs).size();
+    });
+    return files;
+}
+
+BatchProcessor::FileReport BatchProcessor::processFile(const QString& file) const
+{
+    QElapsedTimer total_timer;
+    total_timer.start();
+    const QFileInfo file_info(file);
+    FileReport report;
+    report.filePath = file_info.absoluteFilePath();
+    report.relativePath = QDir(m_options.inputDir).relativeFilePath(file);
+    report.fileSize = static_cast<std::uint64_t>(file_info.size());
+
+    QElapsedTimer timer;
+    const auto stage = [&report, &timer](const QString& name) {
+        report.timings.append({ name, seconds(timer) });
+        timer.restart();
+    };
+    const auto finish = [this, &report, &total_timer]() {
+        report.totalTime = seconds(total_timer);
+        report.peakRss = MEMORY_API::peakRss();
+        writeReport(report);
+        return report;
+    };
+
+    timer.start();
+    auto mesh = CGAL_API::readMeshFromObj(file.toStdString());
+    stage("read");
+    if (nullptr == mesh) {
+        report.error = "cannot read OBJ file";
+        return finish();
+    }
+    const bool valid = CGAL_API::checkConstructedMesh(mesh, file.toStdString());
+    stage("validate");
+    if (!valid) {
+        report.error = "mesh is empty or not valid";
+        return finish();
+    }
+    if (!CGAL_API::triangulateMesh(mesh)) {
+        stage("triangulate");
+        report.error = "triangulation failed";
+        return finish();
+    }
+    stage("triangulate");
+    report.numVertices = mesh->number_of_vertices();
+    report.numFaces = mesh->number_of_faces();
+    report.numEdges = mesh->number_of_edges();
+    const auto normals = CGAL_API::computeVertexNormals(mesh);
+    stage("normals");
+
+    if (m_options.writeCache) {
+        CachedMesh cached;
+        if (!CGAL_API::buildTriangleSoup(mesh, normals, cached.vertices)) {
+            report.error = "cannot allocate the vertex buffer";
+            return finish();
+        }
+        //the surface mesh is not needed anymore, keep the peak memory down
+        mesh.reset();
+        MESH_API::computeBounds(cached.vertices, cached.minBounds, cached.maxBounds);
+        stage("soup");
+        cached.num_vertices = report.numVertices;
+        cached.num_faces = report.numFaces;
+        cached.num_edges = report.numEdges;
+        cached.sourcePath = report.filePath;
+        cached.sourceSize = report.fileSize;
+        cached.sourceModified = file_info.lastModified().toMSecsSinceEpoch();
+        const auto cache_path = outputPath(report.relativePath, CACHE_API::FILE_SUFFIX);
+        const bool written = QDir().mkpath(QFileInfo(cache_path).absolutePath()) &&
+            CACHE_API::writeMeshCache(cache_path, cached);
+        stage("cache");
+        if (!written) {
+            report.error = "cannot write cache file";
+            return finish();
+        }
+    }
+    report.valid = true;
+    return finish();
+}
+
+bool BatchProcessor::writeReport(const FileReport& report) const
+{
+    const auto path = outputPath(report.relativePath, "json");
+    QSaveFile file(path);
+    if (!QDir().mkpath(QFileInfo(path).absolutePath()) || !file.open(QIODevice::WriteOnly) ||
+        file.write(QJsonDocument(report.toJson()).toJson()) < 0 || !file.commit()) {
+        qCritical() << "Critical: cannot write report " << path;
+        return false;
+    }
+    return true;
+}
+
+QString BatchProcessor::outputPath(const QString& relativePath, const QString& suffix) const
+{
+    //model.obj -> model.json / model.3dvc, mirroring the input tree
+    const QFileInfo relative(relativePath);
+    const auto dir = relative.path() == "." ? QString() : relative.path() + "/";
+    return QDir(m_options.outputDir).filePath(dir + relative.completeBaseName() + "." + suffix);
+}
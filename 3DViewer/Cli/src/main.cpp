@@ -0,0 +1,79 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+
+#include <cstdio>
+
+#include "BatchProcessor.h"
+#include "SessionRecording.h"
+
+namespace {
+    void printSummary(const char* name, const RECORDING_API::Summary& summary)
+    {
+        std::printf("%-9s %6d frames: median %.3f ms, mean %.3f ms, stddev %.3f ms, 95%% %.3f ms, 99%% %.3f ms, max %.3f ms\n",
+            name, static_cast<int>(summary.count), summary.median, summary.mean, summary.stddev, summary.p95, summary.p99, summary.max);
+    }
+
+    // frame timings of two replays of the same session by the same renderer at the same size, fails
+    // when the candidate is significantly slower by more than the margin, returns the process exit code
+    int compareTimings(const QString& baselinePath, const QString& candidatePath, double margin)
+    {
+        const auto baseline = RECORDING_API::readTimings(baselinePath);
+        const auto candidate = RECORDING_API::readTimings(candidatePath);
+        if (nullptr == baseline || nullptr == candidate) {
+            return 2;
+        }
+        //a difference in the work drawn would read as a change of the build
+        QString reason;
+        if (!RECORDING_API::isComparable(*baseline, *candidate, reason)) {
+            std::fprintf(stderr, "cannot compare: %s\n", qPrintable(reason));
+            return 2;
+        }
+        std::printf("%s renderer, %dx%d\n", qPrintable(baseline->renderer), baseline->width, baseline->height);
+        const auto comparison = RECORDING_API::compare(baseline->frames, candidate->frames);
+        printSummary("baseline", comparison.baseline);
+        printSummary("candidate", comparison.candidate);
+        const bool slower = comparison.isSignificant() && comparison.medianChange > margin;
+        const bool faster = comparison.isSignificant() && comparison.medianChange < -margin;
+        std::printf("median %+.1f%%, mean %+.1f%%, %s z = %.2f, p = %.4f: %s\n",
+            comparison.medianChange * 100.0, comparison.meanChange * 100.0,
+            comparison.paired ? "signed rank" : "rank sum", comparison.z, comparison.pValue,
+            slower ? "SLOWER" : faster ? "FASTER" : "no significant change");
+        return slower ? 1 : 0;
+    }
+}
+
+int main(int argc, char *argv[]) {
+
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("3DViewer_cli");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Validates and preprocesses all OBJ models under a directory.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("input", "Directory scanned recursively for OBJ files.");
+    QCommandLineOption output_option({ "o", "output" }, "Directory for the reports and cache files, input by default.", "dir");
+    QCommandLineOption cache_option("cache", "Write GPU-ready .3dvc cache files the viewer loads directly.");
+    QCommandLineOption jobs_option({ "j", "jobs" }, "Number of worker threads, all cores by default.", "count");
+    QCommandLineOption compare_option("compare", "Compares the frame timings of a replayed session with the baseline ones "
+        "instead, input is then the timings file of the candidate.", "baseline");
+    QCommandLineOption margin_option("margin", "Slowdown of the median frame tolerated by --compare, 0.05 by default.", "fraction", "0.05");
+    parser.addOptions({ output_option, cache_option, jobs_option, compare_option, margin_option });
+    parser.process(app);
+
+    const auto positional = parser.positionalArguments();
+    if (positional.size() != 1) {
+        std::fputs(qPrintable(parser.helpText()), stderr);
+        return 2;
+    }
+    if (parser.isSet(compare_option)) {
+        return compareTimings(parser.value(compare_option), positional.first(), parser.value(margin_option).toDouble());
+    }
+    BatchProcessor::Options options;
+    options.inputDir = positional.first();
+    options.outputDir = parser.value(output_option);
+    options.writeCache = parser.isSet(cache_option);
+    options.jobs = parser.value(jobs_option).toInt();
+
+    BatchProcessor processor(options);
+    return processor.run();
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include <QJsonObject>
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing scheduler shared by loading, geometry processing and background tasks.
+// Every worker owns a deque per priority: it pushes and pops its own jobs at the back,
+// idle workers steal the oldest ones from the front. Higher priorities are always looked
+// for first, in all the deques, so a background task never delays a pick or a visible load.
+// Jobs can depend on other jobs and are skipped once their cancellation token is cancelled.
+// Jobs submitted by a running job belong to its family; a worker waiting for a job only helps
+// with the jobs of that family, so an unrelated load never runs on the stack of a waiting one.
+class JobSystem {
+public:
+	enum class Priority {
+		INTERACTIVE,
+		LOAD,
+		BACKGROUND
+	};
+	static constexpr int PRIORITY_COUNT = 3;
+
+	// shared flag checked before a job starts and polled by long running jobs
+	class CancellationToken {
+	public:
+		CancellationToken() : m_cancelled(std::make_shared<std::atomic<bool>>(false)) {}
+		inline void cancel() const { m_cancelled->store(true); }
+		inline bool isCancelled() const { return m_cancelled->load(std::memory_order_relaxed); }
+	private:
+		std::shared_ptr<std::atomic<bool>> m_cancelled;
+	};
+
+	class Job {
+	public:
+		inline bool isFinished()  const { return this->m_finished.load(); }
+		inline bool wasCancelled() const { return this->m_cancelled; }
+		// what the function threw, null when it returned, read once the job finished
+		inline std::exception_ptr getException() const { return this->m_exception; }
+	private:
+		friend class JobSystem;
+		std::function<void()> m_function;
+		Priority m_priority = Priority::LOAD;
+		// shared with the jobs it submits while running, unique for jobs submitted from outside
+		std::uint64_t m_family = 0;
+		CancellationToken m_token;
+		std::atomic<int> m_pendingDependencies{ 1 };
+		std::atomic<bool> m_finished{ false };
+		bool m_cancelled = false;
+		std::exception_ptr m_exception;
+		std::mutex m_mutex;
+		std::condition_variable m_finishedCondition;
+		std::vector<std::shared_ptr<Job>> m_continuations;
+	};
+	using JobHandle = std::shared_ptr<Job>;
+
+	struct WorkerStats {
+		std::uint64_t executed = 0;
+		std::uint64_t stolen = 0;
+		double busySeconds = 0.0;
+		// busy time over the time since the last reset
+		double utilisation = 0.0;
+	};
+
+	// process wide scheduler, created on first use
+	static JobSystem& instance();
+	// worker count of the instance, must be called before the first instance() call, 0 means all cores
+	static void configure(unsigned int workers);
+
+	explicit JobSystem(unsigned int workers);
+	~JobSystem();
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// the job runs once all the dependencies finished, cancelled or not
+	JobHandle submit(std::function<void()> function, Priority priority = Priority::LOAD,
+		const std::vector<JobHandle>& dependencies = {}, const CancellationToken& token = CancellationToken());
+	// workers waiting for a job execute the queued jobs of its family in the meantime
+	void wait(const JobHandle& job);
+	void wait(const std::vector<JobHandle>& jobs);
+	// calls func(begin, end) for the [0, count) subranges of at most grain elements,
+	// with the priority and the cancellation token of the calling job, returns when all of them are done;
+	// the first exception thrown by a subrange is rethrown then
+	void parallelFor(std::uint64_t count, std::uint64_t grain, const std::function<void(std::uint64_t, std::uint64_t)>& func);
+	// polled by long running jobs, false outside of a job
+	static bool cancellationRequested();
+
+	inline unsigned int getWorkerCount() const { return static_cast<unsigned int>(this->m_workers.size()); }
+	std::vector<WorkerStats> getWorkerStats() const;
+	void resetStats();
+	QJsonObject statsReport() const;
+
+private:
+	struct WorkQueue {
+		std::mutex mutex;
+		std::deque<JobHandle> jobs;
+	};
+	struct Worker {
+		std::thread thread;
+		std::array<WorkQueue, PRIORITY_COUNT> queues;
+		std::atomic<std::uint64_t> executed{ 0 };
+		std::atomic<std::uint64_t> stolen{ 0 };
+		std::atomic<std::uint64_t> busyNanoseconds{ 0 };
+		// spent by jobs waiting for other jobs with nothing to help with
+		std::atomic<std::uint64_t> waitingNanoseconds{ 0 };
+	};
+
+	void workerLoop(int index);
+	void schedule(const JobHandle& job);
+	// family 0 takes any job
+	JobHandle findJob(int workerIndex, std::uint64_t family = 0);
+	void execute(const JobHandle& job, int workerIndex);
+	void finish(const JobHandle& job);
+	int currentWorkerIndex() const;
+
+	std::vector<std::unique_ptr<Worker>> m_workers;
+	// jobs submitted from threads outside of the pool
+	std::array<WorkQueue, PRIORITY_COUNT> m_injected;
+	std::atomic<std::int64_t> m_queuedJobs{ 0 };
+	std::atomic<bool> m_stopping{ false };
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wakeCondition;
+	std::atomic<std::int64_t> m_statsEpoch;
+	std::atomic<std::uint64_t> m_nextFamily{ 1 };
+
+	inline static unsigned int s_configuredWorkers = 0;
+	inline static thread_local JobSystem* s_currentSystem = nullptr;
+	inline static thread_local int s_currentWorker = -1;
+	inline static thread_local Priority s_currentPriority = Priority::LOAD;
+	inline static thread_local std::uint64_t s_currentFamily = 0;
+	inline static thread_local const CancellationToken* s_currentToken = nullptr;
+};
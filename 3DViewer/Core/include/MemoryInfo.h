@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+// Resident memory of the whole process, 0 when the platform does not report it
+namespace MEMORY_API {
+	std::uint64_t currentRss();
+	std::uint64_t peakRss();
+	// resident memory not backed by a file, mapped files and out-of-core arrays are left out
+	std::uint64_t currentAnonymousRss();
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <QJsonObject>
+#include <QString>
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <mutex>
+
+// Bytes held per object and per category, together with the process-wide totals and peaks.
+// Transient load buffers are reported into the LoadScope of the loading thread, so the
+// peak of a single load is known even though the buffers are gone once the object exists.
+class MemoryTracker {
+public:
+	enum class Category {
+		CPU_GEOMETRY,
+		GPU_BUFFERS,
+		// geometry mapped from workspace and cache files, reclaimable by the OS
+		CACHES,
+		TRANSIENT
+	};
+	static constexpr int CATEGORY_COUNT = 4;
+
+	struct ObjectUsage {
+		QString name;
+		std::array<std::uint64_t, CATEGORY_COUNT> bytes{};
+		// the most transient memory held at once while the object was loading
+		std::uint64_t loadPeak = 0;
+
+		std::uint64_t total() const;
+	};
+
+	// accounts the transient memory of one load on the current thread, scopes can nest
+	class LoadScope {
+	public:
+		LoadScope();
+		~LoadScope();
+		LoadScope(const LoadScope&) = delete;
+		LoadScope& operator=(const LoadScope&) = delete;
+
+		// positive when a buffer is allocated, negative when it is freed, no-op outside of a scope
+		static void add(std::int64_t bytes);
+		// stores the load peak to the object created by this load
+		void attach(unsigned int objId) const;
+
+		inline std::uint64_t getPeak() const { return this->m_peak; }
+
+	private:
+		LoadScope* m_parent;
+		std::uint64_t m_current = 0;
+		std::uint64_t m_peak = 0;
+	};
+
+	static void setObjectBytes(unsigned int objId, const QString& name, Category category, std::uint64_t bytes);
+	static void removeObject(unsigned int objId);
+	// scene-wide derived data of no single object, counted in CACHES, 0 bytes removes the cache
+	static void setCacheBytes(const QString& cache, std::uint64_t bytes);
+	static std::uint64_t getCacheBytes(const QString& cache);
+
+	static ObjectUsage getObjectUsage(unsigned int objId);
+	static std::uint64_t getTotal(Category category);
+	static std::uint64_t getPeak(Category category);
+	static QString categoryName(Category category);
+	static QString formatBytes(std::uint64_t bytes);
+
+	// per object and per category usage, the shared caches, peaks and the process resident memory
+	static QJsonObject report();
+	static QString textReport();
+
+private:
+	static void adjustTotal(Category category, std::int64_t delta);
+
+	inline static std::mutex s_mutex;
+	inline static std::map<unsigned int, ObjectUsage> s_objects;
+	inline static std::map<QString, std::uint64_t> s_caches;
+	inline static std::array<std::uint64_t, CATEGORY_COUNT> s_totals{};
+	inline static std::array<std::uint64_t, CATEGORY_COUNT> s_peaks{};
+	inline static thread_local LoadScope* s_currentScope = nullptr;
+};
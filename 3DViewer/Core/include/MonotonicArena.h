@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+#include "MemoryTracker.h"
+
+// Bump allocator for the temporaries of a single load. The whole capacity is requested once,
+// allocations are never freed one by one and everything is released with the arena.
+// Exceeding the capacity falls back to the heap in geometrically growing blocks.
+class MonotonicArena {
+public:
+	explicit MonotonicArena(std::size_t capacity) :
+		m_capacity(capacity), m_resource(capacity)
+	{
+		MemoryTracker::LoadScope::add(static_cast<std::int64_t>(m_capacity));
+	}
+	~MonotonicArena()
+	{
+		MemoryTracker::LoadScope::add(-static_cast<std::int64_t>(m_capacity));
+	}
+	MonotonicArena(const MonotonicArena&) = delete;
+	MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+	inline std::pmr::memory_resource* resource()		 { return &this->m_resource; }
+	inline std::size_t				  getCapacity() const { return this->m_capacity; }
+
+private:
+	std::size_t m_capacity;
+	std::pmr::monotonic_buffer_resource m_resource;
+};
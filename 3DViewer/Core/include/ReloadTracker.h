@@ -0,0 +1,42 @@
+#pragma once
+#include <QHash>
+
+#include <cstdint>
+#include <vector>
+
+#include "JobSystem.h"
+
+// Latest reload per object. A new reload of an object supersedes the previous one: the previous
+// token is cancelled so its load stops at the next cancellation point, its result is recognised
+// as stale by the generation, and the new job runs after the previous one, so two loads of the
+// same file never hold their memory at the same time.
+class ReloadTracker {
+public:
+	struct Reload {
+		std::uint64_t generation = 0;
+		JobSystem::CancellationToken token;
+		// the job of the superseded reload, the dependency of the new one
+		std::vector<JobSystem::JobHandle> previous;
+	};
+
+	// supersedes the reload of the object in progress
+	Reload begin(unsigned int objId);
+	// the job of the reload begun last
+	void setJob(unsigned int objId, const JobSystem::JobHandle& job);
+	// true when the generation is the latest reload of the object, which is then forgotten
+	bool finish(unsigned int objId, std::uint64_t generation);
+	// the object left the scene, its reload in progress is cancelled
+	void remove(unsigned int objId);
+	void cancelAll();
+
+	inline bool isReloading(unsigned int objId) const { return this->m_reloads.contains(objId); }
+
+private:
+	struct Entry {
+		JobSystem::CancellationToken token;
+		JobSystem::JobHandle job;
+	};
+	QHash<unsigned int, Entry> m_reloads;
+	// kept after a reload finished, so a late result of an older one is still recognised
+	QHash<unsigned int, std::uint64_t> m_generations;
+};
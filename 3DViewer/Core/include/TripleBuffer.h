@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+
+// Hands the latest value of one writer thread over to one reader thread without locks.
+// Each side owns a slot and the third one is exchanged atomically, so publishing never waits
+// for the reader and the reader always takes the newest complete value, skipping older ones.
+template <typename T>
+class TripleBuffer {
+public:
+	TripleBuffer() = default;
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+	// writer side, the slot still holds an older value and is rewritten before publish()
+	inline T& back() { return this->m_slots[this->m_back]; }
+	inline void publish()
+	{
+		m_back = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel) & INDEX;
+	}
+
+	// reader side, true when a newer value was published since the last call
+	inline bool acquire()
+	{
+		if (0 == (m_middle.load(std::memory_order_acquire) & FRESH)) {
+			return false;
+		}
+		m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX;
+		return true;
+	}
+	inline const T& front() const { return this->m_slots[this->m_front]; }
+
+private:
+	static constexpr int INDEX = 3;
+	// set while the middle slot was not taken by the reader yet
+	static constexpr int FRESH = 4;
+
+	T m_slots[3];
+	int m_back = 0;
+	std::atomic<int> m_middle{ 1 };
+	int m_front = 2;
+};
@@ -0,0 +1,352 @@
+#include <QDebug>
+#include <QJsonArray>
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
+#include "JobSystem.h"
+
+namespace {
+    std::int64_t nowNanoseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+JobSystem& JobSystem::instance()
+{
+    static JobSystem system(s_configuredWorkers);
+    return system;
+}
+
+void JobSystem::configure(unsigned int workers)
+{
+    s_configuredWorkers = workers;
+}
+
+JobSystem::JobSystem(unsigned int workers) :
+    m_statsEpoch(nowNanoseconds())
+{
+    if (0 == workers) {
+        workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned int i = 0; i < workers; ++i) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    //all the workers exist before any of them starts stealing
+    for (unsigned int i = 0; i < workers; ++i) {
+        m_workers[i]->thread = std::thread(&JobSystem::workerLoop, this, static_cast<int>(i));
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stopping = true;
+    }
+    m_wakeCondition.notify_all();
+    for (auto& worker : m_workers) {
+        worker->thread.join();
+    }
+}
+
+JobSystem::JobHandle JobSystem::submit(std::function<void()> function, Priority priority,
+    const std::vector<JobHandle>& dependencies, const CancellationToken& token)
+{
+    auto job = std::make_shared<Job>();
+    job->m_function = std::move(function);
+    job->m_priority = priority;
+    job->m_family = (currentWorkerIndex() >= 0 && 0 != s_currentFamily) ? s_currentFamily : m_nextFamily++;
+    job->m_token = token;
+    //the extra count keeps the job from being scheduled while the dependencies are registered
+    job->m_pendingDependencies = static_cast<int>(dependencies.size()) + 1;
+    for (const auto& dependency : dependencies) {
+        std::lock_guard<std::mutex> lock(dependency->m_mutex);
+        if (dependency->m_finished) {
+            --job->m_pendingDependencies;
+        }
+        else {
+            dependency->m_continuations.push_back(job);
+        }
+    }
+    if (0 == --job->m_pendingDependencies) {
+        schedule(job);
+    }
+    return job;
+}
+
+void JobSystem::wait(const JobHandle& job)
+{
+    const int worker_index = currentWorkerIndex();
+    if (worker_index < 0) {
+        std::unique_lock<std::mutex> lock(job->m_mutex);
+        job->m_finishedCondition.wait(lock, [&job]() { return job->m_finished.load(); });
+        return;
+    }
+    //blocking a worker could deadlock the pool, help instead, with the jobs the awaited one is made of
+    auto& worker = *m_workers[worker_index];
+    while (!job->isFinished()) {
+        if (const auto other = findJob(worker_index, job->m_family)) {
+            execute(other, worker_index);
+        }
+        else {
+            const auto idle_start = nowNanoseconds();
+            std::this_thread::yield();
+            //the outer job is accounted as busy, the spinning is not
+            worker.waitingNanoseconds += static_cast<std::uint64_t>(nowNanoseconds() - idle_start);
+        }
+    }
+}
+
+void JobSystem::wait(const std::vector<JobHandle>& jobs)
+{
+    for (const auto& job : jobs) {
+        wait(job);
+    }
+}
+
+void JobSystem::parallelFor(std::uint64_t count, std::uint64_t grain,
+    const std::function<void(std::uint64_t, std::uint64_t)>& func)
+{
+    const auto token = (nullptr != s_currentToken) ? *s_currentToken : CancellationToken();
+    grain = std::max<std::uint64_t>(1, grain);
+    if (count <= grain) {
+        if (count > 0 && !token.isCancelled()) {
+            func(0, count);
+        }
+        return;
+    }
+    std::vector<JobHandle> jobs;
+    jobs.reserve(static_cast<std::size_t>((count + grain - 1) / grain));
+    //the calling thread takes the first range itself
+    for (std::uint64_t begin = grain; begin < count; begin += grain) {
+        const auto end = std::min(count, begin + grain);
+        jobs.push_back(submit([&func, begin, end]() { func(begin, end); }, s_currentPriority, {}, token));
+    }
+    //the other ranges refer to func, they finish before an exception leaves the call
+    try {
+        if (!token.isCancelled()) {
+            func(0, grain);
+        }
+    }
+    catch (...) {
+        wait(jobs);
+        throw;
+    }
+    wait(jobs);
+    //a range that failed leaves the output incomplete, the caller must not take it for done
+    for (const auto& job : jobs) {
+        if (nullptr != job->m_exception) {
+            std::rethrow_exception(job->m_exception);
+        }
+    }
+}
+
+bool JobSystem::cancellationRequested()
+{
+    return nullptr != s_currentToken && s_currentToken->isCancelled();
+}
+
+std::vector<JobSystem::WorkerStats> JobSystem::getWorkerStats() const
+{
+    const double elapsed = static_cast<double>(nowNanoseconds() - m_statsEpoch.load()) / 1000000000.0;
+    std::vector<WorkerStats> stats;
+    for (const auto& worker : m_workers) {
+        WorkerStats worker_stats;
+        worker_stats.executed = worker->executed.load();
+        worker_stats.stolen = worker->stolen.load();
+        const auto busy = worker->busyNanoseconds.load();
+        const auto waiting = std::min(busy, worker->waitingNanoseconds.load());
+        worker_stats.busySeconds = static_cast<double>(busy - waiting) / 1000000000.0;
+        worker_stats.utilisation = elapsed > 0.0 ? std::min(1.0, worker_stats.busySeconds / elapsed) : 0.0;
+        stats.push_back(worker_stats);
+    }
+    return stats;
+}
+
+void JobSystem::resetStats()
+{
+    for (auto& worker : m_workers) {
+        worker->executed = 0;
+        worker->stolen = 0;
+        worker->busyNanoseconds = 0;
+        worker->waitingNanoseconds = 0;
+    }
+    m_statsEpoch = nowNanoseconds();
+}
+
+QJsonObject JobSystem::statsReport() const
+{
+    QJsonArray workers;
+    double utilisation = 0.0;
+    for (const auto& stats : getWorkerStats()) {
+        workers.append(QJsonObject{
+            { "executed",    static_cast<qint64>(stats.executed) },
+            { "stolen",      static_cast<qint64>(stats.stolen) },
+            { "busySeconds", stats.busySeconds },
+            { "utilisation", stats.utilisation }
+        });
+        utilisation += stats.utilisation;
+    }
+    return QJsonObject{
+        { "workers",     workers },
+        { "utilisation", m_workers.empty() ? 0.0 : utilisation / m_workers.size() },
+        { "queued",      static_cast<qint64>(m_queuedJobs.load()) }
+    };
+}
+
+void JobSystem::workerLoop(int index)
+{
+    s_currentSystem = this;
+    s_currentWorker = index;
+    while (true) {
+        if (const auto job = findJob(index)) {
+            const auto start = nowNanoseconds();
+            execute(job, index);
+            m_workers[index]->busyNanoseconds += static_cast<std::uint64_t>(nowNanoseconds() - start);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wakeCondition.wait(lock, [this]() { return m_stopping || m_queuedJobs > 0; });
+        if (m_stopping) {
+            return;
+        }
+    }
+}
+
+void JobSystem::schedule(const JobHandle& job)
+{
+    const int worker_index = currentWorkerIndex();
+    auto& queue = (worker_index >= 0) ?
+        m_workers[worker_index]->queues[static_cast<int>(job->m_priority)] :
+        m_injected[static_cast<int>(job->m_priority)];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(job);
+    }
+    {
+        //under the sleep mutex so a worker going to sleep cannot miss it
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        ++m_queuedJobs;
+    }
+    m_wakeCondition.notify_one();
+}
+
+JobSystem::JobHandle JobSystem::findJob(int workerIndex, std::uint64_t family)
+{
+    const auto take = [this, family](WorkQueue& queue, bool back) -> JobHandle {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty()) {
+            return nullptr;
+        }
+        JobHandle job;
+        if (0 == family) {
+            if (back) {
+                job = std::move(queue.jobs.back());
+                queue.jobs.pop_back();
+            }
+            else {
+                job = std::move(queue.jobs.front());
+                queue.jobs.pop_front();
+            }
+        }
+        else {
+            const auto matches = [family](const JobHandle& queued) { return family == queued->m_family; };
+            if (back) {
+                const auto found = std::find_if(queue.jobs.rbegin(), queue.jobs.rend(), matches);
+                if (queue.jobs.rend() == found) {
+                    return nullptr;
+                }
+                job = std::move(*found);
+                queue.jobs.erase(std::next(found).base());
+            }
+            else {
+                const auto found = std::find_if(queue.jobs.begin(), queue.jobs.end(), matches);
+                if (queue.jobs.end() == found) {
+                    return nullptr;
+                }
+                job = std::move(*found);
+                queue.jobs.erase(found);
+            }
+        }
+        --m_queuedJobs;
+        return job;
+    };
+    const int num_workers = static_cast<int>(m_workers.size());
+    for (int priority = 0; priority < PRIORITY_COUNT; ++priority) {
+        //own newest job first, it is the most likely to be in cache
+        if (auto job = take(m_workers[workerIndex]->queues[priority], true)) {
+            return job;
+        }
+        if (auto job = take(m_injected[priority], false)) {
+            return job;
+        }
+        for (int offset = 1; offset < num_workers; ++offset) {
+            const int victim = (workerIndex + offset) % num_workers;
+            if (auto job = take(m_workers[victim]->queues[priority], false)) {
+                ++m_workers[workerIndex]->stolen;
+                return job;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void JobSystem::execute(const JobHandle& job, int workerIndex)
+{
+    if (job->m_token.isCancelled()) {
+        job->m_cancelled = true;
+    }
+    else {
+        const auto previous_priority = s_currentPriority;
+        const auto previous_family = s_currentFamily;
+        const auto previous_token = s_currentToken;
+        s_currentPriority = job->m_priority;
+        s_currentFamily = job->m_family;
+        s_currentToken = &job->m_token;
+        //kept for parallelFor, which rethrows it to its caller, nothing may leave the worker
+        try {
+            job->m_function();
+        }
+        catch (const std::exception& exp)
+        {
+            qCritical() << "Critical: job failed: " << exp.what();
+            job->m_exception = std::current_exception();
+        }
+        catch (...)
+        {
+            qCritical() << "Critical: job failed with an unknown exception.";
+            job->m_exception = std::current_exception();
+        }
+        s_currentPriority = previous_priority;
+        s_currentFamily = previous_family;
+        s_currentToken = previous_token;
+        ++m_workers[workerIndex]->executed;
+    }
+    finish(job);
+}
+
+void JobSystem::finish(const JobHandle& job)
+{
+    std::vector<JobHandle> continuations;
+    {
+        std::lock_guard<std::mutex> lock(job->m_mutex);
+        job->m_function = nullptr;
+        job->m_finished = true;
+        continuations.swap(job->m_continuations);
+    }
+    job->m_finishedCondition.notify_all();
+    for (const auto& continuation : continuations) {
+        if (0 == --continuation->m_pendingDependencies) {
+            schedule(continuation);
+        }
+    }
+}
+
+int JobSystem::currentWorkerIndex() const
+{
+    return (this == s_currentSystem) ? s_currentWorker : -1;
+}
@@ -0,0 +1,85 @@
+#include <QFile>
+
+#include "MemoryInfo.h"
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_MACOS)
+#include <mach/mach.h>
+#include <sys/resource.h>
+#endif
+
+namespace {
+#if defined(Q_OS_LINUX)
+    //value of a "Key:  1234 kB" line of /proc/self/status
+    std::uint64_t readProcStatus(const QByteArray& key)
+    {
+        QFile status("/proc/self/status");
+        if (!status.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            return 0;
+        }
+        while (!status.atEnd()) {
+            const auto line = status.readLine();
+            if (line.startsWith(key)) {
+                return line.mid(key.size()).simplified().split(' ').first().toULongLong() * 1024;
+            }
+        }
+        return 0;
+    }
+#endif
+}
+
+std::uint64_t MEMORY_API::currentRss()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.WorkingSetSize;
+    }
+    return 0;
+#elif defined(Q_OS_LINUX)
+    return readProcStatus("VmRSS:");
+#elif defined(Q_OS_MACOS)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (KERN_SUCCESS == task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count)) {
+        return info.resident_size;
+    }
+    return 0;
+#else
+    return 0;
+#endif
+}
+
+std::uint64_t MEMORY_API::peakRss()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#elif defined(Q_OS_LINUX)
+    return readProcStatus("VmHWM:");
+#elif defined(Q_OS_MACOS)
+    rusage usage;
+    if (0 == getrusage(RUSAGE_SELF, &usage)) {
+        //bytes on macOS
+        return static_cast<std::uint64_t>(usage.ru_maxrss);
+    }
+    return 0;
+#else
+    return 0;
+#endif
+}
+
+std::uint64_t MEMORY_API::currentAnonymousRss()
+{
+#if defined(Q_OS_LINUX)
+    return readProcStatus("RssAnon:");
+#else
+    //the other platforms report mapped pages in the working set only together with the heap
+    return 0;
+#endif
+}
@@ -0,0 +1,217 @@
+#include <QJsonArray>
+
+#include <algorithm>
+
+#include "MemoryTracker.h"
+#include "MemoryInfo.h"
+
+std::uint64_t MemoryTracker::ObjectUsage::total() const
+{
+    std::uint64_t sum = 0;
+    for (const auto category_bytes : bytes) {
+        sum += category_bytes;
+    }
+    return sum;
+}
+
+MemoryTracker::LoadScope::LoadScope() :
+    m_parent(s_currentScope)
+{
+    s_currentScope = this;
+}
+
+MemoryTracker::LoadScope::~LoadScope()
+{
+    //whatever was not freed explicitly is gone with the load
+    add(-static_cast<std::int64_t>(m_current));
+    s_currentScope = m_parent;
+}
+
+void MemoryTracker::LoadScope::add(std::int64_t bytes)
+{
+    //the parent loads hold the buffers of the nested ones as well
+    for (auto scope = s_currentScope; nullptr != scope; scope = scope->m_parent) {
+        const auto current = static_cast<std::int64_t>(scope->m_current) + bytes;
+        scope->m_current = static_cast<std::uint64_t>(std::max<std::int64_t>(0, current));
+        scope->m_peak = std::max(scope->m_peak, scope->m_current);
+    }
+    if (nullptr != s_currentScope) {
+        adjustTotal(Category::TRANSIENT, bytes);
+    }
+}
+
+void MemoryTracker::LoadScope::attach(unsigned int objId) const
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_objects[objId].loadPeak = m_peak;
+}
+
+void MemoryTracker::setObjectBytes(unsigned int objId, const QString& name, Category category, std::uint64_t bytes)
+{
+    std::int64_t delta = 0;
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        auto& usage = s_objects[objId];
+        if (!name.isEmpty()) {
+            usage.name = name;
+        }
+        auto& current = usage.bytes[static_cast<int>(category)];
+        delta = static_cast<std::int64_t>(bytes) - static_cast<std::int64_t>(current);
+        current = bytes;
+    }
+    adjustTotal(category, delta);
+}
+
+void MemoryTracker::removeObject(unsigned int objId)
+{
+    ObjectUsage usage;
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        const auto it = s_objects.find(objId);
+        if (it == s_objects.end()) {
+            return;
+        }
+        usage = it->second;
+        s_objects.erase(it);
+    }
+    for (int category = 0; category < CATEGORY_COUNT; ++category) {
+        adjustTotal(static_cast<Category>(category), -static_cast<std::int64_t>(usage.bytes[category]));
+    }
+}
+
+void MemoryTracker::setCacheBytes(const QString& cache, std::uint64_t bytes)
+{
+    std::int64_t delta = 0;
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        const auto it = s_caches.find(cache);
+        const std::uint64_t current = it != s_caches.end() ? it->second : 0;
+        delta = static_cast<std::int64_t>(bytes) - static_cast<std::int64_t>(current);
+        if (0 == bytes) {
+            if (it != s_caches.end()) {
+                s_caches.erase(it);
+            }
+        }
+        else {
+            s_caches[cache] = bytes;
+        }
+    }
+    adjustTotal(Category::CACHES, delta);
+}
+
+std::uint64_t MemoryTracker::getCacheBytes(const QString& cache)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    const auto it = s_caches.find(cache);
+    return it != s_caches.end() ? it->second : 0;
+}
+
+MemoryTracker::ObjectUsage MemoryTracker::getObjectUsage(unsigned int objId)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    const auto it = s_objects.find(objId);
+    return it != s_objects.end() ? it->second : ObjectUsage();
+}
+
+std::uint64_t MemoryTracker::getTotal(Category category)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    return s_totals[static_cast<int>(category)];
+}
+
+std::uint64_t MemoryTracker::getPeak(Category category)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    return s_peaks[static_cast<int>(category)];
+}
+
+QString MemoryTracker::categoryName(Category category)
+{
+    switch (category) {
+    case Category::CPU_GEOMETRY: return "cpuGeometry";
+    case Category::GPU_BUFFERS:  return "gpuBuffers";
+    case Category::CACHES:       return "caches";
+    case Category::TRANSIENT:    return "transient";
+    }
+    return "unknown";
+}
+
+QString MemoryTracker::formatBytes(std::uint64_t bytes)
+{
+    if (bytes < 1024ull * 1024ull) {
+        return QString::number(bytes / 1024.0, 'f', 1) + " KB";
+    }
+    if (bytes < 1024ull * 1024ull * 1024ull) {
+        return QString::number(bytes / (1024.0 * 1024.0), 'f', 1) + " MB";
+    }
+    return QString::number(bytes / (1024.0 * 1024.0 * 1024.0), 'f', 2) + " GB";
+}
+
+QJsonObject MemoryTracker::report()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    QJsonArray objects;
+    for (const auto& object : s_objects) {
+        QJsonObject entry{
+            { "id",       static_cast<qint64>(object.first) },
+            { "name",     object.second.name },
+            { "loadPeak", static_cast<qint64>(object.second.loadPeak) },
+            { "total",    static_cast<qint64>(object.second.total()) }
+        };
+        for (int category = 0; category < CATEGORY_COUNT; ++category) {
+            entry.insert(categoryName(static_cast<Category>(category)), static_cast<qint64>(object.second.bytes[category]));
+        }
+        objects.append(entry);
+    }
+    QJsonObject caches;
+    for (const auto& cache : s_caches) {
+        caches.insert(cache.first, static_cast<qint64>(cache.second));
+    }
+    QJsonObject totals, peaks;
+    for (int category = 0; category < CATEGORY_COUNT; ++category) {
+        totals.insert(categoryName(static_cast<Category>(category)), static_cast<qint64>(s_totals[category]));
+        peaks.insert(categoryName(static_cast<Category>(category)), static_cast<qint64>(s_peaks[category]));
+    }
+    return QJsonObject{
+        { "objects",    objects },
+        { "caches",     caches },
+        { "totals",     totals },
+        { "peaks",      peaks },
+        { "currentRss", static_cast<qint64>(MEMORY_API::currentRss()) },
+        { "peakRss",    static_cast<qint64>(MEMORY_API::peakRss()) }
+    };
+}
+
+QString MemoryTracker::textReport()
+{
+    const auto json = report();
+    QString text;
+    for (const auto& value : json["objects"].toArray()) {
+        const auto object = value.toObject();
+        text += QString("%1 (ID %2): CPU %3, GPU %4, cache %5, load peak %6\n").arg(
+            object["name"].toString(), QString::number(object["id"].toInt()),
+            formatBytes(object["cpuGeometry"].toDouble()), formatBytes(object["gpuBuffers"].toDouble()),
+            formatBytes(object["caches"].toDouble()), formatBytes(object["loadPeak"].toDouble()));
+    }
+    const auto caches = json["caches"].toObject();
+    for (auto it = caches.begin(); it != caches.end(); ++it) {
+        text += QString("%1: cache %2\n").arg(it.key(), formatBytes(it.value().toDouble()));
+    }
+    const auto totals = json["totals"].toObject();
+    const auto peaks = json["peaks"].toObject();
+    text += QString("\nTotal: CPU %1, GPU %2, cache %3, transient %4 (peak %5)\n").arg(
+        formatBytes(totals["cpuGeometry"].toDouble()), formatBytes(totals["gpuBuffers"].toDouble()),
+        formatBytes(totals["caches"].toDouble()), formatBytes(totals["transient"].toDouble()),
+        formatBytes(peaks["transient"].toDouble()));
+    text += QString("Process: resident %1, peak resident %2").arg(
+        formatBytes(json["currentRss"].toDouble()), formatBytes(json["peakRss"].toDouble()));
+    return text;
+}
+
+void MemoryTracker::adjustTotal(Category category, std::int64_t delta)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    auto& total = s_totals[static_cast<int>(category)];
+    total = static_cast<std::uint64_t>(std::max<std::int64_t>(0, static_cast<std::int64_t>(total) + delta));
+    s_peaks[static_cast<int>(category)] = std::max(s_peaks[static_cast<int>(category)], total);
+}
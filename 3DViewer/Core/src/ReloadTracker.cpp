@@ -0,0 +1,49 @@
+#include "ReloadTracker.h"
+
+ReloadTracker::Reload ReloadTracker::begin(unsigned int objId)
+{
+    Reload reload;
+    reload.generation = ++m_generations[objId];
+    const auto it = m_reloads.find(objId);
+    if (it != m_reloads.end()) {
+        it->token.cancel();
+        if (nullptr != it->job) {
+            reload.previous.push_back(it->job);
+        }
+    }
+    m_reloads[objId] = Entry{ reload.token, nullptr };
+    return reload;
+}
+
+void ReloadTracker::setJob(unsigned int objId, const JobSystem::JobHandle& job)
+{
+    const auto it = m_reloads.find(objId);
+    if (it != m_reloads.end()) {
+        it->job = job;
+    }
+}
+
+bool ReloadTracker::finish(unsigned int objId, std::uint64_t generation)
+{
+    if (generation != m_generations.value(objId)) {
+        return false;
+    }
+    m_reloads.remove(objId);
+    return true;
+}
+
+void ReloadTracker::remove(unsigned int objId)
+{
+    const auto it = m_reloads.find(objId);
+    if (it != m_reloads.end()) {
+        it->token.cancel();
+        m_reloads.erase(it);
+    }
+}
+
+void ReloadTracker::cancelAll()
+{
+    for (const auto& entry : m_reloads) {
+        entry.token.cancel();
+    }
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+#include <memory>
+
+#include "IndexedMesh.h"
+
+// Importers of the binary formats. The files are memory-mapped and the vertex/index arrays
+// are reinterpreted from the mapping, decoding is split in ranges processed in parallel.
+namespace IMPORT_API {
+   // binary STL, coincident triangle corners are welded into shared vertices
+   std::unique_ptr<IndexedMesh> constructMeshFromStl(const std::string& file_path);
+   // binary little or big endian PLY with a vertex and a face element
+   std::unique_ptr<IndexedMesh> constructMeshFromPly(const std::string& file_path);
+   // glTF 2.0 binary container, all triangle primitives of the default scene in world space
+   std::unique_ptr<IndexedMesh> constructMeshFromGlb(const std::string& file_path);
+}
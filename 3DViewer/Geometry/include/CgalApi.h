@@ -6,12 +6,33 @@
 #include <CGAL/Surface_mesh.h>
 #include <CGAL/IO/OBJ.h>
 
+#include <vector>
+
+#include "CrossSection.h"
+#include "MappedArray.h"
+#include "SurfaceMaterial.h"
+#include "Vertex.h"
+
 typedef CGAL::Simple_cartesian<double> Kernel;
 typedef Kernel::Point_3 Point_3;
 typedef CGAL::Surface_mesh<Point_3> Surface_mesh;
 
 namespace CGAL_API {
-   std::unique_ptr<Surface_mesh> constructMeshFromObj(const std::string& file_path);
+   // read + check + triangulate, texture coordinates and materials go to the attributes when given
+   std::unique_ptr<Surface_mesh> constructMeshFromObj(const std::string& file_path, SurfaceAttributes* attributes = nullptr);
+   // single stages of constructMeshFromObj
+   std::unique_ptr<Surface_mesh> readMeshFromObj(const std::string& file_path, SurfaceAttributes* attributes = nullptr);
+   bool triangulateMesh(const std::unique_ptr<Surface_mesh>& mesh);
    QVector3D computeVertexNormal(const std::unique_ptr<Surface_mesh>& mesh, const CGAL::SM_Vertex_index& vertex);
+   // normals of all the vertices, indexed by the vertex index
+   std::vector<QVector3D> computeVertexNormals(const std::unique_ptr<Surface_mesh>& mesh);
    bool checkConstructedMesh(const std::unique_ptr<Surface_mesh>& mesh, const std::string& filepath);
+   // expands the faces into the triangle soup the renderer draws
+   bool buildTriangleSoup(const std::unique_ptr<Surface_mesh>& mesh, const std::vector<QVector3D>& normals, MappedArray<Vertex>& soup,
+      const SurfaceAttributes* attributes = nullptr);
+   // approximate bytes held by the connectivity, points and the removal flags of the mesh
+   std::uint64_t memoryUsage(const std::unique_ptr<Surface_mesh>& mesh);
+   // fills the cap between the closed contours of the section, nested contours are holes,
+   // false when the calling job was cancelled
+   bool triangulateSectionCap(CrossSection& section);
 }
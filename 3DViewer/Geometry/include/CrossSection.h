@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QVector3D.h>
+
+#include <vector>
+
+#include "MappedArray.h"
+#include "Vertex.h"
+
+// Cut of a triangle soup by the plane dot(normal, p) = offset. The side the normal points to is
+// kept by the clipping, the cap closes the cut and faces the removed side.
+struct CrossSection {
+	struct Contour {
+		// the first point is not repeated at the end of a closed contour
+		std::vector<QVector3D> points;
+		// open contours come from holes in the surface and get no cap
+		bool closed = false;
+	};
+
+	QVector3D normal;
+	float offset = 0.0f;
+	std::vector<Contour> contours;
+	// three corners per triangle
+	std::vector<QVector3D> cap;
+
+	inline bool matches(const QVector3D& normal, float offset) const { return this->normal == normal && this->offset == offset; }
+};
+
+namespace SECTION_API {
+	// plane perpendicular to an object axis at a fraction of its bounds, flipped keeps the lower part
+	void axisPlane(const QVector3D& minBounds, const QVector3D& maxBounds, int axis, float position, bool flipped,
+		QVector3D& normal, float& offset);
+	// crossing segments of all the triangles chained into contours through the edges they share,
+	// false when the calling job was cancelled
+	bool sliceTriangleSoup(const MappedArray<Vertex>& soup, const QVector3D& normal, float offset, CrossSection& section);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QVector3D.h>
+
+#include "MappedArray.h"
+#include "Vertex.h"
+
+// Triangle mesh with shared vertices produced by the importers that bypass CGAL.
+// Every array may be out-of-core, so the mesh size is bounded only by the disk space.
+struct IndexedMesh {
+	MappedArray<QVector3D> positions;
+	MappedArray<QVector3D> normals;
+	// three indices per triangle
+	MappedArray<std::uint32_t> indices;
+
+	std::uint64_t num_vertices = 0;
+	std::uint64_t num_faces = 0;
+	std::uint64_t num_edges = 0;
+
+	inline std::uint64_t numberOfTriangles() const { return this->indices.size() / 3; }
+	inline std::uint64_t sizeInBytes()		 const { return this->positions.sizeInBytes() + this->normals.sizeInBytes() + this->indices.sizeInBytes(); }
+};
+
+namespace MESH_API {
+	// area weighted vertex normals, allocates and fills mesh.normals
+	bool computeVertexNormals(IndexedMesh& mesh);
+	// number of distinct undirected edges, the edges are sorted in passes of bounded memory
+	std::uint64_t countEdges(const IndexedMesh& mesh);
+	// expands the indexed mesh into the triangle soup the renderer draws
+	bool buildTriangleSoup(const IndexedMesh& mesh, MappedArray<Vertex>& soup);
+	void computeBounds(const MappedArray<Vertex>& soup, QVector3D& minBounds, QVector3D& maxBounds);
+	// coarse copy of the soup for interactive drawing: corners are snapped to a uniform grid sized
+	// for about triangleBudget triangles, collapsed and duplicate triangles are dropped
+	bool buildClusteredProxy(const MappedArray<Vertex>& soup, const QVector3D& minBounds, const QVector3D& maxBounds,
+		std::uint64_t triangleBudget, MappedArray<Vertex>& proxy);
+}
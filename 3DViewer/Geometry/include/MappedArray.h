@@ -0,0 +1,147 @@
+#pragma once
+
+#include <QFile>
+#include <QTemporaryFile>
+#include <QDir>
+#include <QDebug>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <type_traits>
+
+// Out-of-core threshold shared by all the element types
+class MappedArrayBase {
+public:
+	static constexpr std::uint64_t DEFAULT_OUT_OF_CORE_THRESHOLD = 256ull * 1024ull * 1024ull;
+
+	inline static void setOutOfCoreThreshold(std::uint64_t bytes) { s_outOfCoreThreshold = bytes; }
+	inline static std::uint64_t outOfCoreThreshold() { return s_outOfCoreThreshold; }
+
+protected:
+	inline static std::uint64_t s_outOfCoreThreshold = DEFAULT_OUT_OF_CORE_THRESHOLD;
+};
+
+// Contiguous array of trivially copyable elements with 64-bit size and indexing.
+// Arrays smaller than the out-of-core threshold live on the heap, bigger ones are spilled
+// to a memory-mapped temporary file, so the OS can page them out instead of growing RSS.
+template <typename T>
+class MappedArray : public MappedArrayBase {
+	static_assert(std::is_trivially_copyable<T>::value, "MappedArray supports only trivially copyable types");
+public:
+	MappedArray() = default;
+	explicit MappedArray(std::vector<T>&& heap) :
+		m_heap(std::move(heap)), m_data(m_heap.data()), m_size(m_heap.size())
+	{
+	}
+	// view of memory mapped from a file, the mapping lives while any view holds the owner
+	MappedArray(std::shared_ptr<QFile> owner, T* data, std::uint64_t count) :
+		m_owner(std::move(owner)), m_data(data), m_size(count)
+	{
+	}
+	~MappedArray() { release(); }
+	MappedArray(const MappedArray&) = delete;
+	MappedArray& operator=(const MappedArray&) = delete;
+	MappedArray(MappedArray&& other) noexcept { *this = std::move(other); }
+	MappedArray& operator=(MappedArray&& other) noexcept;
+
+	// discards the current content and allocates storage for count elements
+	bool allocate(std::uint64_t count);
+	// discards the current content and copies the elements of other, spilled the same way
+	bool copyFrom(const MappedArray& other);
+	// shrinks the logical size without touching the storage
+	inline void truncate(std::uint64_t count) { if (count < m_size) m_size = count; }
+	void release();
+
+	inline T*			 data()						 { return this->m_data; }
+	inline const T*		 data()				   const { return this->m_data; }
+	inline T*			 begin()					 { return this->m_data; }
+	inline T*			 end()						 { return this->m_data + this->m_size; }
+	inline const T*		 begin()			   const { return this->m_data; }
+	inline const T*		 end()				   const { return this->m_data + this->m_size; }
+	inline T&			 operator[](std::uint64_t i)	   { return this->m_data[i]; }
+	inline const T&		 operator[](std::uint64_t i) const { return this->m_data[i]; }
+	inline std::uint64_t size()				   const { return this->m_size; }
+	inline std::uint64_t sizeInBytes()		   const { return this->m_size * sizeof(T); }
+	inline bool			 isEmpty()			   const { return 0 == this->m_size; }
+	inline bool			 isOutOfCore()		   const { return nullptr != this->m_file || nullptr != this->m_owner; }
+	inline bool			 isFileView()		   const { return nullptr != this->m_owner; }
+
+private:
+	std::vector<T> m_heap;
+	std::unique_ptr<QTemporaryFile> m_file;
+	std::shared_ptr<QFile> m_owner;
+	T* m_data = nullptr;
+	std::uint64_t m_size = 0;
+};
+
+template<typename T>
+inline MappedArray<T>& MappedArray<T>::operator=(MappedArray&& other) noexcept
+{
+	if (this != &other) {
+		release();
+		m_heap = std::move(other.m_heap);
+		m_file = std::move(other.m_file);
+		m_owner = std::move(other.m_owner);
+		m_data = other.m_data;
+		m_size = other.m_size;
+		other.m_data = nullptr;
+		other.m_size = 0;
+	}
+	return *this;
+}
+
+template<typename T>
+inline bool MappedArray<T>::allocate(std::uint64_t count)
+{
+	release();
+	if (0 == count) {
+		return true;
+	}
+	const std::uint64_t bytes = count * sizeof(T);
+	if (bytes < s_outOfCoreThreshold) {
+		m_heap.resize(count);
+		m_data = m_heap.data();
+		m_size = count;
+		return true;
+	}
+	m_file = std::make_unique<QTemporaryFile>(QDir::tempPath() + "/3DViewer_XXXXXX.bin");
+	if (!m_file->open() || !m_file->resize(static_cast<qint64>(bytes))) {
+		qCritical() << "Critical: cannot create out-of-core storage of" << bytes << "bytes in" << QDir::tempPath();
+		m_file.reset();
+		return false;
+	}
+	auto mapped = m_file->map(0, static_cast<qint64>(bytes));
+	if (nullptr == mapped) {
+		qCritical() << "Critical: cannot map out-of-core storage:" << m_file->errorString();
+		m_file.reset();
+		return false;
+	}
+	m_data = reinterpret_cast<T*>(mapped);
+	m_size = count;
+	return true;
+}
+
+template<typename T>
+inline bool MappedArray<T>::copyFrom(const MappedArray& other)
+{
+	if (!allocate(other.size())) {
+		return false;
+	}
+	std::copy(other.begin(), other.end(), begin());
+	return true;
+}
+
+template<typename T>
+inline void MappedArray<T>::release()
+{
+	if (nullptr != m_file) {
+		m_file->unmap(reinterpret_cast<uchar*>(m_data));
+		m_file.reset();
+	}
+	m_owner.reset();
+	std::vector<T>().swap(m_heap);
+	m_data = nullptr;
+	m_size = 0;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QString>
+#include <QVector3D.h>
+
+#include <memory>
+
+#include "MappedArray.h"
+#include "Vertex.h"
+
+// GPU-ready mesh produced ahead of time: the triangle soup the renderer uploads as is,
+// stored at a page-aligned offset so loading only maps the file.
+struct CachedMesh {
+	MappedArray<Vertex> vertices;
+	std::uint64_t num_vertices = 0;
+	std::uint64_t num_faces = 0;
+	std::uint64_t num_edges = 0;
+	QVector3D minBounds;
+	QVector3D maxBounds;
+	// absolute path, size and modification time of the model the cache was built from
+	QString sourcePath;
+	std::uint64_t sourceSize = 0;
+	std::int64_t sourceModified = 0;
+};
+
+namespace CACHE_API {
+	constexpr std::uint32_t VERSION = 2;
+	constexpr auto FILE_SUFFIX = "3dvc";
+
+	bool writeMeshCache(const QString& path, const CachedMesh& mesh);
+	// the soup is taken from vertices, everything else from mesh
+	bool writeMeshCache(const QString& path, const CachedMesh& mesh, const MappedArray<Vertex>& vertices);
+	std::unique_ptr<CachedMesh> readMeshCache(const QString& path);
+	// true when the model still exists but its size or modification time differ from the cached ones
+	bool isSourceChanged(const CachedMesh& mesh);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <QString>
+
+#include <memory>
+
+#include "MeshCache.h"
+
+// Compact interchange format of the GPU-ready triangle soup. Positions are quantised to
+// 16 bits inside the bounds, normals are octahedral encoded into two 16-bit values.
+// Triangles are split into chunks with their own vertex list: the indices are coded as the
+// distance back from the next new vertex, the vertex attributes as deltas of the previous
+// vertex, both as zigzag varints which then go through zlib. Every chunk decodes on its own,
+// so loading spreads over all the cores.
+namespace CODEC_API {
+	constexpr std::uint32_t VERSION = 1;
+	constexpr auto FILE_SUFFIX = "3dvz";
+	// triangles per independently decoded chunk
+	constexpr std::uint32_t CHUNK_TRIANGLES = 65536;
+
+	bool writeCompressedMesh(const QString& path, const MappedArray<Vertex>& soup,
+		std::uint64_t num_vertices, std::uint64_t num_faces, std::uint64_t num_edges);
+	std::unique_ptr<CachedMesh> readCompressedMesh(const QString& path);
+	// decodes a whole file already in memory
+	std::unique_ptr<CachedMesh> decodeCompressedMesh(const uchar* data, std::uint64_t size);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <QMatrix4x4>
+#include <QString>
+
+#include <vector>
+
+#include "MappedArray.h"
+#include "SurfaceMaterial.h"
+#include "Vertex.h"
+
+// triangle soup of one object with the transform it is placed with on the scene
+struct ExportPart {
+	QString name;
+	const MappedArray<Vertex>* soup = nullptr;
+	QMatrix4x4 model;
+	// optional, written by the obj exporter into a library next to the file, the ranges cover the soup in order
+	const std::vector<SurfaceMaterial>* materials = nullptr;
+	const std::vector<MaterialRange>* materialRanges = nullptr;
+};
+
+// Writes placed objects into a single model file with their transforms baked into the geometry.
+// The triangles are split into chunks which are transformed and formatted in parallel into a
+// fixed pool of buffers, one half of the pool is written while the other one is formatted.
+// Floats are formatted with std::to_chars into buffers sized for the worst case chunk, so the
+// formatting never checks the space left. Corners are written as they are in the soup, which
+// keeps every chunk independent of the others. An obj file keeps the texture coordinates and
+// gets the materials of its parts in an mtl library of the same name.
+namespace EXPORT_API {
+	enum class Format {
+		OBJ,
+		PLY,
+		STL
+	};
+	// triangles per independently formatted chunk
+	constexpr std::uint64_t CHUNK_TRIANGLES = 4096;
+	// formatting buffers of an export, whatever the number of workers, reported as transient memory
+	constexpr std::size_t BUFFER_POOL_SIZE = 16;
+
+	// false for the suffixes without an exporter
+	bool formatFromSuffix(const QString& suffix, Format& format);
+	// positions by the model matrix, normals by its normal matrix, a plain loop over the floats
+	// the compiler vectorises
+	void bakeTransform(const Vertex* source, std::uint64_t count, const QMatrix4x4& model, Vertex* target);
+	// false when writing failed or the calling job was cancelled, the file is left untouched then
+	bool exportMeshes(const QString& path, Format format, const std::vector<ExportPart>& parts);
+}
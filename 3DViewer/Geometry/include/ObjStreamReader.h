@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+#include <memory>
+
+#include "IndexedMesh.h"
+
+// Streaming OBJ reader for the files which don't fit in memory as CGAL::Surface_mesh.
+// The file is read twice in bounded blocks: the first pass counts the elements,
+// the second one fills exactly sized (and possibly out-of-core) arrays.
+namespace OBJ_STREAM_API {
+   std::unique_ptr<IndexedMesh> constructMeshFromObj(const std::string& file_path);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QFile>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Line and token scanning shared by the OBJ readers
+namespace OBJ_TOKENIZER {
+	constexpr std::size_t READ_BLOCK_SIZE = 16 * 1024 * 1024;
+
+	inline const char* skipSpaces(const char* p, const char* end)
+	{
+		while (p < end && (*p == ' ' || *p == '\t')) ++p;
+		return p;
+	}
+
+	//calls handler(begin, end) for every line of the file without its indentation,
+	//memory usage is bounded by the block size
+	template <typename Handler>
+	inline bool forEachLine(QFile& file, Handler&& handler)
+	{
+		std::vector<char> buffer(READ_BLOCK_SIZE);
+		std::size_t carried = 0;
+		while (true) {
+			const qint64 read = file.read(buffer.data() + carried, static_cast<qint64>(buffer.size() - carried));
+			if (read < 0) {
+				return false;
+			}
+			const char* line = buffer.data();
+			const char* end = line + carried + static_cast<std::size_t>(read);
+			const char* eol = nullptr;
+			while (nullptr != (eol = static_cast<const char*>(std::memchr(line, '\n', end - line)))) {
+				const char* line_end = (eol > line && *(eol - 1) == '\r') ? eol - 1 : eol;
+				if (!handler(skipSpaces(line, line_end), line_end)) {
+					return false;
+				}
+				line = eol + 1;
+			}
+			carried = static_cast<std::size_t>(end - line);
+			if (0 == read || file.atEnd()) {
+				return (0 == carried) ? true : handler(skipSpaces(line, end), end);
+			}
+			if (carried == buffer.size()) {
+				//line is longer than the whole buffer
+				buffer.resize(buffer.size() * 2);
+				continue;
+			}
+			std::memmove(buffer.data(), line, carried);
+		}
+	}
+
+	inline const char* skipToken(const char* p, const char* end)
+	{
+		while (p < end && *p != ' ' && *p != '\t') ++p;
+		return p;
+	}
+
+	inline bool isKeyword(const char* begin, const char* end, char keyword)
+	{
+		return (end - begin) > 1 && begin[0] == keyword && (begin[1] == ' ' || begin[1] == '\t');
+	}
+
+	inline bool isKeyword(const char* begin, const char* end, const char* keyword)
+	{
+		const auto length = std::strlen(keyword);
+		return static_cast<std::size_t>(end - begin) > length && 0 == std::strncmp(begin, keyword, length) &&
+			(begin[length] == ' ' || begin[length] == '\t');
+	}
+
+	inline std::uint64_t countTokens(const char* p, const char* end)
+	{
+		std::uint64_t count = 0;
+		for (p = skipSpaces(p, end); p < end; p = skipSpaces(skipToken(p, end), end)) {
+			++count;
+		}
+		return count;
+	}
+}
+
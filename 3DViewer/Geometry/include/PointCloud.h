@@ -0,0 +1,71 @@
+#pragma once
+
+#include <QVector3D.h>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "MappedArray.h"
+
+// GPU-ready point, the color is packed as RGBA8
+struct PointVertex {
+	QVector3D position;
+	std::uint32_t color;
+};
+
+// Cube of the octree. A node owns an evenly spread subset of the points inside it, the points
+// not taken by the node are refined by its children, so every point is stored exactly once and
+// drawing a node and any of its descendants never draws a point twice.
+struct OctreeNode {
+	QVector3D center;
+	float halfSize = 0.0f;
+	// owned points in the reordered point array
+	std::uint64_t first = 0;
+	std::uint32_t count = 0;
+	std::uint32_t depth = 0;
+	// node indices, -1 for empty octants
+	std::array<std::int32_t, 8> children{ { -1, -1, -1, -1, -1, -1, -1, -1 } };
+};
+
+struct PointCloud {
+	// in node order once the octree is built
+	MappedArray<PointVertex> points;
+	// root first
+	std::vector<OctreeNode> nodes;
+	QVector3D minBounds;
+	QVector3D maxBounds;
+	bool hasColors = false;
+
+	inline std::uint64_t sizeInBytes() const { return this->points.sizeInBytes() + this->nodes.size() * sizeof(OctreeNode); }
+};
+
+namespace POINTCLOUD_API {
+	// points owned by a single node, also the streaming unit of the renderer
+	constexpr std::uint32_t NODE_POINTS = 16384;
+	// cubes are not split below it, only coincident points get that far; the points of such a cube
+	// are chained in nodes of the same cube, each the single child of the previous, so every node
+	// still fits a streaming slot
+	constexpr std::uint32_t MAX_DEPTH = 21;
+	// size of the tail checked for faces
+	constexpr qint64 SNIFF_SIZE = 1024 * 1024;
+
+	// OBJ files list their faces after the vertices, no face in the tail means a vertex only file
+	bool looksLikePointCloud(const std::string& file_path);
+	// vertex lines of an OBJ file, optionally followed by r g b in [0, 1], faces are ignored
+	std::unique_ptr<PointCloud> readPointCloudFromObj(const std::string& file_path);
+	// reorders the points in place into the node order, subtrees are built in parallel
+	bool buildOctree(PointCloud& cloud);
+	// reads and builds the octree, nullptr on failure or cancellation
+	std::unique_ptr<PointCloud> constructPointCloudFromObj(const std::string& file_path);
+
+	inline std::uint32_t packColor(float r, float g, float b)
+	{
+		const auto channel = [](float value) {
+			return static_cast<std::uint32_t>(std::min(1.0f, std::max(0.0f, value)) * 255.0f + 0.5f);
+		};
+		return channel(r) | (channel(g) << 8) | (channel(b) << 16) | (0xffu << 24);
+	}
+}
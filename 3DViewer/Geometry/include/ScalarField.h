@@ -0,0 +1,75 @@
+#pragma once
+
+#include <QString>
+#include <QVector3D.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "MappedArray.h"
+#include "TriangleBvh.h"
+#include "Vertex.h"
+
+// quality measures shown over the surface
+enum class FieldKind {
+	NONE,
+	CURVATURE,
+	ASPECT_RATIO,
+	EDGE_LENGTH,
+	DEVIATION
+};
+
+// Connectivity the triangle soup lost: the corners sharing a position are one vertex. The
+// corners of vertex v are vertexCorners[vertexOffsets[v], vertexOffsets[v + 1]).
+struct WeldedSoup {
+	// positions of the corners, three per triangle, copied out of the soup
+	MappedArray<QVector3D> corners;
+	std::vector<std::uint32_t> cornerVertex;
+	std::vector<std::uint32_t> vertexOffsets;
+	std::vector<std::uint32_t> vertexCorners;
+
+	inline std::uint64_t vertexCount() const { return this->vertexOffsets.empty() ? 0 : this->vertexOffsets.size() - 1; }
+	inline std::uint64_t sizeInBytes() const {
+		return this->corners.sizeInBytes() + (this->cornerVertex.size() + this->vertexOffsets.size() + this->vertexCorners.size()) * sizeof(std::uint32_t);
+	}
+};
+
+// one value per vertex of the soup, uploaded as an extra vertex stream
+struct ScalarField {
+	FieldKind kind = FieldKind::NONE;
+	std::vector<float> values;
+	float minValue = 0.0f;
+	float maxValue = 0.0f;
+	// the colors are spread over this range, the outliers on both ends are clamped
+	float lowValue = 0.0f;
+	float highValue = 0.0f;
+
+	inline std::uint64_t sizeInBytes() const { return this->values.size() * sizeof(float); }
+};
+
+// All the fields are computed in parallel passes over the triangles writing per corner, then
+// over the vertices gathering their corners, so no pass needs atomics. The fields work in the
+// coordinates of the models, a deviation compares two revisions wherever they are placed.
+namespace FIELD_API {
+	// values left out of the color range on each end
+	constexpr float OUTLIER_FRACTION = 0.01f;
+	// aspect ratio of degenerate triangles
+	constexpr float MAX_ASPECT_RATIO = 1000.0f;
+
+	QString kindName(FieldKind kind);
+	// copies the positions out of the soup, the only step reading it
+	bool gatherCorners(const MappedArray<Vertex>& soup, WeldedSoup& welded);
+	// joins the gathered corners by their position, sorted in parallel runs merged pairwise
+	bool weldCorners(WeldedSoup& welded);
+	// signed mean curvature by the cotangent Laplacian over the barycentric areas, positive on
+	// convex parts when the triangles face outwards
+	bool computeCurvature(const WeldedSoup& welded, ScalarField& field);
+	// circumradius over the doubled inradius, 1 for equilateral triangles, flat over each triangle
+	bool computeAspectRatio(const WeldedSoup& welded, ScalarField& field);
+	// mean length of the edges around each vertex
+	bool computeEdgeLength(const WeldedSoup& welded, ScalarField& field);
+	// distance of each vertex to the surface of the reference
+	bool computeDeviation(const WeldedSoup& welded, const TriangleBvh& reference, ScalarField& field);
+	// extremes and the color range of the values
+	void updateRange(ScalarField& field);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <QString>
+#include <QVector2D.h>
+#include <QVector3D.h>
+
+#include <cstdint>
+#include <vector>
+
+// material of a part of an object, from the mtl library of its obj file
+struct SurfaceMaterial {
+	QString name;
+	QVector3D diffuse = QVector3D(0.8f, 0.8f, 0.8f);
+	// absolute paths, empty without a map
+	QString diffuseMap;
+	QString normalMap;
+	// height map of map_Bump, bumpScale from its -bm option
+	QString bumpMap;
+	float bumpScale = 1.0f;
+};
+
+// consecutive triangles of the soup sharing a material, -1 for the material of the scene
+struct MaterialRange {
+	std::uint64_t firstVertex = 0;
+	std::uint64_t vertexCount = 0;
+	int material = -1;
+};
+
+// Attributes of an obj mesh lost in the surface mesh, in the order of the faces. A mesh with
+// texture coordinates or materials is triangulated while read, so every face is a triangle
+// and its corners follow the halfedges from the one of the face.
+struct SurfaceAttributes {
+	// three per face, empty without texture coordinates
+	std::vector<QVector2D> texcoords;
+	// one per face, empty without materials
+	std::vector<int> faceMaterials;
+	std::vector<SurfaceMaterial> materials;
+};
+
+namespace MTL_API {
+	// appends the materials of the library, the maps are resolved against its directory
+	bool readMaterialLibrary(const QString& path, std::vector<SurfaceMaterial>& materials);
+	// -1 when missing
+	int findMaterial(const std::vector<SurfaceMaterial>& materials, const QString& name);
+	// runs of the same material over the triangles of the faces
+	std::vector<MaterialRange> buildMaterialRanges(const std::vector<int>& faceMaterials);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QImage>
+#include <QString>
+
+#include <memory>
+#include <vector>
+
+// Decoded texture with all its mip levels, RGBA8888 with the first row at the bottom as GL
+// expects it. Decoding and filtering a large map takes longer than reading it back, so the
+// chain is kept in the cache directory and rebuilt only when the image changes.
+struct MipChain {
+	// largest first, down to 1x1
+	std::vector<QImage> levels;
+	// size and modification time of the image the chain was built from
+	std::uint64_t sourceSize = 0;
+	std::int64_t sourceModified = 0;
+};
+
+namespace TEXTURE_API {
+	constexpr std::uint32_t VERSION = 1;
+	constexpr auto FILE_SUFFIX = "3dvt";
+	// larger images are scaled down before the levels are built
+	constexpr int MAX_TEXTURE_SIZE = 8192;
+
+	QImage decodeImage(const QString& path);
+	// box filtered levels of the image, rows are filtered in parallel
+	std::unique_ptr<MipChain> buildMipLevels(const QImage& image);
+	// file of the chain of the image in the cache directory
+	QString cachePath(const QString& imagePath);
+	bool writeTextureCache(const QString& path, const MipChain& chain);
+	std::unique_ptr<MipChain> readTextureCache(const QString& path);
+	// cached chain while the image is unchanged, otherwise decodes it and refreshes the cache,
+	// null when the image cannot be read or the calling job was cancelled
+	std::unique_ptr<MipChain> loadTexture(const QString& imagePath);
+}
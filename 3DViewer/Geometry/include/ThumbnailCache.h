@@ -0,0 +1,30 @@
+#pragma once
+
+#include <QImage>
+#include <QString>
+#include <QVector3D.h>
+
+#include "MappedArray.h"
+#include "Vertex.h"
+
+// Small previews of model files for the open dialog. A preview is rendered from a clustered
+// copy of the model, loaded by the importers that bypass the surface mesh, and kept as a png in
+// the cache directory together with the size and modification time of the model, so a folder
+// seen before shows its previews without loading anything.
+namespace THUMBNAIL_API {
+	// edge of the square previews
+	constexpr int THUMBNAIL_SIZE = 128;
+	// about as many triangles as the preview shows pixels
+	constexpr std::uint64_t PREVIEW_TRIANGLES = 20000;
+
+	// file of the preview of the model in the cache directory
+	QString cachePath(const QString& modelPath, int size = THUMBNAIL_SIZE);
+	// null when missing or built from another version of the model
+	QImage readThumbnail(const QString& modelPath, int size = THUMBNAIL_SIZE);
+	bool writeThumbnail(const QString& modelPath, const QImage& image);
+	// transient memory a preview build of the model holds at most, estimated from the size of the file
+	std::uint64_t estimateBuildBytes(const QString& modelPath);
+	// clustered soup of the model and its bounds, false for point clouds, unreadable models and
+	// when the calling job was cancelled
+	bool buildPreviewMesh(const QString& modelPath, MappedArray<Vertex>& preview, QVector3D& minBounds, QVector3D& maxBounds);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <QMatrix4x4>
+#include <QVector3D.h>
+
+#include <limits>
+#include <vector>
+
+#include "MappedArray.h"
+#include "Vertex.h"
+
+struct BvhTriangle {
+	QVector3D corners[3];
+};
+
+// leaves own a range of the triangles, inner nodes have their left child right after them
+struct BvhNode {
+	QVector3D minBounds;
+	QVector3D maxBounds;
+	// first triangle of a leaf, right child of an inner node
+	std::uint32_t first = 0;
+	// zero for inner nodes
+	std::uint32_t count = 0;
+
+	inline bool isLeaf() const { return this->count > 0; }
+};
+
+// Bounding volume hierarchy over the triangles of an object, in its local space. The triangles
+// are copied in the leaf order, so the queries read neither the soup nor scattered memory and
+// run while the object keeps being drawn or reloaded.
+struct TriangleBvh {
+	MappedArray<BvhTriangle> triangles;
+	// root first
+	std::vector<BvhNode> nodes;
+
+	inline std::uint64_t sizeInBytes() const { return this->triangles.sizeInBytes() + this->nodes.size() * sizeof(BvhNode); }
+};
+
+// triangles of two objects closer to each other than the clearance
+struct Proximity {
+	float distance = std::numeric_limits<float>::max();
+	bool intersecting = false;
+	// indices into the triangles of the hierarchies, sorted and unique
+	std::vector<std::uint32_t> trianglesA;
+	std::vector<std::uint32_t> trianglesB;
+};
+
+namespace BVH_API {
+	constexpr std::uint32_t LEAF_TRIANGLES = 8;
+
+	// copies the triangles of the soup, the only step reading it
+	bool gatherTriangles(const MappedArray<Vertex>& soup, TriangleBvh& bvh);
+	// median splits along the longest axis of the centroid bounds, reorders the gathered triangles
+	bool buildHierarchy(TriangleBvh& bvh);
+	// both hierarchies are descended together, the leaf pairs are tested in parallel. bToA places
+	// b in the space of a and must be rigid, the distances are those of a. False when cancelled
+	bool findCloseTriangles(const TriangleBvh& a, const TriangleBvh& b, const QMatrix4x4& bToA, float clearance,
+		Proximity& result);
+	// zero for touching or crossing triangles
+	float triangleDistance(const QVector3D* a, const QVector3D* b);
+	// distance of the point to the closest triangle, the nearer child is descended first, a single
+	// query is sequential so many of them run in parallel
+	float pointDistance(const TriangleBvh& bvh, const QVector3D& point);
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <QVector2D.h>
+#include <QVector3D.h>
+
+// GPU-ready vertex, objects are drawn as a soup of these
+struct Vertex {
+	QVector3D position;
+	QVector3D normal;
+	QVector2D texture;
+};
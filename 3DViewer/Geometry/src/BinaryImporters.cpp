@@ -0,0 +1,814 @@
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMatrix4x4>
+#include <QQuaternion>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include "BinaryImporters.h"
+#include "JobSystem.h"
+
+namespace {
+    constexpr std::uint64_t PARALLEL_GRAIN = 64 * 1024;
+    constexpr std::size_t WELD_BUCKETS = 256;
+
+    //read-only mapping of the whole file
+    class MappedFile {
+    public:
+        bool open(const std::string& file_path)
+        {
+            m_file.setFileName(QString::fromStdString(file_path));
+            if (!m_file.open(QIODevice::ReadOnly)) {
+                qCritical() << "Critical import API: cannot open input file.";
+                return false;
+            }
+            m_size = static_cast<std::uint64_t>(m_file.size());
+            m_data = (0 == m_size) ? nullptr : m_file.map(0, m_file.size());
+            if (nullptr == m_data) {
+                qCritical() << "Critical: import API cannot map " << file_path.c_str();
+                return false;
+            }
+            return true;
+        }
+        inline const uchar*  data() const { return this->m_data; }
+        inline std::uint64_t size() const { return this->m_size; }
+    private:
+        QFile m_file;
+        const uchar* m_data = nullptr;
+        std::uint64_t m_size = 0;
+    };
+
+    //calls func(begin, end) for the [0, count) subranges on the job system
+    template <typename Func>
+    void parallelFor(std::uint64_t count, Func&& func)
+    {
+        JobSystem::instance().parallelFor(count, PARALLEL_GRAIN, func);
+    }
+
+    //calls func(i) for every i in [0, count), one job per element
+    template <typename Func>
+    void parallelForEach(std::uint64_t count, Func&& func)
+    {
+        JobSystem::instance().parallelFor(count, 1, [&func](std::uint64_t begin, std::uint64_t end) {
+            for (auto i = begin; i < end; ++i) {
+                func(i);
+            }
+        });
+    }
+
+    template <typename T>
+    inline T readValue(const uchar* p)
+    {
+        T value;
+        std::memcpy(&value, p, sizeof(T));
+        return value;
+    }
+
+    inline void finishMesh(IndexedMesh& mesh)
+    {
+        mesh.num_vertices = mesh.positions.size();
+        mesh.num_faces = mesh.numberOfTriangles();
+        mesh.num_edges = MESH_API::countEdges(mesh);
+    }
+
+    inline void logElapsed(const QElapsedTimer& timer, const std::string& file_path)
+    {
+        qDebug() << "Message: binary import has been ended and took " <<
+            static_cast<double>(timer.nsecsElapsed()) / 1000000000.0 << " sec: "
+            << file_path.c_str();
+    }
+
+    // ---------------------------------------------------------------- STL
+
+    constexpr std::uint64_t STL_HEADER_SIZE = 84;
+    constexpr std::uint64_t STL_RECORD_SIZE = 50;
+
+    struct PositionKey {
+        std::uint32_t bits[3];
+        inline bool operator==(const PositionKey& other) const
+        {
+            return bits[0] == other.bits[0] && bits[1] == other.bits[1] && bits[2] == other.bits[2];
+        }
+    };
+
+    struct PositionKeyHash {
+        inline std::size_t operator()(const PositionKey& key) const
+        {
+            std::uint64_t hash = 1469598103934665603ull;
+            for (auto bits : key.bits) {
+                hash = (hash ^ bits) * 1099511628211ull;
+            }
+            return static_cast<std::size_t>(hash ^ (hash >> 29));
+        }
+    };
+
+    inline PositionKey stlCornerKey(const uchar* data, std::uint64_t corner)
+    {
+        const uchar* record = data + STL_HEADER_SIZE + (corner / 3) * STL_RECORD_SIZE;
+        const uchar* position = record + 12 + (corner % 3) * 12;
+        PositionKey key;
+        for (int i = 0; i < 3; ++i) {
+            auto coord = readValue<float>(position + i * 4);
+            //-0.0 and 0.0 are the same point
+            coord = (coord == 0.0f) ? 0.0f : coord;
+            std::memcpy(&key.bits[i], &coord, 4);
+        }
+        return key;
+    }
+
+    // ---------------------------------------------------------------- PLY
+
+    enum class PlyType { INT8, UINT8, INT16, UINT16, INT32, UINT32, FLOAT32, FLOAT64, UNKNOWN };
+
+    struct PlyProperty {
+        QByteArray name;
+        PlyType type = PlyType::UNKNOWN;
+        bool isList = false;
+        PlyType countType = PlyType::UNKNOWN;
+    };
+
+    struct PlyElement {
+        QByteArray name;
+        std::uint64_t count = 0;
+        std::vector<PlyProperty> properties;
+    };
+
+    PlyType plyTypeFromName(const QByteArray& name)
+    {
+        if (name == "char" || name == "int8")     return PlyType::INT8;
+        if (name == "uchar" || name == "uint8")   return PlyType::UINT8;
+        if (name == "short" || name == "int16")   return PlyType::INT16;
+        if (name == "ushort" || name == "uint16") return PlyType::UINT16;
+        if (name == "int" || name == "int32")     return PlyType::INT32;
+        if (name == "uint" || name == "uint32")   return PlyType::UINT32;
+        if (name == "float" || name == "float32") return PlyType::FLOAT32;
+        if (name == "double" || name == "float64") return PlyType::FLOAT64;
+        return PlyType::UNKNOWN;
+    }
+
+    std::uint64_t plyTypeSize(PlyType type)
+    {
+        switch (type) {
+        case PlyType::INT8:
+        case PlyType::UINT8:   return 1;
+        case PlyType::INT16:
+        case PlyType::UINT16:  return 2;
+        case PlyType::INT32:
+        case PlyType::UINT32:
+        case PlyType::FLOAT32: return 4;
+        case PlyType::FLOAT64: return 8;
+        default:               return 0;
+        }
+    }
+
+    inline void swapBytes(uchar* bytes, std::uint64_t size)
+    {
+        std::reverse(bytes, bytes + size);
+    }
+
+    inline double readPlyValue(const uchar* p, PlyType type, bool swap)
+    {
+        uchar bytes[8];
+        const auto size = plyTypeSize(type);
+        std::memcpy(bytes, p, size);
+        if (swap) {
+            swapBytes(bytes, size);
+        }
+        switch (type) {
+        case PlyType::INT8:    return readValue<std::int8_t>(bytes);
+        case PlyType::UINT8:   return readValue<std::uint8_t>(bytes);
+        case PlyType::INT16:   return readValue<std::int16_t>(bytes);
+        case PlyType::UINT16:  return readValue<std::uint16_t>(bytes);
+        case PlyType::INT32:   return readValue<std::int32_t>(bytes);
+        case PlyType::UINT32:  return readValue<std::uint32_t>(bytes);
+        case PlyType::FLOAT32: return readValue<float>(bytes);
+        case PlyType::FLOAT64: return readValue<double>(bytes);
+        default:               return 0.0;
+        }
+    }
+
+    //size of the fixed-size row, 0 for rows with list properties
+    std::uint64_t plyFixedRowSize(const PlyElement& element)
+    {
+        std::uint64_t size = 0;
+        for (const auto& property : element.properties) {
+            if (property.isList) {
+                return 0;
+            }
+            size += plyTypeSize(property.type);
+        }
+        return size;
+    }
+
+    //walks over a row with list properties, returns its size or 0 when it doesn't fit
+    std::uint64_t plyRowSize(const PlyElement& element, const uchar* row, const uchar* end, bool swap)
+    {
+        const uchar* p = row;
+        for (const auto& property : element.properties) {
+            if (property.isList) {
+                const auto count_size = plyTypeSize(property.countType);
+                if (p + count_size > end) {
+                    return 0;
+                }
+                const auto count = static_cast<std::uint64_t>(readPlyValue(p, property.countType, swap));
+                p += count_size + count * plyTypeSize(property.type);
+            }
+            else {
+                p += plyTypeSize(property.type);
+            }
+            if (p > end) {
+                return 0;
+            }
+        }
+        return static_cast<std::uint64_t>(p - row);
+    }
+
+    // ---------------------------------------------------------------- GLB
+
+    constexpr std::uint32_t GLB_MAGIC = 0x46546C67;
+    constexpr std::uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+    constexpr std::uint32_t GLB_CHUNK_BIN = 0x004E4942;
+    constexpr int GLTF_TRIANGLES = 4;
+    constexpr int GLTF_UNSIGNED_BYTE = 5121;
+    constexpr int GLTF_UNSIGNED_SHORT = 5123;
+    constexpr int GLTF_UNSIGNED_INT = 5125;
+    constexpr int GLTF_FLOAT = 5126;
+
+    struct GltfAccessorView {
+        const uchar* data = nullptr;
+        std::uint64_t count = 0;
+        std::uint64_t stride = 0;
+        int componentType = 0;
+    };
+
+    struct GltfPrimitive {
+        GltfAccessorView positions;
+        GltfAccessorView indices;
+        QMatrix4x4 transform;
+        std::uint64_t firstVertex = 0;
+        std::uint64_t firstIndex = 0;
+    };
+
+    bool resolveAccessor(const QJsonObject& gltf, int accessor_index, const uchar* bin, std::uint64_t bin_size,
+        GltfAccessorView& view)
+    {
+        const auto accessors = gltf["accessors"].toArray();
+        if (accessor_index < 0 || accessor_index >= accessors.size()) {
+            return false;
+        }
+        const auto accessor = accessors[accessor_index].toObject();
+        const auto buffer_views = gltf["bufferViews"].toArray();
+        const auto view_index = accessor["bufferView"].toInt(-1);
+        if (view_index < 0 || view_index >= buffer_views.size()) {
+            return false;
+        }
+        const auto buffer_view = buffer_views[view_index].toObject();
+        if (0 != buffer_view["buffer"].toInt(0)) {
+            //only the embedded binary chunk is supported
+            return false;
+        }
+        view.componentType = accessor["componentType"].toInt();
+        view.count = static_cast<std::uint64_t>(accessor["count"].toDouble());
+        const auto type = accessor["type"].toString();
+        std::uint64_t element_size = 0;
+        if (type == "VEC3" && view.componentType == GLTF_FLOAT) {
+            element_size = 12;
+        }
+        else if (type == "SCALAR" && view.componentType == GLTF_UNSIGNED_INT) {
+            element_size = 4;
+        }
+        else if (type == "SCALAR" && view.componentType == GLTF_UNSIGNED_SHORT) {
+            element_size = 2;
+        }
+        else if (type == "SCALAR" && view.componentType == GLTF_UNSIGNED_BYTE) {
+            element_size = 1;
+        }
+        else {
+            return false;
+        }
+        const auto stride = static_cast<std::uint64_t>(buffer_view["byteStride"].toDouble(0));
+        view.stride = (0 == stride) ? element_size : stride;
+        const auto offset = static_cast<std::uint64_t>(buffer_view["byteOffset"].toDouble(0)) +
+            static_cast<std::uint64_t>(accessor["byteOffset"].toDouble(0));
+        if (view.count > 0 && offset + (view.count - 1) * view.stride + element_size > bin_size) {
+            return false;
+        }
+        view.data = bin + offset;
+        return true;
+    }
+
+    QMatrix4x4 gltfNodeMatrix(const QJsonObject& node)
+    {
+        QMatrix4x4 matrix;
+        if (node.contains("matrix")) {
+            const auto values = node["matrix"].toArray();
+            float column_major[16];
+            for (int i = 0; i < 16; ++i) {
+                column_major[i] = static_cast<float>(values[i].toDouble());
+            }
+            //QMatrix4x4 takes the values in row-major order
+            return QMatrix4x4(column_major).transposed();
+        }
+        if (node.contains("translation")) {
+            const auto t = node["translation"].toArray();
+            matrix.translate(t[0].toDouble(), t[1].toDouble(), t[2].toDouble());
+        }
+        if (node.contains("rotation")) {
+            const auto r = node["rotation"].toArray();
+            matrix.rotate(QQuaternion(r[3].toDouble(), r[0].toDouble(), r[1].toDouble(), r[2].toDouble()));
+        }
+        if (node.contains("scale")) {
+            const auto s = node["scale"].toArray();
+            matrix.scale(s[0].toDouble(), s[1].toDouble(), s[2].toDouble());
+        }
+        return matrix;
+    }
+
+    bool collectMeshPrimitives(const QJsonObject& gltf, int mesh_index, const QMatrix4x4& transform,
+        const uchar* bin, std::uint64_t bin_size, std::vector<GltfPrimitive>& primitives)
+    {
+        const auto meshes = gltf["meshes"].toArray();
+        if (mesh_index < 0 || mesh_index >= meshes.size()) {
+            return false;
+        }
+        for (const auto& primitive_value : meshes[mesh_index].toObject()["primitives"].toArray()) {
+            const auto primitive = primitive_value.toObject();
+            if (GLTF_TRIANGLES != primitive["mode"].toInt(GLTF_TRIANGLES)) {
+                continue;
+            }
+            GltfPrimitive result;
+            result.transform = transform;
+            const auto position_accessor = primitive["attributes"].toObject()["POSITION"].toInt(-1);
+            if (!resolveAccessor(gltf, position_accessor, bin, bin_size, result.positions) ||
+                GLTF_FLOAT != result.positions.componentType) {
+                return false;
+            }
+            if (primitive.contains("indices") &&
+                !resolveAccessor(gltf, primitive["indices"].toInt(), bin, bin_size, result.indices)) {
+                return false;
+            }
+            primitives.push_back(result);
+        }
+        return true;
+    }
+
+    bool collectNodePrimitives(const QJsonObject& gltf, int node_index, const QMatrix4x4& parent, int depth,
+        const uchar* bin, std::uint64_t bin_size, std::vector<GltfPrimitive>& primitives)
+    {
+        const auto nodes = gltf["nodes"].toArray();
+        //depth guard against cyclic node graphs in broken files
+        if (node_index < 0 || node_index >= nodes.size() || depth > 256) {
+            return false;
+        }
+        const auto node = nodes[node_index].toObject();
+        const auto transform = parent * gltfNodeMatrix(node);
+        if (node.contains("mesh") &&
+            !collectMeshPrimitives(gltf, node["mesh"].toInt(), transform, bin, bin_size, primitives)) {
+            return false;
+        }
+        for (const auto& child : node["children"].toArray()) {
+            if (!collectNodePrimitives(gltf, child.toInt(), transform, depth + 1, bin, bin_size, primitives)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    inline std::uint32_t readGltfIndex(const GltfAccessorView& view, std::uint64_t i)
+    {
+        const uchar* p = view.data + i * view.stride;
+        switch (view.componentType) {
+        case GLTF_UNSIGNED_BYTE:  return *p;
+        case GLTF_UNSIGNED_SHORT: return readValue<std::uint16_t>(p);
+        default:                  return readValue<std::uint32_t>(p);
+        }
+    }
+}
+
+std::unique_ptr<IndexedMesh> IMPORT_API::constructMeshFromStl(const std::string& file_path)
+{
+    MappedFile input;
+    if (!input.open(file_path)) {
+        return nullptr;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    qDebug() << "Message: stl import has been started: " << file_path.c_str();
+    const uchar* data = input.data();
+    const std::uint64_t num_triangles = (input.size() >= STL_HEADER_SIZE) ? readValue<std::uint32_t>(data + 80) : 0;
+    if (0 == num_triangles || input.size() < STL_HEADER_SIZE + num_triangles * STL_RECORD_SIZE) {
+        qCritical() << "Critical: import API mesh constructed from " << file_path.c_str() << " apear to be empty or is not a binary STL.";
+        return nullptr;
+    }
+    const std::uint64_t num_corners = num_triangles * 3;
+    if (num_corners > std::numeric_limits<std::uint32_t>::max()) {
+        qCritical() << "Critical: import API mesh constructed from " << file_path.c_str() << " has too many triangles.";
+        return nullptr;
+    }
+
+    //corners are partitioned into buckets by position hash, every bucket is welded independently
+    MappedArray<std::uint8_t> corner_bucket;
+    MappedArray<std::uint32_t> bucket_corners;
+    MappedArray<std::uint32_t> local_index;
+    if (!corner_bucket.allocate(num_corners) || !bucket_corners.allocate(num_corners) || !local_index.allocate(num_corners)) {
+        return nullptr;
+    }
+    parallelFor(num_corners, [&](std::uint64_t begin, std::uint64_t end) {
+        PositionKeyHash hasher;
+        for (auto corner = begin; corner < end; ++corner) {
+            corner_bucket[corner] = static_cast<std::uint8_t>((hasher(stlCornerKey(data, corner)) >> 3) % WELD_BUCKETS);
+        }
+    });
+    std::vector<std::uint64_t> bucket_offsets(WELD_BUCKETS + 1, 0);
+    for (const auto bucket : corner_bucket) {
+        ++bucket_offsets[bucket + 1];
+    }
+    for (std::size_t b = 0; b < WELD_BUCKETS; ++b) {
+        bucket_offsets[b + 1] += bucket_offsets[b];
+    }
+    {
+        auto cursor = bucket_offsets;
+        for (std::uint64_t corner = 0; corner < num_corners; ++corner) {
+            bucket_corners[cursor[corner_bucket[corner]]++] = static_cast<std::uint32_t>(corner);
+        }
+    }
+
+    std::vector<std::vector<QVector3D>> bucket_positions(WELD_BUCKETS);
+    parallelForEach(WELD_BUCKETS, [&](std::uint64_t bucket) {
+        std::unordered_map<PositionKey, std::uint32_t, PositionKeyHash> welded;
+        welded.reserve((bucket_offsets[bucket + 1] - bucket_offsets[bucket]) / 4);
+        auto& positions = bucket_positions[bucket];
+        for (auto i = bucket_offsets[bucket]; i < bucket_offsets[bucket + 1]; ++i) {
+            const auto corner = bucket_corners[i];
+            const auto key = stlCornerKey(data, corner);
+            const auto inserted = welded.emplace(key, static_cast<std::uint32_t>(positions.size()));
+            if (inserted.second) {
+                float coords[3];
+                std::memcpy(coords, key.bits, sizeof(coords));
+                positions.emplace_back(coords[0], coords[1], coords[2]);
+            }
+            local_index[corner] = inserted.first->second;
+        }
+    });
+    bucket_corners.release();
+
+    std::vector<std::uint64_t> vertex_offsets(WELD_BUCKETS + 1, 0);
+    for (std::size_t b = 0; b < WELD_BUCKETS; ++b) {
+        vertex_offsets[b + 1] = vertex_offsets[b] + bucket_positions[b].size();
+    }
+    auto mesh = std::make_unique<IndexedMesh>();
+    if (!mesh->positions.allocate(vertex_offsets.back()) || !mesh->indices.allocate(num_corners)) {
+        return nullptr;
+    }
+    parallelForEach(WELD_BUCKETS, [&](std::uint64_t bucket) {
+        std::copy(bucket_positions[bucket].begin(), bucket_positions[bucket].end(),
+            mesh->positions.begin() + vertex_offsets[bucket]);
+        std::vector<QVector3D>().swap(bucket_positions[bucket]);
+    });
+    parallelFor(num_corners, [&](std::uint64_t begin, std::uint64_t end) {
+        for (auto corner = begin; corner < end; ++corner) {
+            mesh->indices[corner] = static_cast<std::uint32_t>(vertex_offsets[corner_bucket[corner]] + local_index[corner]);
+        }
+    });
+    logElapsed(timer, file_path);
+
+    if (!MESH_API::computeVertexNormals(*mesh)) {
+        return nullptr;
+    }
+    finishMesh(*mesh);
+    return mesh;
+}
+
+std::unique_ptr<IndexedMesh> IMPORT_API::constructMeshFromPly(const std::string& file_path)
+{
+    MappedFile input;
+    if (!input.open(file_path)) {
+        return nullptr;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    qDebug() << "Message: ply import has been started: " << file_path.c_str();
+
+    //ascii header
+    const auto file_data = QByteArray::fromRawData(reinterpret_cast<const char*>(input.data()),
+        static_cast<int>(std::min<std::uint64_t>(input.size(), 64 * 1024)));
+    const auto header_end = file_data.indexOf("end_header");
+    const auto body_start = (header_end < 0) ? -1 : file_data.indexOf('\n', header_end);
+    if (!file_data.startsWith("ply") || body_start < 0) {
+        qCritical() << "Critical: import API failed to read PLY header " << file_path.c_str();
+        return nullptr;
+    }
+    bool big_endian = false;
+    std::vector<PlyElement> elements;
+    for (const auto& raw_line : file_data.left(header_end).split('\n')) {
+        const auto tokens = raw_line.simplified().split(' ');
+        if (tokens.size() >= 2 && tokens[0] == "format") {
+            if (tokens[1] == "ascii") {
+                qCritical() << "Critical: import API supports only binary PLY " << file_path.c_str();
+                return nullptr;
+            }
+            big_endian = (tokens[1] == "binary_big_endian");
+        }
+        else if (tokens.size() >= 3 && tokens[0] == "element") {
+            PlyElement element;
+            element.name = tokens[1];
+            element.count = tokens[2].toULongLong();
+            elements.push_back(element);
+        }
+        else if (tokens.size() >= 5 && tokens[0] == "property" && tokens[1] == "list" && !elements.empty()) {
+            PlyProperty property;
+            property.isList = true;
+            property.countType = plyTypeFromName(tokens[2]);
+            property.type = plyTypeFromName(tokens[3]);
+            property.name = tokens[4];
+            elements.back().properties.push_back(property);
+        }
+        else if (tokens.size() >= 3 && tokens[0] == "property" && !elements.empty()) {
+            PlyProperty property;
+            property.type = plyTypeFromName(tokens[1]);
+            property.name = tokens[2];
+            elements.back().properties.push_back(property);
+        }
+    }
+    for (const auto& element : elements) {
+        for (const auto& property : element.properties) {
+            if (PlyType::UNKNOWN == property.type || (property.isList && PlyType::UNKNOWN == property.countType)) {
+                qCritical() << "Critical: import API found unknown PLY property type " << file_path.c_str();
+                return nullptr;
+            }
+        }
+    }
+    const bool swap = (big_endian != (Q_BYTE_ORDER == Q_BIG_ENDIAN));
+
+    const uchar* p = input.data() + body_start + 1;
+    const uchar* end = input.data() + input.size();
+    const PlyElement* vertex_element = nullptr;
+    const PlyElement* face_element = nullptr;
+    const uchar* vertex_data = nullptr;
+    const uchar* face_data = nullptr;
+    //locate every element body, rows with lists have to be walked
+    for (const auto& element : elements) {
+        if (element.name == "vertex") {
+            vertex_element = &element;
+            vertex_data = p;
+        }
+        else if (element.name == "face") {
+            face_element = &element;
+            face_data = p;
+        }
+        const auto row_size = plyFixedRowSize(element);
+        if (0 != row_size) {
+            if (static_cast<std::uint64_t>(end - p) < row_size * element.count) {
+                p = nullptr;
+                break;
+            }
+            p += row_size * element.count;
+            continue;
+        }
+        for (std::uint64_t row = 0; row < element.count && nullptr != p; ++row) {
+            const auto size = plyRowSize(element, p, end, swap);
+            p = (0 == size) ? nullptr : p + size;
+        }
+        if (nullptr == p) {
+            break;
+        }
+    }
+    if (nullptr == p || nullptr == vertex_element || nullptr == face_element || 0 == vertex_element->count) {
+        qCritical() << "Critical: import API mesh constructed from " << file_path.c_str() << " apear to be empty or truncated.";
+        return nullptr;
+    }
+    if (vertex_element->count > std::numeric_limits<std::uint32_t>::max()) {
+        qCritical() << "Critical: import API mesh constructed from " << file_path.c_str() << " has too many vertices.";
+        return nullptr;
+    }
+
+    //vertices: fixed-size rows, decoded in parallel ranges
+    const auto vertex_stride = plyFixedRowSize(*vertex_element);
+    std::uint64_t coord_offsets[3] = { 0, 0, 0 };
+    PlyType coord_types[3] = { PlyType::UNKNOWN, PlyType::UNKNOWN, PlyType::UNKNOWN };
+    {
+        std::uint64_t offset = 0;
+        for (const auto& property : vertex_element->properties) {
+            const int axis = (property.name == "x") ? 0 : (property.name == "y") ? 1 : (property.name == "z") ? 2 : -1;
+            if (axis >= 0) {
+                coord_offsets[axis] = offset;
+                coord_types[axis] = property.type;
+            }
+            offset += plyTypeSize(property.type);
+        }
+    }
+    if (0 == vertex_stride || PlyType::UNKNOWN == coord_types[0] ||
+        PlyType::UNKNOWN == coord_types[1] || PlyType::UNKNOWN == coord_types[2]) {
+        qCritical() << "Critical: import API needs x, y, z vertex properties in " << file_path.c_str();
+        return nullptr;
+    }
+    auto mesh = std::make_unique<IndexedMesh>();
+    if (!mesh->positions.allocate(vertex_element->count)) {
+        return nullptr;
+    }
+    const bool packed_floats = !swap && 12 == vertex_stride &&
+        coord_offsets[0] == 0 && coord_offsets[1] == 4 && coord_offsets[2] == 8 &&
+        coord_types[0] == PlyType::FLOAT32 && coord_types[1] == PlyType::FLOAT32 && coord_types[2] == PlyType::FLOAT32;
+    parallelFor(vertex_element->count, [&](std::uint64_t begin, std::uint64_t end_row) {
+        if (packed_floats) {
+            //the vertex block already is an array of QVector3D
+            std::memcpy(mesh->positions.data() + begin, vertex_data + begin * 12, (end_row - begin) * 12);
+            return;
+        }
+        for (auto row = begin; row < end_row; ++row) {
+            const uchar* vertex = vertex_data + row * vertex_stride;
+            mesh->positions[row] = QVector3D(
+                static_cast<float>(readPlyValue(vertex + coord_offsets[0], coord_types[0], swap)),
+                static_cast<float>(readPlyValue(vertex + coord_offsets[1], coord_types[1], swap)),
+                static_cast<float>(readPlyValue(vertex + coord_offsets[2], coord_types[2], swap)));
+        }
+    });
+
+    //faces: variable-size rows, counted first and then fan triangulated
+    int index_property = -1;
+    for (std::size_t i = 0; i < face_element->properties.size(); ++i) {
+        const auto& name = face_element->properties[i].name;
+        if (face_element->properties[i].isList && (name == "vertex_indices" || name == "vertex_index")) {
+            index_property = static_cast<int>(i);
+        }
+    }
+    if (index_property < 0) {
+        qCritical() << "Critical: import API needs vertex_indices face property in " << file_path.c_str();
+        return nullptr;
+    }
+    auto forEachFace = [&](auto&& handler) {
+        const uchar* row = face_data;
+        for (std::uint64_t face = 0; face < face_element->count; ++face) {
+            const uchar* q = row;
+            for (std::size_t i = 0; i < face_element->properties.size(); ++i) {
+                const auto& property = face_element->properties[i];
+                if (!property.isList) {
+                    q += plyTypeSize(property.type);
+                    continue;
+                }
+                const auto count = static_cast<std::uint64_t>(readPlyValue(q, property.countType, swap));
+                q += plyTypeSize(property.countType);
+                if (static_cast<int>(i) == index_property) {
+                    handler(q, count, property.type);
+                }
+                q += count * plyTypeSize(property.type);
+            }
+            row = q;
+        }
+    };
+    std::uint64_t num_triangles = 0;
+    forEachFace([&](const uchar*, std::uint64_t count, PlyType) {
+        num_triangles += (count >= 3) ? count - 2 : 0;
+    });
+    if (0 == num_triangles || !mesh->indices.allocate(num_triangles * 3)) {
+        qCritical() << "Critical: import API mesh constructed from " << file_path.c_str() << " apear to be empty.";
+        return nullptr;
+    }
+    std::uint64_t index_pos = 0;
+    bool indices_valid = true;
+    forEachFace([&](const uchar* indices, std::uint64_t count, PlyType type) {
+        const auto type_size = plyTypeSize(type);
+        auto readIndex = [&](std::uint64_t i) {
+            const auto index = readPlyValue(indices + i * type_size, type, swap);
+            if (index < 0.0 || index >= static_cast<double>(vertex_element->count)) {
+                indices_valid = false;
+                return 0u;
+            }
+            return static_cast<std::uint32_t>(index);
+        };
+        for (std::uint64_t i = 2; i < count; ++i) {
+            mesh->indices[index_pos++] = readIndex(0);
+            mesh->indices[index_pos++] = readIndex(i - 1);
+            mesh->indices[index_pos++] = readIndex(i);
+        }
+    });
+    if (!indices_valid) {
+        qCritical() << "Critical: import API mesh constructed from " << file_path.c_str() << " apear to be invalid.";
+        return nullptr;
+    }
+    logElapsed(timer, file_path);
+
+    if (!MESH_API::computeVertexNormals(*mesh)) {
+        return nullptr;
+    }
+    finishMesh(*mesh);
+    return mesh;
+}
+
+std::unique_ptr<IndexedMesh> IMPORT_API::constructMeshFromGlb(const std::string& file_path)
+{
+    MappedFile input;
+    if (!input.open(file_path)) {
+        return nullptr;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    qDebug() << "Message: glb import has been started: " << file_path.c_str();
+    const uchar* data = input.data();
+    if (input.size() < 20 || GLB_MAGIC != readValue<std::uint32_t>(data) || 2 != readValue<std::uint32_t>(data + 4)) {
+        qCritical() << "Critical: import API supports only glTF 2.0 binary files " << file_path.c_str();
+        return nullptr;
+    }
+    //JSON chunk goes first, binary chunk is optional
+    const std::uint64_t json_size = readValue<std::uint32_t>(data + 12);
+    if (GLB_CHUNK_JSON != readValue<std::uint32_t>(data + 16) || 20 + json_size > input.size()) {
+        qCritical() << "Critical: import API failed to read GLB JSON chunk " << file_path.c_str();
+        return nullptr;
+    }
+    QJsonParseError error;
+    const auto document = QJsonDocument::fromJson(
+        QByteArray::fromRawData(reinterpret_cast<const char*>(data + 20), static_cast<int>(json_size)), &error);
+    if (QJsonParseError::NoError != error.error) {
+        qCritical() << "Critical: import API failed to parse GLB JSON " << error.errorString();
+        return nullptr;
+    }
+    const auto gltf = document.object();
+    const uchar* bin = nullptr;
+    std::uint64_t bin_size = 0;
+    const std::uint64_t bin_header = 20 + ((json_size + 3) & ~3ull);
+    if (bin_header + 8 <= input.size() && GLB_CHUNK_BIN == readValue<std::uint32_t>(data + bin_header + 4)) {
+        bin_size = std::min<std::uint64_t>(readValue<std::uint32_t>(data + bin_header), input.size() - bin_header - 8);
+        bin = data + bin_header + 8;
+    }
+
+    std::vector<GltfPrimitive> primitives;
+    bool collected = true;
+    const auto scenes = gltf["scenes"].toArray();
+    if (!scenes.isEmpty()) {
+        const auto scene = scenes[gltf["scene"].toInt(0)].toObject();
+        for (const auto& node : scene["nodes"].toArray()) {
+            collected = collected && collectNodePrimitives(gltf, node.toInt(), QMatrix4x4(), 0, bin, bin_size, primitives);
+        }
+    }
+    else {
+        for (int mesh_index = 0; mesh_index < gltf["meshes"].toArray().size(); ++mesh_index) {
+            collected = collected && collectMeshPrimitives(gltf, mesh_index, QMatrix4x4(), bin, bin_size, primitives);
+        }
+    }
+    if (!collected) {
+        qCritical() << "Critical: import API found unsupported GLB accessor in " << file_path.c_str();
+        return nullptr;
+    }
+
+    std::uint64_t num_vertices = 0;
+    std::uint64_t num_indices = 0;
+    for (auto& primitive : primitives) {
+        primitive.firstVertex = num_vertices;
+        primitive.firstIndex = num_indices;
+        num_vertices += primitive.positions.count;
+        num_indices += (nullptr != primitive.indices.data) ? primitive.indices.count / 3 * 3 : primitive.positions.count / 3 * 3;
+    }
+    if (0 == num_vertices || 0 == num_indices) {
+        qCritical() << "Critical: import API mesh constructed from " << file_path.c_str() << " apear to be empty.";
+        return nullptr;
+    }
+    if (num_vertices > std::numeric_limits<std::uint32_t>::max()) {
+        qCritical() << "Critical: import API mesh constructed from " << file_path.c_str() << " has too many vertices.";
+        return nullptr;
+    }
+    auto mesh = std::make_unique<IndexedMesh>();
+    if (!mesh->positions.allocate(num_vertices) || !mesh->indices.allocate(num_indices)) {
+        return nullptr;
+    }
+    std::atomic<bool> indices_valid{ true };
+    parallelForEach(primitives.size(), [&](std::uint64_t primitive_index) {
+        const auto& primitive = primitives[primitive_index];
+        const auto& positions = primitive.positions;
+        const bool identity = primitive.transform.isIdentity();
+        for (std::uint64_t i = 0; i < positions.count; ++i) {
+            QVector3D position;
+            std::memcpy(&position, positions.data + i * positions.stride, sizeof(QVector3D));
+            mesh->positions[primitive.firstVertex + i] = identity ? position : primitive.transform.map(position);
+        }
+        const auto& indices = primitive.indices;
+        const auto count = (nullptr != indices.data) ? indices.count / 3 * 3 : positions.count / 3 * 3;
+        for (std::uint64_t i = 0; i < count; ++i) {
+            const std::uint64_t index = (nullptr != indices.data) ? readGltfIndex(indices, i) : i;
+            if (index >= positions.count) {
+                indices_valid = false;
+                return;
+            }
+            mesh->indices[primitive.firstIndex + i] = static_cast<std::uint32_t>(primitive.firstVertex + index);
+        }
+    });
+    if (!indices_valid) {
+        qCritical() << "Critical: import API mesh constructed from " << file_path.c_str() << " apear to be invalid.";
+        return nullptr;
+    }
+    logElapsed(timer, file_path);
+
+    if (!MESH_API::computeVertexNormals(*mesh)) {
+        return nullptr;
+    }
+    finishMesh(*mesh);
+    return mesh;
+}
@@ -1,40 +1,305 @@
 #include <QDebug>
+#include <QDir>
 #include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+
+#include <charconv>
+#include <cmath>
+#include <list>
+#include <memory_resource>
 
 #include "CgalApi.h"
+#include "ObjTokenizer.h"
+#include "MonotonicArena.h"
+#include "JobSystem.h"
 
 #include <CGAL/Polygon_mesh_processing/compute_normal.h>
 #include <CGAL/Polygon_mesh_processing/triangulate_faces.h>
+#include <CGAL/Polygon_mesh_processing/polygon_soup_to_polygon_mesh.h>
+#include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
+#include <CGAL/Constrained_Delaunay_triangulation_2.h>
+#include <CGAL/Triangulation_face_base_with_info_2.h>
+
+using namespace OBJ_TOKENIZER;
 
+namespace {
+    constexpr std::uint64_t PARALLEL_GRAIN = 16 * 1024;
 
+    //contours may touch or cross each other where the surface does, the exact predicates keep the
+    //triangulation valid with the intersections of the constraints
+    typedef CGAL::Exact_predicates_inexact_constructions_kernel Cap_kernel;
+    typedef CGAL::Triangulation_vertex_base_2<Cap_kernel> Cap_vertex_base;
+    //nesting level of the face, odd levels are inside the section
+    typedef CGAL::Triangulation_face_base_with_info_2<int, Cap_kernel> Cap_info_face_base;
+    typedef CGAL::Constrained_triangulation_face_base_2<Cap_kernel, Cap_info_face_base> Cap_face_base;
+    typedef CGAL::Triangulation_data_structure_2<Cap_vertex_base, Cap_face_base> Cap_tds;
+    typedef CGAL::Constrained_Delaunay_triangulation_2<Cap_kernel, Cap_tds, CGAL::Exact_predicates_tag> Cap_triangulation;
 
-std::unique_ptr<Surface_mesh> CGAL_API::constructMeshFromObj(const std::string& file_path)
+    void markNesting(Cap_triangulation& triangulation, Cap_triangulation::Face_handle start, int level,
+        std::list<Cap_triangulation::Edge>& border)
+    {
+        if (-1 != start->info()) {
+            return;
+        }
+        std::list<Cap_triangulation::Face_handle> queue;
+        queue.push_back(start);
+        while (!queue.empty()) {
+            const auto face = queue.front();
+            queue.pop_front();
+            if (-1 != face->info()) {
+                continue;
+            }
+            face->info() = level;
+            for (int i = 0; i < 3; ++i) {
+                const Cap_triangulation::Edge edge(face, i);
+                const auto neighbor = face->neighbor(i);
+                if (-1 == neighbor->info()) {
+                    //crossing a contour enters the next level
+                    if (triangulation.is_constrained(edge)) {
+                        border.push_back(edge);
+                    }
+                    else {
+                        queue.push_back(neighbor);
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+
+std::unique_ptr<Surface_mesh> CGAL_API::constructMeshFromObj(const std::string& file_path, SurfaceAttributes* attributes)
+{
+    auto mesh = readMeshFromObj(file_path, attributes);
+    if (nullptr == mesh || !checkConstructedMesh(mesh, file_path)) {
+        return nullptr;
+    }
+    //triangulate mesh because we dont know how its constructed in obj
+    if (!triangulateMesh(mesh)) {
+        return nullptr;
+    }
+    return mesh;
+}
+
+std::unique_ptr<Surface_mesh> CGAL_API::readMeshFromObj(const std::string& file_path, SurfaceAttributes* attributes)
 {
     //try block only for cgal exceptions
     try {
-        auto mesh = std::make_unique<Surface_mesh>();
-        std::ifstream input(file_path);
-        if (!input) {
+        QFile input(QString::fromStdString(file_path));
+        if (!input.open(QIODevice::ReadOnly)) {
             qCritical() << "Critical CGAL API: cannot open input file.";
             return nullptr;
         }
         QElapsedTimer timer;
         timer.start();
         qDebug() << "Message: obj reading has been started: " << file_path.c_str();
-        if (!CGAL::IO::read_OBJ(input, *mesh)) {
+
+        //first pass: exact sizes of the soup and of the triangulated mesh
+        std::uint64_t num_vertices = 0;
+        std::uint64_t num_polygons = 0;
+        std::uint64_t num_corners = 0;
+        std::uint64_t num_triangles = 0;
+        std::uint64_t num_texcoords = 0;
+        bool has_materials = false;
+        const auto directory = QFileInfo(input).absoluteDir();
+        std::vector<SurfaceMaterial> materials;
+        const bool counted = forEachLine(input, [&](const char* begin, const char* end) {
+            if (isKeyword(begin, end, 'v')) {
+                ++num_vertices;
+            }
+            else if (isKeyword(begin, end, 'f')) {
+                const auto corners = countTokens(begin + 2, end);
+                ++num_polygons;
+                num_corners += corners;
+                num_triangles += (corners >= 3) ? corners - 2 : 0;
+            }
+            else if (nullptr != attributes && isKeyword(begin, end, "vt")) {
+                ++num_texcoords;
+            }
+            else if (nullptr != attributes && isKeyword(begin, end, "usemtl")) {
+                has_materials = true;
+            }
+            else if (nullptr != attributes && isKeyword(begin, end, "mtllib")) {
+                //libraries are loaded up front, usemtl may come before them
+                for (const char* p = skipSpaces(begin + 6, end); p < end; p = skipSpaces(skipToken(p, end), end)) {
+                    const auto name = QString::fromUtf8(p, static_cast<int>(skipToken(p, end) - p));
+                    MTL_API::readMaterialLibrary(directory.absoluteFilePath(name), materials);
+                }
+            }
+            return true;
+        });
+        if (!counted) {
+            qCritical() << "Critical: CGAL API cannot read OBJ file " << file_path.c_str();
+            return nullptr;
+        }
+        //faces of a mesh with attributes are fanned into triangles here, so each triangle keeps its
+        //corners and material and triangulate_faces has nothing left to do
+        const bool triangulate = num_texcoords > 0 || has_materials;
+        if (triangulate) {
+            num_polygons = num_triangles;
+            num_corners = num_triangles * 3;
+        }
+        std::vector<QVector2D> texcoords;
+        std::vector<std::int64_t> corner_texcoords;
+        std::vector<int> face_materials;
+        texcoords.reserve(num_texcoords);
+        if (num_texcoords > 0) {
+            corner_texcoords.reserve(num_corners);
+        }
+        if (has_materials) {
+            face_materials.reserve(num_polygons);
+        }
+        int material = -1;
+        std::vector<std::size_t> corners;
+        std::vector<std::int64_t> corners_texcoords;
+
+        //soup temporaries live in one block released at once when the mesh is built
+        MonotonicArena arena(num_vertices * sizeof(Point_3) +
+            num_polygons * sizeof(std::pmr::vector<std::size_t>) + num_corners * sizeof(std::size_t) + 4096);
+        std::pmr::vector<Point_3> points(arena.resource());
+        std::pmr::vector<std::pmr::vector<std::size_t>> polygons(arena.resource());
+        points.reserve(num_vertices);
+        polygons.reserve(num_polygons);
+
+        //second pass: fill the soup
+        input.seek(0);
+        const bool parsed = forEachLine(input, [&](const char* begin, const char* end) {
+            if (JobSystem::cancellationRequested()) {
+                return false;
+            }
+            if (isKeyword(begin, end, 'v')) {
+                double coords[3];
+                const char* p = begin + 2;
+                for (auto& coord : coords) {
+                    p = skipSpaces(p, end);
+                    const auto result = std::from_chars(p, end, coord);
+                    if (result.ec != std::errc()) {
+                        return false;
+                    }
+                    p = result.ptr;
+                }
+                points.emplace_back(coords[0], coords[1], coords[2]);
+            }
+            else if (isKeyword(begin, end, 'f')) {
+                corners.clear();
+                corners_texcoords.clear();
+                for (const char* p = skipSpaces(begin + 2, end); p < end; p = skipSpaces(skipToken(p, end), end)) {
+                    const char* token_end = skipToken(p, end);
+                    long long index = 0;
+                    const auto result = std::from_chars(p, token_end, index);
+                    if (result.ec != std::errc()) {
+                        return false;
+                    }
+                    //negative indices are relative to the last parsed vertex
+                    index = (index < 0) ? static_cast<long long>(points.size()) + index : index - 1;
+                    if (index < 0 || static_cast<std::uint64_t>(index) >= num_vertices) {
+                        return false;
+                    }
+                    corners.push_back(static_cast<std::size_t>(index));
+                    if (num_texcoords > 0) {
+                        //v/vt/vn, v//vn has no texture coordinate
+                        long long texcoord = 0;
+                        const char* q = result.ptr;
+                        if (q + 1 < token_end && q[0] == '/' && q[1] != '/' &&
+                            std::from_chars(q + 1, token_end, texcoord).ec == std::errc()) {
+                            texcoord = (texcoord < 0) ? static_cast<long long>(texcoords.size()) + texcoord : texcoord - 1;
+                        }
+                        else {
+                            texcoord = -1;
+                        }
+                        corners_texcoords.push_back(texcoord);
+                    }
+                }
+                if (!triangulate) {
+                    polygons.emplace_back(corners.begin(), corners.end());
+                    return true;
+                }
+                for (std::size_t i = 1; i + 1 < corners.size(); ++i) {
+                    auto& polygon = polygons.emplace_back();
+                    polygon.reserve(3);
+                    for (const auto k : { std::size_t(0), i, i + 1 }) {
+                        polygon.push_back(corners[k]);
+                        if (num_texcoords > 0) {
+                            corner_texcoords.push_back(corners_texcoords[k]);
+                        }
+                    }
+                    if (has_materials) {
+                        face_materials.push_back(material);
+                    }
+                }
+            }
+            else if (num_texcoords > 0 && isKeyword(begin, end, "vt")) {
+                float coords[2] = { 0.0f, 0.0f };
+                const char* p = begin + 3;
+                for (auto& coord : coords) {
+                    p = skipSpaces(p, end);
+                    const auto result = std::from_chars(p, end, coord);
+                    if (result.ec != std::errc()) {
+                        break;
+                    }
+                    p = result.ptr;
+                }
+                texcoords.emplace_back(coords[0], coords[1]);
+            }
+            else if (has_materials && isKeyword(begin, end, "usemtl")) {
+                const char* name = skipSpaces(begin + 6, end);
+                material = MTL_API::findMaterial(materials,
+                    QString::fromUtf8(name, static_cast<int>(end - name)).trimmed());
+            }
+            return true;
+        });
+        input.close();
+        if (JobSystem::cancellationRequested()) {
+            qDebug() << "Message: obj reading has been cancelled: " << file_path.c_str();
+            return nullptr;
+        }
+        if (!parsed || !CGAL::Polygon_mesh_processing::is_polygon_soup_a_polygon_mesh(polygons)) {
             qCritical() << "Critical: CGAL API failed to read OBJ file.";
             return nullptr;
         }
+
+        auto mesh = std::make_unique<Surface_mesh>();
+        //sized for the triangulated mesh, so neither the conversion nor triangulate_faces reallocates;
+        //every inner edge is shared by two triangles, open meshes get an allowance for the border
+        const auto num_edges = (num_triangles * 3 + 1) / 2 +
+            static_cast<std::uint64_t>(4.0 * std::sqrt(static_cast<double>(num_triangles))) + 16;
+        mesh->reserve(static_cast<Surface_mesh::size_type>(num_vertices),
+            static_cast<Surface_mesh::size_type>(num_edges), static_cast<Surface_mesh::size_type>(num_triangles));
+        CGAL::Polygon_mesh_processing::polygon_soup_to_polygon_mesh(points, polygons, *mesh);
+        MemoryTracker::LoadScope::add(static_cast<std::int64_t>(memoryUsage(mesh)));
+
+        if (triangulate) {
+            //faces and vertices are added in the order of the soup, so a corner is found by its vertex
+            //index; positions would mix up the corners of a seam, where one vertex has several texcoords.
+            //The first halfedge of a face may point at any of its corners
+            attributes->materials = std::move(materials);
+            attributes->faceMaterials = std::move(face_materials);
+            if (num_texcoords > 0) {
+                attributes->texcoords.assign(polygons.size() * 3, QVector2D(0.0f, 0.0f));
+                JobSystem::instance().parallelFor(polygons.size(), PARALLEL_GRAIN, [&](std::uint64_t begin, std::uint64_t end) {
+                    for (auto i = begin; i < end; ++i) {
+                        const Surface_mesh::Face_index face(static_cast<Surface_mesh::size_type>(i));
+                        const auto first = static_cast<std::size_t>(mesh->target(mesh->halfedge(face)).idx());
+                        std::size_t offset = 0;
+                        while (offset < 2 && polygons[i][offset] != first) {
+                            ++offset;
+                        }
+                        for (std::size_t j = 0; j < 3; ++j) {
+                            const auto texcoord = corner_texcoords[i * 3 + (offset + j) % 3];
+                            if (texcoord >= 0 && static_cast<std::size_t>(texcoord) < texcoords.size()) {
+                                attributes->texcoords[i * 3 + j] = texcoords[static_cast<std::size_t>(texcoord)];
+                            }
+                        }
+                    }
+                });
+            }
+        }
+
         qDebug() << "Message: obj reading has been ended and took " << 
             static_cast<double>(timer.nsecsElapsed()) / 1000000000.0 << " sec: " 
             << file_path.c_str();
-        input.close();
-
-        if (!checkConstructedMesh(mesh, file_path)) {
-            return nullptr;
-        }
-        //triangulate mesh because we dont know how its constructed in obj
-        CGAL::Polygon_mesh_processing::triangulate_faces(*mesh);
         return mesh;
     }
     catch (const std::exception& exp)
@@ -44,6 +309,21 @@ std::unique_ptr<Surface_mesh> CGAL_API::constructMeshFromObj(const std::string&
     }
 }
 
+bool CGAL_API::triangulateMesh(const std::unique_ptr<Surface_mesh>& mesh)
+{
+    try {
+        const auto bytes_before = memoryUsage(mesh);
+        const bool triangulated = CGAL::Polygon_mesh_processing::triangulate_faces(*mesh);
+        MemoryTracker::LoadScope::add(static_cast<std::int64_t>(memoryUsage(mesh)) - static_cast<std::int64_t>(bytes_before));
+        return triangulated;
+    }
+    catch (const std::exception& exp)
+    {
+        qCritical() << exp.what();
+        return false;
+    }
+}
+
 QVector3D CGAL_API::computeVertexNormal(const std::unique_ptr<Surface_mesh>& mesh, const CGAL::SM_Vertex_index& vertex)
 {
     if (nullptr == mesh)
@@ -56,6 +336,87 @@ QVector3D CGAL_API::computeVertexNormal(const std::unique_ptr<Surface_mesh>& mes
     );
 }
 
+std::vector<QVector3D> CGAL_API::computeVertexNormals(const std::unique_ptr<Surface_mesh>& mesh)
+{
+    std::vector<QVector3D> normals;
+    if (nullptr == mesh)
+        return normals;
+    //once per vertex instead of once per face corner, the mesh is only read
+    normals.resize(mesh->number_of_vertices() + mesh->number_of_removed_vertices());
+    JobSystem::instance().parallelFor(normals.size(), PARALLEL_GRAIN, [&](std::uint64_t begin, std::uint64_t end) {
+        for (auto i = begin; i < end; ++i) {
+            const Surface_mesh::Vertex_index vertex(static_cast<Surface_mesh::size_type>(i));
+            if (!mesh->is_removed(vertex)) {
+                normals[i] = computeVertexNormal(mesh, vertex);
+            }
+        }
+    });
+    return normals;
+}
+
+std::uint64_t CGAL_API::memoryUsage(const std::unique_ptr<Surface_mesh>& mesh)
+{
+    if (nullptr == mesh)
+        return 0;
+    //property arrays are sized by the capacity including the removed elements
+    const std::uint64_t vertices = mesh->number_of_vertices() + mesh->number_of_removed_vertices();
+    const std::uint64_t halfedges = mesh->number_of_halfedges() + mesh->number_of_removed_halfedges();
+    const std::uint64_t edges = mesh->number_of_edges() + mesh->number_of_removed_edges();
+    const std::uint64_t faces = mesh->number_of_faces() + mesh->number_of_removed_faces();
+    const std::uint64_t index_size = sizeof(Surface_mesh::Vertex_index);
+    //vertex: point + outgoing halfedge + removed flag, halfedge: face, vertex, next, prev
+    return vertices * (sizeof(Point_3) + index_size + 1) +
+        halfedges * 4 * index_size +
+        edges +
+        faces * (index_size + 1);
+}
+
+bool CGAL_API::buildTriangleSoup(const std::unique_ptr<Surface_mesh>& mesh, const std::vector<QVector3D>& normals, MappedArray<Vertex>& soup,
+    const SurfaceAttributes* attributes)
+{
+    if (nullptr == mesh)
+        return false;
+    std::uint64_t num_corners = 0;
+    for (const auto& face : mesh->faces()) {
+        num_corners += mesh->degree(face);
+    }
+    if (!soup.allocate(num_corners)) {
+        return false;
+    }
+    //texture coordinates follow the faces of a triangulated mesh read with attributes
+    const bool textured = nullptr != attributes && attributes->texcoords.size() == num_corners;
+    const auto writeFace = [&](const Surface_mesh::Face_index& face, std::uint64_t corner) {
+        for (const auto& vertex : mesh->vertices_around_face(mesh->halfedge(face))) {
+            const auto index = corner++;
+            auto& custom_vertex = soup[index];
+            const auto& vertex_point = mesh->point(vertex);
+            custom_vertex.position = {
+                static_cast<float>(CGAL::to_double(vertex_point.x())),
+                static_cast<float>(CGAL::to_double(vertex_point.y())),
+                static_cast<float>(CGAL::to_double(vertex_point.z()))
+            };
+            custom_vertex.normal = normals[vertex.idx()];
+            custom_vertex.texture = textured ? attributes->texcoords[index] : QVector2D(0, 0);
+        }
+    };
+    const std::uint64_t num_faces = mesh->number_of_faces();
+    if (0 == mesh->number_of_removed_faces() && num_corners == num_faces * 3) {
+        //triangles without gaps in the face indices, the corner offset is known for every face
+        JobSystem::instance().parallelFor(num_faces, PARALLEL_GRAIN, [&](std::uint64_t begin, std::uint64_t end) {
+            for (auto i = begin; i < end; ++i) {
+                writeFace(Surface_mesh::Face_index(static_cast<Surface_mesh::size_type>(i)), i * 3);
+            }
+        });
+        return true;
+    }
+    std::uint64_t corner = 0;
+    for (const auto& face : mesh->faces()) {
+        writeFace(face, corner);
+        corner += mesh->degree(face);
+    }
+    return true;
+}
+
 bool CGAL_API::checkConstructedMesh(const std::unique_ptr<Surface_mesh>& mesh, const std::string& filepath)
 {
     if (mesh->is_empty()) {
@@ -68,3 +429,59 @@ bool CGAL_API::checkConstructedMesh(const std::unique_ptr<Surface_mesh>& mesh, c
     }
     return true;
 }
+
+bool CGAL_API::triangulateSectionCap(CrossSection& section)
+{
+    section.cap.clear();
+    //basis of the plane with u x v along the normal
+    const auto normal = section.normal.normalized();
+    const auto helper = std::abs(normal.x()) < 0.9f ? QVector3D(1.0f, 0.0f, 0.0f) : QVector3D(0.0f, 1.0f, 0.0f);
+    const auto u = QVector3D::crossProduct(helper, normal).normalized();
+    const auto v = QVector3D::crossProduct(normal, u);
+    const auto origin = normal * (section.offset / section.normal.length());
+
+    Cap_triangulation triangulation;
+    std::vector<Cap_kernel::Point_2> points;
+    for (const auto& contour : section.contours) {
+        if (!contour.closed || contour.points.size() < 3) {
+            continue;
+        }
+        if (JobSystem::cancellationRequested()) {
+            return false;
+        }
+        points.clear();
+        for (const auto& point : contour.points) {
+            const auto local = point - origin;
+            points.emplace_back(QVector3D::dotProduct(local, u), QVector3D::dotProduct(local, v));
+        }
+        triangulation.insert_constraint(points.begin(), points.end(), true);
+    }
+    if (0 == triangulation.number_of_faces()) {
+        return !JobSystem::cancellationRequested();
+    }
+    for (auto face = triangulation.all_faces_begin(); face != triangulation.all_faces_end(); ++face) {
+        face->info() = -1;
+    }
+    std::list<Cap_triangulation::Edge> border;
+    markNesting(triangulation, triangulation.infinite_face(), 0, border);
+    while (!border.empty()) {
+        const auto edge = border.front();
+        border.pop_front();
+        const auto neighbor = edge.first->neighbor(edge.second);
+        markNesting(triangulation, neighbor, edge.first->info() + 1, border);
+    }
+
+    const auto toSpace = [&](const Cap_kernel::Point_2& point) {
+        return origin + u * static_cast<float>(point.x()) + v * static_cast<float>(point.y());
+    };
+    for (auto face = triangulation.finite_faces_begin(); face != triangulation.finite_faces_end(); ++face) {
+        if (0 == face->info() % 2) {
+            continue;
+        }
+        //counterclockwise in the plane faces along the normal, the cap faces the removed side
+        section.cap.push_back(toSpace(face->vertex(0)->point()));
+        section.cap.push_back(toSpace(face->vertex(2)->point()));
+        section.cap.push_back(toSpace(face->vertex(1)->point()));
+    }
+    return !JobSystem::cancellationRequested();
+}
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <unordered_map>
+
+#include "CrossSection.h"
+#include "JobSystem.h"
+
+namespace {
+    constexpr std::uint64_t SLICE_GRAIN = 64 * 1024;
+
+    // edge of the soup by the bits of its corners, the smaller corner first, so both triangles
+    // sharing the edge produce the same key
+    struct EdgeKey {
+        std::array<std::uint32_t, 6> bits;
+        inline bool operator==(const EdgeKey& other) const { return bits == other.bits; }
+    };
+    struct EdgeKeyHash {
+        std::size_t operator()(const EdgeKey& key) const {
+            std::uint64_t hash = 1469598103934665603ull;
+            for (const auto value : key.bits) {
+                hash = (hash ^ value) * 1099511628211ull;
+            }
+            return static_cast<std::size_t>(hash);
+        }
+    };
+    // part of the contour inside one triangle, from the edge leaving the kept side to the edge
+    // entering it, the neighbour across the second edge continues the contour
+    struct Segment {
+        QVector3D from;
+        EdgeKey fromKey;
+        EdgeKey toKey;
+        QVector3D to;
+    };
+
+    std::array<std::uint32_t, 3> cornerBits(const QVector3D& corner)
+    {
+        std::array<std::uint32_t, 3> bits;
+        const float values[3] = { corner.x(), corner.y(), corner.z() };
+        std::memcpy(bits.data(), values, sizeof(values));
+        return bits;
+    }
+
+    //the crossing is computed from the ordered corners, both triangles get exactly the same point
+    QVector3D crossEdge(const QVector3D& a, float distance_a, const QVector3D& b, float distance_b, EdgeKey& key)
+    {
+        const auto bits_a = cornerBits(a);
+        const auto bits_b = cornerBits(b);
+        if (bits_b < bits_a) {
+            return crossEdge(b, distance_b, a, distance_a, key);
+        }
+        std::copy(bits_a.begin(), bits_a.end(), key.bits.begin());
+        std::copy(bits_b.begin(), bits_b.end(), key.bits.begin() + 3);
+        if (0.0f == distance_a) {
+            return a;
+        }
+        if (0.0f == distance_b) {
+            return b;
+        }
+        const float t = distance_a / (distance_a - distance_b);
+        return a + (b - a) * t;
+    }
+
+    void appendPoint(std::vector<QVector3D>& points, const QVector3D& point)
+    {
+        //corners lying on the plane end two segments at the same point
+        if (points.empty() || points.back() != point) {
+            points.push_back(point);
+        }
+    }
+}
+
+void SECTION_API::axisPlane(const QVector3D& minBounds, const QVector3D& maxBounds, int axis, float position, bool flipped,
+    QVector3D& normal, float& offset)
+{
+    normal = QVector3D(0.0f, 0.0f, 0.0f);
+    normal[axis] = flipped ? -1.0f : 1.0f;
+    offset = minBounds[axis] + (maxBounds[axis] - minBounds[axis]) * position;
+    if (flipped) {
+        offset = -offset;
+    }
+}
+
+bool SECTION_API::sliceTriangleSoup(const MappedArray<Vertex>& soup, const QVector3D& normal, float offset, CrossSection& section)
+{
+    section.normal = normal;
+    section.offset = offset;
+    section.contours.clear();
+    section.cap.clear();
+    const std::uint64_t num_triangles = soup.size() / 3;
+    std::vector<std::vector<Segment>> ranges((num_triangles + SLICE_GRAIN - 1) / SLICE_GRAIN);
+    JobSystem::instance().parallelFor(num_triangles, SLICE_GRAIN, [&](std::uint64_t begin, std::uint64_t end) {
+        auto& segments = ranges[begin / SLICE_GRAIN];
+        for (std::uint64_t t = begin; t < end; ++t) {
+            const Vertex* corners = &soup[t * 3];
+            float distances[3];
+            bool kept[3];
+            for (int c = 0; c < 3; ++c) {
+                distances[c] = QVector3D::dotProduct(normal, corners[c].position) - offset;
+                //a corner on the plane counts as kept, every crossed edge has one corner strictly behind it
+                kept[c] = distances[c] >= 0.0f;
+            }
+            if (kept[0] == kept[1] && kept[1] == kept[2]) {
+                continue;
+            }
+            Segment segment;
+            for (int c = 0; c < 3; ++c) {
+                const int next = (c + 1) % 3;
+                if (kept[c] && !kept[next]) {
+                    segment.from = crossEdge(corners[c].position, distances[c], corners[next].position, distances[next], segment.fromKey);
+                }
+                else if (!kept[c] && kept[next]) {
+                    segment.to = crossEdge(corners[c].position, distances[c], corners[next].position, distances[next], segment.toKey);
+                }
+            }
+            segments.push_back(segment);
+        }
+    });
+    if (JobSystem::cancellationRequested()) {
+        return false;
+    }
+
+    std::vector<Segment> segments;
+    for (auto& range : ranges) {
+        segments.insert(segments.end(), range.begin(), range.end());
+        std::vector<Segment>().swap(range);
+    }
+    //a non-manifold edge keeps the first segment, the others end up in contours of their own
+    std::unordered_map<EdgeKey, std::uint32_t, EdgeKeyHash> starts;
+    std::unordered_map<EdgeKey, std::uint32_t, EdgeKeyHash> ends;
+    starts.reserve(segments.size());
+    ends.reserve(segments.size());
+    for (std::uint32_t i = 0; i < segments.size(); ++i) {
+        starts.emplace(segments[i].fromKey, i);
+        ends.emplace(segments[i].toKey, i);
+    }
+    std::vector<bool> used(segments.size(), false);
+    const auto follow = [&](std::uint32_t first) {
+        CrossSection::Contour contour;
+        auto current = first;
+        for (;;) {
+            used[current] = true;
+            appendPoint(contour.points, segments[current].from);
+            const auto next = starts.find(segments[current].toKey);
+            if (next == starts.end() || used[next->second]) {
+                contour.closed = next != starts.end() && next->second == first;
+                if (!contour.closed) {
+                    appendPoint(contour.points, segments[current].to);
+                }
+                break;
+            }
+            current = next->second;
+        }
+        if (contour.closed && contour.points.size() > 1 && contour.points.back() == contour.points.front()) {
+            contour.points.pop_back();
+        }
+        //a loop around a single corner on the plane encloses nothing
+        if (contour.points.size() > (contour.closed ? 2u : 1u)) {
+            section.contours.push_back(std::move(contour));
+        }
+    };
+    //open contours are walked from their first segment, whatever is left forms loops
+    for (std::uint32_t i = 0; i < segments.size(); ++i) {
+        const auto previous = ends.find(segments[i].fromKey);
+        if (!used[i] && previous == ends.end()) {
+            follow(i);
+        }
+    }
+    for (std::uint32_t i = 0; i < segments.size(); ++i) {
+        if (!used[i]) {
+            follow(i);
+        }
+    }
+    return !JobSystem::cancellationRequested();
+}
@@ -0,0 +1,182 @@
+#include <QDebug>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include "IndexedMesh.h"
+
+bool MESH_API::computeVertexNormals(IndexedMesh& mesh)
+{
+    if (!mesh.normals.allocate(mesh.positions.size())) {
+        return false;
+    }
+    std::fill(mesh.normals.begin(), mesh.normals.end(), QVector3D(0.0f, 0.0f, 0.0f));
+    const std::uint64_t num_triangles = mesh.numberOfTriangles();
+    for (std::uint64_t t = 0; t < num_triangles; ++t) {
+        const auto i0 = mesh.indices[t * 3 + 0];
+        const auto i1 = mesh.indices[t * 3 + 1];
+        const auto i2 = mesh.indices[t * 3 + 2];
+        const auto& p0 = mesh.positions[i0];
+        //not normalized cross product is weighted by the triangle area
+        const auto face_normal = QVector3D::crossProduct(mesh.positions[i1] - p0, mesh.positions[i2] - p0);
+        mesh.normals[i0] += face_normal;
+        mesh.normals[i1] += face_normal;
+        mesh.normals[i2] += face_normal;
+    }
+    for (auto& normal : mesh.normals) {
+        normal.normalize();
+    }
+    return true;
+}
+
+std::uint64_t MESH_API::countEdges(const IndexedMesh& mesh)
+{
+    //edge keys held at once, 128 MB
+    constexpr std::uint64_t EDGE_BUDGET = 16ull * 1024ull * 1024ull;
+    constexpr std::uint64_t HISTOGRAM_BINS = 64 * 1024;
+    const std::uint64_t num_vertices = mesh.positions.size();
+    const std::uint64_t num_corners = mesh.numberOfTriangles() * 3;
+    if (0 == num_vertices || 0 == num_corners) {
+        return 0;
+    }
+    const auto forEachEdge = [&mesh, num_corners](auto&& func) {
+        for (std::uint64_t corner = 0; corner < num_corners; ++corner) {
+            const std::uint64_t a = mesh.indices[corner];
+            const std::uint64_t b = mesh.indices[corner - corner % 3 + (corner + 1) % 3];
+            if (a != b) {
+                func(std::min(a, b), std::max(a, b));
+            }
+        }
+    };
+    //every edge is keyed by its smaller vertex, the vertex range is split into parts whose keys fit the budget
+    const std::uint64_t bin_width = num_vertices / HISTOGRAM_BINS + 1;
+    std::vector<std::uint64_t> histogram(HISTOGRAM_BINS, 0);
+    forEachEdge([&histogram, bin_width](std::uint64_t low, std::uint64_t) { ++histogram[low / bin_width]; });
+
+    std::uint64_t num_edges = 0;
+    std::vector<std::uint64_t> keys;
+    for (std::uint64_t first_bin = 0; first_bin < HISTOGRAM_BINS;) {
+        auto end_bin = first_bin;
+        std::uint64_t part_size = 0;
+        while (end_bin < HISTOGRAM_BINS && (end_bin == first_bin || part_size + histogram[end_bin] <= EDGE_BUDGET)) {
+            part_size += histogram[end_bin++];
+        }
+        if (part_size > 0) {
+            const auto first_vertex = first_bin * bin_width;
+            const auto end_vertex = end_bin * bin_width;
+            keys.clear();
+            keys.reserve(static_cast<std::size_t>(part_size));
+            forEachEdge([&keys, first_vertex, end_vertex](std::uint64_t low, std::uint64_t high) {
+                if (low >= first_vertex && low < end_vertex) {
+                    keys.push_back((low << 32) | high);
+                }
+            });
+            std::sort(keys.begin(), keys.end());
+            num_edges += static_cast<std::uint64_t>(std::unique(keys.begin(), keys.end()) - keys.begin());
+        }
+        first_bin = end_bin;
+    }
+    return num_edges;
+}
+
+bool MESH_API::buildTriangleSoup(const IndexedMesh& mesh, MappedArray<Vertex>& soup)
+{
+    if (!soup.allocate(mesh.indices.size())) {
+        return false;
+    }
+    for (std::uint64_t i = 0; i < mesh.indices.size(); ++i) {
+        const auto index = mesh.indices[i];
+        auto& custom_vertex = soup[i];
+        custom_vertex.position = mesh.positions[index];
+        custom_vertex.normal = mesh.normals[index];
+        custom_vertex.texture = { 0, 0 };
+    }
+    return true;
+}
+
+void MESH_API::computeBounds(const MappedArray<Vertex>& soup, QVector3D& minBounds, QVector3D& maxBounds)
+{
+    minBounds = QVector3D(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+    maxBounds = QVector3D(-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max());
+    for (const auto& vertex : soup) {
+        minBounds.setX(std::min(minBounds.x(), vertex.position.x()));
+        minBounds.setY(std::min(minBounds.y(), vertex.position.y()));
+        minBounds.setZ(std::min(minBounds.z(), vertex.position.z()));
+
+        maxBounds.setX(std::max(maxBounds.x(), vertex.position.x()));
+        maxBounds.setY(std::max(maxBounds.y(), vertex.position.y()));
+        maxBounds.setZ(std::max(maxBounds.z(), vertex.position.z()));
+    }
+}
+
+bool MESH_API::buildClusteredProxy(const MappedArray<Vertex>& soup, const QVector3D& minBounds, const QVector3D& maxBounds,
+    std::uint64_t triangleBudget, MappedArray<Vertex>& proxy)
+{
+    //a closed surface crosses about 6 * r^2 cells of an r^3 grid, two triangles per cell
+    constexpr std::uint64_t MAX_RESOLUTION = (1ull << 21) - 1;
+    const auto resolution = std::min(MAX_RESOLUTION, std::max<std::uint64_t>(2,
+        static_cast<std::uint64_t>(std::sqrt(static_cast<double>(triangleBudget) / 12.0))));
+    const auto extent = maxBounds - minBounds;
+    const float largest = std::max({ extent.x(), extent.y(), extent.z() });
+    if (soup.size() < 3 || !(largest > 0.0f)) {
+        return false;
+    }
+    const float scale = static_cast<float>(resolution) / largest;
+    const auto cellKey = [&](const QVector3D& position) {
+        const auto local = (position - minBounds) * scale;
+        const auto x = std::min<std::uint64_t>(resolution, static_cast<std::uint64_t>(std::max(0.0f, local.x())));
+        const auto y = std::min<std::uint64_t>(resolution, static_cast<std::uint64_t>(std::max(0.0f, local.y())));
+        const auto z = std::min<std::uint64_t>(resolution, static_cast<std::uint64_t>(std::max(0.0f, local.z())));
+        return (x << 42) | (y << 21) | z;
+    };
+
+    std::unordered_map<std::uint64_t, std::uint32_t> cells;
+    cells.reserve(static_cast<std::size_t>(triangleBudget));
+    //accumulated position and normal of the corners falling into the cell
+    std::vector<Vertex> representatives;
+    std::vector<std::uint32_t> counts;
+    std::vector<std::array<std::uint32_t, 3>> triangles;
+    triangles.reserve(static_cast<std::size_t>(triangleBudget));
+    for (std::uint64_t t = 0; t + 2 < soup.size(); t += 3) {
+        std::array<std::uint32_t, 3> corners;
+        for (int c = 0; c < 3; ++c) {
+            const auto& vertex = soup[t + c];
+            const auto inserted = cells.emplace(cellKey(vertex.position), static_cast<std::uint32_t>(representatives.size()));
+            if (inserted.second) {
+                representatives.push_back({ QVector3D(), QVector3D(), QVector2D() });
+                counts.push_back(0);
+            }
+            const auto cell = inserted.first->second;
+            representatives[cell].position += vertex.position;
+            representatives[cell].normal += vertex.normal;
+            ++counts[cell];
+            corners[c] = cell;
+        }
+        if (corners[0] == corners[1] || corners[1] == corners[2] || corners[0] == corners[2]) {
+            continue;
+        }
+        //smallest index first keeps the winding and makes duplicates equal
+        std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end()), corners.end());
+        triangles.push_back(corners);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    triangles.erase(std::unique(triangles.begin(), triangles.end()), triangles.end());
+    for (std::size_t i = 0; i < representatives.size(); ++i) {
+        representatives[i].position /= static_cast<float>(counts[i]);
+        representatives[i].normal.normalize();
+    }
+
+    if (!proxy.allocate(triangles.size() * 3)) {
+        return false;
+    }
+    for (std::size_t t = 0; t < triangles.size(); ++t) {
+        for (int c = 0; c < 3; ++c) {
+            proxy[t * 3 + c] = representatives[triangles[t][c]];
+        }
+    }
+    return true;
+}
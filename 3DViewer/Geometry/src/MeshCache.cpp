@@ -0,0 +1,128 @@
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <cstring>
+
+#include "MeshCache.h"
+
+namespace {
+    constexpr char CACHE_MAGIC[8] = { '3', 'D', 'V', 'C', 'A', 'C', 'H', '\0' };
+    constexpr std::uint64_t BLOB_ALIGNMENT = 4096;
+    constexpr qint64 WRITE_BLOCK_SIZE = 64 * 1024 * 1024;
+
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t vertexSize;
+        std::uint64_t numVertices;
+        std::uint64_t numFaces;
+        std::uint64_t numEdges;
+        float minBounds[3];
+        float maxBounds[3];
+        std::uint64_t sourceSize;
+        std::int64_t sourceModified;
+        std::uint64_t vertexOffset;
+        std::uint64_t vertexCount;
+        // UTF-8 path of the source right after the header
+        std::uint64_t sourcePathSize;
+    };
+}
+
+bool CACHE_API::writeMeshCache(const QString& path, const CachedMesh& mesh)
+{
+    return writeMeshCache(path, mesh, mesh.vertices);
+}
+
+bool CACHE_API::writeMeshCache(const QString& path, const CachedMesh& mesh, const MappedArray<Vertex>& vertices)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCritical() << "Critical: cannot open cache file " << path;
+        return false;
+    }
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.vertexSize = sizeof(Vertex);
+    header.numVertices = mesh.num_vertices;
+    header.numFaces = mesh.num_faces;
+    header.numEdges = mesh.num_edges;
+    for (int i = 0; i < 3; ++i) {
+        header.minBounds[i] = mesh.minBounds[i];
+        header.maxBounds[i] = mesh.maxBounds[i];
+    }
+    header.sourceSize = mesh.sourceSize;
+    header.sourceModified = mesh.sourceModified;
+    const auto source_path = mesh.sourcePath.toUtf8();
+    header.sourcePathSize = static_cast<std::uint64_t>(source_path.size());
+    //page aligned blob can be mapped and uploaded directly
+    header.vertexOffset = (sizeof(header) + header.sourcePathSize + BLOB_ALIGNMENT - 1) / BLOB_ALIGNMENT * BLOB_ALIGNMENT;
+    header.vertexCount = vertices.size();
+
+    const QByteArray padding(static_cast<int>(header.vertexOffset - sizeof(header) - header.sourcePathSize), '\0');
+    bool written = file.write(reinterpret_cast<const char*>(&header), sizeof(header)) == sizeof(header) &&
+        file.write(source_path) == source_path.size() && file.write(padding) == padding.size();
+    auto data = reinterpret_cast<const char*>(vertices.data());
+    auto size = vertices.sizeInBytes();
+    while (written && size > 0) {
+        const auto block = std::min<std::uint64_t>(size, WRITE_BLOCK_SIZE);
+        written = file.write(data, static_cast<qint64>(block)) == static_cast<qint64>(block);
+        data += block;
+        size -= block;
+    }
+    if (!written || !file.commit()) {
+        qCritical() << "Critical: cannot write cache file " << path;
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<CachedMesh> CACHE_API::readMeshCache(const QString& path)
+{
+    auto file = std::make_shared<QFile>(path);
+    if (!file->open(QIODevice::ReadOnly) || file->size() < static_cast<qint64>(sizeof(Header))) {
+        qCritical() << "Critical: cannot open cache file " << path;
+        return nullptr;
+    }
+    const auto file_size = static_cast<std::uint64_t>(file->size());
+    uchar* data = file->map(0, file->size(), QFileDevice::MapPrivateOption);
+    if (nullptr == data) {
+        qCritical() << "Critical: cannot map cache file " << path;
+        return nullptr;
+    }
+    Header header;
+    std::memcpy(&header, data, sizeof(header));
+    if (0 != std::memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) || VERSION != header.version ||
+        sizeof(Vertex) != header.vertexSize || header.vertexOffset > file_size || header.vertexOffset < sizeof(header) ||
+        header.sourcePathSize > header.vertexOffset - sizeof(header) ||
+        header.vertexCount > (file_size - header.vertexOffset) / sizeof(Vertex)) {
+        qCritical() << "Critical: " << path << " is not a compatible cache file.";
+        return nullptr;
+    }
+    auto mesh = std::make_unique<CachedMesh>();
+    mesh->vertices = MappedArray<Vertex>(file, reinterpret_cast<Vertex*>(data + header.vertexOffset), header.vertexCount);
+    mesh->num_vertices = header.numVertices;
+    mesh->num_faces = header.numFaces;
+    mesh->num_edges = header.numEdges;
+    mesh->minBounds = QVector3D(header.minBounds[0], header.minBounds[1], header.minBounds[2]);
+    mesh->maxBounds = QVector3D(header.maxBounds[0], header.maxBounds[1], header.maxBounds[2]);
+    mesh->sourcePath = QString::fromUtf8(reinterpret_cast<const char*>(data + sizeof(header)), static_cast<int>(header.sourcePathSize));
+    mesh->sourceSize = header.sourceSize;
+    mesh->sourceModified = header.sourceModified;
+    return mesh;
+}
+
+bool CACHE_API::isSourceChanged(const CachedMesh& mesh)
+{
+    //a cache whose model is gone is all there is left of it
+    const QFileInfo source(mesh.sourcePath);
+    if (mesh.sourcePath.isEmpty() || !source.exists()) {
+        return false;
+    }
+    return static_cast<std::uint64_t>(source.size()) != mesh.sourceSize ||
+        source.lastModified().toMSecsSinceEpoch() != mesh.sourceModified;
+}
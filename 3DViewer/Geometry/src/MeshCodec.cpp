@@ -0,0 +1,467 @@
+#include <QDebug>
+#include <QSaveFile>
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include "MeshCodec.h"
+#include "JobSystem.h"
+
+namespace {
+    constexpr char CODEC_MAGIC[8] = { '3', 'D', 'V', 'Z', 'M', 'S', 'H', '\0' };
+    constexpr std::uint32_t FLAG_TEXTURE = 1;
+    constexpr float QUANTIZATION_MAX = 65535.0f;
+
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t flags;
+        std::uint64_t numVertices;
+        std::uint64_t numFaces;
+        std::uint64_t numEdges;
+        float minBounds[3];
+        float maxBounds[3];
+        std::uint64_t soupVertexCount;
+        std::uint32_t chunkCount;
+        std::uint32_t chunkTriangles;
+    };
+
+    struct ChunkEntry {
+        std::uint64_t offset;
+        std::uint32_t compressedSize;
+        std::uint32_t triangleCount;
+        std::uint32_t vertexCount;
+        std::uint32_t reserved;
+    };
+
+    // vertex as stored, equal vertices of a chunk are welded after the quantisation
+    struct QuantizedVertex {
+        std::uint32_t texture[2];
+        std::uint16_t position[3];
+        std::uint16_t normal[2];
+        std::uint16_t unused;
+
+        bool operator==(const QuantizedVertex& other) const {
+            return 0 == std::memcmp(this, &other, sizeof(QuantizedVertex));
+        }
+    };
+    static_assert(sizeof(QuantizedVertex) == 20, "QuantizedVertex must not have padding");
+
+    struct QuantizedVertexHash {
+        std::size_t operator()(const QuantizedVertex& vertex) const {
+            std::uint64_t hash = 1469598103934665603ull;
+            const auto bytes = reinterpret_cast<const unsigned char*>(&vertex);
+            for (std::size_t i = 0; i < sizeof(QuantizedVertex); ++i) {
+                hash = (hash ^ bytes[i]) * 1099511628211ull;
+            }
+            return static_cast<std::size_t>(hash);
+        }
+    };
+
+    struct Quantization {
+        QVector3D minBounds;
+        QVector3D maxBounds;
+        float scale[3];
+        float step[3];
+
+        Quantization(const QVector3D& min, const QVector3D& max) : minBounds(min), maxBounds(max) {
+            for (int i = 0; i < 3; ++i) {
+                const float extent = max[i] - min[i];
+                scale[i] = extent > 0.0f ? QUANTIZATION_MAX / extent : 0.0f;
+                step[i] = extent > 0.0f ? extent / QUANTIZATION_MAX : 0.0f;
+            }
+        }
+    };
+
+    inline std::uint16_t quantizeUnit(float value) {
+        //[-1, 1] into the whole 16-bit range
+        const float clamped = std::max(-1.0f, std::min(1.0f, value));
+        return static_cast<std::uint16_t>(std::lround((clamped * 0.5f + 0.5f) * QUANTIZATION_MAX));
+    }
+
+    inline float dequantizeUnit(std::uint16_t value) {
+        return static_cast<float>(value) / QUANTIZATION_MAX * 2.0f - 1.0f;
+    }
+
+    inline float signNotZero(float value) {
+        return value >= 0.0f ? 1.0f : -1.0f;
+    }
+
+    QuantizedVertex quantize(const Vertex& vertex, const Quantization& quantization, bool hasTexture) {
+        QuantizedVertex result;
+        std::memset(&result, 0, sizeof(result));
+        for (int i = 0; i < 3; ++i) {
+            const float value = (vertex.position[i] - quantization.minBounds[i]) * quantization.scale[i];
+            result.position[i] = static_cast<std::uint16_t>(std::lround(std::max(0.0f, std::min(QUANTIZATION_MAX, value))));
+        }
+        //octahedral mapping, the lower hemisphere is folded over the diagonals
+        const auto& normal = vertex.normal;
+        const float length = std::abs(normal.x()) + std::abs(normal.y()) + std::abs(normal.z());
+        float u = length > 0.0f ? normal.x() / length : 0.0f;
+        float v = length > 0.0f ? normal.y() / length : 0.0f;
+        if (length > 0.0f && normal.z() < 0.0f) {
+            const float folded_u = (1.0f - std::abs(v)) * signNotZero(u);
+            v = (1.0f - std::abs(u)) * signNotZero(v);
+            u = folded_u;
+        }
+        result.normal[0] = quantizeUnit(u);
+        result.normal[1] = quantizeUnit(v);
+        if (hasTexture) {
+            const float texture[2] = { vertex.texture.x(), vertex.texture.y() };
+            std::memcpy(result.texture, texture, sizeof(texture));
+        }
+        return result;
+    }
+
+    Vertex dequantize(const QuantizedVertex& vertex, const Quantization& quantization) {
+        Vertex result;
+        result.position = QVector3D(
+            quantization.minBounds.x() + vertex.position[0] * quantization.step[0],
+            quantization.minBounds.y() + vertex.position[1] * quantization.step[1],
+            quantization.minBounds.z() + vertex.position[2] * quantization.step[2]);
+        float u = dequantizeUnit(vertex.normal[0]);
+        float v = dequantizeUnit(vertex.normal[1]);
+        const float z = 1.0f - std::abs(u) - std::abs(v);
+        if (z < 0.0f) {
+            const float unfolded_u = (1.0f - std::abs(v)) * signNotZero(u);
+            v = (1.0f - std::abs(u)) * signNotZero(v);
+            u = unfolded_u;
+        }
+        result.normal = QVector3D(u, v, z).normalized();
+        float texture[2];
+        std::memcpy(texture, vertex.texture, sizeof(texture));
+        result.texture = QVector2D(texture[0], texture[1]);
+        return result;
+    }
+
+    inline std::uint32_t zigzag(std::int32_t value) {
+        return (static_cast<std::uint32_t>(value) << 1) ^ static_cast<std::uint32_t>(value >> 31);
+    }
+
+    inline std::int32_t unzigzag(std::uint32_t value) {
+        return static_cast<std::int32_t>(value >> 1) ^ -static_cast<std::int32_t>(value & 1);
+    }
+
+    inline void writeVarint(std::vector<uchar>& out, std::uint32_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uchar>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uchar>(value));
+    }
+
+    class StreamReader {
+    public:
+        StreamReader(const uchar* data, std::uint64_t size) : m_data(data), m_end(data + size) {}
+
+        inline bool readVarint(std::uint32_t& value) {
+            value = 0;
+            for (int shift = 0; shift < 35; shift += 7) {
+                if (m_data == m_end) {
+                    return false;
+                }
+                const uchar byte = *m_data++;
+                value |= static_cast<std::uint32_t>(byte & 0x7f) << shift;
+                if (0 == (byte & 0x80)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        inline bool readRaw(void* out, std::uint64_t size) {
+            if (static_cast<std::uint64_t>(m_end - m_data) < size) {
+                return false;
+            }
+            std::memcpy(out, m_data, size);
+            m_data += size;
+            return true;
+        }
+        inline bool atEnd() const { return m_data == m_end; }
+
+    private:
+        const uchar* m_data;
+        const uchar* m_end;
+    };
+
+    // vertex stream first: position deltas, normal deltas, raw textures, then the indices
+    QByteArray encodeChunk(const Vertex* corners, std::uint64_t triangles, const Quantization& quantization,
+        bool hasTexture, std::uint32_t& vertexCount)
+    {
+        const auto corner_count = triangles * 3;
+        std::unordered_map<QuantizedVertex, std::uint32_t, QuantizedVertexHash> welded;
+        welded.reserve(static_cast<std::size_t>(corner_count));
+        std::vector<QuantizedVertex> unique;
+        unique.reserve(static_cast<std::size_t>(corner_count));
+        std::vector<std::uint32_t> codes;
+        codes.reserve(static_cast<std::size_t>(corner_count));
+        for (std::uint64_t i = 0; i < corner_count; ++i) {
+            const auto vertex = quantize(corners[i], quantization, hasTexture);
+            const auto next = static_cast<std::uint32_t>(unique.size());
+            const auto inserted = welded.emplace(vertex, next);
+            if (inserted.second) {
+                //vertices are numbered by first use, a new one is always the next
+                unique.push_back(vertex);
+                codes.push_back(0);
+            }
+            else {
+                codes.push_back(next - inserted.first->second);
+            }
+        }
+        vertexCount = static_cast<std::uint32_t>(unique.size());
+
+        std::vector<uchar> stream;
+        stream.reserve(static_cast<std::size_t>(unique.size() * 8 + corner_count * 2));
+        QuantizedVertex previous;
+        std::memset(&previous, 0, sizeof(previous));
+        for (const auto& vertex : unique) {
+            for (int i = 0; i < 3; ++i) {
+                writeVarint(stream, zigzag(static_cast<std::int32_t>(vertex.position[i]) - previous.position[i]));
+            }
+            previous = vertex;
+        }
+        std::memset(&previous, 0, sizeof(previous));
+        for (const auto& vertex : unique) {
+            for (int i = 0; i < 2; ++i) {
+                writeVarint(stream, zigzag(static_cast<std::int32_t>(vertex.normal[i]) - previous.normal[i]));
+            }
+            previous = vertex;
+        }
+        if (hasTexture) {
+            for (const auto& vertex : unique) {
+                const auto bytes = reinterpret_cast<const uchar*>(vertex.texture);
+                stream.insert(stream.end(), bytes, bytes + sizeof(vertex.texture));
+            }
+        }
+        for (const auto code : codes) {
+            writeVarint(stream, code);
+        }
+        return qCompress(stream.data(), static_cast<int>(stream.size()));
+    }
+
+    bool decodeChunk(const uchar* data, const ChunkEntry& entry, const Quantization& quantization,
+        bool hasTexture, Vertex* corners)
+    {
+        const auto raw = qUncompress(data, static_cast<int>(entry.compressedSize));
+        StreamReader reader(reinterpret_cast<const uchar*>(raw.constData()), static_cast<std::uint64_t>(raw.size()));
+        std::vector<QuantizedVertex> quantized(entry.vertexCount);
+        QuantizedVertex previous;
+        std::memset(&previous, 0, sizeof(previous));
+        for (auto& vertex : quantized) {
+            std::memset(&vertex, 0, sizeof(vertex));
+            for (int i = 0; i < 3; ++i) {
+                std::uint32_t delta = 0;
+                if (!reader.readVarint(delta)) {
+                    return false;
+                }
+                vertex.position[i] = static_cast<std::uint16_t>(previous.position[i] + unzigzag(delta));
+            }
+            previous = vertex;
+        }
+        std::memset(&previous, 0, sizeof(previous));
+        for (auto& vertex : quantized) {
+            for (int i = 0; i < 2; ++i) {
+                std::uint32_t delta = 0;
+                if (!reader.readVarint(delta)) {
+                    return false;
+                }
+                vertex.normal[i] = static_cast<std::uint16_t>(previous.normal[i] + unzigzag(delta));
+            }
+            previous = vertex;
+        }
+        if (hasTexture) {
+            for (auto& vertex : quantized) {
+                if (!reader.readRaw(vertex.texture, sizeof(vertex.texture))) {
+                    return false;
+                }
+            }
+        }
+        std::vector<Vertex> vertices(quantized.size());
+        for (std::size_t i = 0; i < quantized.size(); ++i) {
+            vertices[i] = dequantize(quantized[i], quantization);
+        }
+        std::uint32_t next = 0;
+        const std::uint64_t corner_count = static_cast<std::uint64_t>(entry.triangleCount) * 3;
+        for (std::uint64_t i = 0; i < corner_count; ++i) {
+            std::uint32_t code = 0;
+            if (!reader.readVarint(code) || code > next || (0 == code && next >= entry.vertexCount)) {
+                return false;
+            }
+            corners[i] = vertices[0 == code ? next++ : next - code];
+        }
+        return reader.atEnd();
+    }
+}
+
+bool CODEC_API::writeCompressedMesh(const QString& path, const MappedArray<Vertex>& soup,
+    std::uint64_t num_vertices, std::uint64_t num_faces, std::uint64_t num_edges)
+{
+    if (0 != soup.size() % 3) {
+        qCritical() << "Critical: cannot compress " << path << ", the vertices are not a triangle soup.";
+        return false;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    const std::uint64_t triangles = soup.size() / 3;
+    const std::uint64_t chunk_count = (triangles + CHUNK_TRIANGLES - 1) / CHUNK_TRIANGLES;
+
+    //the bounds of the soup itself, so the quantisation never clamps
+    QVector3D min_bounds(0.0f, 0.0f, 0.0f);
+    QVector3D max_bounds(0.0f, 0.0f, 0.0f);
+    bool has_texture = false;
+    if (!soup.isEmpty()) {
+        min_bounds = max_bounds = soup[0].position;
+    }
+    for (const auto& vertex : soup) {
+        for (int i = 0; i < 3; ++i) {
+            min_bounds[i] = std::min(min_bounds[i], vertex.position[i]);
+            max_bounds[i] = std::max(max_bounds[i], vertex.position[i]);
+        }
+        has_texture = has_texture || !vertex.texture.isNull();
+    }
+    const Quantization quantization(min_bounds, max_bounds);
+
+    std::vector<QByteArray> encoded(static_cast<std::size_t>(chunk_count));
+    std::vector<ChunkEntry> entries(static_cast<std::size_t>(chunk_count));
+    std::atomic<bool> failed{ false };
+    JobSystem::instance().parallelFor(chunk_count, 1, [&](std::uint64_t begin, std::uint64_t end) {
+        for (auto i = begin; i < end; ++i) {
+            const auto first = i * CHUNK_TRIANGLES;
+            const auto count = std::min<std::uint64_t>(CHUNK_TRIANGLES, triangles - first);
+            auto& entry = entries[static_cast<std::size_t>(i)];
+            std::memset(&entry, 0, sizeof(entry));
+            entry.triangleCount = static_cast<std::uint32_t>(count);
+            encoded[static_cast<std::size_t>(i)] = encodeChunk(soup.data() + first * 3, count, quantization, has_texture, entry.vertexCount);
+            if (encoded[static_cast<std::size_t>(i)].isEmpty()) {
+                failed.store(true);
+            }
+        }
+    });
+    if (failed.load() || JobSystem::cancellationRequested()) {
+        qCritical() << "Critical: cannot compress " << path;
+        return false;
+    }
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, CODEC_MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.flags = has_texture ? FLAG_TEXTURE : 0;
+    header.numVertices = num_vertices;
+    header.numFaces = num_faces;
+    header.numEdges = num_edges;
+    for (int i = 0; i < 3; ++i) {
+        header.minBounds[i] = min_bounds[i];
+        header.maxBounds[i] = max_bounds[i];
+    }
+    header.soupVertexCount = soup.size();
+    header.chunkCount = static_cast<std::uint32_t>(chunk_count);
+    header.chunkTriangles = CHUNK_TRIANGLES;
+    std::uint64_t offset = sizeof(Header) + chunk_count * sizeof(ChunkEntry);
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        entries[i].offset = offset;
+        entries[i].compressedSize = static_cast<std::uint32_t>(encoded[i].size());
+        offset += entries[i].compressedSize;
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCritical() << "Critical: cannot open compressed mesh file " << path;
+        return false;
+    }
+    const auto table_size = static_cast<qint64>(entries.size() * sizeof(ChunkEntry));
+    bool written = file.write(reinterpret_cast<const char*>(&header), sizeof(header)) == sizeof(header) &&
+        file.write(reinterpret_cast<const char*>(entries.data()), table_size) == table_size;
+    for (std::size_t i = 0; written && i < encoded.size(); ++i) {
+        written = file.write(encoded[i]) == encoded[i].size();
+    }
+    if (!written || !file.commit()) {
+        qCritical() << "Critical: cannot write compressed mesh file " << path;
+        return false;
+    }
+    qDebug() << "Message: compressing" << path << "took" <<
+        static_cast<double>(timer.nsecsElapsed()) / 1000000000.0 << "sec," << soup.sizeInBytes() << "->" << offset << "bytes";
+    return true;
+}
+
+std::unique_ptr<CachedMesh> CODEC_API::readCompressedMesh(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || file.size() < static_cast<qint64>(sizeof(Header))) {
+        qCritical() << "Critical: cannot open compressed mesh file " << path;
+        return nullptr;
+    }
+    //the chunks are read once, a private mapping avoids copying them into a buffer
+    uchar* data = file.map(0, file.size(), QFileDevice::MapPrivateOption);
+    if (nullptr == data) {
+        qCritical() << "Critical: cannot map compressed mesh file " << path;
+        return nullptr;
+    }
+    auto mesh = decodeCompressedMesh(data, static_cast<std::uint64_t>(file.size()));
+    file.unmap(data);
+    if (nullptr == mesh) {
+        qCritical() << "Critical: " << path << " is not a valid compressed mesh file.";
+    }
+    return mesh;
+}
+
+std::unique_ptr<CachedMesh> CODEC_API::decodeCompressedMesh(const uchar* data, std::uint64_t size)
+{
+    if (size < sizeof(Header)) {
+        return nullptr;
+    }
+    Header header;
+    std::memcpy(&header, data, sizeof(header));
+    if (0 != std::memcmp(header.magic, CODEC_MAGIC, sizeof(header.magic)) || VERSION != header.version ||
+        0 == header.chunkTriangles ||
+        header.chunkCount > (size - sizeof(Header)) / sizeof(ChunkEntry)) {
+        return nullptr;
+    }
+    std::vector<ChunkEntry> entries(header.chunkCount);
+    std::memcpy(entries.data(), data + sizeof(Header), entries.size() * sizeof(ChunkEntry));
+    //every chunk writes its own range of the soup
+    std::vector<std::uint64_t> first_corners(entries.size());
+    std::uint64_t corners = 0;
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        const auto& entry = entries[i];
+        if (entry.offset > size || entry.compressedSize > size - entry.offset ||
+            entry.triangleCount > header.chunkTriangles || entry.vertexCount > entry.triangleCount * 3ull) {
+            return nullptr;
+        }
+        first_corners[i] = corners;
+        corners += static_cast<std::uint64_t>(entry.triangleCount) * 3;
+    }
+    if (corners != header.soupVertexCount) {
+        return nullptr;
+    }
+
+    auto mesh = std::make_unique<CachedMesh>();
+    if (!mesh->vertices.allocate(corners)) {
+        return nullptr;
+    }
+    mesh->minBounds = QVector3D(header.minBounds[0], header.minBounds[1], header.minBounds[2]);
+    mesh->maxBounds = QVector3D(header.maxBounds[0], header.maxBounds[1], header.maxBounds[2]);
+    const Quantization quantization(mesh->minBounds, mesh->maxBounds);
+    const bool has_texture = 0 != (header.flags & FLAG_TEXTURE);
+    std::atomic<bool> failed{ false };
+    JobSystem::instance().parallelFor(entries.size(), 1, [&](std::uint64_t begin, std::uint64_t end) {
+        for (auto i = begin; i < end && !failed.load(std::memory_order_relaxed); ++i) {
+            const auto& entry = entries[static_cast<std::size_t>(i)];
+            if (!decodeChunk(data + entry.offset, entry, quantization, has_texture,
+                mesh->vertices.data() + first_corners[static_cast<std::size_t>(i)])) {
+                failed.store(true);
+            }
+        }
+    });
+    if (failed.load() || JobSystem::cancellationRequested()) {
+        return nullptr;
+    }
+    mesh->num_vertices = header.numVertices;
+    mesh->num_faces = header.numFaces;
+    mesh->num_edges = header.numEdges;
+    return mesh;
+}
@@ -0,0 +1,500 @@
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+
+#include "MeshExporter.h"
+#include "JobSystem.h"
+#include "MemoryTracker.h"
+
+namespace {
+    //shortest round trip form of a float, e.g. -1.1754944e-38, with room to spare
+    constexpr std::size_t MAX_FLOAT_CHARS = 24;
+    constexpr std::size_t MAX_INDEX_CHARS = 20;
+    constexpr std::size_t STL_HEADER_SIZE = 80;
+    constexpr std::size_t STL_TRIANGLE_SIZE = 50;
+    //three floats of the position and three of the normal
+    constexpr std::size_t PLY_VERTEX_SIZE = 24;
+    //corner count followed by three indices
+    constexpr std::size_t PLY_FACE_SIZE = 13;
+    //faces of a part without materials, not defined in the library so they get the scene material again
+    const QByteArray DEFAULT_MATERIAL("default");
+
+    struct Chunk {
+        std::size_t part = 0;
+        std::uint64_t firstTriangle = 0;
+        std::uint64_t triangleCount = 0;
+        //index of the first corner over all the parts
+        std::uint64_t firstCorner = 0;
+    };
+
+    //allocated once for the worst case chunk, the appends only move the cursor
+    class ChunkBuffer {
+    public:
+        void allocate(std::size_t capacity) {
+            m_data = std::make_unique<char[]>(capacity);
+            m_size = 0;
+        }
+        inline void clear() { m_size = 0; }
+        inline const char* data() const { return m_data.get(); }
+        inline std::size_t size() const { return m_size; }
+
+        inline void append(const char* text, std::size_t length) {
+            std::memcpy(m_data.get() + m_size, text, length);
+            m_size += length;
+        }
+        inline void append(char c) {
+            m_data[m_size++] = c;
+        }
+        inline void appendFloat(float value) {
+            char* begin = m_data.get() + m_size;
+            m_size += static_cast<std::size_t>(std::to_chars(begin, begin + MAX_FLOAT_CHARS, value).ptr - begin);
+        }
+        inline void appendIndex(std::uint64_t value) {
+            char* begin = m_data.get() + m_size;
+            m_size += static_cast<std::size_t>(std::to_chars(begin, begin + MAX_INDEX_CHARS, value).ptr - begin);
+        }
+        template <typename T>
+        inline void appendLittleEndian(T value) {
+            qToLittleEndian(value, m_data.get() + m_size);
+            m_size += sizeof(T);
+        }
+        inline void appendLittleEndian(float value) {
+            quint32 bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            appendLittleEndian(bits);
+        }
+
+    private:
+        std::unique_ptr<char[]> m_data;
+        std::size_t m_size = 0;
+    };
+
+    using ChunkCapacity = std::function<std::size_t(const Chunk&)>;
+    using ChunkFormatter = std::function<void(const Chunk&, ChunkBuffer&)>;
+
+    std::vector<Chunk> splitChunks(const std::vector<ExportPart>& parts)
+    {
+        std::vector<Chunk> chunks;
+        std::uint64_t corner = 0;
+        for (std::size_t part = 0; part < parts.size(); ++part) {
+            const auto triangles = parts[part].soup->size() / 3;
+            for (std::uint64_t first = 0; first < triangles; first += EXPORT_API::CHUNK_TRIANGLES) {
+                Chunk chunk;
+                chunk.part = part;
+                chunk.firstTriangle = first;
+                chunk.triangleCount = std::min(EXPORT_API::CHUNK_TRIANGLES, triangles - first);
+                chunk.firstCorner = corner + first * 3;
+                chunks.push_back(chunk);
+            }
+            corner += triangles * 3;
+        }
+        return chunks;
+    }
+
+    //a batch of chunks is formatted in parallel while the previous one is written by another job,
+    //the two batches share a fixed pool of buffers sized for the biggest chunk
+    bool writeChunks(QIODevice& file, const std::vector<Chunk>& chunks, const ChunkCapacity& capacity, const ChunkFormatter& format)
+    {
+        std::size_t buffer_size = 1;
+        for (const auto& chunk : chunks) {
+            buffer_size = std::max(buffer_size, capacity(chunk));
+        }
+        constexpr std::uint64_t batch_size = EXPORT_API::BUFFER_POOL_SIZE / 2;
+        std::vector<ChunkBuffer> buffers(EXPORT_API::BUFFER_POOL_SIZE);
+        for (auto& buffer : buffers) {
+            buffer.allocate(buffer_size);
+        }
+        const auto pool_bytes = static_cast<std::int64_t>(buffer_size * buffers.size());
+        MemoryTracker::LoadScope::add(pool_bytes);
+        std::atomic<bool> written{ true };
+        JobSystem::JobHandle writing;
+        bool cancelled = false;
+        for (std::uint64_t first = 0; first < chunks.size(); first += batch_size) {
+            const auto count = std::min<std::uint64_t>(batch_size, chunks.size() - first);
+            //the buffers of this batch were written two batches ago, that write was waited for
+            ChunkBuffer* batch = buffers.data() + ((first / batch_size) % 2) * batch_size;
+            JobSystem::instance().parallelFor(count, 1, [&](std::uint64_t begin, std::uint64_t end) {
+                for (auto i = begin; i < end; ++i) {
+                    batch[i].clear();
+                    format(chunks[first + i], batch[i]);
+                }
+            });
+            if (nullptr != writing) {
+                JobSystem::instance().wait(writing);
+            }
+            if (!written || JobSystem::cancellationRequested()) {
+                cancelled = true;
+                writing = nullptr;
+                break;
+            }
+            writing = JobSystem::instance().submit([&file, batch, &written, count]() {
+                for (std::uint64_t i = 0; i < count && written; ++i) {
+                    const auto size = static_cast<qint64>(batch[i].size());
+                    written = file.write(batch[i].data(), size) == size;
+                }
+            });
+        }
+        if (nullptr != writing) {
+            JobSystem::instance().wait(writing);
+        }
+        MemoryTracker::LoadScope::add(-pool_bytes);
+        return !cancelled && written;
+    }
+
+    void bakeChunk(const ExportPart& part, const Chunk& chunk, std::vector<Vertex>& baked)
+    {
+        baked.resize(chunk.triangleCount * 3);
+        EXPORT_API::bakeTransform(part.soup->data() + chunk.firstTriangle * 3, baked.size(), part.model, baked.data());
+    }
+
+    bool hasMaterials(const ExportPart& part)
+    {
+        return nullptr != part.materials && !part.materials->empty() && nullptr != part.materialRanges;
+    }
+
+    //the materials of every part are renamed after it, so parts loaded from different files never clash
+    QByteArray materialName(std::size_t part, const SurfaceMaterial& material)
+    {
+        return QString("p%1_%2").arg(part).arg(material.name).toUtf8();
+    }
+
+    //the maps relative to the library, which is written next to the model
+    bool writeMaterialLibrary(const QString& path, const std::vector<ExportPart>& parts)
+    {
+        const auto directory = QFileInfo(path).absoluteDir();
+        QByteArray library("# 3DViewer export\n");
+        for (std::size_t part = 0; part < parts.size(); ++part) {
+            if (!hasMaterials(parts[part])) {
+                continue;
+            }
+            for (const auto& material : *parts[part].materials) {
+                library += "newmtl " + materialName(part, material) + "\n";
+                library += "Kd " + QByteArray::number(material.diffuse.x()) + " " + QByteArray::number(material.diffuse.y()) +
+                    " " + QByteArray::number(material.diffuse.z()) + "\n";
+                if (!material.diffuseMap.isEmpty()) {
+                    library += "map_Kd " + directory.relativeFilePath(material.diffuseMap).toUtf8() + "\n";
+                }
+                if (!material.normalMap.isEmpty()) {
+                    library += "norm " + directory.relativeFilePath(material.normalMap).toUtf8() + "\n";
+                }
+                if (!material.bumpMap.isEmpty()) {
+                    library += "map_Bump -bm " + QByteArray::number(material.bumpScale) + " " +
+                        directory.relativeFilePath(material.bumpMap).toUtf8() + "\n";
+                }
+            }
+        }
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly) || file.write(library) != library.size() || !file.commit()) {
+            qCritical() << "Critical: cannot write material library " << path;
+            return false;
+        }
+        return true;
+    }
+
+    bool writeObj(QIODevice& file, const std::vector<ExportPart>& parts, const QString& libraryName)
+    {
+        //a coordinate per corner of every part once one of them is textured, so vt indices equal v indices
+        bool textured = false;
+        bool materials = false;
+        std::vector<std::vector<QByteArray>> material_names(parts.size());
+        std::vector<std::size_t> max_material_name(parts.size(), static_cast<std::size_t>(DEFAULT_MATERIAL.size()));
+        for (std::size_t part = 0; part < parts.size(); ++part) {
+            const auto& soup = *parts[part].soup;
+            textured = textured || std::any_of(soup.begin(), soup.end(), [](const Vertex& vertex) { return !vertex.texture.isNull(); });
+            if (hasMaterials(parts[part])) {
+                materials = true;
+                for (const auto& material : *parts[part].materials) {
+                    material_names[part].push_back(materialName(part, material));
+                    max_material_name[part] = std::max(max_material_name[part], static_cast<std::size_t>(material_names[part].back().size()));
+                }
+            }
+        }
+        QByteArray header("# 3DViewer export\n");
+        if (materials) {
+            header += "mtllib " + libraryName.toUtf8() + "\n";
+        }
+        if (file.write(header) != header.size()) {
+            return false;
+        }
+        std::vector<QByteArray> names;
+        for (const auto& part : parts) {
+            names.push_back(part.name.toUtf8());
+        }
+        //v and vn lines of every corner, vt ones when textured, then f lines with their 1-based absolute indices
+        constexpr std::size_t line_size = 3 + 3 * (MAX_FLOAT_CHARS + 1);
+        constexpr std::size_t texcoord_size = 4 + 2 * (MAX_FLOAT_CHARS + 1);
+        constexpr std::size_t face_size = 2 + 3 * (3 * MAX_INDEX_CHARS + 3);
+        const auto capacity = [&](const Chunk& chunk) {
+            const auto corners = static_cast<std::size_t>(chunk.triangleCount * 3);
+            //a material run may start at every triangle
+            const std::size_t usemtl_size = materials ? 8 + max_material_name[chunk.part] : 0;
+            return static_cast<std::size_t>(names[chunk.part].size()) + 3 + corners * (2 * line_size + (textured ? texcoord_size : 0)) +
+                static_cast<std::size_t>(chunk.triangleCount) * (face_size + usemtl_size);
+        };
+        return writeChunks(file, splitChunks(parts), capacity, [&](const Chunk& chunk, ChunkBuffer& buffer) {
+            const auto& part = parts[chunk.part];
+            std::vector<Vertex> baked;
+            bakeChunk(part, chunk, baked);
+            const auto& name = names[chunk.part];
+            if (0 == chunk.firstTriangle) {
+                buffer.append("o ", 2);
+                buffer.append(name.constData(), static_cast<std::size_t>(name.size()));
+                buffer.append('\n');
+            }
+            for (const auto& vertex : baked) {
+                buffer.append("v ", 2);
+                buffer.appendFloat(vertex.position.x());
+                buffer.append(' ');
+                buffer.appendFloat(vertex.position.y());
+                buffer.append(' ');
+                buffer.appendFloat(vertex.position.z());
+                buffer.append('\n');
+            }
+            if (textured) {
+                for (const auto& vertex : baked) {
+                    buffer.append("vt ", 3);
+                    buffer.appendFloat(vertex.texture.x());
+                    buffer.append(' ');
+                    buffer.appendFloat(vertex.texture.y());
+                    buffer.append('\n');
+                }
+            }
+            for (const auto& vertex : baked) {
+                buffer.append("vn ", 3);
+                buffer.appendFloat(vertex.normal.x());
+                buffer.append(' ');
+                buffer.appendFloat(vertex.normal.y());
+                buffer.append(' ');
+                buffer.appendFloat(vertex.normal.z());
+                buffer.append('\n');
+            }
+            //every chunk names its material first, the previous chunk may belong to another part
+            const bool part_materials = hasMaterials(part);
+            std::vector<MaterialRange>::const_iterator range;
+            if (part_materials) {
+                range = std::upper_bound(part.materialRanges->begin(), part.materialRanges->end(), chunk.firstTriangle * 3,
+                    [](std::uint64_t vertex, const MaterialRange& r) { return vertex < r.firstVertex; });
+                if (range != part.materialRanges->begin()) {
+                    --range;
+                }
+            }
+            int current = -2;
+            for (std::uint64_t triangle = 0; triangle < chunk.triangleCount; ++triangle) {
+                if (materials) {
+                    int material = -1;
+                    if (part_materials) {
+                        const auto corner = (chunk.firstTriangle + triangle) * 3;
+                        while (range != part.materialRanges->end() && range->firstVertex + range->vertexCount <= corner) {
+                            ++range;
+                        }
+                        if (range != part.materialRanges->end() && range->firstVertex <= corner &&
+                            range->material < static_cast<int>(material_names[chunk.part].size())) {
+                            material = range->material;
+                        }
+                    }
+                    if (material != current) {
+                        current = material;
+                        const auto& material_name = (material >= 0) ? material_names[chunk.part][material] : DEFAULT_MATERIAL;
+                        buffer.append("usemtl ", 7);
+                        buffer.append(material_name.constData(), static_cast<std::size_t>(material_name.size()));
+                        buffer.append('\n');
+                    }
+                }
+                buffer.append('f');
+                for (std::uint64_t corner = 0; corner < 3; ++corner) {
+                    const auto index = chunk.firstCorner + triangle * 3 + corner + 1;
+                    buffer.append(' ');
+                    buffer.appendIndex(index);
+                    if (textured) {
+                        buffer.append('/');
+                        buffer.appendIndex(index);
+                        buffer.append('/');
+                    }
+                    else {
+                        buffer.append("//", 2);
+                    }
+                    buffer.appendIndex(index);
+                }
+                buffer.append('\n');
+            }
+        });
+    }
+
+    bool writePly(QIODevice& file, const std::vector<ExportPart>& parts)
+    {
+        std::uint64_t corners = 0;
+        for (const auto& part : parts) {
+            corners += part.soup->size() / 3 * 3;
+        }
+        if (corners > static_cast<std::uint64_t>(std::numeric_limits<std::int32_t>::max())) {
+            qCritical() << "Critical: too many vertices for the int indices of a PLY file.";
+            return false;
+        }
+        const QByteArray header = QByteArray("ply\nformat binary_little_endian 1.0\ncomment 3DViewer export\n") +
+            "element vertex " + QByteArray::number(static_cast<qulonglong>(corners)) + "\n" +
+            "property float x\nproperty float y\nproperty float z\n"
+            "property float nx\nproperty float ny\nproperty float nz\n"
+            "element face " + QByteArray::number(static_cast<qulonglong>(corners / 3)) + "\n" +
+            "property list uchar int vertex_indices\nend_header\n";
+        if (file.write(header) != header.size()) {
+            return false;
+        }
+        //every vertex comes before the first face
+        const auto chunks = splitChunks(parts);
+        const auto vertices_capacity = [](const Chunk& chunk) { return static_cast<std::size_t>(chunk.triangleCount * 3 * PLY_VERTEX_SIZE); };
+        const bool vertices_written = writeChunks(file, chunks, vertices_capacity, [&parts](const Chunk& chunk, ChunkBuffer& buffer) {
+            std::vector<Vertex> baked;
+            bakeChunk(parts[chunk.part], chunk, baked);
+            for (const auto& vertex : baked) {
+                buffer.appendLittleEndian(vertex.position.x());
+                buffer.appendLittleEndian(vertex.position.y());
+                buffer.appendLittleEndian(vertex.position.z());
+                buffer.appendLittleEndian(vertex.normal.x());
+                buffer.appendLittleEndian(vertex.normal.y());
+                buffer.appendLittleEndian(vertex.normal.z());
+            }
+        });
+        const auto faces_capacity = [](const Chunk& chunk) { return static_cast<std::size_t>(chunk.triangleCount * PLY_FACE_SIZE); };
+        return vertices_written && writeChunks(file, chunks, faces_capacity, [](const Chunk& chunk, ChunkBuffer& buffer) {
+            for (std::uint64_t triangle = 0; triangle < chunk.triangleCount; ++triangle) {
+                buffer.append(static_cast<char>(3));
+                for (std::uint64_t corner = 0; corner < 3; ++corner) {
+                    buffer.appendLittleEndian(static_cast<qint32>(chunk.firstCorner + triangle * 3 + corner));
+                }
+            }
+        });
+    }
+
+    bool writeStl(QIODevice& file, const std::vector<ExportPart>& parts)
+    {
+        std::uint64_t triangles = 0;
+        for (const auto& part : parts) {
+            triangles += part.soup->size() / 3;
+        }
+        if (triangles > std::numeric_limits<quint32>::max()) {
+            qCritical() << "Critical: too many triangles for a binary STL file.";
+            return false;
+        }
+        char header[STL_HEADER_SIZE + sizeof(quint32)] = {};
+        const char title[] = "3DViewer export";
+        std::memcpy(header, title, sizeof(title) - 1);
+        qToLittleEndian(static_cast<quint32>(triangles), header + STL_HEADER_SIZE);
+        if (file.write(header, sizeof(header)) != static_cast<qint64>(sizeof(header))) {
+            return false;
+        }
+        const auto capacity = [](const Chunk& chunk) { return static_cast<std::size_t>(chunk.triangleCount * STL_TRIANGLE_SIZE); };
+        return writeChunks(file, splitChunks(parts), capacity, [&parts](const Chunk& chunk, ChunkBuffer& buffer) {
+            std::vector<Vertex> baked;
+            bakeChunk(parts[chunk.part], chunk, baked);
+            for (std::uint64_t triangle = 0; triangle < chunk.triangleCount; ++triangle) {
+                const auto* corners = baked.data() + triangle * 3;
+                //the facet normal of the placed triangle, the corner normals are smoothed
+                const auto normal = QVector3D::normal(corners[0].position, corners[1].position, corners[2].position);
+                buffer.appendLittleEndian(normal.x());
+                buffer.appendLittleEndian(normal.y());
+                buffer.appendLittleEndian(normal.z());
+                for (int corner = 0; corner < 3; ++corner) {
+                    buffer.appendLittleEndian(corners[corner].position.x());
+                    buffer.appendLittleEndian(corners[corner].position.y());
+                    buffer.appendLittleEndian(corners[corner].position.z());
+                }
+                buffer.appendLittleEndian(static_cast<quint16>(0));
+            }
+        });
+    }
+}
+
+bool EXPORT_API::formatFromSuffix(const QString& suffix, Format& format)
+{
+    const auto lower = suffix.toLower();
+    if ("obj" == lower) {
+        format = Format::OBJ;
+    }
+    else if ("ply" == lower) {
+        format = Format::PLY;
+    }
+    else if ("stl" == lower) {
+        format = Format::STL;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+void EXPORT_API::bakeTransform(const Vertex* source, std::uint64_t count, const QMatrix4x4& model, Vertex* target)
+{
+    //both matrices are column major, copied out so the loop reads plain locals
+    const float* m = model.constData();
+    const float m0 = m[0], m1 = m[1], m2 = m[2], m4 = m[4], m5 = m[5], m6 = m[6];
+    const float m8 = m[8], m9 = m[9], m10 = m[10], m12 = m[12], m13 = m[13], m14 = m[14];
+    const QMatrix3x3 normal_matrix = model.normalMatrix();
+    const float* n = normal_matrix.constData();
+    const float n0 = n[0], n1 = n[1], n2 = n[2], n3 = n[3], n4 = n[4], n5 = n[5], n6 = n[6], n7 = n[7], n8 = n[8];
+    for (std::uint64_t i = 0; i < count; ++i) {
+        const float px = source[i].position.x();
+        const float py = source[i].position.y();
+        const float pz = source[i].position.z();
+        const float nx = source[i].normal.x();
+        const float ny = source[i].normal.y();
+        const float nz = source[i].normal.z();
+        const float tx = n0 * nx + n3 * ny + n6 * nz;
+        const float ty = n1 * nx + n4 * ny + n7 * nz;
+        const float tz = n2 * nx + n5 * ny + n8 * nz;
+        const float length = std::sqrt(tx * tx + ty * ty + tz * tz);
+        const float scale = (length > 0.0f) ? 1.0f / length : 0.0f;
+        target[i].position = QVector3D(m0 * px + m4 * py + m8 * pz + m12, m1 * px + m5 * py + m9 * pz + m13, m2 * px + m6 * py + m10 * pz + m14);
+        target[i].normal = QVector3D(tx * scale, ty * scale, tz * scale);
+        target[i].texture = source[i].texture;
+    }
+}
+
+bool EXPORT_API::exportMeshes(const QString& path, Format format, const std::vector<ExportPart>& parts)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCritical() << "Critical: cannot open export file " << path;
+        return false;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    bool written = false;
+    //the materials of an obj file go into a library of the same name next to it
+    const QFileInfo info(path);
+    const auto library_name = info.completeBaseName() + ".mtl";
+    switch (format) {
+    case Format::OBJ:
+        written = writeObj(file, parts, library_name);
+        if (written && std::any_of(parts.begin(), parts.end(), hasMaterials)) {
+            written = writeMaterialLibrary(info.absoluteDir().filePath(library_name), parts);
+        }
+        break;
+    case Format::PLY:
+        written = writePly(file, parts);
+        break;
+    case Format::STL:
+        written = writeStl(file, parts);
+        break;
+    }
+    if (JobSystem::cancellationRequested()) {
+        //the temporary file is dropped, an existing file keeps its content
+        file.cancelWriting();
+        return false;
+    }
+    if (!written || !file.commit()) {
+        qCritical() << "Critical: cannot write export file " << path;
+        return false;
+    }
+    qDebug() << "Message: export took" << static_cast<double>(timer.nsecsElapsed()) / 1000000000.0 << "sec: " << path;
+    return true;
+}
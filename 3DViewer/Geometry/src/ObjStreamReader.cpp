@@ -0,0 +1,123 @@
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+
+#include <charconv>
+#include <limits>
+
+#include "ObjStreamReader.h"
+#include "ObjTokenizer.h"
+#include "JobSystem.h"
+
+using namespace OBJ_TOKENIZER;
+
+std::unique_ptr<IndexedMesh> OBJ_STREAM_API::constructMeshFromObj(const std::string& file_path)
+{
+    QFile input(QString::fromStdString(file_path));
+    if (!input.open(QIODevice::ReadOnly)) {
+        qCritical() << "Critical OBJ stream API: cannot open input file.";
+        return nullptr;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    qDebug() << "Message: obj streaming has been started: " << file_path.c_str();
+
+    //first pass: exact element counts
+    std::uint64_t num_vertices = 0;
+    std::uint64_t num_triangles = 0;
+    const bool counted = forEachLine(input, [&](const char* begin, const char* end) {
+        if (isKeyword(begin, end, 'v')) {
+            ++num_vertices;
+        }
+        else if (isKeyword(begin, end, 'f')) {
+            const auto corners = countTokens(begin + 2, end);
+            num_triangles += (corners >= 3) ? corners - 2 : 0;
+        }
+        return true;
+    });
+    if (!counted) {
+        qCritical() << "Critical: OBJ stream API cannot read " << file_path.c_str();
+        return nullptr;
+    }
+    if (0 == num_vertices || 0 == num_triangles) {
+        qCritical() << "Critical: OBJ stream API mesh constructed from " << file_path.c_str() << " apear to be empty.";
+        return nullptr;
+    }
+    if (num_vertices > std::numeric_limits<std::uint32_t>::max()) {
+        qCritical() << "Critical: OBJ stream API mesh constructed from " << file_path.c_str() << " has too many vertices.";
+        return nullptr;
+    }
+
+    auto mesh = std::make_unique<IndexedMesh>();
+    if (!mesh->positions.allocate(num_vertices) || !mesh->indices.allocate(num_triangles * 3)) {
+        return nullptr;
+    }
+
+    //second pass: fill the arrays
+    input.seek(0);
+    std::uint64_t vertex_pos = 0;
+    std::uint64_t index_pos = 0;
+    const bool parsed = forEachLine(input, [&](const char* begin, const char* end) {
+        if (JobSystem::cancellationRequested()) {
+            return false;
+        }
+        if (isKeyword(begin, end, 'v')) {
+            float coords[3];
+            const char* p = begin + 2;
+            for (auto& coord : coords) {
+                p = skipSpaces(p, end);
+                const auto result = std::from_chars(p, end, coord);
+                if (result.ec != std::errc()) {
+                    return false;
+                }
+                p = result.ptr;
+            }
+            mesh->positions[vertex_pos++] = QVector3D(coords[0], coords[1], coords[2]);
+        }
+        else if (isKeyword(begin, end, 'f')) {
+            std::uint32_t first = 0, previous = 0;
+            std::uint64_t corner = 0;
+            for (const char* p = skipSpaces(begin + 2, end); p < end; p = skipSpaces(skipToken(p, end), end)) {
+                long long index = 0;
+                const auto result = std::from_chars(p, skipToken(p, end), index);
+                if (result.ec != std::errc()) {
+                    return false;
+                }
+                //negative indices are relative to the last parsed vertex
+                index = (index < 0) ? static_cast<long long>(vertex_pos) + index : index - 1;
+                if (index < 0 || static_cast<std::uint64_t>(index) >= num_vertices) {
+                    return false;
+                }
+                const auto current = static_cast<std::uint32_t>(index);
+                if (0 == corner) {
+                    first = current;
+                }
+                else if (corner >= 2) {
+                    //fan triangulation, faces in obj are expected to be convex
+                    mesh->indices[index_pos++] = first;
+                    mesh->indices[index_pos++] = previous;
+                    mesh->indices[index_pos++] = current;
+                }
+                previous = current;
+                ++corner;
+            }
+        }
+        return true;
+    });
+    input.close();
+    if (!parsed || vertex_pos != num_vertices || index_pos != num_triangles * 3) {
+        qCritical() << "Critical: OBJ stream API failed to parse OBJ file " << file_path.c_str();
+        return nullptr;
+    }
+    qDebug() << "Message: obj streaming has been ended and took " <<
+        static_cast<double>(timer.nsecsElapsed()) / 1000000000.0 << " sec: "
+        << file_path.c_str();
+
+    if (!MESH_API::computeVertexNormals(*mesh)) {
+        return nullptr;
+    }
+    mesh->num_vertices = num_vertices;
+    mesh->num_faces = num_triangles;
+    mesh->num_edges = MESH_API::countEdges(*mesh);
+    return mesh;
+}
@@ -0,0 +1,263 @@
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+
+#include <charconv>
+#include <limits>
+#include <mutex>
+
+#include "PointCloud.h"
+#include "ObjTokenizer.h"
+#include "JobSystem.h"
+
+using namespace OBJ_TOKENIZER;
+
+namespace {
+    // shared by the jobs building the subtrees
+    struct OctreeBuilder {
+        PointVertex* points;
+        std::vector<OctreeNode>& nodes;
+        std::mutex mutex;
+
+        std::int32_t build(std::uint64_t begin, std::uint64_t end, const QVector3D& center, float halfSize, std::uint32_t depth);
+        // nodes of the same cube owning NODE_POINTS each, every one the single child of the previous
+        std::int32_t buildChain(std::uint64_t begin, std::uint64_t end, const QVector3D& center, float halfSize, std::uint32_t depth);
+    };
+
+    // splits the range by the octant of the center, octant i lies in [bounds[i], bounds[i + 1])
+    std::array<std::uint64_t, 9> partitionOctants(PointVertex* points, std::uint64_t begin, std::uint64_t end, const QVector3D& center)
+    {
+        const auto split = [points](std::uint64_t first, std::uint64_t last, auto&& below) {
+            return static_cast<std::uint64_t>(std::partition(points + first, points + last, below) - points);
+        };
+        std::array<std::uint64_t, 9> bounds;
+        bounds[0] = begin;
+        bounds[8] = end;
+        bounds[4] = split(begin, end, [&center](const PointVertex& p) { return p.position.z() < center.z(); });
+        for (int z = 0; z < 8; z += 4) {
+            bounds[z + 2] = split(bounds[z], bounds[z + 4], [&center](const PointVertex& p) { return p.position.y() < center.y(); });
+            for (int y = z; y < z + 4; y += 2) {
+                bounds[y + 1] = split(bounds[y], bounds[y + 2], [&center](const PointVertex& p) { return p.position.x() < center.x(); });
+            }
+        }
+        return bounds;
+    }
+
+    std::int32_t OctreeBuilder::build(std::uint64_t begin, std::uint64_t end, const QVector3D& center, float halfSize, std::uint32_t depth)
+    {
+        const std::uint64_t count = end - begin;
+        //only coincident points get that far, splitting the cube further would not separate them
+        if (depth >= POINTCLOUD_API::MAX_DEPTH && count > POINTCLOUD_API::NODE_POINTS) {
+            return buildChain(begin, end, center, halfSize, depth);
+        }
+        OctreeNode node;
+        node.center = center;
+        node.halfSize = halfSize;
+        node.first = begin;
+        node.depth = depth;
+        const bool leaf = count <= POINTCLOUD_API::NODE_POINTS || JobSystem::cancellationRequested();
+        std::array<std::uint64_t, 9> octants{};
+        if (leaf) {
+            node.count = static_cast<std::uint32_t>(std::min<std::uint64_t>(count, std::numeric_limits<std::uint32_t>::max()));
+        }
+        else {
+            //sorted by octant first, so the stride sample takes from every octant by its share
+            partitionOctants(points, begin, end, center);
+            const double step = static_cast<double>(count) / POINTCLOUD_API::NODE_POINTS;
+            for (std::uint32_t i = 0; i < POINTCLOUD_API::NODE_POINTS; ++i) {
+                std::swap(points[begin + i], points[begin + static_cast<std::uint64_t>(i * step)]);
+            }
+            node.count = POINTCLOUD_API::NODE_POINTS;
+            octants = partitionOctants(points, begin + node.count, end, center);
+        }
+        std::int32_t index;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            index = static_cast<std::int32_t>(nodes.size());
+            nodes.push_back(node);
+        }
+        if (leaf) {
+            return index;
+        }
+        std::array<std::int32_t, 8> children;
+        JobSystem::instance().parallelFor(8, 1, [&](std::uint64_t first, std::uint64_t last) {
+            for (auto octant = first; octant < last; ++octant) {
+                if (octants[octant] == octants[octant + 1]) {
+                    children[octant] = -1;
+                    continue;
+                }
+                const float child_half = halfSize * 0.5f;
+                const QVector3D child_center(
+                    center.x() + ((octant & 1) ? child_half : -child_half),
+                    center.y() + ((octant & 2) ? child_half : -child_half),
+                    center.z() + ((octant & 4) ? child_half : -child_half));
+                children[octant] = build(octants[octant], octants[octant + 1], child_center, child_half, depth + 1);
+            }
+        });
+        std::lock_guard<std::mutex> lock(mutex);
+        nodes[index].children = children;
+        return index;
+    }
+
+    std::int32_t OctreeBuilder::buildChain(std::uint64_t begin, std::uint64_t end, const QVector3D& center, float halfSize, std::uint32_t depth)
+    {
+        std::int32_t head = -1;
+        std::int32_t previous = -1;
+        for (auto first = begin; first < end; first += POINTCLOUD_API::NODE_POINTS) {
+            OctreeNode node;
+            node.center = center;
+            node.halfSize = halfSize;
+            node.first = first;
+            node.count = static_cast<std::uint32_t>(std::min<std::uint64_t>(end - first, POINTCLOUD_API::NODE_POINTS));
+            node.depth = depth++;
+            std::lock_guard<std::mutex> lock(mutex);
+            const auto index = static_cast<std::int32_t>(nodes.size());
+            nodes.push_back(node);
+            if (previous >= 0) {
+                nodes[previous].children[0] = index;
+            }
+            else {
+                head = index;
+            }
+            previous = index;
+        }
+        return head;
+    }
+}
+
+bool POINTCLOUD_API::looksLikePointCloud(const std::string& file_path)
+{
+    QFile input(QString::fromStdString(file_path));
+    if (!input.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    if (input.size() > SNIFF_SIZE) {
+        input.seek(input.size() - SNIFF_SIZE);
+    }
+    const auto tail = input.read(SNIFF_SIZE);
+    bool has_vertices = false;
+    bool has_faces = false;
+    const char* line = tail.constData();
+    const char* end = line + tail.size();
+    while (line < end) {
+        const char* eol = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        eol = (nullptr == eol) ? end : eol;
+        has_vertices = has_vertices || isKeyword(line, eol, 'v');
+        has_faces = has_faces || isKeyword(line, eol, 'f');
+        line = eol + 1;
+    }
+    return has_vertices && !has_faces;
+}
+
+std::unique_ptr<PointCloud> POINTCLOUD_API::readPointCloudFromObj(const std::string& file_path)
+{
+    QFile input(QString::fromStdString(file_path));
+    if (!input.open(QIODevice::ReadOnly)) {
+        qCritical() << "Critical point cloud API: cannot open input file.";
+        return nullptr;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    qDebug() << "Message: point cloud reading has been started: " << file_path.c_str();
+
+    //first pass: exact point count
+    std::uint64_t num_points = 0;
+    const bool counted = forEachLine(input, [&num_points](const char* begin, const char* end) {
+        if (isKeyword(begin, end, 'v')) {
+            ++num_points;
+        }
+        return true;
+    });
+    if (!counted) {
+        qCritical() << "Critical: point cloud API failed to read OBJ file " << file_path.c_str();
+        return nullptr;
+    }
+    if (0 == num_points) {
+        qCritical() << "Critical: point cloud read from " << file_path.c_str() << " apear to be empty.";
+        return nullptr;
+    }
+    auto cloud = std::make_unique<PointCloud>();
+    if (!cloud->points.allocate(num_points)) {
+        return nullptr;
+    }
+
+    //second pass: positions, colors and bounds
+    input.seek(0);
+    constexpr float max_float = std::numeric_limits<float>::max();
+    QVector3D min_bounds(max_float, max_float, max_float);
+    QVector3D max_bounds(-max_float, -max_float, -max_float);
+    const std::uint32_t default_color = packColor(1.0f, 1.0f, 1.0f);
+    std::uint64_t point_pos = 0;
+    std::uint64_t colored = 0;
+    const bool parsed = forEachLine(input, [&](const char* begin, const char* end) {
+        if (JobSystem::cancellationRequested()) {
+            return false;
+        }
+        if (!isKeyword(begin, end, 'v')) {
+            return true;
+        }
+        float values[6];
+        int num_values = 0;
+        for (const char* p = skipSpaces(begin + 2, end); p < end && num_values < 6; p = skipSpaces(p, end)) {
+            const auto result = std::from_chars(p, end, values[num_values]);
+            if (result.ec != std::errc()) {
+                break;
+            }
+            p = result.ptr;
+            ++num_values;
+        }
+        if (num_values < 3) {
+            return false;
+        }
+        const QVector3D position(values[0], values[1], values[2]);
+        min_bounds = QVector3D(std::min(min_bounds.x(), position.x()), std::min(min_bounds.y(), position.y()), std::min(min_bounds.z(), position.z()));
+        max_bounds = QVector3D(std::max(max_bounds.x(), position.x()), std::max(max_bounds.y(), position.y()), std::max(max_bounds.z(), position.z()));
+        //the fourth value alone is the optional w of the obj format, not a color
+        const bool has_color = 6 == num_values;
+        colored += has_color ? 1 : 0;
+        cloud->points[point_pos++] = { position, has_color ? packColor(values[3], values[4], values[5]) : default_color };
+        return true;
+    });
+    input.close();
+    if (!parsed || point_pos != num_points) {
+        qCritical() << "Critical: point cloud API failed to parse OBJ file " << file_path.c_str();
+        return nullptr;
+    }
+    cloud->minBounds = min_bounds;
+    cloud->maxBounds = max_bounds;
+    cloud->hasColors = colored == num_points;
+    qDebug() << "Message: point cloud reading has been ended and took " <<
+        static_cast<double>(timer.nsecsElapsed()) / 1000000000.0 << " sec: " << file_path.c_str();
+    return cloud;
+}
+
+bool POINTCLOUD_API::buildOctree(PointCloud& cloud)
+{
+    if (cloud.points.isEmpty()) {
+        return false;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    const auto extent = cloud.maxBounds - cloud.minBounds;
+    //a cube around the bounds, the octant tests put the points on the max faces inside
+    const float half_size = std::max({ extent.x(), extent.y(), extent.z(), std::numeric_limits<float>::epsilon() }) * 0.5f;
+    cloud.nodes.clear();
+    cloud.nodes.reserve(static_cast<std::size_t>(cloud.points.size() / NODE_POINTS * 8 / 7 + 1));
+    OctreeBuilder builder{ cloud.points.data(), cloud.nodes };
+    builder.build(0, cloud.points.size(), (cloud.minBounds + cloud.maxBounds) * 0.5f, half_size, 0);
+    if (JobSystem::cancellationRequested()) {
+        return false;
+    }
+    qDebug() << "Message: octree of" << cloud.nodes.size() << "nodes took" <<
+        static_cast<double>(timer.nsecsElapsed()) / 1000000000.0 << "sec to build";
+    return true;
+}
+
+std::unique_ptr<PointCloud> POINTCLOUD_API::constructPointCloudFromObj(const std::string& file_path)
+{
+    auto cloud = readPointCloudFromObj(file_path);
+    if (nullptr == cloud || !buildOctree(*cloud)) {
+        return nullptr;
+    }
+    return cloud;
+}
@@ -0,0 +1,280 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#include "ScalarField.h"
+#include "JobSystem.h"
+
+namespace {
+    constexpr std::uint64_t TRIANGLE_GRAIN = 64 * 1024;
+    constexpr std::uint64_t VERTEX_GRAIN = 64 * 1024;
+    // a point query descends the reference, far more work per vertex
+    constexpr std::uint64_t DEVIATION_GRAIN = 1024;
+    // corners sorted by one job before the runs are merged
+    constexpr std::uint64_t SORT_GRAIN = 256 * 1024;
+
+    // share of one triangle in the curvature of its corner
+    struct CornerCurvature {
+        QVector3D laplacian;
+        // area weighted, unnormalized
+        QVector3D normal;
+        float area = 0.0f;
+    };
+
+    inline bool positionLess(const QVector3D& a, const QVector3D& b)
+    {
+        if (a.x() != b.x()) {
+            return a.x() < b.x();
+        }
+        if (a.y() != b.y()) {
+            return a.y() < b.y();
+        }
+        return a.z() < b.z();
+    }
+
+    //sorts runs of a grain in parallel, then merges neighbouring runs pairwise, each round in parallel
+    template <typename Less>
+    bool parallelSort(std::vector<std::uint32_t>& values, Less less)
+    {
+        const std::uint64_t count = values.size();
+        const std::uint64_t runs = (count + SORT_GRAIN - 1) / SORT_GRAIN;
+        JobSystem::instance().parallelFor(runs, 1, [&](std::uint64_t begin, std::uint64_t end) {
+            for (auto r = begin; r < end; ++r) {
+                std::sort(values.begin() + r * SORT_GRAIN, values.begin() + std::min(count, (r + 1) * SORT_GRAIN), less);
+            }
+        });
+        if (JobSystem::cancellationRequested()) {
+            return false;
+        }
+        std::vector<std::uint32_t> merged(runs > 1 ? count : 0);
+        for (std::uint64_t width = SORT_GRAIN; width < count; width *= 2) {
+            const std::uint64_t pairs = (count + 2 * width - 1) / (2 * width);
+            JobSystem::instance().parallelFor(pairs, 1, [&](std::uint64_t begin, std::uint64_t end) {
+                for (auto p = begin; p < end; ++p) {
+                    const auto first = p * 2 * width;
+                    const auto middle = std::min(count, first + width);
+                    const auto last = std::min(count, first + 2 * width);
+                    std::merge(values.begin() + first, values.begin() + middle, values.begin() + middle, values.begin() + last,
+                        merged.begin() + first, less);
+                }
+            });
+            if (JobSystem::cancellationRequested()) {
+                return false;
+            }
+            values.swap(merged);
+        }
+        return true;
+    }
+
+    //cotangent of the angle between u and v
+    inline float cotangent(const QVector3D& u, const QVector3D& v)
+    {
+        const float sine = QVector3D::crossProduct(u, v).length();
+        return sine > 0.0f ? QVector3D::dotProduct(u, v) / sine : 0.0f;
+    }
+
+    //spreads the per vertex values over the corners of the soup
+    bool scatter(const WeldedSoup& welded, const std::vector<float>& vertexValues, ScalarField& field)
+    {
+        field.values.resize(welded.cornerVertex.size());
+        JobSystem::instance().parallelFor(field.values.size(), VERTEX_GRAIN, [&](std::uint64_t begin, std::uint64_t end) {
+            for (auto c = begin; c < end; ++c) {
+                field.values[c] = vertexValues[welded.cornerVertex[c]];
+            }
+        });
+        if (JobSystem::cancellationRequested()) {
+            return false;
+        }
+        FIELD_API::updateRange(field);
+        return true;
+    }
+}
+
+QString FIELD_API::kindName(FieldKind kind)
+{
+    switch (kind) {
+    case FieldKind::CURVATURE:    return "Curvature";
+    case FieldKind::ASPECT_RATIO: return "Aspect Ratio";
+    case FieldKind::EDGE_LENGTH:  return "Edge Length";
+    case FieldKind::DEVIATION:    return "Deviation";
+    default:                      return "None";
+    }
+}
+
+bool FIELD_API::gatherCorners(const MappedArray<Vertex>& soup, WeldedSoup& welded)
+{
+    const std::uint64_t num_corners = soup.size() / 3 * 3;
+    if (num_corners > std::numeric_limits<std::uint32_t>::max() || !welded.corners.allocate(num_corners)) {
+        return false;
+    }
+    JobSystem::instance().parallelFor(num_corners, TRIANGLE_GRAIN, [&](std::uint64_t begin, std::uint64_t end) {
+        for (auto c = begin; c < end; ++c) {
+            welded.corners[c] = soup[c].position;
+        }
+    });
+    return !JobSystem::cancellationRequested();
+}
+
+bool FIELD_API::weldCorners(WeldedSoup& welded)
+{
+    const auto num_corners = static_cast<std::uint32_t>(welded.corners.size());
+    //sorted by position the corners of a vertex are neighbours, a hash would need a merge step
+    welded.vertexCorners.resize(num_corners);
+    std::iota(welded.vertexCorners.begin(), welded.vertexCorners.end(), 0u);
+    const bool sorted = parallelSort(welded.vertexCorners, [&welded](std::uint32_t a, std::uint32_t b) {
+        return positionLess(welded.corners[a], welded.corners[b]);
+    });
+    if (!sorted) {
+        return false;
+    }
+    welded.cornerVertex.resize(num_corners);
+    welded.vertexOffsets.clear();
+    for (std::uint32_t i = 0; i < num_corners; ++i) {
+        const auto corner = welded.vertexCorners[i];
+        if (0 == i || welded.corners[welded.vertexCorners[i - 1]] != welded.corners[corner]) {
+            welded.vertexOffsets.push_back(i);
+        }
+        welded.cornerVertex[corner] = static_cast<std::uint32_t>(welded.vertexOffsets.size() - 1);
+    }
+    welded.vertexOffsets.push_back(num_corners);
+    return true;
+}
+
+bool FIELD_API::computeCurvature(const WeldedSoup& welded, ScalarField& field)
+{
+    field.kind = FieldKind::CURVATURE;
+    const std::uint64_t num_triangles = welded.corners.size() / 3;
+    std::vector<CornerCurvature> shares(welded.corners.size());
+    JobSystem::instance().parallelFor(num_triangles, TRIANGLE_GRAIN, [&](std::uint64_t begin, std::uint64_t end) {
+        for (auto t = begin; t < end; ++t) {
+            const QVector3D* p = &welded.corners[t * 3];
+            const auto normal = QVector3D::crossProduct(p[1] - p[0], p[2] - p[0]);
+            const float area = normal.length() * 0.5f;
+            for (int c = 0; c < 3; ++c) {
+                const auto& i = p[c];
+                const auto& j = p[(c + 1) % 3];
+                const auto& k = p[(c + 2) % 3];
+                //the edge to j is weighted by the angle at k and the other way round
+                auto& share = shares[t * 3 + c];
+                share.laplacian = cotangent(i - k, j - k) * (j - i) + cotangent(i - j, k - j) * (k - i);
+                share.normal = normal;
+                share.area = area / 3.0f;
+            }
+        }
+    });
+    if (JobSystem::cancellationRequested()) {
+        return false;
+    }
+    std::vector<float> curvature(welded.vertexCount());
+    JobSystem::instance().parallelFor(curvature.size(), VERTEX_GRAIN, [&](std::uint64_t begin, std::uint64_t end) {
+        for (auto v = begin; v < end; ++v) {
+            CornerCurvature sum;
+            for (auto i = welded.vertexOffsets[v]; i < welded.vertexOffsets[v + 1]; ++i) {
+                const auto& share = shares[welded.vertexCorners[i]];
+                sum.laplacian += share.laplacian;
+                sum.normal += share.normal;
+                sum.area += share.area;
+            }
+            //the Laplacian is -4AH along the normal
+            curvature[v] = sum.area > 0.0f ? -QVector3D::dotProduct(sum.laplacian, sum.normal.normalized()) / (4.0f * sum.area) : 0.0f;
+        }
+    });
+    return !JobSystem::cancellationRequested() && scatter(welded, curvature, field);
+}
+
+bool FIELD_API::computeAspectRatio(const WeldedSoup& welded, ScalarField& field)
+{
+    field.kind = FieldKind::ASPECT_RATIO;
+    const std::uint64_t num_triangles = welded.corners.size() / 3;
+    field.values.resize(num_triangles * 3);
+    JobSystem::instance().parallelFor(num_triangles, TRIANGLE_GRAIN, [&](std::uint64_t begin, std::uint64_t end) {
+        for (auto t = begin; t < end; ++t) {
+            const QVector3D* p = &welded.corners[t * 3];
+            const float a = (p[1] - p[0]).length();
+            const float b = (p[2] - p[1]).length();
+            const float c = (p[0] - p[2]).length();
+            const float area = QVector3D::crossProduct(p[1] - p[0], p[2] - p[0]).length() * 0.5f;
+            //R / 2r = abc s / 8A^2
+            const float s = (a + b + c) * 0.5f;
+            const float denominator = 8.0f * area * area;
+            const float ratio = denominator > 0.0f ? std::min(MAX_ASPECT_RATIO, a * b * c * s / denominator) : MAX_ASPECT_RATIO;
+            std::fill_n(&field.values[t * 3], 3, ratio);
+        }
+    });
+    if (JobSystem::cancellationRequested()) {
+        return false;
+    }
+    updateRange(field);
+    return true;
+}
+
+bool FIELD_API::computeEdgeLength(const WeldedSoup& welded, ScalarField& field)
+{
+    field.kind = FieldKind::EDGE_LENGTH;
+    const std::uint64_t num_triangles = welded.corners.size() / 3;
+    //both edges of a corner, inner edges are seen from both sides so the mean stays fair
+    std::vector<float> shares(welded.corners.size());
+    JobSystem::instance().parallelFor(num_triangles, TRIANGLE_GRAIN, [&](std::uint64_t begin, std::uint64_t end) {
+        for (auto t = begin; t < end; ++t) {
+            const QVector3D* p = &welded.corners[t * 3];
+            for (int c = 0; c < 3; ++c) {
+                shares[t * 3 + c] = (p[(c + 1) % 3] - p[c]).length() + (p[(c + 2) % 3] - p[c]).length();
+            }
+        }
+    });
+    if (JobSystem::cancellationRequested()) {
+        return false;
+    }
+    std::vector<float> lengths(welded.vertexCount());
+    JobSystem::instance().parallelFor(lengths.size(), VERTEX_GRAIN, [&](std::uint64_t begin, std::uint64_t end) {
+        for (auto v = begin; v < end; ++v) {
+            float sum = 0.0f;
+            for (auto i = welded.vertexOffsets[v]; i < welded.vertexOffsets[v + 1]; ++i) {
+                sum += shares[welded.vertexCorners[i]];
+            }
+            lengths[v] = sum / (2.0f * (welded.vertexOffsets[v + 1] - welded.vertexOffsets[v]));
+        }
+    });
+    return !JobSystem::cancellationRequested() && scatter(welded, lengths, field);
+}
+
+bool FIELD_API::computeDeviation(const WeldedSoup& welded, const TriangleBvh& reference, ScalarField& field)
+{
+    field.kind = FieldKind::DEVIATION;
+    if (reference.nodes.empty()) {
+        return false;
+    }
+    std::vector<float> distances(welded.vertexCount());
+    JobSystem::instance().parallelFor(distances.size(), DEVIATION_GRAIN, [&](std::uint64_t begin, std::uint64_t end) {
+        for (auto v = begin; v < end; ++v) {
+            const auto& position = welded.corners[welded.vertexCorners[welded.vertexOffsets[v]]];
+            distances[v] = BVH_API::pointDistance(reference, position);
+        }
+    });
+    return !JobSystem::cancellationRequested() && scatter(welded, distances, field);
+}
+
+void FIELD_API::updateRange(ScalarField& field)
+{
+    if (field.values.empty()) {
+        field.minValue = field.maxValue = field.lowValue = field.highValue = 0.0f;
+        return;
+    }
+    const auto extremes = std::minmax_element(field.values.begin(), field.values.end());
+    field.minValue = *extremes.first;
+    field.maxValue = *extremes.second;
+    //a few spikes would otherwise paint the whole surface in one color
+    std::vector<float> sorted(field.values);
+    const auto last = sorted.size() - 1;
+    const auto low = static_cast<std::size_t>(last * OUTLIER_FRACTION);
+    const auto high = last - low;
+    std::nth_element(sorted.begin(), sorted.begin() + low, sorted.end());
+    field.lowValue = sorted[low];
+    std::nth_element(sorted.begin() + low, sorted.begin() + high, sorted.end());
+    field.highValue = sorted[high];
+    if (field.highValue <= field.lowValue) {
+        field.lowValue = field.minValue;
+        field.highValue = field.maxValue;
+    }
+}
@@ -0,0 +1,119 @@
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include <charconv>
+#include <cstring>
+
+#include "SurfaceMaterial.h"
+#include "ObjTokenizer.h"
+
+using namespace OBJ_TOKENIZER;
+
+namespace {
+    //options like -bm 0.5 come before the file name, which is the last token
+    QString mapPath(const QDir& directory, const char* begin, const char* end)
+    {
+        const char* last = nullptr;
+        for (const char* p = skipSpaces(skipToken(begin, end), end); p < end; p = skipSpaces(skipToken(p, end), end)) {
+            last = p;
+        }
+        if (nullptr == last) {
+            return QString();
+        }
+        auto name = QString::fromUtf8(last, static_cast<int>(skipToken(last, end) - last));
+        name.replace('\\', '/');
+        return QDir::cleanPath(directory.absoluteFilePath(name));
+    }
+
+    //value of an option of a map statement, fallback when it is missing
+    float mapOption(const char* begin, const char* end, const char* option, float fallback)
+    {
+        const auto length = std::strlen(option);
+        for (const char* p = skipSpaces(skipToken(begin, end), end); p < end; p = skipSpaces(skipToken(p, end), end)) {
+            const char* token_end = skipToken(p, end);
+            if (static_cast<std::size_t>(token_end - p) == length && 0 == std::strncmp(p, option, length)) {
+                const char* value = skipSpaces(token_end, end);
+                float result = fallback;
+                if (std::from_chars(value, end, result).ec == std::errc()) {
+                    return result;
+                }
+                return fallback;
+            }
+        }
+        return fallback;
+    }
+}
+
+bool MTL_API::readMaterialLibrary(const QString& path, std::vector<SurfaceMaterial>& materials)
+{
+    QFile input(path);
+    if (!input.open(QIODevice::ReadOnly)) {
+        qCritical() << "Critical: cannot open material library " << path;
+        return false;
+    }
+    const auto directory = QFileInfo(path).absoluteDir();
+    SurfaceMaterial* current = nullptr;
+    return forEachLine(input, [&](const char* begin, const char* end) {
+        if (isKeyword(begin, end, "newmtl")) {
+            const char* name = skipSpaces(begin + 6, end);
+            materials.emplace_back();
+            current = &materials.back();
+            current->name = QString::fromUtf8(name, static_cast<int>(end - name)).trimmed();
+        }
+        else if (nullptr == current) {
+            return true;
+        }
+        else if (isKeyword(begin, end, "Kd")) {
+            const char* p = begin + 2;
+            for (int i = 0; i < 3; ++i) {
+                p = skipSpaces(p, end);
+                float value = 0.0f;
+                const auto result = std::from_chars(p, end, value);
+                if (result.ec != std::errc()) {
+                    break;
+                }
+                current->diffuse[i] = value;
+                p = result.ptr;
+            }
+        }
+        else if (isKeyword(begin, end, "map_Kd")) {
+            current->diffuseMap = mapPath(directory, begin, end);
+        }
+        else if (isKeyword(begin, end, "norm")) {
+            current->normalMap = mapPath(directory, begin, end);
+        }
+        //a bump map holds heights, not normals
+        else if (isKeyword(begin, end, "map_Bump") || isKeyword(begin, end, "map_bump") || isKeyword(begin, end, "bump")) {
+            current->bumpMap = mapPath(directory, begin, end);
+            current->bumpScale = mapOption(begin, end, "-bm", 1.0f);
+        }
+        return true;
+    });
+}
+
+int MTL_API::findMaterial(const std::vector<SurfaceMaterial>& materials, const QString& name)
+{
+    for (std::size_t i = 0; i < materials.size(); ++i) {
+        if (materials[i].name == name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+std::vector<MaterialRange> MTL_API::buildMaterialRanges(const std::vector<int>& faceMaterials)
+{
+    std::vector<MaterialRange> ranges;
+    for (std::size_t face = 0; face < faceMaterials.size(); ++face) {
+        if (ranges.empty() || ranges.back().material != faceMaterials[face]) {
+            MaterialRange range;
+            range.firstVertex = face * 3;
+            range.material = faceMaterials[face];
+            ranges.push_back(range);
+        }
+        ranges.back().vertexCount += 3;
+    }
+    return ranges;
+}
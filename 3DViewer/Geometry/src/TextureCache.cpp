@@ -0,0 +1,202 @@
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <cstring>
+
+#include "TextureCache.h"
+#include "JobSystem.h"
+
+namespace {
+    constexpr char TEXTURE_MAGIC[8] = { '3', 'D', 'V', 'T', 'E', 'X', 'C', '\0' };
+    constexpr std::uint64_t ROW_GRAIN = 64;
+    constexpr std::uint32_t MAX_LEVELS = 16;
+
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t levelCount;
+        std::uint64_t sourceSize;
+        std::int64_t sourceModified;
+    };
+
+    struct LevelHeader {
+        std::uint32_t width;
+        std::uint32_t height;
+    };
+
+    //2x2 box filter, the last row or column of an odd level is reused
+    QImage downsample(const QImage& source)
+    {
+        const int width = std::max(1, source.width() / 2);
+        const int height = std::max(1, source.height() / 2);
+        QImage level(width, height, QImage::Format_RGBA8888);
+        //bits() detaches, so it is taken once before the rows are shared between the jobs
+        uchar* destination = level.bits();
+        const auto destination_stride = level.bytesPerLine();
+        JobSystem::instance().parallelFor(static_cast<std::uint64_t>(height), ROW_GRAIN, [&](std::uint64_t begin, std::uint64_t end) {
+            for (auto y = begin; y < end; ++y) {
+                const int y0 = std::min(static_cast<int>(y) * 2, source.height() - 1);
+                const int y1 = std::min(y0 + 1, source.height() - 1);
+                const uchar* row0 = source.constScanLine(y0);
+                const uchar* row1 = source.constScanLine(y1);
+                uchar* out = destination + y * destination_stride;
+                for (int x = 0; x < width; ++x) {
+                    const int x0 = std::min(x * 2, source.width() - 1) * 4;
+                    const int x1 = std::min(x * 2 + 1, source.width() - 1) * 4;
+                    for (int c = 0; c < 4; ++c) {
+                        out[x * 4 + c] = static_cast<uchar>((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+                    }
+                }
+            }
+        });
+        return level;
+    }
+}
+
+QImage TEXTURE_API::decodeImage(const QString& path)
+{
+    QImageReader reader(path);
+    reader.setAutoTransform(true);
+    const auto size = reader.size();
+    if (size.width() > MAX_TEXTURE_SIZE || size.height() > MAX_TEXTURE_SIZE) {
+        reader.setScaledSize(size.scaled(MAX_TEXTURE_SIZE, MAX_TEXTURE_SIZE, Qt::KeepAspectRatio));
+    }
+    QImage image = reader.read();
+    if (image.isNull()) {
+        qCritical() << "Critical: cannot decode texture " << path << ": " << reader.errorString();
+    }
+    return image;
+}
+
+std::unique_ptr<MipChain> TEXTURE_API::buildMipLevels(const QImage& image)
+{
+    if (image.isNull()) {
+        return nullptr;
+    }
+    auto chain = std::make_unique<MipChain>();
+    //GL reads the rows from the bottom up
+    chain->levels.push_back(image.convertToFormat(QImage::Format_RGBA8888).mirrored());
+    while (chain->levels.back().width() > 1 || chain->levels.back().height() > 1) {
+        if (JobSystem::cancellationRequested()) {
+            return nullptr;
+        }
+        chain->levels.push_back(downsample(chain->levels.back()));
+    }
+    return chain;
+}
+
+QString TEXTURE_API::cachePath(const QString& imagePath)
+{
+    const auto key = QCryptographicHash::hash(QFileInfo(imagePath).absoluteFilePath().toUtf8(), QCryptographicHash::Sha1).toHex();
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/textures/" +
+        QString::fromLatin1(key) + "." + FILE_SUFFIX;
+}
+
+bool TEXTURE_API::writeTextureCache(const QString& path, const MipChain& chain)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCritical() << "Critical: cannot open texture cache file " << path;
+        return false;
+    }
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, TEXTURE_MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.levelCount = static_cast<std::uint32_t>(chain.levels.size());
+    header.sourceSize = chain.sourceSize;
+    header.sourceModified = chain.sourceModified;
+    bool written = file.write(reinterpret_cast<const char*>(&header), sizeof(header)) == sizeof(header);
+    for (const auto& level : chain.levels) {
+        if (!written) {
+            break;
+        }
+        const LevelHeader level_header = { static_cast<std::uint32_t>(level.width()), static_cast<std::uint32_t>(level.height()) };
+        written = file.write(reinterpret_cast<const char*>(&level_header), sizeof(level_header)) == sizeof(level_header);
+        //rows are written without the scanline padding
+        const qint64 row_size = static_cast<qint64>(level.width()) * 4;
+        for (int y = 0; written && y < level.height(); ++y) {
+            written = file.write(reinterpret_cast<const char*>(level.constScanLine(y)), row_size) == row_size;
+        }
+    }
+    if (!written || !file.commit()) {
+        qCritical() << "Critical: cannot write texture cache file " << path;
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<MipChain> TEXTURE_API::readTextureCache(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+    Header header;
+    if (file.read(reinterpret_cast<char*>(&header), sizeof(header)) != sizeof(header) ||
+        0 != std::memcmp(header.magic, TEXTURE_MAGIC, sizeof(header.magic)) || VERSION != header.version ||
+        0 == header.levelCount || header.levelCount > MAX_LEVELS) {
+        qCritical() << "Critical: " << path << " is not a compatible texture cache file.";
+        return nullptr;
+    }
+    auto chain = std::make_unique<MipChain>();
+    chain->sourceSize = header.sourceSize;
+    chain->sourceModified = header.sourceModified;
+    for (std::uint32_t i = 0; i < header.levelCount; ++i) {
+        LevelHeader level_header;
+        if (file.read(reinterpret_cast<char*>(&level_header), sizeof(level_header)) != sizeof(level_header) ||
+            0 == level_header.width || 0 == level_header.height ||
+            level_header.width > MAX_TEXTURE_SIZE || level_header.height > MAX_TEXTURE_SIZE) {
+            qCritical() << "Critical: " << path << " is not a compatible texture cache file.";
+            return nullptr;
+        }
+        QImage level(static_cast<int>(level_header.width), static_cast<int>(level_header.height), QImage::Format_RGBA8888);
+        const qint64 row_size = static_cast<qint64>(level.width()) * 4;
+        for (int y = 0; y < level.height(); ++y) {
+            if (file.read(reinterpret_cast<char*>(level.scanLine(y)), row_size) != row_size) {
+                qCritical() << "Critical: texture cache file " << path << " is truncated.";
+                return nullptr;
+            }
+        }
+        chain->levels.push_back(std::move(level));
+    }
+    return chain;
+}
+
+std::unique_ptr<MipChain> TEXTURE_API::loadTexture(const QString& imagePath)
+{
+    const QFileInfo info(imagePath);
+    if (!info.exists()) {
+        qCritical() << "Critical: texture " << imagePath << " does not exist.";
+        return nullptr;
+    }
+    const auto source_size = static_cast<std::uint64_t>(info.size());
+    const auto source_modified = info.lastModified().toMSecsSinceEpoch();
+    const auto cache_path = cachePath(imagePath);
+    if (QFileInfo::exists(cache_path)) {
+        auto cached = readTextureCache(cache_path);
+        if (nullptr != cached && source_size == cached->sourceSize && source_modified == cached->sourceModified) {
+            return cached;
+        }
+    }
+    if (JobSystem::cancellationRequested()) {
+        return nullptr;
+    }
+    auto chain = buildMipLevels(decodeImage(imagePath));
+    if (nullptr == chain) {
+        return nullptr;
+    }
+    chain->sourceSize = source_size;
+    chain->sourceModified = source_modified;
+    //a failed write only costs the next load a decode
+    writeTextureCache(cache_path, *chain);
+    return chain;
+}
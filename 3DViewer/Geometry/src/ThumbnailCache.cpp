@@ -0,0 +1,145 @@
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+
+#include "ThumbnailCache.h"
+#include "BinaryImporters.h"
+#include "IndexedMesh.h"
+#include "JobSystem.h"
+#include "MeshCache.h"
+#include "MeshCodec.h"
+#include "ObjStreamReader.h"
+
+namespace {
+    //keys of the png text chunks identifying the version of the model
+    constexpr auto SOURCE_SIZE_KEY = "3DViewer-SourceSize";
+    constexpr auto SOURCE_MODIFIED_KEY = "3DViewer-SourceModified";
+    //bytes of the indexed mesh and the soup built from a byte of the file, a binary stl triangle
+    //of 50 bytes becomes 96 bytes of soup, indexed formats share their vertices between the corners
+    constexpr std::uint64_t STL_BUILD_FACTOR = 3;
+    constexpr std::uint64_t INDEXED_BUILD_FACTOR = 6;
+    constexpr std::uint64_t OBJ_BUILD_FACTOR = 4;
+    constexpr std::uint64_t COMPRESSED_BUILD_FACTOR = 10;
+
+    bool soupFromIndexedMesh(std::unique_ptr<IndexedMesh> mesh, MappedArray<Vertex>& soup)
+    {
+        return nullptr != mesh && mesh->numberOfTriangles() > 0 &&
+            MESH_API::computeVertexNormals(*mesh) && MESH_API::buildTriangleSoup(*mesh, soup);
+    }
+}
+
+QString THUMBNAIL_API::cachePath(const QString& modelPath, int size)
+{
+    const auto key = QCryptographicHash::hash(QFileInfo(modelPath).absoluteFilePath().toUtf8(), QCryptographicHash::Sha1).toHex();
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/thumbnails/" +
+        QString::fromLatin1(key) + "_" + QString::number(size) + ".png";
+}
+
+QImage THUMBNAIL_API::readThumbnail(const QString& modelPath, int size)
+{
+    const QFileInfo info(modelPath);
+    const auto cache_path = cachePath(modelPath, size);
+    if (!info.exists() || !QFileInfo::exists(cache_path)) {
+        return QImage();
+    }
+    QImageReader reader(cache_path, "png");
+    //the text chunks come before the pixels, a stale preview is not decoded
+    if (reader.text(SOURCE_SIZE_KEY) != QString::number(info.size()) ||
+        reader.text(SOURCE_MODIFIED_KEY) != QString::number(info.lastModified().toMSecsSinceEpoch())) {
+        return QImage();
+    }
+    const auto image = reader.read();
+    if (image.isNull() || image.size() != QSize(size, size)) {
+        return QImage();
+    }
+    return image;
+}
+
+bool THUMBNAIL_API::writeThumbnail(const QString& modelPath, const QImage& image)
+{
+    const QFileInfo info(modelPath);
+    if (!info.exists() || image.isNull() || image.width() != image.height()) {
+        return false;
+    }
+    const auto cache_path = cachePath(modelPath, image.width());
+    QDir().mkpath(QFileInfo(cache_path).absolutePath());
+    QSaveFile file(cache_path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCritical() << "Critical: cannot open thumbnail cache file " << cache_path;
+        return false;
+    }
+    auto tagged = image;
+    tagged.setText(SOURCE_SIZE_KEY, QString::number(info.size()));
+    tagged.setText(SOURCE_MODIFIED_KEY, QString::number(info.lastModified().toMSecsSinceEpoch()));
+    if (!tagged.save(&file, "png") || !file.commit()) {
+        qCritical() << "Critical: cannot write thumbnail cache file " << cache_path;
+        return false;
+    }
+    return true;
+}
+
+std::uint64_t THUMBNAIL_API::estimateBuildBytes(const QString& modelPath)
+{
+    const QFileInfo info(modelPath);
+    const auto size = static_cast<std::uint64_t>(std::max<qint64>(0, info.size()));
+    const auto suffix = info.suffix().toLower();
+    if (CACHE_API::FILE_SUFFIX == suffix) {
+        //the cache is the soup itself
+        return size;
+    }
+    if (CODEC_API::FILE_SUFFIX == suffix) {
+        return size * COMPRESSED_BUILD_FACTOR;
+    }
+    if ("stl" == suffix) {
+        return size * STL_BUILD_FACTOR;
+    }
+    if ("ply" == suffix || "glb" == suffix) {
+        return size * INDEXED_BUILD_FACTOR;
+    }
+    return size * OBJ_BUILD_FACTOR;
+}
+
+bool THUMBNAIL_API::buildPreviewMesh(const QString& modelPath, MappedArray<Vertex>& preview, QVector3D& minBounds, QVector3D& maxBounds)
+{
+    const auto suffix = QFileInfo(modelPath).suffix().toLower();
+    const auto file = modelPath.toStdString();
+    MappedArray<Vertex> soup;
+    bool loaded = false;
+    if (CACHE_API::FILE_SUFFIX == suffix || CODEC_API::FILE_SUFFIX == suffix) {
+        auto cached = (CACHE_API::FILE_SUFFIX == suffix) ? CACHE_API::readMeshCache(modelPath) : CODEC_API::readCompressedMesh(modelPath);
+        if (nullptr != cached) {
+            soup = std::move(cached->vertices);
+            loaded = true;
+        }
+    }
+    else if ("stl" == suffix) {
+        loaded = soupFromIndexedMesh(IMPORT_API::constructMeshFromStl(file), soup);
+    }
+    else if ("ply" == suffix) {
+        loaded = soupFromIndexedMesh(IMPORT_API::constructMeshFromPly(file), soup);
+    }
+    else if ("glb" == suffix) {
+        loaded = soupFromIndexedMesh(IMPORT_API::constructMeshFromGlb(file), soup);
+    }
+    else if ("obj" == suffix) {
+        //the streaming reader skips the validation of the surface mesh, a preview does not need it
+        //and vertex only scans come out without triangles
+        loaded = soupFromIndexedMesh(OBJ_STREAM_API::constructMeshFromObj(file), soup);
+    }
+    if (!loaded || soup.isEmpty() || JobSystem::cancellationRequested()) {
+        return false;
+    }
+    MESH_API::computeBounds(soup, minBounds, maxBounds);
+    if (soup.size() / 3 <= PREVIEW_TRIANGLES) {
+        preview = std::move(soup);
+        return true;
+    }
+    return MESH_API::buildClusteredProxy(soup, minBounds, maxBounds, PREVIEW_TRIANGLES, preview);
+}
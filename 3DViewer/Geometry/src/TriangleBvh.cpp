@@ -0,0 +1,439 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <mutex>
+
+#include "TriangleBvh.h"
+#include "JobSystem.h"
+
+namespace {
+    constexpr std::uint64_t GATHER_GRAIN = 64 * 1024;
+    constexpr std::uint64_t LEAF_PAIR_GRAIN = 256;
+    // traversal steps between two cancellation checks
+    constexpr std::uint32_t CANCEL_CHECK_STEPS = 4096;
+
+    struct Box {
+        QVector3D min;
+        QVector3D max;
+    };
+
+    inline float clamp01(float value)
+    {
+        return std::min(1.0f, std::max(0.0f, value));
+    }
+
+    float boxDistanceSquared(const Box& a, const Box& b)
+    {
+        float distance = 0.0f;
+        for (int axis = 0; axis < 3; ++axis) {
+            const float gap = std::max({ 0.0f, b.min[axis] - a.max[axis], a.min[axis] - b.max[axis] });
+            distance += gap * gap;
+        }
+        return distance;
+    }
+
+    Box transformBox(const QMatrix4x4& matrix, const QVector3D& min, const QVector3D& max)
+    {
+        Box box{ QVector3D(1.0f, 1.0f, 1.0f) * std::numeric_limits<float>::max(), QVector3D(1.0f, 1.0f, 1.0f) * -std::numeric_limits<float>::max() };
+        for (int bits = 0; bits < 8; ++bits) {
+            const auto corner = matrix.map(QVector3D((bits & 1) ? max.x() : min.x(), (bits & 2) ? max.y() : min.y(), (bits & 4) ? max.z() : min.z()));
+            for (int axis = 0; axis < 3; ++axis) {
+                box.min[axis] = std::min(box.min[axis], corner[axis]);
+                box.max[axis] = std::max(box.max[axis], corner[axis]);
+            }
+        }
+        return box;
+    }
+
+    inline float extent(const Box& box)
+    {
+        return (box.max - box.min).lengthSquared();
+    }
+
+    //closest points of two segments, Ericson's Real-Time Collision Detection 5.1.9
+    float segmentDistanceSquared(const QVector3D& p1, const QVector3D& q1, const QVector3D& p2, const QVector3D& q2)
+    {
+        constexpr float EPSILON = 1e-12f;
+        const auto d1 = q1 - p1;
+        const auto d2 = q2 - p2;
+        const auto r = p1 - p2;
+        const float a = QVector3D::dotProduct(d1, d1);
+        const float e = QVector3D::dotProduct(d2, d2);
+        const float f = QVector3D::dotProduct(d2, r);
+        float s = 0.0f;
+        float t = 0.0f;
+        if (a <= EPSILON && e <= EPSILON) {
+            return r.lengthSquared();
+        }
+        if (a <= EPSILON) {
+            t = clamp01(f / e);
+        }
+        else {
+            const float c = QVector3D::dotProduct(d1, r);
+            if (e <= EPSILON) {
+                s = clamp01(-c / a);
+            }
+            else {
+                const float b = QVector3D::dotProduct(d1, d2);
+                const float denominator = a * e - b * b;
+                s = denominator != 0.0f ? clamp01((b * f - c * e) / denominator) : 0.0f;
+                t = (b * s + f) / e;
+                if (t < 0.0f) {
+                    t = 0.0f;
+                    s = clamp01(-c / a);
+                }
+                else if (t > 1.0f) {
+                    t = 1.0f;
+                    s = clamp01((b - c) / a);
+                }
+            }
+        }
+        return ((p1 + d1 * s) - (p2 + d2 * t)).lengthSquared();
+    }
+
+    //Ericson 5.1.5, by the Voronoi regions of the triangle
+    QVector3D closestPointOnTriangle(const QVector3D& p, const QVector3D& a, const QVector3D& b, const QVector3D& c)
+    {
+        const auto ab = b - a;
+        const auto ac = c - a;
+        const auto ap = p - a;
+        const float d1 = QVector3D::dotProduct(ab, ap);
+        const float d2 = QVector3D::dotProduct(ac, ap);
+        if (d1 <= 0.0f && d2 <= 0.0f) {
+            return a;
+        }
+        const auto bp = p - b;
+        const float d3 = QVector3D::dotProduct(ab, bp);
+        const float d4 = QVector3D::dotProduct(ac, bp);
+        if (d3 >= 0.0f && d4 <= d3) {
+            return b;
+        }
+        const float vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+            return a + ab * (d1 / (d1 - d3));
+        }
+        const auto cp = p - c;
+        const float d5 = QVector3D::dotProduct(ab, cp);
+        const float d6 = QVector3D::dotProduct(ac, cp);
+        if (d6 >= 0.0f && d5 <= d6) {
+            return c;
+        }
+        const float vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+            return a + ac * (d2 / (d2 - d6));
+        }
+        const float va = d3 * d6 - d5 * d4;
+        if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+            return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+        }
+        const float denominator = 1.0f / (va + vb + vc);
+        return a + ab * (vb * denominator) + ac * (vc * denominator);
+    }
+
+    //Moller-Trumbore limited to the segment, both sides of the triangle
+    bool segmentCrossesTriangle(const QVector3D& p, const QVector3D& q, const QVector3D* triangle)
+    {
+        const auto direction = q - p;
+        const auto e1 = triangle[1] - triangle[0];
+        const auto e2 = triangle[2] - triangle[0];
+        const auto h = QVector3D::crossProduct(direction, e2);
+        const float determinant = QVector3D::dotProduct(e1, h);
+        //parallel, a coplanar contact is found by the distances
+        if (0.0f == determinant) {
+            return false;
+        }
+        const float inverse = 1.0f / determinant;
+        const auto s = p - triangle[0];
+        const float u = inverse * QVector3D::dotProduct(s, h);
+        if (u < 0.0f || u > 1.0f) {
+            return false;
+        }
+        const auto qv = QVector3D::crossProduct(s, e1);
+        const float v = inverse * QVector3D::dotProduct(direction, qv);
+        if (v < 0.0f || u + v > 1.0f) {
+            return false;
+        }
+        const float t = inverse * QVector3D::dotProduct(e2, qv);
+        return t >= 0.0f && t <= 1.0f;
+    }
+
+    Box triangleBox(const QVector3D* corners)
+    {
+        Box box{ corners[0], corners[0] };
+        for (int c = 1; c < 3; ++c) {
+            for (int axis = 0; axis < 3; ++axis) {
+                box.min[axis] = std::min(box.min[axis], corners[c][axis]);
+                box.max[axis] = std::max(box.max[axis], corners[c][axis]);
+            }
+        }
+        return box;
+    }
+
+    std::vector<std::uint32_t> flaggedIndices(const std::unique_ptr<std::atomic<bool>[]>& flags, std::uint64_t count)
+    {
+        std::vector<std::uint32_t> indices;
+        for (std::uint64_t i = 0; i < count; ++i) {
+            if (flags[i].load(std::memory_order_relaxed)) {
+                indices.push_back(static_cast<std::uint32_t>(i));
+            }
+        }
+        return indices;
+    }
+}
+
+bool BVH_API::gatherTriangles(const MappedArray<Vertex>& soup, TriangleBvh& bvh)
+{
+    const std::uint64_t num_triangles = soup.size() / 3;
+    bvh.nodes.clear();
+    if (num_triangles > std::numeric_limits<std::uint32_t>::max() || !bvh.triangles.allocate(num_triangles)) {
+        return false;
+    }
+    JobSystem::instance().parallelFor(num_triangles, GATHER_GRAIN, [&](std::uint64_t begin, std::uint64_t end) {
+        for (std::uint64_t t = begin; t < end; ++t) {
+            auto& triangle = bvh.triangles[t];
+            for (int c = 0; c < 3; ++c) {
+                triangle.corners[c] = soup[t * 3 + c].position;
+            }
+        }
+    });
+    return !JobSystem::cancellationRequested();
+}
+
+bool BVH_API::buildHierarchy(TriangleBvh& bvh)
+{
+    bvh.nodes.clear();
+    const auto num_triangles = static_cast<std::uint32_t>(bvh.triangles.size());
+    if (0 == num_triangles) {
+        return true;
+    }
+    bvh.nodes.reserve(2 * (num_triangles / LEAF_TRIANGLES + 1));
+    const auto centroid = [](const BvhTriangle& triangle, int axis) {
+        return triangle.corners[0][axis] + triangle.corners[1][axis] + triangle.corners[2][axis];
+    };
+    struct Range {
+        std::uint32_t begin;
+        std::uint32_t end;
+        // node waiting for its right child, -1 for the root and the left children
+        std::int64_t parent;
+    };
+    //the left child is always built right after its parent, the right one once the left subtree is done
+    std::vector<Range> stack;
+    stack.push_back({ 0, num_triangles, -1 });
+    std::uint32_t steps = 0;
+    while (!stack.empty()) {
+        if (0 == ++steps % CANCEL_CHECK_STEPS && JobSystem::cancellationRequested()) {
+            return false;
+        }
+        const auto range = stack.back();
+        stack.pop_back();
+        const auto index = static_cast<std::uint32_t>(bvh.nodes.size());
+        if (range.parent >= 0) {
+            bvh.nodes[range.parent].first = index;
+        }
+        BvhNode node;
+        node.minBounds = QVector3D(1.0f, 1.0f, 1.0f) * std::numeric_limits<float>::max();
+        node.maxBounds = -node.minBounds;
+        QVector3D centroid_min = node.minBounds;
+        QVector3D centroid_max = node.maxBounds;
+        for (auto t = range.begin; t < range.end; ++t) {
+            const auto& triangle = bvh.triangles[t];
+            for (int axis = 0; axis < 3; ++axis) {
+                for (int c = 0; c < 3; ++c) {
+                    node.minBounds[axis] = std::min(node.minBounds[axis], triangle.corners[c][axis]);
+                    node.maxBounds[axis] = std::max(node.maxBounds[axis], triangle.corners[c][axis]);
+                }
+                centroid_min[axis] = std::min(centroid_min[axis], centroid(triangle, axis));
+                centroid_max[axis] = std::max(centroid_max[axis], centroid(triangle, axis));
+            }
+        }
+        const auto count = range.end - range.begin;
+        if (count <= LEAF_TRIANGLES) {
+            node.first = range.begin;
+            node.count = count;
+            bvh.nodes.push_back(node);
+            continue;
+        }
+        bvh.nodes.push_back(node);
+        const auto spread = centroid_max - centroid_min;
+        const int axis = spread.x() >= spread.y() && spread.x() >= spread.z() ? 0 : (spread.y() >= spread.z() ? 1 : 2);
+        const auto middle = range.begin + count / 2;
+        //coincident centroids are split in the middle as they are
+        if (spread[axis] > 0.0f) {
+            std::nth_element(bvh.triangles.begin() + range.begin, bvh.triangles.begin() + middle, bvh.triangles.begin() + range.end,
+                [&centroid, axis](const BvhTriangle& a, const BvhTriangle& b) { return centroid(a, axis) < centroid(b, axis); });
+        }
+        stack.push_back({ middle, range.end, index });
+        stack.push_back({ range.begin, middle, -1 });
+    }
+    return true;
+}
+
+float BVH_API::triangleDistance(const QVector3D* a, const QVector3D* b)
+{
+    for (int e = 0; e < 3; ++e) {
+        if (segmentCrossesTriangle(a[e], a[(e + 1) % 3], b) || segmentCrossesTriangle(b[e], b[(e + 1) % 3], a)) {
+            return 0.0f;
+        }
+    }
+    //apart, the closest points are on two edges or a corner and a face
+    float distance = std::numeric_limits<float>::max();
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            distance = std::min(distance, segmentDistanceSquared(a[i], a[(i + 1) % 3], b[j], b[(j + 1) % 3]));
+        }
+        distance = std::min(distance, (a[i] - closestPointOnTriangle(a[i], b[0], b[1], b[2])).lengthSquared());
+        distance = std::min(distance, (b[i] - closestPointOnTriangle(b[i], a[0], a[1], a[2])).lengthSquared());
+    }
+    return std::sqrt(distance);
+}
+
+bool BVH_API::findCloseTriangles(const TriangleBvh& a, const TriangleBvh& b, const QMatrix4x4& bToA, float clearance,
+    Proximity& result)
+{
+    result = Proximity();
+    if (a.nodes.empty() || b.nodes.empty()) {
+        return true;
+    }
+    //the boxes of b are placed once, the smaller hierarchy takes that
+    if (b.nodes.size() > a.nodes.size()) {
+        const bool found = findCloseTriangles(b, a, bToA.inverted(), clearance, result);
+        std::swap(result.trianglesA, result.trianglesB);
+        return found;
+    }
+    std::vector<Box> b_boxes(b.nodes.size());
+    JobSystem::instance().parallelFor(b.nodes.size(), GATHER_GRAIN, [&](std::uint64_t begin, std::uint64_t end) {
+        for (auto i = begin; i < end; ++i) {
+            b_boxes[i] = transformBox(bToA, b.nodes[i].minBounds, b.nodes[i].maxBounds);
+        }
+    });
+
+    const float clearance_squared = clearance * clearance;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> leaf_pairs;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> stack;
+    stack.emplace_back(0, 0);
+    std::uint32_t steps = 0;
+    while (!stack.empty()) {
+        if (0 == ++steps % CANCEL_CHECK_STEPS && JobSystem::cancellationRequested()) {
+            return false;
+        }
+        const auto pair = stack.back();
+        stack.pop_back();
+        const auto& node_a = a.nodes[pair.first];
+        const auto& node_b = b.nodes[pair.second];
+        const Box box_a{ node_a.minBounds, node_a.maxBounds };
+        if (boxDistanceSquared(box_a, b_boxes[pair.second]) > clearance_squared) {
+            continue;
+        }
+        if (node_a.isLeaf() && node_b.isLeaf()) {
+            leaf_pairs.push_back(pair);
+        }
+        //the bigger box is split first
+        else if (node_b.isLeaf() || (!node_a.isLeaf() && extent(box_a) >= extent(b_boxes[pair.second]))) {
+            stack.emplace_back(pair.first + 1, pair.second);
+            stack.emplace_back(node_a.first, pair.second);
+        }
+        else {
+            stack.emplace_back(pair.first, pair.second + 1);
+            stack.emplace_back(pair.first, node_b.first);
+        }
+    }
+
+    //a pair of triangles both known to be close is tested only when it may lower the distance
+    //or reveal the first crossing, overlapping surfaces skip most of their pairs that way
+    std::unique_ptr<std::atomic<bool>[]> close_a(new std::atomic<bool>[a.triangles.size()]());
+    std::unique_ptr<std::atomic<bool>[]> close_b(new std::atomic<bool>[b.triangles.size()]());
+    std::atomic<bool> intersecting{ false };
+    std::mutex result_mutex;
+    JobSystem::instance().parallelFor(leaf_pairs.size(), LEAF_PAIR_GRAIN, [&](std::uint64_t begin, std::uint64_t end) {
+        float best = std::numeric_limits<float>::max();
+        for (auto i = begin; i < end; ++i) {
+            const auto& leaf_a = a.nodes[leaf_pairs[i].first];
+            const auto& leaf_b = b.nodes[leaf_pairs[i].second];
+            for (auto tb = leaf_b.first; tb < leaf_b.first + leaf_b.count; ++tb) {
+                const auto& triangle_b = b.triangles[tb];
+                const QVector3D placed[3] = { bToA.map(triangle_b.corners[0]), bToA.map(triangle_b.corners[1]), bToA.map(triangle_b.corners[2]) };
+                const auto box_b = triangleBox(placed);
+                for (auto ta = leaf_a.first; ta < leaf_a.first + leaf_a.count; ++ta) {
+                    const auto& triangle_a = a.triangles[ta];
+                    const float box_distance = std::sqrt(boxDistanceSquared(triangleBox(triangle_a.corners), box_b));
+                    if (box_distance > clearance) {
+                        continue;
+                    }
+                    if (close_a[ta].load(std::memory_order_relaxed) && close_b[tb].load(std::memory_order_relaxed) &&
+                        box_distance >= best && (box_distance > 0.0f || intersecting.load(std::memory_order_relaxed))) {
+                        continue;
+                    }
+                    const float distance = triangleDistance(triangle_a.corners, placed);
+                    if (distance > clearance) {
+                        continue;
+                    }
+                    best = std::min(best, distance);
+                    if (0.0f == distance) {
+                        intersecting.store(true, std::memory_order_relaxed);
+                    }
+                    close_a[ta].store(true, std::memory_order_relaxed);
+                    close_b[tb].store(true, std::memory_order_relaxed);
+                }
+            }
+        }
+        std::lock_guard<std::mutex> lock(result_mutex);
+        result.distance = std::min(result.distance, best);
+    });
+    if (JobSystem::cancellationRequested()) {
+        return false;
+    }
+    result.intersecting = intersecting.load();
+    result.trianglesA = flaggedIndices(close_a, a.triangles.size());
+    result.trianglesB = flaggedIndices(close_b, b.triangles.size());
+    return true;
+}
+
+float BVH_API::pointDistance(const TriangleBvh& bvh, const QVector3D& point)
+{
+    const auto pointBoxSquared = [&point](const BvhNode& node) {
+        float distance = 0.0f;
+        for (int axis = 0; axis < 3; ++axis) {
+            const float gap = std::max({ 0.0f, node.minBounds[axis] - point[axis], point[axis] - node.maxBounds[axis] });
+            distance += gap * gap;
+        }
+        return distance;
+    };
+    float best = std::numeric_limits<float>::max();
+    if (bvh.nodes.empty()) {
+        return best;
+    }
+    //nodes with the squared distance of their box when pushed
+    std::vector<std::pair<std::uint32_t, float>> stack;
+    stack.emplace_back(0, pointBoxSquared(bvh.nodes.front()));
+    while (!stack.empty()) {
+        const auto entry = stack.back();
+        stack.pop_back();
+        if (entry.second >= best) {
+            continue;
+        }
+        const auto& node = bvh.nodes[entry.first];
+        if (node.isLeaf()) {
+            for (auto t = node.first; t < node.first + node.count; ++t) {
+                const auto& corners = bvh.triangles[t].corners;
+                best = std::min(best, (closestPointOnTriangle(point, corners[0], corners[1], corners[2]) - point).lengthSquared());
+            }
+            continue;
+        }
+        const std::uint32_t left = entry.first + 1;
+        const std::uint32_t right = node.first;
+        const float left_distance = pointBoxSquared(bvh.nodes[left]);
+        const float right_distance = pointBoxSquared(bvh.nodes[right]);
+        //the nearer child goes on top
+        if (left_distance < right_distance) {
+            stack.emplace_back(right, right_distance);
+            stack.emplace_back(left, left_distance);
+        }
+        else {
+            stack.emplace_back(left, left_distance);
+            stack.emplace_back(right, right_distance);
+        }
+    }
+    return std::sqrt(best);
+}
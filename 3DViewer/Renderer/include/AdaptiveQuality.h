@@ -0,0 +1,70 @@
+#pragma once
+#include <array>
+
+// Picks the representation drawn while the user drags or zooms. The GPU time of the drawn frames
+// is measured per level, when the one drawn exceeds the target the next frames fall back to the
+// clustered proxy and then to the bounding box. A cheap level tries the finer one again after a
+// delay, which doubles every time the finer one turns out too slow. The level reached is kept for
+// the next interaction with the same object, full quality returns once the input stops, and full
+// frames drawn meanwhile fitting the target let the next interaction start in full again.
+class AdaptiveQuality {
+public:
+	enum class Level {
+		FULL,
+		PROXY,
+		BOUNDS
+	};
+	static constexpr int LEVEL_COUNT = 3;
+	static constexpr double DEFAULT_TARGET_FRAME_TIME = 1.0 / 30.0;
+	// quiet time after the last input event which ends the interaction
+	static constexpr double RESTORE_DELAY = 0.15;
+	// weight of the newest frame time in the moving average
+	static constexpr double SMOOTHING = 0.3;
+	// frame times measured before a level is judged, a single stall does not degrade it
+	static constexpr int MIN_SAMPLES = 3;
+	// a cheaper level tries the finer one again below this fraction of the target
+	static constexpr double UPGRADE_HEADROOM = 0.5;
+	// time spent on a cheaper level before the finer one is tried again, doubled up to the maximum
+	// every time the finer one turns out too slow
+	static constexpr double UPGRADE_DELAY = 1.0;
+	static constexpr double MAX_UPGRADE_DELAY = 8.0;
+
+	explicit AdaptiveQuality(double targetFrameTime = DEFAULT_TARGET_FRAME_TIME);
+
+	void inputReceived(double now);
+	// level of the frame painted at the time now, times are in seconds of a monotonic clock
+	Level beginFrame(double now, bool hasProxy);
+	// time the GPU spent on a frame drawn at the level, reported once it is known
+	void frameTimed(Level level, double seconds);
+	// forgets the measurements, for a newly selected object
+	void reset();
+
+	inline bool	  isInteracting(double now) const { return now - this->m_lastInput < RESTORE_DELAY; }
+	inline Level  getLevel()				const { return this->m_level; }
+	inline double getAverageFrameTime(Level level) const { return this->m_frameTimes[static_cast<int>(level)]; }
+	inline double getTargetFrameTime()		const { return this->m_targetFrameTime; }
+	inline void	  setTargetFrameTime(double seconds) { this->m_targetFrameTime = seconds; }
+
+	static const char* levelName(Level level);
+
+private:
+	Level degrade(Level level, bool hasProxy) const;
+	Level upgrade(Level level, bool hasProxy) const;
+	// judged once it has enough samples
+	bool isMeasured(Level level) const;
+	// the next samples of the level are measured from scratch
+	void enter(Level level, double now);
+
+	double m_targetFrameTime;
+	double m_lastInput = -1.0;
+	std::array<double, LEVEL_COUNT> m_frameTimes{};
+	std::array<int, LEVEL_COUNT> m_samples{};
+	bool m_interacting = false;
+	Level m_level = Level::FULL;
+	// level the previous interaction ended with
+	Level m_interactionLevel = Level::FULL;
+	double m_levelStart = 0.0;
+	double m_upgradeDelay = UPGRADE_DELAY;
+	// the level was entered by trying a finer one again, it is not proven yet
+	bool m_probing = false;
+};
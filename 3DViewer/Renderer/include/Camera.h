@@ -13,6 +13,14 @@ enum class CameraMovement {
     RIGHT
 };
 
+// everything needed to put the camera back where it was
+struct CameraState {
+    QVector3D position;
+    float yaw;
+    float pitch;
+    float zoom;
+};
+
 class Camera {
 public:
     Camera(const QVector3D& m_position = { 0.0f, 0.0f, 20.0f });
@@ -20,6 +28,8 @@ public:
     // Getters for camera vectors and matrices
     QMatrix4x4 getViewMatrix();
     inline float getZoom() const { return this->m_zoom; }
+    inline CameraState getState() const { return { m_position, m_yaw, m_pitch, m_zoom }; }
+    void setState(const CameraState& state);
     // Input handling functions
     void processMouseScroll(float yOffset);
     void processKeyboard(CameraMovement direction, float deltaTime);
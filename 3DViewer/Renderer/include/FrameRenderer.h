@@ -0,0 +1,220 @@
+#pragma once
+#include <QObject>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLWidget>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions_3_3_Core>
+#include <QElapsedTimer>
+#include <QMutex>
+
+#include <array>
+#include <atomic>
+#include <unordered_map>
+
+#include "AdaptiveQuality.h"
+#include "GpuUploader.h"
+#include "PointCloudStreamer.h"
+#include "OcclusionCuller.h"
+#include "SceneSnapshot.h"
+#include "TextureStreamer.h"
+#include "TripleBuffer.h"
+
+// Draws the frames on a thread of its own from the snapshots published by the GUI thread, so a
+// heavy frame never holds up the input and the input never holds up a frame. The thread draws
+// with a context of its own that shares the objects of the widget, into a framebuffer of its own.
+// A finished frame is resolved into one of two textures and presented, the widget blits the one
+// presented last whenever it composes, so no frame waits for the GUI event loop.
+class FrameRenderer : public QObject, protected QOpenGLFunctions_3_3_Core {
+	Q_OBJECT
+public:
+	static constexpr float POINT_SIZE = 2.0f;
+	static constexpr float NEAR_PLANE = 0.1f;
+	static constexpr float FAR_PLANE = 10000.0f;
+	static constexpr int SAMPLES = 4;
+	// section colors as fractions of the material color
+	static constexpr float CAP_SHADE = 0.6f;
+	static constexpr float CONTOUR_SHADE = 0.25f;
+	// triangles closer than the clearance to another object
+	static constexpr QVector3D CONTACT_COLOR = QVector3D(0.9f, 0.15f, 0.1f);
+	// fences not signaled yet are looked at again after this long instead of on a frame drawn at once
+	static constexpr int FENCE_POLL_MS = 4;
+	// GPU timings of the selected object in flight, a frame is not timed while all of them are
+	static constexpr int FRAME_QUERIES = 4;
+	// field buffers no longer shown are kept up to this size, switching back to their object reuses them
+	static constexpr std::uint64_t IDLE_FIELD_BYTES = 64ull * 1024 * 1024;
+	// the field buffers of the renderer in the shared caches of the memory report
+	static constexpr const char* FIELD_BUFFER_CACHE = "field buffers";
+
+	explicit FrameRenderer(QOpenGLWidget* widget);
+
+	// the GUI thread writes the back slot and publishes it
+	inline TripleBuffer<SceneSnapshot>& snapshots() { return this->m_snapshots; }
+	// monotonic clock shared by both threads, in seconds
+	inline double seconds() const { return static_cast<double>(this->m_timer.nsecsElapsed()) / 1000000000.0; }
+	// frames drawn since the previous call
+	inline int takeFrameCount() { return this->m_frames.exchange(0); }
+	inline OcclusionCuller::Stats getOcclusionStats() const {
+		OcclusionCuller::Stats stats;
+		stats.visible = this->m_occlusionVisible.load();
+		stats.occluded = this->m_occlusionOccluded.load();
+		stats.savedTriangles = this->m_occlusionSaved.load();
+		return stats;
+	}
+
+	// GUI thread, with the widget context current; the render context and the uploader share it
+	void createContexts(QOpenGLContext* widgetContext);
+	// render thread, invoked by the GUI thread before it stops the thread
+	void destroy();
+
+	inline bool isExiting() const { return this->m_exiting.load(); }
+	void prepareExit();
+	// size of the widget framebuffer in pixels, any thread
+	void setTargetSize(const QSize& size);
+	// GUI thread with the widget context current, blits the frame presented last into the target
+	void compose(GLuint targetFramebuffer, const QSize& targetSize);
+	// GUI thread with the widget context current, once no more frames are composed
+	void releaseCompose();
+
+	void drawObject(SceneObject& obj);
+	void initObjectBuffers(SceneObject& obj);
+	// draws vertices of the bound chunk split by their materials, first is relative to the chunk
+	void drawChunkRange(const SceneObject& obj, const BufferChunk& chunk, std::uint64_t first, std::uint64_t count);
+
+public slots:
+	// any thread, requests made before the frame starts are merged into it
+	void requestFrame();
+	// a frame once the poll interval has passed, requests made meanwhile are merged into it
+	void requestFencePoll();
+	void render();
+
+signals:
+	void qualityChanged(QString);
+	void geometrySwapped(unsigned int objId);
+	// a replayed frame finished on the GPU, drawing alone
+	void frameTimed(quint64 timedFrame, double milliseconds);
+
+private:
+	void initialize();
+	void initializeShaders();
+	void paint(const SceneSnapshot& snapshot);
+	// resolves the drawn frame into the texture the widget does not compose and presents it
+	void present(const QSize& size);
+	// false while the geometry of the selected object is still on its way
+	bool drawCurrent(const SceneSnapshot& snapshot);
+	void takeSnapshot();
+	void releaseRemovedObjects(const SceneSnapshot& snapshot);
+	void swapPendingGeometry(const SceneSnapshot& snapshot);
+	bool prepareObjectBuffers(const std::shared_ptr<SceneObject>& obj);
+	void prepareProxyBuffers(const std::shared_ptr<SceneObject>& obj);
+	void setupVertexArray(BufferChunk& chunk);
+	void drawProxy(SceneObject& obj);
+	void drawBounds(const SceneObject& obj);
+	void drawPointCloud(const SceneSnapshot::Object& entry, const SceneSnapshot& snapshot);
+	void drawCulled(const std::shared_ptr<SceneObject>& obj, const SceneSnapshot& snapshot);
+	void drawSection(const SceneSnapshot& snapshot, const SceneObject& obj, const QVector3D& normal, float offset);
+	void uploadSection(const std::shared_ptr<const CrossSection>& cut);
+	void drawContacts(const SceneSnapshot& snapshot, const SceneSnapshot::Object& entry);
+	// points the vertex arrays of the object at the values of its field, false while none is shown
+	bool bindField(const SceneSnapshot::Object& entry);
+	// deletes the least recently shown field buffers beyond the idle size
+	void releaseFieldBuffers(const SceneSnapshot& snapshot, std::uint64_t idleBytes = IDLE_FIELD_BYTES);
+	void transform(const SceneSnapshot& snapshot, const SceneSnapshot::Object& obj);
+	void setUniforms(const SceneSnapshot& snapshot);
+	// -1 restores the untextured material of the snapshot
+	void bindMaterial(const SceneObject& obj, int material);
+	float pixelsPerUnit(const SceneSnapshot& snapshot) const;
+	// hands the GPU times known by now to the adaptive quality, never waits for one
+	void collectFrameTimes();
+
+	QOpenGLWidget* m_widget;
+	TripleBuffer<SceneSnapshot> m_snapshots;
+	QElapsedTimer m_timer;
+
+	std::unique_ptr<QOffscreenSurface> m_surface;
+	std::unique_ptr<QOpenGLContext> m_context;
+	// resolved frames, the render thread fills one while the widget composes the other
+	struct PresentedFrame {
+		std::unique_ptr<QOpenGLFramebufferObject> target;
+		// signaled once the frame is drawn, the composition waits for it on the GPU
+		GLsync drawn = nullptr;
+		// signaled once the widget read the frame, the next frame into it waits for it on the GPU
+		GLsync composed = nullptr;
+	};
+	std::array<PresentedFrame, 2> m_presented;
+	// guards the presented frames, the index of the one presented last and the target size
+	QMutex m_presentMutex;
+	int m_front = -1;
+	// framebuffer of the widget context the presented texture is attached to for the blit
+	GLuint m_composeFramebuffer = 0;
+	std::atomic<bool> m_exiting{ false };
+	std::atomic<bool> m_frameRequested{ false };
+	std::atomic<bool> m_fencePollRequested{ false };
+	bool m_initialized = false;
+	QSize m_targetSize;
+
+	QMatrix4x4 m_projection;
+	QMatrix4x4 m_view;
+	QMatrix4x4 m_model;
+
+	QOpenGLShaderProgram* m_shaderProgram = nullptr;
+	QOpenGLShaderProgram* m_pointProgram = nullptr;
+	std::unique_ptr<QOpenGLFramebufferObject> m_frameBuffer;
+
+	std::unique_ptr<GpuUploader> m_uploader;
+	std::unique_ptr<TextureStreamer> m_textures;
+	// material whose uniforms are set, -1 for the one of the snapshot
+	int m_boundMaterial = -1;
+	QVector3D m_materialColor;
+	// everything the snapshots handed over, released once it is gone from them
+	std::unordered_map<SceneObject*, std::shared_ptr<SceneObject>> m_residentObjects;
+	// per point cloud object, live while the object is on the scene
+	std::unordered_map<unsigned int, std::unique_ptr<PointCloudStreamer>> m_pointStreamers;
+	std::unordered_map<unsigned int, std::unique_ptr<OcclusionCuller>> m_occlusionCullers;
+
+	QOpenGLBuffer m_boundsVbo;
+	QOpenGLVertexArrayObject m_boundsVao;
+
+	struct SectionContour {
+		GLint first = 0;
+		GLsizei count = 0;
+		bool closed = false;
+	};
+	// cap triangles followed by the contours of the cut last drawn
+	std::shared_ptr<const CrossSection> m_sectionCut;
+	QOpenGLBuffer m_sectionVbo;
+	QOpenGLVertexArrayObject m_sectionVao;
+	GLsizei m_sectionCapCount = 0;
+	std::vector<SectionContour> m_sectionContours;
+
+	// highlight of the selected object last drawn
+	std::shared_ptr<const std::vector<Vertex>> m_contacts;
+	QOpenGLBuffer m_contactsVbo;
+	QOpenGLVertexArrayObject m_contactsVao;
+
+	// per field handed over, the ones gone from the snapshots are dropped least recently shown first
+	std::unordered_map<const ScalarField*, std::shared_ptr<FieldBuffer>> m_fieldBuffers;
+	std::uint64_t m_fieldUses = 0;
+
+	AdaptiveQuality m_quality;
+	AdaptiveQuality::Level m_shownLevel = AdaptiveQuality::Level::FULL;
+	unsigned int m_qualityObjId = 0;
+	struct FrameQuery {
+		GLuint query = 0;
+		bool pending = false;
+		AdaptiveQuality::Level level = AdaptiveQuality::Level::FULL;
+		unsigned int objId = 0;
+	};
+	std::array<FrameQuery, FRAME_QUERIES> m_frameQueries;
+	int m_nextFrameQuery = 0;
+	double m_lastInputTime = -1.0;
+	// replayed frame last reported, the frame may be drawn again before the next one is published
+	std::uint64_t m_timedFrame = 0;
+
+	// read by the status timer of the GUI thread
+	std::atomic<int> m_frames{ 0 };
+	std::atomic<int> m_occlusionVisible{ 0 };
+	std::atomic<int> m_occlusionOccluded{ 0 };
+	std::atomic<std::uint64_t> m_occlusionSaved{ 0 };
+};
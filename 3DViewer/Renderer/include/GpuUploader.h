@@ -0,0 +1,84 @@
+#pragma once
+#include <QObject>
+#include <QThread>
+#include <QOpenGLContext>
+#include <QOffscreenSurface>
+#include <QOpenGLFunctions_3_3_Core>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "ScalarField.h"
+#include "SceneObject.h"
+#include "TextureCache.h"
+#include "TextureStreamer.h"
+
+// values of an analysis field, a vertex stream next to the buffers of its object
+struct FieldBuffer {
+	enum class State {
+		QUEUED,
+		FENCED,
+		READY,
+		FAILED
+	};
+
+	explicit FieldBuffer(const std::shared_ptr<const ScalarField>& field) : field(field) {}
+
+	// held until the upload finished
+	std::shared_ptr<const ScalarField> field;
+	std::atomic<State> state{ State::QUEUED };
+	// set by the uploader before it publishes FENCED, owned by the render thread afterwards
+	GLuint vbo = 0;
+	GLsync fence = nullptr;
+	// render thread only, orders the idle buffers for eviction
+	std::uint64_t lastUsed = 0;
+};
+
+// Uploads object geometry on a worker thread with its own context shared with the renderer.
+// Buffers are filled in bounded blocks and published together with a fence, the render
+// thread only creates its vertex arrays once the fence is signaled, so a frame never uploads.
+// Textures are sent one mip level per event, so a large map never holds up the geometry.
+class GpuUploader : public QObject {
+	Q_OBJECT
+public:
+	//upper bound of a single vertex buffer, bigger objects are split into several buffers
+	static constexpr std::uint64_t MAX_BUFFER_SIZE = 128ull * 1024ull * 1024ull;
+	//amount of data handed to the driver between flushes
+	static constexpr std::uint64_t UPLOAD_BLOCK_SIZE = 8ull * 1024ull * 1024ull;
+
+	// must be created on the GUI thread while the share context is valid
+	explicit GpuUploader(QOpenGLContext* shareContext);
+	~GpuUploader();
+
+	void enqueue(const std::shared_ptr<SceneObject>& obj);
+	// any thread, the levels are uploaded from the coarsest one
+	void enqueueTexture(const std::shared_ptr<StreamedTexture>& texture, const std::shared_ptr<const MipChain>& chain);
+	// any thread, a single buffer as the values take an eighth of the geometry
+	void enqueueField(const std::shared_ptr<FieldBuffer>& buffer);
+
+	// buffers which are no longer used, destroyed by the render thread with its context current
+	static void retire(std::vector<BufferChunk>&& chunks, GLsync fence = nullptr);
+	static void destroyRetired(QOpenGLFunctions_3_3_Core* functions);
+
+signals:
+	void uploadFinished(unsigned int objId);
+	void textureLevelUploaded();
+	void fieldUploaded();
+
+private:
+	void uploadObject(const std::shared_ptr<SceneObject>& obj);
+	void uploadTextureLevel(const std::shared_ptr<StreamedTexture>& texture, const std::shared_ptr<const MipChain>& chain, int level);
+	void uploadField(const std::shared_ptr<FieldBuffer>& buffer);
+	bool makeCurrent();
+
+	QThread m_thread;
+	QOffscreenSurface* m_surface;
+	QOpenGLContext* m_context;
+	QOpenGLFunctions_3_3_Core* m_functions;
+
+	inline static std::mutex s_retiredMutex;
+	inline static std::vector<BufferChunk> s_retiredChunks;
+	inline static std::vector<GLsync> s_retiredFences;
+};
@@ -0,0 +1,83 @@
+#pragma once
+#include <QOpenGLBuffer>
+#include <QOpenGLVertexArrayObject>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLFunctions_3_3_Core>
+#include <QMatrix4x4>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "SceneObject.h"
+
+// Conservative occlusion culling of the clusters of a dense object, e.g. the parts of an
+// interior or an engine bay. The biggest clusters on screen are drawn first, front to back,
+// and fill the depth buffer. Every other cluster is drawn unless the query of its bounding box
+// from the previous frame found no visible sample, then the boxes are queried again. Results
+// are read only once available, so the frame never waits for the GPU.
+class OcclusionCuller {
+public:
+	static constexpr std::uint64_t MIN_CLUSTER_TRIANGLES = 512;
+	// smaller objects are drawn whole, their draw calls and queries cost more than culling saves
+	static constexpr std::uint64_t MIN_CULLED_TRIANGLES = 64 * MIN_CLUSTER_TRIANGLES;
+	// bounds the number of draw calls and queries per frame
+	static constexpr std::uint64_t MAX_CLUSTERS = 1024;
+	static constexpr int MAX_OCCLUDERS = 16;
+	// clusters at least this high on screen are occluders
+	static constexpr float OCCLUDER_SCREEN_FRACTION = 0.25f;
+
+	struct View {
+		QMatrix4x4 model;
+		QMatrix4x4 view;
+		// projected size of a unit at unit distance
+		float pixelsPerUnit;
+		float viewportHeight;
+		float nearPlane;
+		// draws a part of the bound chunk, e.g. split by the materials, a single draw call when empty
+		std::function<void(const BufferChunk&, std::uint64_t, std::uint64_t)> drawRange;
+	};
+	struct Stats {
+		int visible = 0;
+		int occluded = 0;
+		std::uint64_t savedTriangles = 0;
+	};
+
+	// contiguous clusters inside every chunk, run by the uploader; none below MIN_CULLED_TRIANGLES
+	static std::vector<DrawCluster> buildClusters(const MappedArray<Vertex>& vertices, const std::vector<BufferChunk>& chunks);
+
+	explicit OcclusionCuller(const std::shared_ptr<SceneObject>& obj);
+	OcclusionCuller(const OcclusionCuller&) = delete;
+	OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+	// with the render context current
+	void initialize(QOpenGLFunctions_3_3_Core* functions, QOpenGLShaderProgram* program);
+	void destroy(QOpenGLFunctions_3_3_Core* functions);
+	// draws the object with the bound program and uniforms, modelMatrix is changed for the boxes
+	void draw(QOpenGLFunctions_3_3_Core* functions, QOpenGLShaderProgram* program, const View& view);
+
+	// reloaded or uploaded again since the culler was created
+	inline bool isStale() const {
+		return this->m_object->getGeometryVersion() != this->m_geometryVersion ||
+			this->m_object->drawClusters.size() != this->m_queries.size();
+	}
+	inline const Stats& getStats() const { return this->m_stats; }
+
+private:
+	void drawCluster(QOpenGLFunctions_3_3_Core* functions, const DrawCluster& cluster, const View& view);
+
+	std::shared_ptr<SceneObject> m_object;
+	unsigned int m_geometryVersion;
+	std::vector<GLuint> m_queries;
+	// a query was issued and its result is not read yet
+	std::vector<bool> m_pending;
+	// result of the last finished query, clusters start visible
+	std::vector<bool> m_visible;
+	std::vector<std::pair<float, int>> m_order;
+	std::vector<int> m_tested;
+
+	QOpenGLBuffer m_boxVbo;
+	QOpenGLVertexArrayObject m_boxVao;
+
+	Stats m_stats;
+};
@@ -0,0 +1,55 @@
+#pragma once
+#include <QOffscreenSurface>
+#include <QOpenGLBuffer>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions_3_3_Core>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLVertexArrayObject>
+
+#include <memory>
+#include <vector>
+
+#include "SceneObject.h"
+#include "SessionRecording.h"
+
+// Replays a recorded session headless, on machines without a display or a window in the way. The
+// objects of the workspace are uploaded once into a context of its own, then the selected object of
+// every frame is drawn in full with the shaders of the viewer into a multisampled framebuffer of the
+// recorded viewport size. The default material is used without maps or fields, and occlusion culling,
+// the adaptive quality and the overlays are left out, so the timings measure the geometry and the
+// shading alone. They are labelled as such and only compared with other offscreen timings.
+class OffscreenReplay : protected QOpenGLFunctions_3_3_Core {
+public:
+	// must be created on the GUI thread, the frames are drawn on it as well
+	OffscreenReplay();
+	~OffscreenReplay();
+
+	inline bool isAvailable() const { return this->m_available; }
+
+	// draws the frames one after another, each timed until the GPU finished it; objects are indexed
+	// by the frames, false when the context or the buffers cannot be created
+	bool run(const SessionRecording& recording, const std::vector<SessionRecording::Frame>& frames,
+		const QVector<std::shared_ptr<SceneObject>>& objects, FrameTimings& timings);
+
+private:
+	struct Chunk {
+		std::unique_ptr<QOpenGLBuffer> vbo;
+		std::unique_ptr<QOpenGLVertexArrayObject> vao;
+		GLsizei vertexCount = 0;
+	};
+
+	bool initializeResources(const QSize& size);
+	bool uploadObject(const SceneObject& obj, std::vector<Chunk>& chunks);
+	void drawFrame(const SessionRecording& recording, const SessionRecording::Frame& frame,
+		const QVector<std::shared_ptr<SceneObject>>& objects, int current);
+	void releaseResources();
+
+	bool m_available = false;
+	std::unique_ptr<QOffscreenSurface> m_surface;
+	std::unique_ptr<QOpenGLContext> m_context;
+	std::unique_ptr<QOpenGLFramebufferObject> m_frameBuffer;
+	std::unique_ptr<QOpenGLShaderProgram> m_program;
+	// per object of the workspace, empty for the point clouds
+	std::vector<std::vector<Chunk>> m_objectChunks;
+};
@@ -1,30 +1,59 @@
 #pragma once
 #include <QOpenGLWidget>
-#include <QOpenGLShaderProgram>
-#include <QOpenGLShader>
-#include <QOpenGLFunctions_3_3_Core>
-#include <QElapsedTimer>
 #include <QSurfaceFormat>
 #include <QListWidget>
+#include <QThread>
+#include <QTimer>
 
+#include "AdaptiveQuality.h"
 #include "Camera.h"
 #include "Scene.h"
+#include "FrameRenderer.h"
+#include "JobSystem.h"
+#include "SessionRecording.h"
 
+#include <memory>
 
-class OpenGLRenderer : public QOpenGLWidget, protected QOpenGLFunctions_3_3_Core {
+
+// Viewport widget of the GUI thread. It handles the input, owns the camera and publishes a
+// snapshot of the scene on every change, the frames are drawn by the FrameRenderer on the
+// render thread and only composed here.
+class OpenGLRenderer : public QOpenGLWidget {
 	Q_OBJECT
 public:
 	enum class Mode {
 		WIREFRAME,
 		SOLID
 	};
+	// status bar and object details refresh rate, frames are not limited by it
+	static constexpr int STATUS_INTERVAL_MS = 250;
+	// the cut of a moving plane is computed once it rests for this long
+	static constexpr int SECTION_DEBOUNCE_MS = 150;
+	// plane movement as a fraction of the object bounds, per key press and per dragged pixel
+	static constexpr float SECTION_STEP = 0.01f;
+	static constexpr float SECTION_DRAG_SPEED = 0.002f;
+
 	OpenGLRenderer(QWidget* parent = nullptr, const Scene& scene = Scene());
-	~OpenGLRenderer() = default;
+	~OpenGLRenderer();
 
-	void drawObject(SceneObject& obj);
-	void initObjectBuffers(SceneObject& obj);
+	inline Camera& getCamera() { return this->m_camera; }
+	inline bool isRecording() const { return nullptr != this->m_recording; }
+	inline bool isReplaying() const { return !this->m_replay.frames.empty(); }
+
+	// samples the camera and the selected object after every input from now on, starting with the
+	// current state; the selection is stored as its index in objects, the ones of the workspace
+	void startRecording(const QVector<std::shared_ptr<SceneObject>>& objects);
+	// nullptr when not recording
+	std::unique_ptr<SessionRecording> stopRecording();
+	// draws the frames one at a time, each once the geometry of its object is on the GPU, and times
+	// them; objects are indexed by the frames, the input of the user is ignored meanwhile
+	bool startReplay(const SessionRecording& recording, const std::vector<SessionRecording::Frame>& frames,
+		const QVector<std::shared_ptr<SceneObject>>& objects);
+	// the timings of the frames drawn so far are dropped
+	void stopReplay();
 
 public slots:
+	// publishes the current state and requests a frame of it
     void redraw(void);
     void updateCamera(float bblength);
 
@@ -32,11 +61,22 @@ signals:
 	void mouseMoved(QString);
 	void framerateUpdated(QString);
 	void drawingModeChanged(QString);
+	void qualityChanged(QString);
+	void occlusionUpdated(QString);
+	void sectionUpdated(QString);
+	void geometrySwapped(unsigned int objId);
+	// translated, rotated or reset by the user
+	void objectMoved(unsigned int objId);
+	// a replayed frame was recorded with another object selected
+	void selectionWanted(unsigned int objId);
+	// every frame timed, the timings are empty when the replay was stopped
+	void replayFinished(const FrameTimings& timings);
 
 protected:
 	void initializeGL() override;
+	void resizeGL(int w, int h) override;
+	// frames come from the render thread, the widget only blits the one presented last
 	void paintGL() override;
-	void initializeShaders();
 
 	void mouseMoveEvent(QMouseEvent* event) override;
 	void wheelEvent(QWheelEvent* event) override;
@@ -44,28 +84,73 @@ protected:
 	void mousePressEvent(QMouseEvent* event) override;
 	void mouseReleaseEvent(QMouseEvent* event) override;
 
+private slots:
+	void handleGeometrySwapped(unsigned int objId);
+	void computeSection();
+	void handleFrameTimed(quint64 timedFrame, double milliseconds);
+
 private:
-	void transform(const std::shared_ptr<SceneObject>& obj);
-	void setUniforms();
-	void calculateFPS();
+	void publishSnapshot();
+	void registerInput();
+	void updateStatus();
+	void updateSectionStatus();
+	// the cut is stale, a new one starts once the plane rests
+	void requestSection();
+	void moveSection(float delta);
+	void handleSectionFinished(unsigned int objId, const std::shared_ptr<const CrossSection>& cut,
+		unsigned int version, std::uint64_t generation);
 	void reset();
 	void processTranslation(QVector3D& delta);
 	void processRotation(QVector3D& delta);
+	// appends the state after an input to the recording in progress
+	void recordInput();
+	void replayNextFrame();
 
 	Camera m_camera;
 	const Scene&  m_scene;
 
 	QPointF m_lastMousePos;
+	QPoint m_mousePos;
+	QString m_shownMousePos;
 
-	QMatrix4x4 m_projection;
-	QMatrix4x4 m_view;
-	QMatrix4x4 m_model;
+	QThread m_renderThread;
+	std::unique_ptr<FrameRenderer> m_frameRenderer;
 
-	QOpenGLShader* m_vertexShader;
-	QOpenGLShader* m_fragmentShader;
-	QOpenGLShaderProgram* m_shaderProgram;
-
-	QElapsedTimer m_timer;
 	Mode m_drawingMode;
-	std::chrono::high_resolution_clock::time_point m_lastFrameTime;
-};
\ No newline at end of file
+	bool m_occlusionCulling = true;
+	QString m_shownOcclusion;
+	double m_lastInputTime = -1.0;
+	// coalesced status updates
+	QTimer m_statusTimer;
+	// repaints in full quality once the input stops
+	QTimer m_restoreTimer;
+	double m_lastStatusTime = 0.0;
+
+	SceneSnapshot::Section m_section;
+	// object of the latest cut request
+	unsigned int m_sectionObjId = 0;
+	QString m_shownSection;
+	// debounces the plane movement
+	QTimer m_sectionTimer;
+	JobSystem::CancellationToken m_sectionToken;
+	// cancelled cuts may still be running, they are waited for on destruction
+	std::vector<JobSystem::JobHandle> m_sectionJobs;
+	// results of older requests are dropped
+	std::uint64_t m_sectionGeneration = 0;
+
+	std::unique_ptr<SessionRecording> m_recording;
+	QVector<std::shared_ptr<SceneObject>> m_recordedObjects;
+	double m_recordingStart = 0.0;
+	struct Replay {
+		std::vector<SessionRecording::Frame> frames;
+		QVector<std::shared_ptr<SceneObject>> objects;
+		std::size_t next = 0;
+		// recorded viewport in pixels
+		QSize size;
+		FrameTimings timings;
+	};
+	Replay m_replay;
+	// frame of the replay waiting for its timing, 0 for the frames of the user
+	std::uint64_t m_timedFrame = 0;
+	std::uint64_t m_lastTimedFrame = 0;
+};
@@ -0,0 +1,89 @@
+#pragma once
+#include <QOpenGLBuffer>
+#include <QOpenGLVertexArrayObject>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLFunctions_3_3_Core>
+#include <QMatrix4x4>
+#include <QVector4D>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "SceneObject.h"
+
+// Draws a point cloud through its octree under a fixed point budget. Every frame the visible
+// nodes are walked from the root, biggest on screen first, and a node is refined while the
+// spacing of its points is wider than a couple of pixels. Nodes are streamed into a fixed pool
+// of GPU slots with least recently used eviction: out-of-core points are paged in by jobs first,
+// the render thread uploads at most a few nodes per frame, so memory on both sides stays bounded.
+class PointCloudStreamer {
+public:
+	static constexpr std::uint64_t POINT_BUDGET = 4000000;
+	// twice the budget, moving the camera reuses most of the resident nodes
+	static constexpr int POOL_SLOTS = static_cast<int>(2 * POINT_BUDGET / POINTCLOUD_API::NODE_POINTS);
+	static constexpr int MAX_UPLOADS_PER_FRAME = 8;
+	static constexpr int MAX_PREFETCHES = 32;
+	// pixels between neighbouring points above which a node is refined
+	static constexpr float TARGET_SPACING = 1.5f;
+
+	struct View {
+		QMatrix4x4 modelView;
+		QMatrix4x4 modelViewProjection;
+		// projected size of a unit at unit distance
+		float pixelsPerUnit;
+	};
+
+	explicit PointCloudStreamer(const std::shared_ptr<SceneObject>& obj);
+	PointCloudStreamer(const PointCloudStreamer&) = delete;
+	PointCloudStreamer& operator=(const PointCloudStreamer&) = delete;
+
+	// with the render context current
+	void initialize(QOpenGLShaderProgram* program);
+	void destroy();
+	// selects the nodes of the frame and streams in the missing ones, true while some are missing
+	bool update(const View& view);
+	void draw(QOpenGLFunctions_3_3_Core* functions);
+
+	inline std::uint64_t getDrawnPoints()  const { return this->m_drawnPoints; }
+	inline int			 getSlotCount()	   const { return static_cast<int>(this->m_slotNode.size()); }
+	// the geometry of the object was reloaded since the streamer was created
+	inline bool			 isStale()		   const { return this->m_object->getGeometryVersion() != this->m_geometryVersion; }
+
+private:
+	enum NodeState {
+		NOT_LOADED,
+		LOADING,
+		LOADED
+	};
+	// shared with the page-in jobs, which may outlive the streamer
+	struct Residency {
+		explicit Residency(std::size_t nodes) : states(nodes) {}
+		std::vector<std::atomic<int>> states;
+		std::atomic<int> inFlight{ 0 };
+	};
+
+	bool isVisible(const OctreeNode& node) const;
+	float projectedSize(const OctreeNode& node, const View& view) const;
+	void prefetch(int node);
+	int acquireSlot();
+	void upload(int node, int slot);
+
+	std::shared_ptr<SceneObject> m_object;
+	std::shared_ptr<const PointCloud> m_cloud;
+	unsigned int m_geometryVersion;
+	std::shared_ptr<Residency> m_residency;
+	std::vector<int> m_nodeSlot;
+	std::vector<int> m_slotNode;
+	std::vector<std::uint64_t> m_slotFrame;
+	std::vector<GLint> m_drawFirst;
+	std::vector<GLsizei> m_drawCount;
+	std::array<QVector4D, 6> m_frustum;
+
+	QOpenGLBuffer m_vbo;
+	QOpenGLVertexArrayObject m_vao;
+
+	std::uint64_t m_frame = 0;
+	std::uint64_t m_drawnPoints = 0;
+};
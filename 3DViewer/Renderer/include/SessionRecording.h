@@ -0,0 +1,99 @@
+#pragma once
+#include <QQuaternion>
+#include <QString>
+#include <QVector3D>
+
+#include <memory>
+#include <vector>
+
+#include "Camera.h"
+
+// Camera and object transforms of a viewing session, one sample per input, replayed frame by frame
+// so the same views are drawn again by another build or on another machine. The model set is the
+// workspace saved next to the recording when it starts, object indices refer to its objects.
+struct SessionRecording {
+	static constexpr int VERSION = 1;
+	static constexpr auto FILE_SUFFIX = "3dvrec";
+
+	struct Frame {
+		// seconds since the recording started
+		double time = 0.0;
+		CameraState camera;
+		// index of the selected object in the workspace, -1 without a selection
+		int object = -1;
+		QVector3D translation;
+		QQuaternion rotation;
+	};
+
+	// file name of the workspace, next to the recording
+	QString workspace;
+	// viewport the session was recorded in, in pixels, the replays draw at this size
+	int width = 1;
+	int height = 1;
+	bool wireframe = false;
+	bool occlusionCulling = true;
+	std::vector<Frame> frames;
+};
+
+// duration of every replayed frame in milliseconds, from the start of its drawing until the GPU finished it
+struct FrameTimings {
+	static constexpr auto FILE_SUFFIX = "json";
+	// the selected object drawn by the viewer, with its materials, maps, field and occlusion culling
+	static constexpr auto VIEWER_RENDERER = "viewer";
+	// the selected object drawn headless in full with the default material, no maps, field or culling
+	static constexpr auto OFFSCREEN_RENDERER = "offscreen";
+
+	QString recording;
+	// one of the renderers above, timings of different renderers measure different work
+	QString renderer;
+	int width = 0;
+	int height = 0;
+	std::vector<double> frames;
+};
+
+namespace RECORDING_API {
+	// two-sided significance level of the comparison of two replays
+	constexpr double SIGNIFICANCE = 0.05;
+
+	struct Summary {
+		std::size_t count = 0;
+		double mean = 0.0;
+		double stddev = 0.0;
+		double min = 0.0;
+		double median = 0.0;
+		double p95 = 0.0;
+		double p99 = 0.0;
+		double max = 0.0;
+	};
+	struct Comparison {
+		Summary baseline;
+		Summary candidate;
+		// relative changes of the candidate, positive when it is slower
+		double medianChange = 0.0;
+		double meanChange = 0.0;
+		// signed rank test of the frame pairs, rank sum test of the two samples when the counts differ
+		bool paired = false;
+		// normal approximation of the rank statistic, positive when the candidate is slower
+		double z = 0.0;
+		double pValue = 1.0;
+
+		inline bool isSignificant() const { return pValue < SIGNIFICANCE; }
+	};
+
+	bool writeRecording(const QString& path, const SessionRecording& recording);
+	// nullptr when missing or not a recording
+	std::unique_ptr<SessionRecording> readRecording(const QString& path);
+	// absolute path of the workspace of the recording stored at recordingPath
+	QString workspacePath(const QString& recordingPath, const SessionRecording& recording);
+	// frameCount frames spread evenly over the recorded time and interpolated between the samples,
+	// the recorded samples themselves for a count below one
+	std::vector<SessionRecording::Frame> resample(const std::vector<SessionRecording::Frame>& frames, int frameCount);
+
+	bool writeTimings(const QString& path, const FrameTimings& timings);
+	std::unique_ptr<FrameTimings> readTimings(const QString& path);
+	Summary summarize(const std::vector<double>& values);
+	// the same session drawn by the same renderer at the same size, the reason why not otherwise
+	bool isComparable(const FrameTimings& baseline, const FrameTimings& candidate, QString& reason);
+	// a replay draws the same frames in both builds, so frames are compared pairwise when the counts match
+	Comparison compare(const std::vector<double>& baseline, const std::vector<double>& candidate);
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QOpenGLFunctions_3_3_Core>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "JobSystem.h"
+
+class GpuUploader;
+
+// texture of a material map, filled by the uploader level by level from the coarsest
+struct StreamedTexture {
+	enum class State {
+		DECODING,
+		UPLOADING,
+		READY,
+		FAILED
+	};
+
+	std::atomic<State> state{ State::DECODING };
+	// created by the uploader together with the first level
+	std::atomic<GLuint> id{ 0 };
+	std::atomic<int> levelCount{ 0 };
+	std::mutex mutex;
+	// uploaded levels with the fence the render thread polls before sampling them
+	std::vector<std::pair<int, GLsync>> fencedLevels;
+	// finest level the render thread samples, -1 until the first one arrived, render thread only
+	int baseLevel = -1;
+};
+
+// Material maps of the drawn objects, streamed in without ever blocking a frame. An image is
+// decoded and filtered into its mip levels by a background job, or read back from the texture
+// cache, then handed over to the uploader which sends the coarsest level first. The surface is
+// drawn untextured until the first level arrives and sharpens as the finer ones follow.
+class TextureStreamer {
+public:
+	explicit TextureStreamer(GpuUploader* uploader);
+	TextureStreamer(const TextureStreamer&) = delete;
+	TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+	// render thread, starts the load on the first request, 0 while no level can be sampled yet
+	GLuint acquire(const QString& path);
+	// render thread, makes the uploaded levels of all textures visible whose copy is done,
+	// true while some are still on their way and the fences have to be polled again
+	bool drainFences(QOpenGLFunctions_3_3_Core* functions);
+	// deletes the finished textures of maps no longer used by any object
+	void releaseUnused(const QSet<QString>& used, QOpenGLFunctions_3_3_Core* functions);
+	// cancels the loads and waits for them, before the uploader goes away
+	void stop();
+	// with the render context current, after the uploader stopped
+	void destroy(QOpenGLFunctions_3_3_Core* functions);
+
+private:
+	static void destroyTexture(StreamedTexture& texture, QOpenGLFunctions_3_3_Core* functions);
+
+	GpuUploader* m_uploader;
+	QHash<QString, std::shared_ptr<StreamedTexture>> m_textures;
+	JobSystem::CancellationToken m_token;
+	std::vector<JobSystem::JobHandle> m_jobs;
+};
@@ -0,0 +1,54 @@
+#pragma once
+#include <QObject>
+#include <QThread>
+#include <QImage>
+#include <QOpenGLContext>
+#include <QOffscreenSurface>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions_3_3_Core>
+#include <QOpenGLShaderProgram>
+
+#include <memory>
+
+#include "MappedArray.h"
+#include "ThumbnailCache.h"
+#include "Vertex.h"
+
+// Draws previews of models headless, on a thread with a context of its own which shares nothing
+// with the viewer, into a multisampled framebuffer read back as an image. Only a core 3.3
+// context is required, so it runs on software rasterizers as well.
+class ThumbnailRenderer : public QObject {
+	Q_OBJECT
+public:
+	// clustered model with its bounds, as built by THUMBNAIL_API::buildPreviewMesh
+	struct Preview {
+		MappedArray<Vertex> vertices;
+		QVector3D minBounds;
+		QVector3D maxBounds;
+	};
+
+	// must be created on the GUI thread
+	explicit ThumbnailRenderer(int size = THUMBNAIL_API::THUMBNAIL_SIZE);
+	~ThumbnailRenderer();
+
+	// any thread, the image comes with rendered, null when drawing failed
+	void enqueue(const QString& path, const std::shared_ptr<const Preview>& preview);
+	inline bool isAvailable() const { return this->m_available; }
+
+signals:
+	void rendered(const QString& path, const QImage& image);
+
+private:
+	void render(const QString& path, const std::shared_ptr<const Preview>& preview);
+	bool initializeResources();
+	void releaseResources();
+
+	int m_size;
+	bool m_available = false;
+	QThread m_thread;
+	QOffscreenSurface* m_surface;
+	QOpenGLContext* m_context;
+	QOpenGLFunctions_3_3_Core* m_functions = nullptr;
+	std::unique_ptr<QOpenGLFramebufferObject> m_frameBuffer;
+	std::unique_ptr<QOpenGLShaderProgram> m_program;
+};
@@ -0,0 +1,58 @@
+#pragma once
+#include <QObject>
+#include <QImage>
+#include <QSet>
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "JobSystem.h"
+#include "ThumbnailRenderer.h"
+
+// Previews of model files for the open dialog. A request first looks into the cache directory,
+// which takes only a png decode, the models without a current preview are then loaded and
+// clustered by background jobs behind the loads of the viewer and drawn one after another
+// by the headless renderer. A folder of large models is loaded a few at a time within a memory
+// budget, models beyond the budget get no preview. Fresh previews are written back to the cache.
+class ThumbnailService : public QObject {
+	Q_OBJECT
+public:
+	// models loaded for previews at once
+	static constexpr int MAX_PREVIEW_BUILDS = 2;
+	// estimated transient memory of the loads at once, a single load may not exceed it
+	static constexpr std::uint64_t PREVIEW_MEMORY_BUDGET = 1024ull * 1024ull * 1024ull;
+
+	// must be created on the GUI thread
+	explicit ThumbnailService(QObject* parent = nullptr);
+	// cancels the requests in progress and waits for their jobs
+	~ThumbnailService();
+
+	// the preview comes with thumbnailReady, or thumbnailFailed for files without one
+	void request(const QString& path);
+	// forgets the requests not answered yet, e.g. when the dialog moves to another folder
+	void cancelPending();
+
+signals:
+	void thumbnailReady(const QString& path, const QImage& image);
+	void thumbnailFailed(const QString& path);
+
+private:
+	void generate(const QString& path);
+	// starts the queued builds the limits allow
+	void startBuilds();
+	void handleBuildFinished(std::uint64_t bytes);
+	void handleRendered(const QString& path, const QImage& image);
+	void finish(const QString& path, const QImage& image);
+	// drops the handles of the finished jobs
+	void pruneJobs();
+
+	std::unique_ptr<ThumbnailRenderer> m_renderer;
+	QSet<QString> m_pending;
+	// waiting for a build, in the order they were requested
+	std::deque<QString> m_queued;
+	int m_building = 0;
+	std::uint64_t m_buildingBytes = 0;
+	JobSystem::CancellationToken m_token;
+	std::vector<JobSystem::JobHandle> m_jobs;
+};
@@ -2,6 +2,8 @@
 
 in vec3 FragPos;     // Fragment position in world coordinates
 in vec3 Normal;      // Normal vector at the fragment
+in vec2 TexCoord;    // Texture coordinate of the material maps
+in float Scalar;     // Analysis value of the fragment
 
 out vec4 FragColor;
 
@@ -12,9 +14,67 @@ uniform vec3 objectColor;
 uniform float ambientStrength;
 uniform float specularStrength;
 uniform float shininess;
+// maps of the material, sampled only while bound
+uniform sampler2D diffuseMap;
+uniform sampler2D normalMap;
+uniform sampler2D bumpMap;
+uniform bool hasDiffuseMap;
+uniform bool hasNormalMap;
+uniform bool hasBumpMap;
+uniform float bumpScale;
+// analysis field replacing the material color, fieldRange spans blue to red
+uniform bool showField;
+uniform vec2 fieldRange;
+
+// Tangent frame from the screen space derivatives of the position and the texture coordinate,
+// the meshes carry no tangents
+vec3 perturbNormal(vec3 normal)
+{
+    vec3 dp1 = dFdx(FragPos);
+    vec3 dp2 = dFdy(FragPos);
+    vec2 duv1 = dFdx(TexCoord);
+    vec2 duv2 = dFdy(TexCoord);
+    vec3 dp2perp = cross(dp2, normal);
+    vec3 dp1perp = cross(normal, dp1);
+    vec3 tangent = dp2perp * duv1.x + dp1perp * duv2.x;
+    vec3 bitangent = dp2perp * duv1.y + dp1perp * duv2.y;
+    float invmax = inversesqrt(max(dot(tangent, tangent), dot(bitangent, bitangent)));
+    vec3 mapped = texture(normalMap, TexCoord).xyz * 2.0 - 1.0;
+    return normalize(mat3(tangent * invmax, bitangent * invmax, normal) * mapped);
+}
+
+// Normal tilted by the screen space gradient of the height map, without a tangent frame either
+vec3 bumpNormal(vec3 normal)
+{
+    vec3 dp1 = dFdx(FragPos);
+    vec3 dp2 = dFdy(FragPos);
+    float height = texture(bumpMap, TexCoord).r * bumpScale;
+    float dh1 = dFdx(height);
+    float dh2 = dFdy(height);
+    vec3 r1 = cross(dp2, normal);
+    vec3 r2 = cross(normal, dp1);
+    float det = dot(dp1, r1);
+    vec3 gradient = sign(det) * (dh1 * r1 + dh2 * r2);
+    return normalize(abs(det) * normal - gradient);
+}
 
 void main()
 {
+    // Material maps replace the interpolated normal and modulate the color, a normal map wins over a bump map
+    vec3 normal = Normal;
+    if (hasNormalMap) {
+        normal = perturbNormal(normalize(Normal));
+    }
+    else if (hasBumpMap) {
+        normal = bumpNormal(normalize(Normal));
+    }
+    vec3 baseColor = hasDiffuseMap ? objectColor * texture(diffuseMap, TexCoord).rgb : objectColor;
+    if (showField) {
+        // Rainbow ramp, values outside of the range keep the color of its ends
+        float t = clamp((Scalar - fieldRange.x) / max(fieldRange.y - fieldRange.x, 1e-20), 0.0, 1.0);
+        baseColor = clamp(vec3(1.5 - abs(4.0 * t - 3.0), 1.5 - abs(4.0 * t - 2.0), 1.5 - abs(4.0 * t - 1.0)), 0.0, 1.0);
+    }
+
     // Calculate ambient lighting for both light sources
     vec3 ambientFront = ambientStrength * lightColor;
     vec3 ambientBack = ambientStrength * lightColor;
@@ -24,26 +84,26 @@ void main()
     vec3 lightDirBack = normalize(-lightDirectionBack);
 
     // Calculate diffuse lighting for both light sources
-    float diffFront = max(dot(Normal, lightDirFront), 0.0);
+    float diffFront = max(dot(normal, lightDirFront), 0.0);
     vec3 diffuseFront = diffFront * lightColor;
 
-    float diffBack = max(dot(Normal, lightDirBack), 0.0);
+    float diffBack = max(dot(normal, lightDirBack), 0.0);
     vec3 diffuseBack = diffBack * lightColor;
 
     // Calculate the view direction (camera direction)
     vec3 viewDir = normalize(-FragPos);
 
     // Calculate specular lighting using the Phong reflection model for both light sources
-    vec3 reflectDirFront = reflect(-lightDirFront, Normal);
+    vec3 reflectDirFront = reflect(-lightDirFront, normal);
     float specFront = pow(max(dot(viewDir, reflectDirFront), 0.0), shininess);
     vec3 specularFront = specularStrength * specFront * lightColor;
 
-    vec3 reflectDirBack = reflect(-lightDirBack, Normal);
+    vec3 reflectDirBack = reflect(-lightDirBack, normal);
     float specBack = pow(max(dot(viewDir, reflectDirBack), 0.0), shininess);
     vec3 specularBack = specularStrength * specBack * lightColor;
 
     // Combine lighting components from both light sources
-    vec3 result = (ambientFront + diffuseFront + specularFront) * objectColor + (ambientBack + diffuseBack + specularBack) * objectColor;
+    vec3 result = (ambientFront + diffuseFront + specularFront) * baseColor + (ambientBack + diffuseBack + specularBack) * baseColor;
 
     // Output the final fragment color
     FragColor = vec4(result, 1.0);
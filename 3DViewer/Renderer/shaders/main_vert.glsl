@@ -3,16 +3,26 @@
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec2 inTexture;
+// analysis value of the vertex, a separate stream only bound while a field is shown
+layout(location = 3) in float inScalar;
 
 uniform mat4 viewMatrix;
 uniform mat4 projectionMatrix;
 uniform mat4 modelMatrix;
+// section plane in object coordinates, the side with dot(xyz, p) >= w is kept
+uniform vec4 clipPlane;
 
 out vec3 Normal;
 out vec3 FragPos;
+out vec2 TexCoord;
+out float Scalar;
 
 void main() {
     FragPos = (modelMatrix * vec4(inPosition, 1.0)).xyz;
     Normal = mat3(transpose(inverse(modelMatrix))) * inNormal;
+    TexCoord = inTexture;
+    Scalar = inScalar;
     gl_Position = projectionMatrix * viewMatrix * vec4(FragPos, 1.0);
+    // only used while GL_CLIP_DISTANCE0 is enabled
+    gl_ClipDistance[0] = dot(clipPlane.xyz, inPosition) - clipPlane.w;
 }
\ No newline at end of file
@@ -0,0 +1,20 @@
+#version 330 core
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec4 inColor;
+
+uniform mat4 viewMatrix;
+uniform mat4 projectionMatrix;
+uniform mat4 modelMatrix;
+uniform float pointSize;
+uniform bool useColors;
+uniform vec3 objectColor;
+
+out vec3 Color;
+
+void main() {
+    gl_Position = projectionMatrix * viewMatrix * modelMatrix * vec4(inPosition, 1.0);
+    gl_PointSize = pointSize;
+    // scans without colors are drawn with the material
+    Color = useColors ? inColor.rgb : objectColor;
+}
\ No newline at end of file
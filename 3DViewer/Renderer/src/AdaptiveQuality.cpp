@@ -0,0 +1,118 @@
+#include <algorithm>
+
+#include "AdaptiveQuality.h"
+
+AdaptiveQuality::AdaptiveQuality(double targetFrameTime) :
+	m_targetFrameTime(targetFrameTime)
+{
+}
+
+void AdaptiveQuality::inputReceived(double now)
+{
+	m_lastInput = now;
+}
+
+AdaptiveQuality::Level AdaptiveQuality::beginFrame(double now, bool hasProxy)
+{
+	if (!isInteracting(now)) {
+		m_interacting = false;
+		m_level = Level::FULL;
+		return m_level;
+	}
+	if (!m_interacting) {
+		m_interacting = true;
+		//full frames drawn since then may have become cheap enough, a window made smaller
+		const bool full_fits = isMeasured(Level::FULL) &&
+			m_frameTimes[static_cast<int>(Level::FULL)] <= m_targetFrameTime;
+		//start where the previous interaction ended instead of lagging again
+		m_level = full_fits ? Level::FULL : m_interactionLevel;
+		m_interactionLevel = m_level;
+		m_levelStart = now;
+	}
+	if (Level::PROXY == m_level && !hasProxy) {
+		enter(Level::BOUNDS, now);
+	}
+	const double frame_time = m_frameTimes[static_cast<int>(m_level)];
+	if (!isMeasured(m_level)) {
+		return m_level;
+	}
+	if (frame_time > m_targetFrameTime && Level::BOUNDS != m_level) {
+		if (m_probing) {
+			//the finer level is still too slow, it is tried again later
+			m_upgradeDelay = std::min(MAX_UPGRADE_DELAY, m_upgradeDelay * 2.0);
+		}
+		enter(degrade(m_level, hasProxy), now);
+		m_probing = false;
+	}
+	else if (frame_time <= m_targetFrameTime && m_probing) {
+		m_probing = false;
+		m_upgradeDelay = UPGRADE_DELAY;
+	}
+	else if (frame_time < m_targetFrameTime * UPGRADE_HEADROOM && Level::FULL != m_level &&
+		now - m_levelStart >= m_upgradeDelay) {
+		enter(upgrade(m_level, hasProxy), now);
+		m_probing = true;
+	}
+	return m_level;
+}
+
+void AdaptiveQuality::frameTimed(Level level, double seconds)
+{
+	const int index = static_cast<int>(level);
+	m_frameTimes[index] = 0 == m_samples[index] ?
+		seconds : SMOOTHING * seconds + (1.0 - SMOOTHING) * m_frameTimes[index];
+	++m_samples[index];
+}
+
+void AdaptiveQuality::reset()
+{
+	m_frameTimes.fill(0.0);
+	m_samples.fill(0);
+	m_interactionLevel = Level::FULL;
+	m_level = Level::FULL;
+	m_interacting = false;
+	m_upgradeDelay = UPGRADE_DELAY;
+	m_probing = false;
+}
+
+const char* AdaptiveQuality::levelName(Level level)
+{
+	switch (level) {
+	case Level::PROXY:
+		return "proxy";
+	case Level::BOUNDS:
+		return "bounds";
+	default:
+		return "full";
+	}
+}
+
+AdaptiveQuality::Level AdaptiveQuality::degrade(Level level, bool hasProxy) const
+{
+	if (Level::FULL == level && hasProxy) {
+		return Level::PROXY;
+	}
+	return Level::BOUNDS;
+}
+
+AdaptiveQuality::Level AdaptiveQuality::upgrade(Level level, bool hasProxy) const
+{
+	if (Level::BOUNDS == level && hasProxy) {
+		return Level::PROXY;
+	}
+	return Level::FULL;
+}
+
+bool AdaptiveQuality::isMeasured(Level level) const
+{
+	return m_samples[static_cast<int>(level)] >= MIN_SAMPLES;
+}
+
+void AdaptiveQuality::enter(Level level, double now)
+{
+	m_level = level;
+	m_interactionLevel = level;
+	m_levelStart = now;
+	//the frames timed so far were drawn before the change
+	m_samples[static_cast<int>(level)] = 0;
+}
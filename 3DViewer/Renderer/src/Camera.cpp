@@ -54,6 +54,15 @@ void Camera::reset(float bbLength)
     FitInWindow(bbLength);
 }
 
+void Camera::setState(const CameraState& state)
+{
+    m_position = state.position;
+    m_yaw = state.yaw;
+    m_pitch = qBound(-89.0f, state.pitch, 89.0f);
+    m_zoom = qBound(1.0f, state.zoom, 120.0f);
+    m_updateCameraVectors();
+}
+
 void Camera::processMouseScroll(float yOffset) 
 {
     if (m_zoom >= 1.0f && m_zoom <= 120.0f)
@@ -0,0 +1,1007 @@
+#include <QDebug>
+#include <QOpenGLExtraFunctions>
+#include <QThread>
+#include <QTimer>
+#include <QVector4D>
+#include <QtMath>
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "FrameRenderer.h"
+#include "MemoryTracker.h"
+
+FrameRenderer::FrameRenderer(QOpenGLWidget* widget) :
+	m_widget(widget)
+{
+	m_timer.start();
+}
+
+void FrameRenderer::createContexts(QOpenGLContext* widgetContext)
+{
+	if (nullptr != m_uploader) {
+		return;
+	}
+	m_surface = std::make_unique<QOffscreenSurface>();
+	m_surface->setFormat(widgetContext->format());
+	m_surface->create();
+	m_context = std::make_unique<QOpenGLContext>();
+	m_context->setFormat(widgetContext->format());
+	m_context->setShareContext(widgetContext);
+	if (!m_context->create()) {
+		qCritical() << "Critical: cannot create shared OpenGL context for rendering.";
+		m_context.reset();
+	}
+	else {
+		m_context->moveToThread(thread());
+	}
+	m_uploader = std::make_unique<GpuUploader>(widgetContext);
+	m_textures = std::make_unique<TextureStreamer>(m_uploader.get());
+	connect(m_uploader.get(), &GpuUploader::uploadFinished, this, &FrameRenderer::requestFrame);
+	connect(m_uploader.get(), &GpuUploader::textureLevelUploaded, this, &FrameRenderer::requestFrame);
+	connect(m_uploader.get(), &GpuUploader::fieldUploaded, this, &FrameRenderer::requestFrame);
+}
+
+void FrameRenderer::prepareExit()
+{
+	m_exiting.store(true);
+}
+
+void FrameRenderer::setTargetSize(const QSize& size)
+{
+	QMutexLocker lock(&m_presentMutex);
+	m_targetSize = size;
+}
+
+void FrameRenderer::compose(GLuint targetFramebuffer, const QSize& targetSize)
+{
+	auto* functions = QOpenGLContext::currentContext()->extraFunctions();
+	QMutexLocker lock(&m_presentMutex);
+	if (m_front < 0) {
+		functions->glBindFramebuffer(GL_FRAMEBUFFER, targetFramebuffer);
+		functions->glClearColor(0.85f, 0.85f, 0.85f, 1.0f);
+		functions->glClear(GL_COLOR_BUFFER_BIT);
+		return;
+	}
+	auto& frame = m_presented[m_front];
+	//the render context may not have finished the frame yet, only the GPU waits for it
+	functions->glWaitSync(frame.drawn, 0, GL_TIMEOUT_IGNORED);
+	if (0 == m_composeFramebuffer) {
+		functions->glGenFramebuffers(1, &m_composeFramebuffer);
+	}
+	const QSize size = frame.target->size();
+	functions->glBindFramebuffer(GL_READ_FRAMEBUFFER, m_composeFramebuffer);
+	functions->glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, frame.target->texture(), 0);
+	functions->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, targetFramebuffer);
+	//a frame of the previous size is stretched until one of the new size is presented
+	functions->glBlitFramebuffer(0, 0, size.width(), size.height(), 0, 0, targetSize.width(), targetSize.height(),
+		GL_COLOR_BUFFER_BIT, size == targetSize ? GL_NEAREST : GL_LINEAR);
+	functions->glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	functions->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, targetFramebuffer);
+	if (nullptr != frame.composed) {
+		functions->glDeleteSync(frame.composed);
+	}
+	frame.composed = functions->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	//the render context waits for the fence, it has to reach the GPU
+	functions->glFlush();
+}
+
+void FrameRenderer::releaseCompose()
+{
+	if (0 != m_composeFramebuffer) {
+		QOpenGLContext::currentContext()->extraFunctions()->glDeleteFramebuffers(1, &m_composeFramebuffer);
+		m_composeFramebuffer = 0;
+	}
+}
+
+void FrameRenderer::destroy()
+{
+	if (nullptr != m_context && !m_context->makeCurrent(m_surface.get())) {
+		qCritical() << "Critical: cannot make render context current to release its resources.";
+	}
+	//the objects still held are released here, the scene releases the rest
+	for (auto& obj : m_residentObjects) {
+		obj.second->release();
+	}
+	m_residentObjects.clear();
+	if (m_initialized) {
+		for (auto& streamer : m_pointStreamers) {
+			streamer.second->destroy();
+		}
+		for (auto& culler : m_occlusionCullers) {
+			culler.second->destroy(this);
+		}
+		m_boundsVao.destroy();
+		m_boundsVbo.destroy();
+		m_sectionVao.destroy();
+		m_sectionVbo.destroy();
+		m_contactsVao.destroy();
+		m_contactsVbo.destroy();
+		for (auto& frame_query : m_frameQueries) {
+			glDeleteQueries(1, &frame_query.query);
+			frame_query = FrameQuery();
+		}
+		m_frameBuffer.reset();
+		QMutexLocker lock(&m_presentMutex);
+		for (auto& frame : m_presented) {
+			frame.target.reset();
+			if (nullptr != frame.drawn) {
+				glDeleteSync(frame.drawn);
+			}
+			if (nullptr != frame.composed) {
+				glDeleteSync(frame.composed);
+			}
+			frame = PresentedFrame();
+		}
+		m_front = -1;
+		lock.unlock();
+		delete m_shaderProgram;
+		delete m_pointProgram;
+		m_shaderProgram = nullptr;
+		m_pointProgram = nullptr;
+	}
+	m_pointStreamers.clear();
+	m_occlusionCullers.clear();
+	m_sectionCut.reset();
+	m_contacts.reset();
+	//decode jobs hand their levels to the uploader
+	if (nullptr != m_textures) {
+		m_textures->stop();
+	}
+	//waits for the upload in flight, which retires its buffers
+	m_uploader.reset();
+	if (m_initialized) {
+		GpuUploader::destroyRetired(this);
+		if (nullptr != m_textures) {
+			m_textures->destroy(this);
+		}
+		releaseFieldBuffers(SceneSnapshot(), 0);
+	}
+	m_fieldBuffers.clear();
+	m_textures.reset();
+	if (nullptr != m_context) {
+		m_context->doneCurrent();
+		m_context.reset();
+	}
+}
+
+void FrameRenderer::requestFrame()
+{
+	if (!m_frameRequested.exchange(true)) {
+		QMetaObject::invokeMethod(this, &FrameRenderer::render, Qt::QueuedConnection);
+	}
+}
+
+void FrameRenderer::requestFencePoll()
+{
+	if (!m_fencePollRequested.exchange(true)) {
+		//the timer runs on the render thread, whichever thread asks
+		QMetaObject::invokeMethod(this, [this]() {
+			QTimer::singleShot(FENCE_POLL_MS, this, [this]() {
+				m_fencePollRequested.store(false);
+				requestFrame();
+			});
+		}, Qt::QueuedConnection);
+	}
+}
+
+void FrameRenderer::render()
+{
+	m_frameRequested.store(false);
+	//not initialized yet, its initializeGL requests the first frame
+	if (m_exiting || nullptr == m_context) {
+		return;
+	}
+	if (!m_context->makeCurrent(m_surface.get())) {
+		qCritical() << "Critical: cannot make render context current.";
+		return;
+	}
+	if (!m_initialized) {
+		initialize();
+	}
+	takeSnapshot();
+	paint(m_snapshots.front());
+	m_context->doneCurrent();
+	//composed on the GUI thread
+	QMetaObject::invokeMethod(m_widget, "update", Qt::QueuedConnection);
+}
+
+void FrameRenderer::initialize()
+{
+	m_initialized = true;
+	initializeOpenGLFunctions();
+	initializeShaders();
+	for (auto& frame_query : m_frameQueries) {
+		glGenQueries(1, &frame_query.query);
+	}
+
+	m_boundsVbo.create();
+	m_boundsVbo.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+	m_boundsVbo.bind();
+	m_boundsVbo.allocate(24 * sizeof(Vertex));
+	m_boundsVbo.release();
+	m_shaderProgram->bind();
+	m_boundsVao.create();
+	m_boundsVao.bind();
+	m_boundsVbo.bind();
+	m_shaderProgram->enableAttributeArray(0);
+	m_shaderProgram->setAttributeBuffer(0, GL_FLOAT, 0, 3, sizeof(Vertex));
+	m_shaderProgram->enableAttributeArray(1);
+	m_shaderProgram->setAttributeBuffer(1, GL_FLOAT, sizeof(QVector3D), 3, sizeof(Vertex));
+	m_boundsVao.release();
+	m_boundsVbo.release();
+
+	//refilled with every new cut, the layout of the bounds
+	m_sectionVbo.create();
+	m_sectionVbo.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+	m_sectionVao.create();
+	m_sectionVao.bind();
+	m_sectionVbo.bind();
+	m_shaderProgram->enableAttributeArray(0);
+	m_shaderProgram->setAttributeBuffer(0, GL_FLOAT, 0, 3, sizeof(Vertex));
+	m_shaderProgram->enableAttributeArray(1);
+	m_shaderProgram->setAttributeBuffer(1, GL_FLOAT, sizeof(QVector3D), 3, sizeof(Vertex));
+	m_sectionVao.release();
+	m_sectionVbo.release();
+
+	//refilled with every new highlight
+	m_contactsVbo.create();
+	m_contactsVbo.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+	m_contactsVao.create();
+	m_contactsVao.bind();
+	m_contactsVbo.bind();
+	m_shaderProgram->enableAttributeArray(0);
+	m_shaderProgram->setAttributeBuffer(0, GL_FLOAT, 0, 3, sizeof(Vertex));
+	m_shaderProgram->enableAttributeArray(1);
+	m_shaderProgram->setAttributeBuffer(1, GL_FLOAT, sizeof(QVector3D), 3, sizeof(Vertex));
+	m_contactsVao.release();
+	m_contactsVbo.release();
+}
+
+void FrameRenderer::initializeShaders()
+{
+	m_shaderProgram = new QOpenGLShaderProgram();
+	if (!m_shaderProgram->addShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/main_vert.glsl")) {
+		qCritical() << "Critical: error while loading vertex shader.";
+	}
+	if (!m_shaderProgram->addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/main_frag.glsl")) {
+		qCritical() << "Critical: error while loading fragment shader.";
+	}
+	m_pointProgram = new QOpenGLShaderProgram();
+	if (!m_pointProgram->addShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/point_vert.glsl") ||
+		!m_pointProgram->addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/point_frag.glsl")) {
+		qCritical() << "Critical: error while loading point cloud shaders.";
+	}
+}
+
+void FrameRenderer::takeSnapshot()
+{
+	//without a newer one the previous snapshot is drawn again
+	if (!m_snapshots.acquire()) {
+		return;
+	}
+	const auto& snapshot = m_snapshots.front();
+	releaseRemovedObjects(snapshot);
+	if (snapshot.lastInputTime != m_lastInputTime) {
+		m_lastInputTime = snapshot.lastInputTime;
+		m_quality.inputReceived(m_lastInputTime);
+	}
+}
+
+void FrameRenderer::releaseRemovedObjects(const SceneSnapshot& snapshot)
+{
+	std::unordered_set<const SceneObject*> live;
+	std::unordered_set<unsigned int> live_ids;
+	QSet<QString> live_maps;
+	const auto addMaps = [&live_maps](const SceneObject& obj) {
+		for (const auto& material : obj.materials) {
+			live_maps.insert(material.diffuseMap);
+			live_maps.insert(material.normalMap);
+			live_maps.insert(material.bumpMap);
+		}
+	};
+	for (const auto& entry : snapshot.objects) {
+		live.insert(entry.object.get());
+		live_ids.insert(entry.object->getID());
+		addMaps(*entry.object);
+		if (nullptr != entry.pending) {
+			live.insert(entry.pending.get());
+			addMaps(*entry.pending);
+		}
+	}
+	for (auto it = m_residentObjects.begin(); it != m_residentObjects.end();) {
+		if (0 == live.count(it->first)) {
+			//removed from the scene or a reload replaced by a newer one
+			it->second->release();
+			it = m_residentObjects.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+	for (const auto& entry : snapshot.objects) {
+		m_residentObjects.emplace(entry.object.get(), entry.object);
+		if (nullptr != entry.pending) {
+			m_residentObjects.emplace(entry.pending.get(), entry.pending);
+		}
+	}
+	for (auto it = m_pointStreamers.begin(); it != m_pointStreamers.end();) {
+		if (0 == live_ids.count(it->first)) {
+			it->second->destroy();
+			it = m_pointStreamers.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+	for (auto it = m_occlusionCullers.begin(); it != m_occlusionCullers.end();) {
+		if (0 == live_ids.count(it->first)) {
+			it->second->destroy(this);
+			it = m_occlusionCullers.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+	m_textures->releaseUnused(live_maps, this);
+	releaseFieldBuffers(snapshot);
+}
+
+void FrameRenderer::paint(const SceneSnapshot& snapshot)
+{
+	QSize size = snapshot.frameSize;
+	if (size.isEmpty()) {
+		QMutexLocker lock(&m_presentMutex);
+		size = m_targetSize.isEmpty() ? QSize(1, 1) : m_targetSize;
+	}
+	if (nullptr == m_frameBuffer || m_frameBuffer->size() != size) {
+		QOpenGLFramebufferObjectFormat format;
+		format.setAttachment(QOpenGLFramebufferObject::Depth);
+		//anti-alising, resolved by the blit into the widget
+		format.setSamples(SAMPLES);
+		m_frameBuffer = std::make_unique<QOpenGLFramebufferObject>(size, format);
+	}
+	m_frameBuffer->bind();
+	glViewport(0, 0, size.width(), size.height());
+	glEnable(GL_DEPTH_TEST);
+	glClearColor(0.85f, 0.85f, 0.85f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	swapPendingGeometry(snapshot);
+	GpuUploader::destroyRetired(this);
+	if (m_textures->drainFences(this)) {
+		//finer levels of the maps are on their way, looked at again without spinning on frames
+		requestFencePoll();
+	}
+
+	//the uploads and the clear queued above are not part of the replayed frame
+	const bool timed = 0 != snapshot.timedFrame && snapshot.timedFrame != m_timedFrame;
+	if (timed) {
+		glFinish();
+	}
+	const double start = seconds();
+	const bool complete = drawCurrent(snapshot);
+	double milliseconds = 0.0;
+	if (timed && complete) {
+		//counted once the GPU is done with it, before the resolve waits for the widget to compose
+		glFinish();
+		milliseconds = (seconds() - start) * 1000.0;
+	}
+
+	present(size);
+	if (timed && complete) {
+		m_timedFrame = snapshot.timedFrame;
+		emit frameTimed(snapshot.timedFrame, milliseconds);
+	}
+	++m_frames;
+}
+
+void FrameRenderer::present(const QSize& size)
+{
+	//the frame not composed last, the render thread alone changes which one that is
+	const int back = (m_front + 1) % static_cast<int>(m_presented.size());
+	auto& frame = m_presented[back];
+	GLsync composed = nullptr;
+	{
+		QMutexLocker lock(&m_presentMutex);
+		std::swap(composed, frame.composed);
+	}
+	if (nullptr != composed) {
+		//the widget may still read the texture on the GPU, the resolve is queued behind it
+		glWaitSync(composed, 0, GL_TIMEOUT_IGNORED);
+		glDeleteSync(composed);
+	}
+	if (nullptr == frame.target || frame.target->size() != size) {
+		frame.target = std::make_unique<QOpenGLFramebufferObject>(size);
+	}
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_frameBuffer->handle());
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, frame.target->handle());
+	glBlitFramebuffer(0, 0, size.width(), size.height(), 0, 0, size.width(), size.height(),
+		GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	GLsync drawn = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	//the widget context waits for the fence, it has to reach the GPU
+	glFlush();
+	QMutexLocker lock(&m_presentMutex);
+	if (nullptr != frame.drawn) {
+		glDeleteSync(frame.drawn);
+	}
+	frame.drawn = drawn;
+	m_front = back;
+}
+
+bool FrameRenderer::drawCurrent(const SceneSnapshot& snapshot)
+{
+	if (snapshot.current < 0) {
+		return true;
+	}
+	const auto& current = snapshot.objects[snapshot.current];
+	const auto& current_obj = current.object;
+	if (current_obj->getID() != m_qualityObjId) {
+		m_qualityObjId = current_obj->getID();
+		m_quality.reset();
+	}
+	if (!current.visible) {
+		return true;
+	}
+	if (current_obj->isPointCloud()) {
+		//bounded by the point budget, the adaptive quality is not needed
+		drawPointCloud(current, snapshot);
+		return true;
+	}
+	if (!prepareObjectBuffers(current_obj)) {
+		return false;
+	}
+	prepareProxyBuffers(current_obj);
+	collectFrameTimes();
+	//a replay draws the same frames whatever the previous ones cost
+	const auto level = 0 != snapshot.timedFrame ? AdaptiveQuality::Level::FULL :
+		m_quality.beginFrame(seconds(), SceneObject::ProxyState::READY == current_obj->getProxyState());
+	//the cost of the level is what picks the next one, the time between the input events is not
+	auto& frame_query = m_frameQueries[m_nextFrameQuery];
+	const bool timed = 0 == snapshot.timedFrame && !frame_query.pending;
+	if (timed) {
+		frame_query.pending = true;
+		frame_query.level = level;
+		frame_query.objId = current_obj->getID();
+		m_nextFrameQuery = (m_nextFrameQuery + 1) % FRAME_QUERIES;
+		glBeginQuery(GL_TIME_ELAPSED, frame_query.query);
+	}
+	m_shaderProgram->bind();
+	snapshot.wireframe ? glPolygonMode(GL_FRONT_AND_BACK, GL_LINE) : glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	glEnable(GL_MULTISAMPLE);
+	transform(snapshot, current);
+	setUniforms(snapshot);
+	//colors the full geometry only, the proxy and the bounds have no values
+	const bool show_field = bindField(current) && AdaptiveQuality::Level::FULL == level;
+	if (show_field) {
+		m_shaderProgram->setUniformValue("showField", true);
+		m_shaderProgram->setUniformValue("fieldRange", QVector2D(current.field->lowValue, current.field->highValue));
+	}
+	//clipped in the vertex shader, moving the plane costs nothing more per frame
+	const auto& section = snapshot.section;
+	QVector3D clip_normal;
+	float clip_offset = 0.0f;
+	if (section.axis >= 0) {
+		SECTION_API::axisPlane(current_obj->getMinBounds(), current_obj->getMaxBounds(), section.axis, section.position,
+			section.flipped, clip_normal, clip_offset);
+		m_shaderProgram->setUniformValue("clipPlane", QVector4D(clip_normal, clip_offset));
+		glEnable(GL_CLIP_DISTANCE0);
+	}
+	OcclusionCuller::Stats stats;
+	switch (level) {
+	case AdaptiveQuality::Level::PROXY:
+		drawProxy(*current_obj);
+		break;
+	case AdaptiveQuality::Level::BOUNDS:
+		drawBounds(*current_obj);
+		break;
+	default:
+		//lines hide nothing behind them, wireframe draws everything
+		if (snapshot.occlusionCulling && !snapshot.wireframe && !current_obj->drawClusters.empty()) {
+			drawCulled(current_obj, snapshot);
+			stats = m_occlusionCullers[current_obj->getID()]->getStats();
+		}
+		else {
+			current_obj->draw(this);
+		}
+		m_occlusionVisible.store(stats.visible);
+		m_occlusionOccluded.store(stats.occluded);
+		m_occlusionSaved.store(stats.savedTriangles);
+		break;
+	}
+	bindMaterial(*current_obj, -1);
+	m_shaderProgram->setUniformValue("showField", false);
+	//clipped by the section as well
+	if (AdaptiveQuality::Level::BOUNDS != level) {
+		drawContacts(snapshot, current);
+	}
+	if (section.axis >= 0) {
+		glDisable(GL_CLIP_DISTANCE0);
+		if (AdaptiveQuality::Level::BOUNDS != level) {
+			drawSection(snapshot, *current_obj, clip_normal, clip_offset);
+		}
+	}
+	glDisable(GL_MULTISAMPLE);
+	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	if (timed) {
+		glEndQuery(GL_TIME_ELAPSED);
+	}
+	if (level != m_shownLevel) {
+		m_shownLevel = level;
+		emit qualityChanged(AdaptiveQuality::levelName(level));
+	}
+	return true;
+}
+
+void FrameRenderer::collectFrameTimes()
+{
+	for (auto& frame_query : m_frameQueries) {
+		if (!frame_query.pending) {
+			continue;
+		}
+		GLuint available = 0;
+		glGetQueryObjectuiv(frame_query.query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (GL_TRUE != available) {
+			continue;
+		}
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(frame_query.query, GL_QUERY_RESULT, &elapsed);
+		frame_query.pending = false;
+		//drawn for the object selected before
+		if (frame_query.objId == m_qualityObjId) {
+			m_quality.frameTimed(frame_query.level, static_cast<double>(elapsed) / 1000000000.0);
+		}
+	}
+}
+
+void FrameRenderer::drawObject(SceneObject& obj)
+{
+	for (auto& chunk : obj.bufferChunks) {
+		chunk.vao->bind();
+		drawChunkRange(obj, chunk, 0, chunk.vertexCount);
+		chunk.vao->release();
+	}
+}
+
+void FrameRenderer::drawChunkRange(const SceneObject& obj, const BufferChunk& chunk, std::uint64_t first, std::uint64_t count)
+{
+	//one draw call per material run, a single one without materials
+	obj.forEachMaterialRun(chunk.firstVertex + first, count, [this, &obj, &chunk](std::uint64_t begin, std::uint64_t vertices, int material) {
+		bindMaterial(obj, material);
+		glDrawArrays(GL_TRIANGLES, static_cast<GLint>(begin - chunk.firstVertex), static_cast<GLsizei>(vertices));
+	});
+}
+
+void FrameRenderer::bindMaterial(const SceneObject& obj, int material)
+{
+	if (material == m_boundMaterial) {
+		return;
+	}
+	m_boundMaterial = material;
+	QVector3D color = m_materialColor;
+	GLuint diffuse_map = 0;
+	GLuint normal_map = 0;
+	GLuint bump_map = 0;
+	float bump_scale = 1.0f;
+	if (material >= 0 && material < static_cast<int>(obj.materials.size())) {
+		const auto& surface = obj.materials[material];
+		color = surface.diffuse;
+		//untextured until the first level of a map arrives
+		if (!surface.diffuseMap.isEmpty()) {
+			diffuse_map = m_textures->acquire(surface.diffuseMap);
+		}
+		if (!surface.normalMap.isEmpty()) {
+			normal_map = m_textures->acquire(surface.normalMap);
+		}
+		if (!surface.bumpMap.isEmpty()) {
+			bump_map = m_textures->acquire(surface.bumpMap);
+			bump_scale = surface.bumpScale;
+		}
+	}
+	m_shaderProgram->setUniformValue("objectColor", color);
+	m_shaderProgram->setUniformValue("hasDiffuseMap", 0 != diffuse_map);
+	m_shaderProgram->setUniformValue("hasNormalMap", 0 != normal_map);
+	m_shaderProgram->setUniformValue("hasBumpMap", 0 != bump_map);
+	m_shaderProgram->setUniformValue("bumpScale", bump_scale);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, diffuse_map);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, normal_map);
+	glActiveTexture(GL_TEXTURE2);
+	glBindTexture(GL_TEXTURE_2D, bump_map);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void FrameRenderer::drawProxy(SceneObject& obj)
+{
+	obj.proxyChunk.vao->bind();
+	glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(obj.proxyChunk.vertexCount));
+	obj.proxyChunk.vao->release();
+}
+
+void FrameRenderer::drawBounds(const SceneObject& obj)
+{
+	//12 edges of the box, rewritten each time as the buffer is shared by all the objects
+	const auto min = obj.getMinBounds();
+	const auto max = obj.getMaxBounds();
+	Vertex edges[24];
+	int count = 0;
+	const auto corner = [&min, &max](int bits) {
+		return QVector3D((bits & 1) ? max.x() : min.x(), (bits & 2) ? max.y() : min.y(), (bits & 4) ? max.z() : min.z());
+	};
+	for (int bits = 0; bits < 8; ++bits) {
+		for (int axis = 1; axis < 8; axis <<= 1) {
+			if (0 == (bits & axis)) {
+				edges[count++] = { corner(bits), QVector3D(0.0f, 0.0f, 1.0f), QVector2D() };
+				edges[count++] = { corner(bits | axis), QVector3D(0.0f, 0.0f, 1.0f), QVector2D() };
+			}
+		}
+	}
+	m_boundsVbo.bind();
+	m_boundsVbo.write(0, edges, sizeof(edges));
+	m_boundsVbo.release();
+	m_boundsVao.bind();
+	glDrawArrays(GL_LINES, 0, count);
+	m_boundsVao.release();
+}
+
+void FrameRenderer::drawPointCloud(const SceneSnapshot::Object& entry, const SceneSnapshot& snapshot)
+{
+	const auto& obj = entry.object;
+	auto& streamer = m_pointStreamers[obj->getID()];
+	if (nullptr != streamer && streamer->isStale()) {
+		//reloaded, the pool is rebuilt for the new octree
+		streamer->destroy();
+		streamer.reset();
+	}
+	if (nullptr == streamer) {
+		streamer = std::make_unique<PointCloudStreamer>(obj);
+		streamer->initialize(m_pointProgram);
+	}
+	transform(snapshot, entry);
+	PointCloudStreamer::View view;
+	view.modelView = m_view * m_model;
+	view.modelViewProjection = m_projection * view.modelView;
+	view.pixelsPerUnit = pixelsPerUnit(snapshot);
+	const bool streaming = streamer->update(view);
+
+	m_pointProgram->bind();
+	m_pointProgram->setUniformValue("viewMatrix", m_view);
+	m_pointProgram->setUniformValue("projectionMatrix", m_projection);
+	m_pointProgram->setUniformValue("modelMatrix", m_model);
+	m_pointProgram->setUniformValue("pointSize", POINT_SIZE);
+	m_pointProgram->setUniformValue("useColors", obj->pointCloud->hasColors);
+	m_pointProgram->setUniformValue("objectColor", snapshot.material.objectColor);
+	glEnable(GL_PROGRAM_POINT_SIZE);
+	streamer->draw(this);
+	glDisable(GL_PROGRAM_POINT_SIZE);
+	if (streaming) {
+		//keep pulling the missing nodes in
+		requestFrame();
+	}
+}
+
+void FrameRenderer::drawCulled(const std::shared_ptr<SceneObject>& obj, const SceneSnapshot& snapshot)
+{
+	auto& culler = m_occlusionCullers[obj->getID()];
+	if (nullptr != culler && culler->isStale()) {
+		culler->destroy(this);
+		culler.reset();
+	}
+	if (nullptr == culler) {
+		culler = std::make_unique<OcclusionCuller>(obj);
+		culler->initialize(this, m_shaderProgram);
+		m_shaderProgram->bind();
+	}
+	OcclusionCuller::View view;
+	view.model = m_model;
+	view.view = m_view;
+	view.pixelsPerUnit = pixelsPerUnit(snapshot);
+	view.viewportHeight = static_cast<float>(snapshot.height);
+	view.nearPlane = NEAR_PLANE;
+	if (!obj->materials.empty()) {
+		view.drawRange = [this, &obj](const BufferChunk& chunk, std::uint64_t first, std::uint64_t count) {
+			drawChunkRange(*obj, chunk, first, count);
+		};
+	}
+	culler->draw(this, m_shaderProgram, view);
+}
+
+void FrameRenderer::drawSection(const SceneSnapshot& snapshot, const SceneObject& obj, const QVector3D& normal, float offset)
+{
+	const auto& section = snapshot.section;
+	//a cut of another plane or of the geometry before a reload, the GUI thread has a new one on the way
+	if (nullptr == section.cut || section.cutObjId != obj.getID() || section.cutVersion != obj.getGeometryVersion() ||
+		!section.cut->matches(normal, offset)) {
+		return;
+	}
+	if (section.cut != m_sectionCut) {
+		uploadSection(section.cut);
+	}
+	m_sectionVao.bind();
+	if (!snapshot.wireframe && m_sectionCapCount > 0) {
+		//pushed back, the contours stay on top of it
+		glEnable(GL_POLYGON_OFFSET_FILL);
+		glPolygonOffset(1.0f, 1.0f);
+		m_shaderProgram->setUniformValue("objectColor", snapshot.material.objectColor * CAP_SHADE);
+		glDrawArrays(GL_TRIANGLES, 0, m_sectionCapCount);
+		glDisable(GL_POLYGON_OFFSET_FILL);
+	}
+	m_shaderProgram->setUniformValue("objectColor", snapshot.material.objectColor * CONTOUR_SHADE);
+	for (const auto& contour : m_sectionContours) {
+		glDrawArrays(contour.closed ? GL_LINE_LOOP : GL_LINE_STRIP, contour.first, contour.count);
+	}
+	m_sectionVao.release();
+	m_shaderProgram->setUniformValue("objectColor", snapshot.material.objectColor);
+}
+
+void FrameRenderer::uploadSection(const std::shared_ptr<const CrossSection>& cut)
+{
+	m_sectionCut = cut;
+	m_sectionContours.clear();
+	//the cap faces the removed side, the contours are lit the same way
+	const auto normal = -cut->normal.normalized();
+	std::vector<Vertex> vertices;
+	vertices.reserve(cut->cap.size());
+	for (const auto& corner : cut->cap) {
+		vertices.push_back({ corner, normal, QVector2D() });
+	}
+	m_sectionCapCount = static_cast<GLsizei>(vertices.size());
+	for (const auto& contour : cut->contours) {
+		m_sectionContours.push_back({ static_cast<GLint>(vertices.size()), static_cast<GLsizei>(contour.points.size()), contour.closed });
+		for (const auto& point : contour.points) {
+			vertices.push_back({ point, normal, QVector2D() });
+		}
+	}
+	m_sectionVbo.bind();
+	m_sectionVbo.allocate(vertices.data(), static_cast<int>(vertices.size() * sizeof(Vertex)));
+	m_sectionVbo.release();
+}
+
+void FrameRenderer::drawContacts(const SceneSnapshot& snapshot, const SceneSnapshot::Object& entry)
+{
+	//a highlight of the geometry before a reload, the next check brings the new one
+	if (nullptr == entry.contacts || entry.contacts->empty() || entry.contactsVersion != entry.object->getGeometryVersion()) {
+		return;
+	}
+	if (entry.contacts != m_contacts) {
+		m_contacts = entry.contacts;
+		m_contactsVbo.bind();
+		m_contactsVbo.allocate(m_contacts->data(), static_cast<int>(m_contacts->size() * sizeof(Vertex)));
+		m_contactsVbo.release();
+	}
+	//pulled forward, the triangles lie on the surface drawn before them
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glEnable(GL_POLYGON_OFFSET_LINE);
+	glPolygonOffset(-1.0f, -1.0f);
+	m_shaderProgram->setUniformValue("objectColor", CONTACT_COLOR);
+	m_contactsVao.bind();
+	glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(m_contacts->size()));
+	m_contactsVao.release();
+	glDisable(GL_POLYGON_OFFSET_LINE);
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	m_shaderProgram->setUniformValue("objectColor", snapshot.material.objectColor);
+}
+
+bool FrameRenderer::bindField(const SceneSnapshot::Object& entry)
+{
+	const auto& obj = entry.object;
+	const std::uint64_t num_vertices = obj->bufferChunks.empty() ? 0 :
+		obj->bufferChunks.back().firstVertex + obj->bufferChunks.back().vertexCount;
+	GLuint vbo = 0;
+	//a field of the geometry before a reload, the analyzer has the new one on the way
+	if (nullptr != entry.field && entry.fieldVersion == obj->getGeometryVersion() && entry.field->values.size() == num_vertices) {
+		auto& buffer = m_fieldBuffers[entry.field.get()];
+		if (nullptr == buffer) {
+			buffer = std::make_shared<FieldBuffer>(entry.field);
+			m_uploader->enqueueField(buffer);
+		}
+		buffer->lastUsed = ++m_fieldUses;
+		if (FieldBuffer::State::FENCED == buffer->state.load()) {
+			//polled like the geometry, the material colors are shown meanwhile
+			const auto status = glClientWaitSync(buffer->fence, 0, 0);
+			if (GL_ALREADY_SIGNALED == status || GL_CONDITION_SATISFIED == status) {
+				glDeleteSync(buffer->fence);
+				buffer->fence = nullptr;
+				buffer->state.store(FieldBuffer::State::READY);
+			}
+			else {
+				requestFencePoll();
+			}
+		}
+		if (FieldBuffer::State::READY == buffer->state.load()) {
+			vbo = buffer->vbo;
+		}
+	}
+	//set on every frame, the arrays of an object keep the stream of the last field shown on them
+	for (auto& chunk : obj->bufferChunks) {
+		chunk.vao->bind();
+		if (0 != vbo) {
+			glBindBuffer(GL_ARRAY_BUFFER, vbo);
+			glEnableVertexAttribArray(3);
+			glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(float), reinterpret_cast<const void*>(chunk.firstVertex * sizeof(float)));
+		}
+		else {
+			glDisableVertexAttribArray(3);
+		}
+		chunk.vao->release();
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	return 0 != vbo;
+}
+
+void FrameRenderer::releaseFieldBuffers(const SceneSnapshot& snapshot, std::uint64_t idleBytes)
+{
+	std::unordered_set<const ScalarField*> live;
+	for (const auto& entry : snapshot.objects) {
+		live.insert(entry.field.get());
+	}
+	std::vector<std::pair<std::uint64_t, const ScalarField*>> idle;
+	std::uint64_t idle_bytes = 0;
+	std::uint64_t total_bytes = 0;
+	for (const auto& it : m_fieldBuffers) {
+		const auto bytes = it.second->field->values.size() * sizeof(float);
+		total_bytes += bytes;
+		//the uploader still writes a queued one
+		if (0 != live.count(it.first) || FieldBuffer::State::QUEUED == it.second->state.load()) {
+			continue;
+		}
+		idle.emplace_back(it.second->lastUsed, it.first);
+		idle_bytes += bytes;
+	}
+	//least recently shown first
+	std::sort(idle.begin(), idle.end());
+	for (const auto& entry : idle) {
+		if (idle_bytes <= idleBytes) {
+			break;
+		}
+		auto& buffer = *m_fieldBuffers[entry.second];
+		const auto bytes = buffer.field->values.size() * sizeof(float);
+		if (nullptr != buffer.fence) {
+			glDeleteSync(buffer.fence);
+		}
+		if (0 != buffer.vbo) {
+			glDeleteBuffers(1, &buffer.vbo);
+		}
+		m_fieldBuffers.erase(entry.second);
+		idle_bytes -= bytes;
+		total_bytes -= bytes;
+	}
+	MemoryTracker::setCacheBytes(FIELD_BUFFER_CACHE, total_bytes);
+}
+
+void FrameRenderer::swapPendingGeometry(const SceneSnapshot& snapshot)
+{
+	for (const auto& entry : snapshot.objects) {
+		const auto& pending = entry.pending;
+		//swapped already, the scene drops it from the next snapshot
+		if (nullptr == pending || SceneObject::UploadState::RELEASED == pending->getUploadState()) {
+			continue;
+		}
+		const auto& obj = entry.object;
+		//uploaded objects keep drawing their old buffers until the new ones are ready
+		if (SceneObject::UploadState::READY == obj->getUploadState() && !pending->isPointCloud() &&
+			!prepareObjectBuffers(pending)) {
+			continue;
+		}
+		if (obj->swapGeometry(*pending)) {
+			emit geometrySwapped(obj->getID());
+		}
+		else {
+			//an upload, a proxy job or the GUI thread still read the old geometry
+			requestFrame();
+		}
+	}
+}
+
+void FrameRenderer::initObjectBuffers(SceneObject& obj)
+{
+	//vertex arrays are not shared between contexts, buffers are filled by the uploader
+	m_shaderProgram->bind();
+	for (auto& chunk : obj.bufferChunks) {
+		setupVertexArray(chunk);
+	}
+	obj.markBuffersReady();
+}
+
+void FrameRenderer::setupVertexArray(BufferChunk& chunk)
+{
+	chunk.vao = std::make_unique<QOpenGLVertexArrayObject>();
+	chunk.vao->create();
+	chunk.vao->bind();
+	chunk.vbo.bind();
+
+	//m_position
+	m_shaderProgram->enableAttributeArray(0);
+	m_shaderProgram->setAttributeBuffer(0, GL_FLOAT, 0, 3, sizeof(Vertex));
+	//normal
+	m_shaderProgram->enableAttributeArray(1);
+	m_shaderProgram->setAttributeBuffer(1, GL_FLOAT, sizeof(QVector3D), 3, sizeof(Vertex));
+	//texture
+	m_shaderProgram->enableAttributeArray(2);
+	m_shaderProgram->setAttributeBuffer(2, GL_FLOAT, sizeof(QVector3D) * 2, 2, sizeof(Vertex));
+
+	chunk.vao->release();
+	chunk.vbo.release();
+}
+
+bool FrameRenderer::prepareObjectBuffers(const std::shared_ptr<SceneObject>& obj)
+{
+	switch (obj->getUploadState()) {
+	case SceneObject::UploadState::NONE:
+		m_uploader->enqueue(obj);
+		return false;
+	case SceneObject::UploadState::FENCED: {
+		//never block the frame, poll the fence and look again a little later
+		const auto status = glClientWaitSync(obj->getUploadFence(), 0, 0);
+		if (GL_ALREADY_SIGNALED != status && GL_CONDITION_SATISFIED != status) {
+			requestFencePoll();
+			return false;
+		}
+		glDeleteSync(obj->getUploadFence());
+		obj->intializeBuffers(this);
+		return true;
+	}
+	case SceneObject::UploadState::READY:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void FrameRenderer::prepareProxyBuffers(const std::shared_ptr<SceneObject>& obj)
+{
+	//the proxy is small enough by its budget to be uploaded directly, without the uploader thread
+	if (SceneObject::ProxyState::BUILT != obj->getProxyState()) {
+		return;
+	}
+	auto& chunk = obj->proxyChunk;
+	chunk.firstVertex = 0;
+	chunk.vertexCount = obj->proxyVertices.size();
+	chunk.vbo.create();
+	chunk.vbo.setUsagePattern(QOpenGLBuffer::StaticDraw);
+	chunk.vbo.bind();
+	chunk.vbo.allocate(obj->proxyVertices.data(), static_cast<int>(obj->proxyVertices.sizeInBytes()));
+	chunk.vbo.release();
+	m_shaderProgram->bind();
+	setupVertexArray(chunk);
+	obj->markProxyReady();
+}
+
+void FrameRenderer::transform(const SceneSnapshot& snapshot, const SceneSnapshot::Object& obj)
+{
+	m_projection.setToIdentity();
+	m_projection.perspective(snapshot.zoom, static_cast<float>(snapshot.width / snapshot.height), NEAR_PLANE, FAR_PLANE);
+	m_view = snapshot.view;
+	m_model = obj.model;
+}
+
+void FrameRenderer::setUniforms(const SceneSnapshot& snapshot)
+{
+	//vertex shader
+	m_shaderProgram->setUniformValue("viewMatrix", m_view);
+	m_shaderProgram->setUniformValue("projectionMatrix", m_projection);
+	m_shaderProgram->setUniformValue("modelMatrix", m_model);
+	//fragment shader
+	m_shaderProgram->setUniformValue("lightDirectionFront", QVector3D(0.0f, 0.0f, -1.0f));
+	m_shaderProgram->setUniformValue("lightDirectionBack", QVector3D(0.0f, 0.0f, 1.0f));
+	m_shaderProgram->setUniformValue("lightColor", QVector3D(1.0f, 1.0f, 1.0f));
+	//material, the maps of an object are bound per material run
+	m_materialColor = snapshot.material.objectColor;
+	m_boundMaterial = -1;
+	m_shaderProgram->setUniformValue("objectColor", snapshot.material.objectColor);
+	m_shaderProgram->setUniformValue("diffuseMap", 0);
+	m_shaderProgram->setUniformValue("normalMap", 1);
+	m_shaderProgram->setUniformValue("bumpMap", 2);
+	m_shaderProgram->setUniformValue("hasDiffuseMap", false);
+	m_shaderProgram->setUniformValue("hasNormalMap", false);
+	m_shaderProgram->setUniformValue("hasBumpMap", false);
+	m_shaderProgram->setUniformValue("showField", false);
+	m_shaderProgram->setUniformValue("ambientStrength", snapshot.material.ambientStrength);
+	m_shaderProgram->setUniformValue("specularStrength", snapshot.material.specularStrength);
+	m_shaderProgram->setUniformValue("shininess", snapshot.material.shininess);
+}
+
+float FrameRenderer::pixelsPerUnit(const SceneSnapshot& snapshot) const
+{
+	return snapshot.height / (2.0f * std::tan(qDegreesToRadians(snapshot.zoom) * 0.5f));
+}
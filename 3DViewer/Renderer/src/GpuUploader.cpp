@@ -0,0 +1,224 @@
+#include <QDebug>
+#include <QElapsedTimer>
+
+#include "GpuUploader.h"
+#include "OcclusionCuller.h"
+
+GpuUploader::GpuUploader(QOpenGLContext* shareContext) :
+	m_surface(new QOffscreenSurface()),
+	m_context(new QOpenGLContext()),
+	m_functions(nullptr)
+{
+	m_surface->setFormat(shareContext->format());
+	m_surface->create();
+	m_context->setFormat(shareContext->format());
+	m_context->setShareContext(shareContext);
+	if (!m_context->create()) {
+		qCritical() << "Critical: cannot create shared OpenGL context for uploads.";
+	}
+	m_context->moveToThread(&m_thread);
+	moveToThread(&m_thread);
+	m_thread.setObjectName("GpuUploader");
+	m_thread.start();
+}
+
+GpuUploader::~GpuUploader()
+{
+	m_thread.quit();
+	m_thread.wait();
+	delete m_context;
+	delete m_surface;
+}
+
+void GpuUploader::enqueue(const std::shared_ptr<SceneObject>& obj)
+{
+	if (!obj->queueUpload()) {
+		return;
+	}
+	QMetaObject::invokeMethod(this, [this, obj]() { uploadObject(obj); }, Qt::QueuedConnection);
+}
+
+void GpuUploader::uploadObject(const std::shared_ptr<SceneObject>& obj)
+{
+	//object might have been removed while waiting in the queue
+	if (!obj->beginUpload()) {
+		return;
+	}
+	if (!makeCurrent()) {
+		return;
+	}
+	QElapsedTimer timer;
+	timer.start();
+
+	//split geometry into bounded buffers, whole triangles per buffer
+	constexpr std::uint64_t vertices_per_chunk = (MAX_BUFFER_SIZE / sizeof(Vertex)) / 3 * 3;
+	std::vector<BufferChunk> chunks;
+	for (std::uint64_t first = 0; first < obj->vertices.size(); first += vertices_per_chunk) {
+		BufferChunk chunk;
+		chunk.firstVertex = first;
+		chunk.vertexCount = std::min(vertices_per_chunk, obj->vertices.size() - first);
+		chunk.vbo.create();
+		chunk.vbo.setUsagePattern(QOpenGLBuffer::StaticDraw);
+		chunk.vbo.bind();
+		const auto bytes = chunk.vertexCount * sizeof(Vertex);
+		const auto data = reinterpret_cast<const char*>(obj->vertices.data() + first);
+		chunk.vbo.allocate(static_cast<int>(bytes));
+		for (std::uint64_t offset = 0; offset < bytes; offset += UPLOAD_BLOCK_SIZE) {
+			const auto block = std::min(UPLOAD_BLOCK_SIZE, bytes - offset);
+			chunk.vbo.write(static_cast<int>(offset), data + offset, static_cast<int>(block));
+			m_functions->glFlush();
+		}
+		chunk.vbo.release();
+		chunks.push_back(std::move(chunk));
+	}
+	GLsync fence = m_functions->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_functions->glFlush();
+	//bounds of the culling clusters, computed while the driver copies the data
+	auto clusters = OcclusionCuller::buildClusters(obj->vertices, chunks);
+	if (!obj->finishUpload(chunks, clusters, fence)) {
+		//removed during the upload, render thread cleans up
+		retire(std::move(chunks), fence);
+	}
+	m_context->doneCurrent();
+	qDebug() << "Message: object upload took" <<
+		static_cast<double>(timer.nsecsElapsed()) / 1000000000.0 << "sec to execute";
+	emit uploadFinished(obj->getID());
+}
+
+void GpuUploader::enqueueTexture(const std::shared_ptr<StreamedTexture>& texture, const std::shared_ptr<const MipChain>& chain)
+{
+	const int coarsest = static_cast<int>(chain->levels.size()) - 1;
+	QMetaObject::invokeMethod(this, [this, texture, chain, coarsest]() { uploadTextureLevel(texture, chain, coarsest); },
+		Qt::QueuedConnection);
+}
+
+void GpuUploader::uploadTextureLevel(const std::shared_ptr<StreamedTexture>& texture, const std::shared_ptr<const MipChain>& chain, int level)
+{
+	if (!makeCurrent()) {
+		texture->state.store(StreamedTexture::State::FAILED);
+		return;
+	}
+	const int level_count = static_cast<int>(chain->levels.size());
+	if (0 == texture->id.load()) {
+		//storage of all the levels up front, only the coarsest is sampled until the finer ones arrive
+		GLuint id = 0;
+		m_functions->glGenTextures(1, &id);
+		m_functions->glBindTexture(GL_TEXTURE_2D, id);
+		for (int i = 0; i < level_count; ++i) {
+			const auto& image = chain->levels[i];
+			m_functions->glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA8, image.width(), image.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		}
+		m_functions->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level_count - 1);
+		m_functions->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level_count - 1);
+		m_functions->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		m_functions->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		m_functions->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		m_functions->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		texture->levelCount.store(level_count);
+		texture->id.store(id);
+	}
+	else {
+		m_functions->glBindTexture(GL_TEXTURE_2D, texture->id.load());
+	}
+	//bands of whole rows of at most a block each, the driver never copies a large level in one go
+	const auto& image = chain->levels[level];
+	const auto row_bytes = static_cast<std::uint64_t>(image.bytesPerLine());
+	const int band_rows = static_cast<int>(std::max<std::uint64_t>(1, UPLOAD_BLOCK_SIZE / std::max<std::uint64_t>(1, row_bytes)));
+	for (int y = 0; y < image.height(); y += band_rows) {
+		const int rows = std::min(band_rows, image.height() - y);
+		m_functions->glTexSubImage2D(GL_TEXTURE_2D, level, 0, y, image.width(), rows, GL_RGBA, GL_UNSIGNED_BYTE, image.constScanLine(y));
+		m_functions->glFlush();
+	}
+	m_functions->glBindTexture(GL_TEXTURE_2D, 0);
+	GLsync fence = m_functions->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_functions->glFlush();
+	m_context->doneCurrent();
+	{
+		std::lock_guard<std::mutex> lock(texture->mutex);
+		texture->fencedLevels.push_back({ level, fence });
+	}
+	if (level > 0) {
+		//the next level goes behind the uploads queued meanwhile
+		QMetaObject::invokeMethod(this, [this, texture, chain, level]() { uploadTextureLevel(texture, chain, level - 1); },
+			Qt::QueuedConnection);
+	}
+	else {
+		texture->state.store(StreamedTexture::State::READY);
+	}
+	emit textureLevelUploaded();
+}
+
+void GpuUploader::enqueueField(const std::shared_ptr<FieldBuffer>& buffer)
+{
+	QMetaObject::invokeMethod(this, [this, buffer]() { uploadField(buffer); }, Qt::QueuedConnection);
+}
+
+void GpuUploader::uploadField(const std::shared_ptr<FieldBuffer>& buffer)
+{
+	if (!makeCurrent()) {
+		buffer->state.store(FieldBuffer::State::FAILED);
+		return;
+	}
+	const auto& values = buffer->field->values;
+	const auto bytes = values.size() * sizeof(float);
+	const auto data = reinterpret_cast<const char*>(values.data());
+	m_functions->glGenBuffers(1, &buffer->vbo);
+	m_functions->glBindBuffer(GL_ARRAY_BUFFER, buffer->vbo);
+	m_functions->glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(bytes), nullptr, GL_STATIC_DRAW);
+	for (std::uint64_t offset = 0; offset < bytes; offset += UPLOAD_BLOCK_SIZE) {
+		const auto block = std::min<std::uint64_t>(UPLOAD_BLOCK_SIZE, bytes - offset);
+		m_functions->glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(block), data + offset);
+		m_functions->glFlush();
+	}
+	m_functions->glBindBuffer(GL_ARRAY_BUFFER, 0);
+	buffer->fence = m_functions->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_functions->glFlush();
+	m_context->doneCurrent();
+	buffer->state.store(FieldBuffer::State::FENCED);
+	emit fieldUploaded();
+}
+
+bool GpuUploader::makeCurrent()
+{
+	if (!m_context->makeCurrent(m_surface)) {
+		qCritical() << "Critical: cannot make upload context current.";
+		return false;
+	}
+	if (nullptr == m_functions) {
+		m_functions = m_context->versionFunctions<QOpenGLFunctions_3_3_Core>();
+		m_functions->initializeOpenGLFunctions();
+	}
+	return true;
+}
+
+void GpuUploader::retire(std::vector<BufferChunk>&& chunks, GLsync fence)
+{
+	std::lock_guard<std::mutex> lock(s_retiredMutex);
+	for (auto& chunk : chunks) {
+		s_retiredChunks.push_back(std::move(chunk));
+	}
+	chunks.clear();
+	if (nullptr != fence) {
+		s_retiredFences.push_back(fence);
+	}
+}
+
+void GpuUploader::destroyRetired(QOpenGLFunctions_3_3_Core* functions)
+{
+	std::vector<BufferChunk> chunks;
+	std::vector<GLsync> fences;
+	{
+		std::lock_guard<std::mutex> lock(s_retiredMutex);
+		chunks.swap(s_retiredChunks);
+		fences.swap(s_retiredFences);
+	}
+	for (auto& chunk : chunks) {
+		chunk.vbo.destroy();
+		if (nullptr != chunk.vao) {
+			chunk.vao->destroy();
+		}
+	}
+	for (auto fence : fences) {
+		functions->glDeleteSync(fence);
+	}
+}
@@ -0,0 +1,187 @@
+#include <algorithm>
+
+#include "OcclusionCuller.h"
+#include "JobSystem.h"
+
+namespace {
+	// 12 triangles of the unit cube, scaled to a cluster box by the model matrix
+	constexpr float UNIT_BOX[36 * 3] = {
+		0, 0, 0,  1, 1, 0,  1, 0, 0,   0, 0, 0,  0, 1, 0,  1, 1, 0,
+		0, 0, 1,  1, 0, 1,  1, 1, 1,   0, 0, 1,  1, 1, 1,  0, 1, 1,
+		0, 0, 0,  1, 0, 0,  1, 0, 1,   0, 0, 0,  1, 0, 1,  0, 0, 1,
+		0, 1, 0,  0, 1, 1,  1, 1, 1,   0, 1, 0,  1, 1, 1,  1, 1, 0,
+		0, 0, 0,  0, 0, 1,  0, 1, 1,   0, 0, 0,  0, 1, 1,  0, 1, 0,
+		1, 0, 0,  1, 1, 0,  1, 1, 1,   1, 0, 0,  1, 1, 1,  1, 0, 1
+	};
+}
+
+std::vector<DrawCluster> OcclusionCuller::buildClusters(const MappedArray<Vertex>& vertices, const std::vector<BufferChunk>& chunks)
+{
+	const std::uint64_t triangles = vertices.size() / 3;
+	std::vector<DrawCluster> clusters;
+	if (triangles < MIN_CULLED_TRIANGLES) {
+		return clusters;
+	}
+	const std::uint64_t cluster_vertices =
+		std::max(MIN_CLUSTER_TRIANGLES, (triangles + MAX_CLUSTERS - 1) / MAX_CLUSTERS) * 3;
+	for (int chunk = 0; chunk < static_cast<int>(chunks.size()); ++chunk) {
+		//whole triangles in a chunk, clusters never cross its end
+		for (std::uint64_t first = 0; first < chunks[chunk].vertexCount; first += cluster_vertices) {
+			DrawCluster cluster;
+			cluster.chunk = chunk;
+			cluster.firstVertex = first;
+			cluster.vertexCount = std::min(cluster_vertices, chunks[chunk].vertexCount - first);
+			clusters.push_back(cluster);
+		}
+	}
+	JobSystem::instance().parallelFor(clusters.size(), 16, [&](std::uint64_t begin, std::uint64_t end) {
+		for (auto i = begin; i < end; ++i) {
+			auto& cluster = clusters[i];
+			const auto* vertex = vertices.data() + chunks[cluster.chunk].firstVertex + cluster.firstVertex;
+			cluster.minBounds = cluster.maxBounds = vertex->position;
+			for (std::uint64_t j = 0; j < cluster.vertexCount; ++j, ++vertex) {
+				for (int axis = 0; axis < 3; ++axis) {
+					cluster.minBounds[axis] = std::min(cluster.minBounds[axis], vertex->position[axis]);
+					cluster.maxBounds[axis] = std::max(cluster.maxBounds[axis], vertex->position[axis]);
+				}
+			}
+		}
+	});
+	return clusters;
+}
+
+OcclusionCuller::OcclusionCuller(const std::shared_ptr<SceneObject>& obj) :
+	m_object(obj),
+	m_geometryVersion(obj->getGeometryVersion()),
+	m_queries(obj->drawClusters.size(), 0),
+	m_pending(obj->drawClusters.size(), false),
+	m_visible(obj->drawClusters.size(), true)
+{
+}
+
+void OcclusionCuller::initialize(QOpenGLFunctions_3_3_Core* functions, QOpenGLShaderProgram* program)
+{
+	if (!m_queries.empty()) {
+		functions->glGenQueries(static_cast<GLsizei>(m_queries.size()), m_queries.data());
+	}
+	m_boxVbo.create();
+	m_boxVbo.setUsagePattern(QOpenGLBuffer::StaticDraw);
+	m_boxVbo.bind();
+	m_boxVbo.allocate(UNIT_BOX, sizeof(UNIT_BOX));
+	m_boxVao.create();
+	m_boxVao.bind();
+	program->bind();
+	//m_position only, nothing is written to the color buffer
+	program->enableAttributeArray(0);
+	program->setAttributeBuffer(0, GL_FLOAT, 0, 3, 3 * sizeof(float));
+	m_boxVao.release();
+	m_boxVbo.release();
+}
+
+void OcclusionCuller::destroy(QOpenGLFunctions_3_3_Core* functions)
+{
+	if (!m_queries.empty() && 0 != m_queries.front()) {
+		functions->glDeleteQueries(static_cast<GLsizei>(m_queries.size()), m_queries.data());
+	}
+	std::fill(m_queries.begin(), m_queries.end(), 0);
+	std::fill(m_pending.begin(), m_pending.end(), false);
+	m_boxVao.destroy();
+	m_boxVbo.destroy();
+}
+
+void OcclusionCuller::draw(QOpenGLFunctions_3_3_Core* functions, QOpenGLShaderProgram* program, const View& view)
+{
+	const auto& clusters = m_object->drawClusters;
+	const QMatrix4x4 model_view = view.view * view.model;
+	//the camera in object space, boxes around it are always drawn
+	const QVector3D eye = model_view.inverted().map(QVector3D(0.0f, 0.0f, 0.0f));
+	m_order.clear();
+	for (int i = 0; i < static_cast<int>(clusters.size()); ++i) {
+		const auto center = (clusters[i].minBounds + clusters[i].maxBounds) * 0.5f;
+		m_order.push_back({ -model_view.map(center).z(), i });
+	}
+	std::sort(m_order.begin(), m_order.end());
+
+	m_stats = Stats();
+	m_tested.clear();
+	int occluders = 0;
+	const QVector3D margin(view.nearPlane, view.nearPlane, view.nearPlane);
+	for (const auto& entry : m_order) {
+		const auto& cluster = clusters[entry.second];
+		const auto min = cluster.minBounds - margin;
+		const auto max = cluster.maxBounds + margin;
+		const bool around_eye = eye.x() >= min.x() && eye.y() >= min.y() && eye.z() >= min.z() &&
+			eye.x() <= max.x() && eye.y() <= max.y() && eye.z() <= max.z();
+		const float screen_size = (cluster.maxBounds - cluster.minBounds).length() * view.pixelsPerUnit /
+			std::max(entry.first, view.nearPlane);
+		const bool occluder = occluders < MAX_OCCLUDERS && screen_size >= OCCLUDER_SCREEN_FRACTION * view.viewportHeight;
+		if (around_eye || occluder) {
+			//depth pre-pass of the big ones, front to back
+			occluders += occluder ? 1 : 0;
+			drawCluster(functions, cluster, view);
+			++m_stats.visible;
+			continue;
+		}
+		m_tested.push_back(entry.second);
+	}
+
+	for (const auto index : m_tested) {
+		if (m_pending[index]) {
+			GLuint available = 0;
+			functions->glGetQueryObjectuiv(m_queries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (GL_TRUE == available) {
+				GLuint passed = 0;
+				functions->glGetQueryObjectuiv(m_queries[index], GL_QUERY_RESULT, &passed);
+				m_visible[index] = 0 != passed;
+				m_pending[index] = false;
+			}
+		}
+		if (m_visible[index]) {
+			drawCluster(functions, clusters[index], view);
+			++m_stats.visible;
+		}
+		else {
+			++m_stats.occluded;
+			m_stats.savedTriangles += clusters[index].vertexCount / 3;
+		}
+	}
+
+	//boxes against the finished depth, tested without writing anything
+	functions->glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	functions->glDepthMask(GL_FALSE);
+	//padded, so flat clusters get a volume and their box is not hidden by the cluster itself
+	const float pad = 0.001f * m_object->getBoundingBoxLength();
+	const QVector3D padding(pad, pad, pad);
+	m_boxVao.bind();
+	for (const auto index : m_tested) {
+		if (m_pending[index]) {
+			continue;
+		}
+		const auto& cluster = clusters[index];
+		QMatrix4x4 box = view.model;
+		box.translate(cluster.minBounds - padding);
+		box.scale(cluster.maxBounds - cluster.minBounds + padding * 2.0f);
+		program->setUniformValue("modelMatrix", box);
+		functions->glBeginQuery(GL_ANY_SAMPLES_PASSED, m_queries[index]);
+		functions->glDrawArrays(GL_TRIANGLES, 0, 36);
+		functions->glEndQuery(GL_ANY_SAMPLES_PASSED);
+		m_pending[index] = true;
+	}
+	m_boxVao.release();
+	program->setUniformValue("modelMatrix", view.model);
+	functions->glDepthMask(GL_TRUE);
+	functions->glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+void OcclusionCuller::drawCluster(QOpenGLFunctions_3_3_Core* functions, const DrawCluster& cluster, const View& view)
+{
+	auto& chunk = m_object->bufferChunks[cluster.chunk];
+	chunk.vao->bind();
+	if (view.drawRange) {
+		view.drawRange(chunk, cluster.firstVertex, cluster.vertexCount);
+	}
+	else {
+		functions->glDrawArrays(GL_TRIANGLES, static_cast<GLint>(cluster.firstVertex), static_cast<GLsizei>(cluster.vertexCount));
+	}
+	chunk.vao->release();
+}
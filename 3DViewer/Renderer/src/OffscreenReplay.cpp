@@ -0,0 +1,201 @@
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QSurfaceFormat>
+#include <QVector4D>
+
+#include <algorithm>
+
+#include "Camera.h"
+#include "FrameRenderer.h"
+#include "GpuUploader.h"
+#include "OffscreenReplay.h"
+#include "Scene.h"
+
+namespace {
+	//split the way the viewer uploads them, a single buffer of a large model exceeds what drivers allocate
+	constexpr std::uint64_t CHUNK_VERTICES = GpuUploader::MAX_BUFFER_SIZE / sizeof(Vertex);
+}
+
+OffscreenReplay::OffscreenReplay() :
+	m_surface(std::make_unique<QOffscreenSurface>()),
+	m_context(std::make_unique<QOpenGLContext>())
+{
+	QSurfaceFormat format;
+	format.setVersion(3, 3);
+	format.setProfile(QSurfaceFormat::CoreProfile);
+	m_surface->setFormat(format);
+	m_surface->create();
+	m_context->setFormat(format);
+	m_available = m_surface->isValid() && m_context->create();
+	if (!m_available) {
+		qCritical() << "Critical: cannot create OpenGL context for the session replay.";
+	}
+}
+
+OffscreenReplay::~OffscreenReplay()
+{
+	releaseResources();
+}
+
+bool OffscreenReplay::initializeResources(const QSize& size)
+{
+	if (!m_available || !m_context->makeCurrent(m_surface.get())) {
+		qCritical() << "Critical: cannot make replay context current.";
+		return false;
+	}
+	if (!initializeOpenGLFunctions()) {
+		qCritical() << "Critical: replay context does not support OpenGL 3.3 core.";
+		return false;
+	}
+	m_program = std::make_unique<QOpenGLShaderProgram>();
+	if (!m_program->addShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/main_vert.glsl") ||
+		!m_program->addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/main_frag.glsl") ||
+		!m_program->link()) {
+		qCritical() << "Critical: error while loading replay shaders.";
+		return false;
+	}
+	QOpenGLFramebufferObjectFormat format;
+	format.setAttachment(QOpenGLFramebufferObject::Depth);
+	format.setSamples(FrameRenderer::SAMPLES);
+	m_frameBuffer = std::make_unique<QOpenGLFramebufferObject>(size, format);
+	return m_frameBuffer->isValid();
+}
+
+void OffscreenReplay::releaseResources()
+{
+	if (nullptr == m_program || !m_context->makeCurrent(m_surface.get())) {
+		return;
+	}
+	m_objectChunks.clear();
+	m_frameBuffer.reset();
+	m_program.reset();
+	m_context->doneCurrent();
+}
+
+bool OffscreenReplay::uploadObject(const SceneObject& obj, std::vector<Chunk>& chunks)
+{
+	const auto& vertices = obj.vertices;
+	for (std::uint64_t first = 0; first < vertices.size(); first += CHUNK_VERTICES) {
+		Chunk chunk;
+		chunk.vertexCount = static_cast<GLsizei>(std::min(CHUNK_VERTICES, vertices.size() - first));
+		chunk.vbo = std::make_unique<QOpenGLBuffer>();
+		chunk.vao = std::make_unique<QOpenGLVertexArrayObject>();
+		if (!chunk.vbo->create() || !chunk.vao->create()) {
+			return false;
+		}
+		chunk.vao->bind();
+		chunk.vbo->bind();
+		chunk.vbo->allocate(vertices.data() + first, static_cast<int>(chunk.vertexCount * sizeof(Vertex)));
+		m_program->enableAttributeArray(0);
+		m_program->setAttributeBuffer(0, GL_FLOAT, 0, 3, sizeof(Vertex));
+		m_program->enableAttributeArray(1);
+		m_program->setAttributeBuffer(1, GL_FLOAT, sizeof(QVector3D), 3, sizeof(Vertex));
+		m_program->enableAttributeArray(2);
+		m_program->setAttributeBuffer(2, GL_FLOAT, sizeof(QVector3D) * 2, 2, sizeof(Vertex));
+		chunk.vao->release();
+		chunk.vbo->release();
+		chunks.push_back(std::move(chunk));
+	}
+	return GL_NO_ERROR == glGetError();
+}
+
+bool OffscreenReplay::run(const SessionRecording& recording, const std::vector<SessionRecording::Frame>& frames,
+	const QVector<std::shared_ptr<SceneObject>>& objects, FrameTimings& timings)
+{
+	const QSize size(recording.width, recording.height);
+	if (frames.empty() || !initializeResources(size)) {
+		return false;
+	}
+	m_program->bind();
+	m_objectChunks.resize(objects.size());
+	for (int i = 0; i < objects.size(); ++i) {
+		if (!objects[i]->isPointCloud() && !uploadObject(*objects[i], m_objectChunks[i])) {
+			qCritical() << "Critical: cannot upload " << objects[i]->getName() << " for the session replay.";
+			m_context->doneCurrent();
+			return false;
+		}
+	}
+	timings.renderer = FrameTimings::OFFSCREEN_RENDERER;
+	timings.width = size.width();
+	timings.height = size.height();
+	timings.frames.clear();
+	timings.frames.reserve(frames.size());
+
+	//the first drawing pays for the first use of the buffers by the driver, it is not counted
+	int current = -1;
+	const auto select = [&objects, &current](const SessionRecording::Frame& frame) {
+		if (frame.object >= 0 && frame.object < objects.size()) {
+			current = frame.object;
+		}
+	};
+	select(frames.front());
+	drawFrame(recording, frames.front(), objects, current);
+	glFinish();
+	QElapsedTimer timer;
+	for (const auto& frame : frames) {
+		select(frame);
+		timer.start();
+		drawFrame(recording, frame, objects, current);
+		glFinish();
+		timings.frames.push_back(static_cast<double>(timer.nsecsElapsed()) / 1000000.0);
+	}
+	m_program->release();
+	m_frameBuffer->release();
+	m_context->doneCurrent();
+	return true;
+}
+
+void OffscreenReplay::drawFrame(const SessionRecording& recording, const SessionRecording::Frame& frame,
+	const QVector<std::shared_ptr<SceneObject>>& objects, int current)
+{
+	m_frameBuffer->bind();
+	glViewport(0, 0, recording.width, recording.height);
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_MULTISAMPLE);
+	glClearColor(0.85f, 0.85f, 0.85f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	if (current < 0 || Qt::CheckState::Checked != objects[current]->isVisible()) {
+		return;
+	}
+	const auto& obj = objects[current];
+	//the transform of the frame belongs to the object it was recorded with
+	QMatrix4x4 model;
+	if (frame.object == current) {
+		obj->setTranslationVec(frame.translation);
+		obj->setRotationQuart(frame.rotation);
+	}
+	model.translate(obj->getTranslationVec());
+	model.rotate(obj->getRotationQuart());
+	Camera camera;
+	camera.setState(frame.camera);
+	QMatrix4x4 projection;
+	projection.perspective(frame.camera.zoom, static_cast<float>(recording.width) / recording.height,
+		FrameRenderer::NEAR_PLANE, FrameRenderer::FAR_PLANE);
+
+	m_program->setUniformValue("viewMatrix", camera.getViewMatrix());
+	m_program->setUniformValue("projectionMatrix", projection);
+	m_program->setUniformValue("modelMatrix", model);
+	m_program->setUniformValue("clipPlane", QVector4D());
+	m_program->setUniformValue("lightDirectionFront", QVector3D(0.0f, 0.0f, -1.0f));
+	m_program->setUniformValue("lightDirectionBack", QVector3D(0.0f, 0.0f, 1.0f));
+	m_program->setUniformValue("lightColor", QVector3D(1.0f, 1.0f, 1.0f));
+	const auto material = Scene::defaultMaterial();
+	m_program->setUniformValue("objectColor", material.objectColor);
+	m_program->setUniformValue("diffuseMap", 0);
+	m_program->setUniformValue("normalMap", 1);
+	m_program->setUniformValue("bumpMap", 2);
+	m_program->setUniformValue("hasDiffuseMap", false);
+	m_program->setUniformValue("hasNormalMap", false);
+	m_program->setUniformValue("hasBumpMap", false);
+	m_program->setUniformValue("showField", false);
+	m_program->setUniformValue("ambientStrength", material.ambientStrength);
+	m_program->setUniformValue("specularStrength", material.specularStrength);
+	m_program->setUniformValue("shininess", material.shininess);
+	glPolygonMode(GL_FRONT_AND_BACK, recording.wireframe ? GL_LINE : GL_FILL);
+	for (const auto& chunk : m_objectChunks[current]) {
+		chunk.vao->bind();
+		glDrawArrays(GL_TRIANGLES, 0, chunk.vertexCount);
+		chunk.vao->release();
+	}
+	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+}
@@ -2,144 +2,161 @@
 #include <QApplication>
 #include <QtMath>
 
+#include <algorithm>
+
 #include "OpenGLRenderer.h"
 
 OpenGLRenderer::OpenGLRenderer(QWidget* parent, const Scene& scene) :
 	QOpenGLWidget(parent),
 	m_drawingMode(Mode::SOLID),
 	m_camera(),
-	m_scene(scene)
+	m_scene(scene),
+	m_frameRenderer(std::make_unique<FrameRenderer>(this))
 {
 	setFocusPolicy(parent->focusPolicy());
 	setMouseTracking(true);
-	//anti-alising
+	//anti-alising is done by the framebuffer of the render thread
 	QSurfaceFormat format;
-	format.setSamples(4);
+	//frames are composed by the GUI thread, with vsync at most one per refresh
+	format.setSwapInterval(1);
 	setFormat(format); 
+
+	//frames are drawn by the render thread with a context of its own and composed here
+	m_frameRenderer->moveToThread(&m_renderThread);
+	m_renderThread.setObjectName("FrameRenderer");
+	connect(m_frameRenderer.get(), &FrameRenderer::qualityChanged, this, &OpenGLRenderer::qualityChanged);
+	connect(m_frameRenderer.get(), &FrameRenderer::geometrySwapped, this, &OpenGLRenderer::geometrySwapped);
+	connect(m_frameRenderer.get(), &FrameRenderer::geometrySwapped, this, &OpenGLRenderer::handleGeometrySwapped);
+	connect(m_frameRenderer.get(), &FrameRenderer::frameTimed, this, &OpenGLRenderer::handleFrameTimed);
+	m_renderThread.start();
+
+	m_statusTimer.setInterval(STATUS_INTERVAL_MS);
+	connect(&m_statusTimer, &QTimer::timeout, this, &OpenGLRenderer::updateStatus);
+	m_restoreTimer.setSingleShot(true);
+	m_restoreTimer.setInterval(static_cast<int>(AdaptiveQuality::RESTORE_DELAY * 1000.0) + 10);
+	connect(&m_restoreTimer, &QTimer::timeout, this, &OpenGLRenderer::redraw);
+	m_sectionTimer.setSingleShot(true);
+	m_sectionTimer.setInterval(SECTION_DEBOUNCE_MS);
+	connect(&m_sectionTimer, &QTimer::timeout, this, &OpenGLRenderer::computeSection);
 }
 
-void OpenGLRenderer::drawObject(SceneObject& obj)
+OpenGLRenderer::~OpenGLRenderer()
 {
-	obj.vao.bind();
-	glDrawArrays(GL_TRIANGLES, 0, obj.vertices.size());
-	obj.vao.release();
+	//a cut in progress stops at its next cancellation point
+	m_sectionToken.cancel();
+	JobSystem::instance().wait(m_sectionJobs);
+	m_frameRenderer->prepareExit();
+	//the render context is released on the thread it is current on
+	QMetaObject::invokeMethod(m_frameRenderer.get(), &FrameRenderer::destroy, Qt::BlockingQueuedConnection);
+	m_renderThread.quit();
+	m_renderThread.wait();
+	makeCurrent();
+	m_frameRenderer->releaseCompose();
+	doneCurrent();
+	m_frameRenderer.reset();
 }
 
-void OpenGLRenderer::initObjectBuffers(SceneObject& obj)
+void OpenGLRenderer::initializeGL()
 {
-	obj.vao.create();
-	obj.vao.bind();
-
-	obj.vbo.create();
-	obj.vbo.setUsagePattern(QOpenGLBuffer::StaticDraw);
-	obj.vbo.bind();
-
-	obj.vbo.allocate(obj.vertices.constData(), obj.vertices.size() * sizeof(Vertex));
-
-	m_shaderProgram->bind();
-	//m_position
-	m_shaderProgram->enableAttributeArray(0);
-	m_shaderProgram->setAttributeArray(0, GL_FLOAT, 0, 3, sizeof(Vertex));
-	//normal
-	m_shaderProgram->enableAttributeArray(1);
-	m_shaderProgram->setAttributeBuffer(1, GL_FLOAT, sizeof(QVector3D), 3, sizeof(Vertex));
-	//texture
-	m_shaderProgram->enableAttributeArray(2);
-	m_shaderProgram->setAttributeBuffer(2, GL_FLOAT, sizeof(QVector3D) * 2, 2, sizeof(Vertex));
-
-	obj.setBuffersInited(true);
+	m_frameRenderer->createContexts(context());
+	m_frameRenderer->setTargetSize(size() * devicePixelRatioF());
+	m_lastMousePos = QPoint(width() / 2.0f, height() / 2.0f);
+	m_statusTimer.start();
+	redraw();
 }
 
-void OpenGLRenderer::updateCamera(float bblength) 
+void OpenGLRenderer::resizeGL(int w, int h)
 {
-    m_camera.reset(bblength);
+	m_frameRenderer->setTargetSize(size() * devicePixelRatioF());
+	redraw();
 }
 
-void OpenGLRenderer::redraw(void)
+void OpenGLRenderer::paintGL()
 {
-	this->update();
+	m_frameRenderer->compose(defaultFramebufferObject(), size() * devicePixelRatioF());
 }
 
-void OpenGLRenderer::initializeGL() {
-	m_timer.start();
-	initializeOpenGLFunctions();
-	initializeShaders();
-	m_lastMousePos = QPoint(width() / 2.0f, height() / 2.0f);
+void OpenGLRenderer::updateCamera(float bblength) 
+{
+    m_camera.reset(bblength);
 }
 
-void OpenGLRenderer::transform(const std::shared_ptr<SceneObject>& obj)
+void OpenGLRenderer::redraw(void)
 {
-	m_projection.setToIdentity();
-	m_projection.perspective(m_camera.getZoom(), static_cast<float>(width() / height()), 0.1f, 10000.0f);
-	m_view.setToIdentity();
-	m_view = m_camera.getViewMatrix();
-	m_model.setToIdentity();
-	m_model.translate(obj->getTranslationVec());
-	m_model.rotate(obj->getRotationQuart());
+	publishSnapshot();
+	m_frameRenderer->requestFrame();
 }
 
-void OpenGLRenderer::setUniforms()
+void OpenGLRenderer::publishSnapshot()
 {
-	//vertex shader
-	m_shaderProgram->setUniformValue("viewMatrix", m_view);
-	m_shaderProgram->setUniformValue("projectionMatrix", m_projection);
-	m_shaderProgram->setUniformValue("modelMatrix", m_model);
-	//fragment shader
-	m_shaderProgram->setUniformValue("lightDirectionFront", QVector3D(0.0f, 0.0f, -1.0f));
-	m_shaderProgram->setUniformValue("lightDirectionBack", QVector3D(0.0f, 0.0f, 1.0f));
-	m_shaderProgram->setUniformValue("lightColor", QVector3D(1.0f, 1.0f, 1.0f));
-	//material
-	auto current_material = m_scene.getCurrentMaterial();
-	m_shaderProgram->setUniformValue("objectColor", current_material.objectColor);
-	m_shaderProgram->setUniformValue("ambientStrength", current_material.ambientStrength);
-	m_shaderProgram->setUniformValue("specularStrength", current_material.specularStrength);
-	m_shaderProgram->setUniformValue("shininess", current_material.shininess);
-}
+	//the slot is not read by the render thread until published, it still holds an older state
+	auto& snapshot = m_frameRenderer->snapshots().back();
+	m_scene.fillSnapshot(snapshot);
+	snapshot.view = m_camera.getViewMatrix();
+	snapshot.zoom = m_camera.getZoom();
+	snapshot.width = width();
+	snapshot.height = height();
+	snapshot.frameSize = QSize();
+	if (isReplaying()) {
+		//drawn at the recorded viewport whatever the size of the window, stretched into it when they differ
+		snapshot.frameSize = m_replay.size;
+		snapshot.width = m_replay.size.width();
+		snapshot.height = m_replay.size.height();
+	}
+	snapshot.wireframe = Mode::WIREFRAME == m_drawingMode;
+	snapshot.occlusionCulling = m_occlusionCulling;
+	snapshot.lastInputTime = m_lastInputTime;
+	snapshot.section = m_section;
+	snapshot.timedFrame = m_timedFrame;
+	m_frameRenderer->snapshots().publish();
 
-void OpenGLRenderer::calculateFPS() {
-	auto currentTime = std::chrono::high_resolution_clock::now();
-	std::chrono::duration<double> elapsedTime = currentTime - m_lastFrameTime;
-	m_lastFrameTime = currentTime;
-	double fps = 1.0 / elapsedTime.count();
-	emit framerateUpdated(QString::number(fps, 'f', 2));
+	const auto& current_obj = m_scene.getCurrentObjSelection();
+	if (m_section.axis >= 0 && nullptr != current_obj && current_obj->getID() != m_sectionObjId) {
+		//another object was selected, it is cut by the same plane
+		requestSection();
+	}
 }
 
-void OpenGLRenderer::paintGL()
+void OpenGLRenderer::registerInput()
 {
-	glEnable(GL_DEPTH_TEST);
-	glClearColor(0.85f, 0.85f, 0.85f, 1.0f);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-	const auto& current_obj = std::move(m_scene.getCurrentObjSelection());
-	if (nullptr != current_obj && Qt::CheckState::Checked == current_obj->isVisible()) {
-		m_shaderProgram->bind();
-		(m_drawingMode == Mode::SOLID) ? glPolygonMode(GL_FRONT_AND_BACK, GL_FILL) : glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-		glEnable(GL_MULTISAMPLE);
-		if (!current_obj->isBuffersInited()) {
-			current_obj->intializeBuffers(this);
-			current_obj->setTranslationVec(-current_obj->getObjectCenter()); //move obj to center coordinate system
-		}
-		transform(current_obj);
-		setUniforms();
-		current_obj->draw(this);
-		glDisable(GL_MULTISAMPLE);
-	}
-	m_scene.updateObjDetails(current_obj);
-	calculateFPS();
+	m_lastInputTime = m_frameRenderer->seconds();
+	m_restoreTimer.start();
 }
 
-void OpenGLRenderer::initializeShaders() 
+void OpenGLRenderer::updateStatus()
 {
-	m_shaderProgram = new QOpenGLShaderProgram(this);
-	if (!m_shaderProgram->addShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/main_vert.glsl")) {
-		qCritical() << "Critical: error while loading vertex shader.";
+	const double now = m_frameRenderer->seconds();
+	const int frames = m_frameRenderer->takeFrameCount();
+	//an idle view keeps the last rate instead of showing zero
+	if (frames > 0) {
+		emit framerateUpdated(QString::number(frames / (now - m_lastStatusTime), 'f', 2));
+	}
+	m_lastStatusTime = now;
+	const auto mouse_pos = QStringLiteral("x = %1, y = %2").arg(m_mousePos.x()).arg(m_mousePos.y());
+	if (mouse_pos != m_shownMousePos) {
+		m_shownMousePos = mouse_pos;
+		emit mouseMoved(mouse_pos);
 	}
-	if (!m_shaderProgram->addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/main_frag.glsl")) {
-		qCritical() << "Critical: error while loading fragment shader.";
+	const auto stats = m_frameRenderer->getOcclusionStats();
+	const auto occlusion = !m_occlusionCulling ? QStringLiteral("off") :
+		QStringLiteral("%1 visible, %2 occluded, %3 triangles saved").arg(stats.visible)
+			.arg(stats.occluded).arg(stats.savedTriangles);
+	if (occlusion != m_shownOcclusion) {
+		m_shownOcclusion = occlusion;
+		emit occlusionUpdated(occlusion);
 	}
+	updateSectionStatus();
+	m_scene.updateObjDetails(m_scene.getCurrentObjSelection());
 }
 
 void OpenGLRenderer::keyPressEvent(QKeyEvent* event) {
+	if (isReplaying()) {
+		//the replay owns the camera and the objects until it ends
+		if (Qt::Key_Escape == event->key()) {
+			stopReplay();
+		}
+		return;
+	}
 	switch (event->key()) {
 	case Qt::Key_W:
 		m_camera.processKeyboard(CameraMovement::FORWARD, 0);
@@ -160,7 +177,30 @@ void OpenGLRenderer::keyPressEvent(QKeyEvent* event) {
 		m_drawingMode = (m_drawingMode == Mode::SOLID) ? Mode::WIREFRAME : Mode::SOLID;
 		emit drawingModeChanged(m_drawingMode == Mode::SOLID ? "solid" : "wireframe");
 		break;
+	case Qt::Key_O:
+		m_occlusionCulling = !m_occlusionCulling;
+		break;
+	case Qt::Key_X:
+		//off, x, y, z
+		m_section.axis = (m_section.axis + 2) % 4 - 1;
+		requestSection();
+		break;
+	case Qt::Key_V:
+		m_section.flipped = !m_section.flipped;
+		requestSection();
+		break;
+	case Qt::Key_PageUp:
+		moveSection(SECTION_STEP);
+		break;
+	case Qt::Key_PageDown:
+		moveSection(-SECTION_STEP);
+		break;
+	}
+	if (event->key() != Qt::Key_C && event->key() != Qt::Key_R && event->key() != Qt::Key_O &&
+		event->key() != Qt::Key_X && event->key() != Qt::Key_V) {
+		registerInput();
 	}
+	recordInput();
 	redraw();
 }
 
@@ -186,14 +226,23 @@ void OpenGLRenderer::mouseReleaseEvent(QMouseEvent* event)
 
 void OpenGLRenderer::mouseMoveEvent(QMouseEvent* event)
 {
-	emit mouseMoved(QStringLiteral("x = %1, y = %2").arg(event->pos().x()).arg(event->pos().y()));
+	//shown by the status timer, a move without buttons only changes the label
+	m_mousePos = event->pos();
+	if (Qt::NoButton == event->buttons() || isReplaying()) {
+		m_lastMousePos = event->globalPos();
+		return;
+	}
+	registerInput();
 	auto delta_pos = event->globalPos() - m_lastMousePos;
 	QVector3D delta_vec = {
 		static_cast<float>(delta_pos.x()),
 		static_cast<float>(delta_pos.y()),
 		0.0f
 	};
-	if (event->buttons() == (Qt::LeftButton | Qt::RightButton)) {
+	if ((event->modifiers() & Qt::ControlModifier) && (event->buttons() & Qt::LeftButton) && m_section.axis >= 0) {
+		moveSection(-delta_vec.y() * SECTION_DRAG_SPEED);
+	}
+	else if (event->buttons() == (Qt::LeftButton | Qt::RightButton)) {
 		processTranslation(delta_vec);
 	}
 	else if (event->buttons() & Qt::RightButton) {
@@ -203,12 +252,18 @@ void OpenGLRenderer::mouseMoveEvent(QMouseEvent* event)
 		processRotation(delta_vec);
 	}
 	m_lastMousePos = event->globalPos();
+	recordInput();
 	redraw();
 }
 
 void OpenGLRenderer::wheelEvent(QWheelEvent* event) {
+	if (isReplaying()) {
+		return;
+	}
 	int delta = event->delta();
 	m_camera.processMouseScroll(delta);
+	registerInput();
+	recordInput();
 	redraw();
 }
 
@@ -216,8 +271,11 @@ void OpenGLRenderer::reset()
 {
 	const auto& current_obj = std::move(m_scene.getCurrentObjSelection());
 	if (nullptr != current_obj) {
+		//the center and the size change with a reload swapped in by the render thread
+		const auto lock = current_obj->lockGeometry();
 		current_obj->reset();
         updateCamera(current_obj->getBoundingBoxLength());
+		emit objectMoved(current_obj->getID());
 	}
 }
 
@@ -227,6 +285,7 @@ void OpenGLRenderer::processTranslation(QVector3D& delta)
 	const auto& current_obj = std::move(m_scene.getCurrentObjSelection());
 	if (nullptr != current_obj) {
 		current_obj->setTranslationVec(current_obj->getTranslationVec() + delta * m_scene.TRANSLATION_SPEED);
+		emit objectMoved(current_obj->getID());
 	}
 }
 
@@ -238,5 +297,225 @@ void OpenGLRenderer::processRotation(QVector3D& delta)
 	const auto& current_obj = std::move(m_scene.getCurrentObjSelection());
 	if (nullptr != current_obj) {
 		current_obj->setRotationQuart(current_obj->getRotationQuart() * rotation);
+		emit objectMoved(current_obj->getID());
 	}
-}
\ No newline at end of file
+}
+
+void OpenGLRenderer::moveSection(float delta)
+{
+	if (m_section.axis < 0) {
+		return;
+	}
+	m_section.position = qBound(0.0f, m_section.position + delta, 1.0f);
+	requestSection();
+}
+
+void OpenGLRenderer::requestSection()
+{
+	//the running cut is of no use anymore, the frames hide its result once the plane moved
+	m_sectionToken.cancel();
+	++m_sectionGeneration;
+	const auto& current_obj = m_scene.getCurrentObjSelection();
+	m_sectionObjId = nullptr != current_obj ? current_obj->getID() : 0;
+	if (m_section.axis >= 0) {
+		m_sectionTimer.start();
+	}
+	else {
+		m_sectionTimer.stop();
+		m_section.cut.reset();
+	}
+	updateSectionStatus();
+}
+
+void OpenGLRenderer::computeSection()
+{
+	const auto obj = m_scene.getCurrentObjSelection();
+	if (nullptr == obj || m_section.axis < 0) {
+		return;
+	}
+	m_sectionJobs.erase(std::remove_if(m_sectionJobs.begin(), m_sectionJobs.end(),
+		[](const JobSystem::JobHandle& job) { return job->isFinished(); }), m_sectionJobs.end());
+	m_sectionToken = JobSystem::CancellationToken();
+	const auto axis = m_section.axis;
+	const auto position = m_section.position;
+	const auto flipped = m_section.flipped;
+	const auto generation = m_sectionGeneration;
+	m_sectionJobs.push_back(JobSystem::instance().submit([this, obj, axis, position, flipped, generation]() {
+		MemoryTracker::LoadScope scope;
+		MappedArray<Vertex> soup;
+		QVector3D normal;
+		float offset = 0.0f;
+		unsigned int version = 0;
+		{
+			//copied under the lock, the slicing runs parallel jobs and must not hold up a swap or the GUI
+			const auto lock = obj->lockGeometry();
+			version = obj->getGeometryVersion();
+			if (!obj->isPointCloud() && !soup.copyFrom(obj->vertices)) {
+				return;
+			}
+			SECTION_API::axisPlane(obj->getMinBounds(), obj->getMaxBounds(), axis, position, flipped, normal, offset);
+		}
+		std::shared_ptr<CrossSection> cut;
+		if (!soup.isEmpty()) {
+			MemoryTracker::LoadScope::add(soup.sizeInBytes());
+			cut = std::make_shared<CrossSection>();
+			if (!SECTION_API::sliceTriangleSoup(soup, normal, offset, *cut) || !CGAL_API::triangulateSectionCap(*cut)) {
+				return;
+			}
+		}
+		QMetaObject::invokeMethod(this, [this, obj, cut, version, generation]() {
+			handleSectionFinished(obj->getID(), cut, version, generation);
+		}, Qt::QueuedConnection);
+	}, JobSystem::Priority::BACKGROUND, {}, m_sectionToken));
+	updateSectionStatus();
+}
+
+void OpenGLRenderer::handleSectionFinished(unsigned int objId, const std::shared_ptr<const CrossSection>& cut,
+	unsigned int version, std::uint64_t generation)
+{
+	if (generation != m_sectionGeneration) {
+		return;
+	}
+	m_section.cut = cut;
+	m_section.cutObjId = objId;
+	m_section.cutVersion = version;
+	updateSectionStatus();
+	redraw();
+}
+
+void OpenGLRenderer::handleGeometrySwapped(unsigned int objId)
+{
+	//the cut of the old geometry is hidden by the frames, the reload gets its own
+	if (m_section.axis >= 0 && objId == m_sectionObjId) {
+		requestSection();
+	}
+}
+
+void OpenGLRenderer::updateSectionStatus()
+{
+	QString text = QStringLiteral("off");
+	if (m_section.axis >= 0) {
+		text = QStringLiteral("%1%2 at %3%").arg(m_section.flipped ? QStringLiteral("-") : QString()).arg(QChar('x' + m_section.axis))
+			.arg(qRound(m_section.position * 100.0f));
+		const bool cutting = m_sectionTimer.isActive() || (!m_sectionJobs.empty() && !m_sectionJobs.back()->isFinished());
+		if (cutting) {
+			text += QStringLiteral(", cutting");
+		}
+		else if (nullptr != m_section.cut && m_section.cutObjId == m_sectionObjId) {
+			text += QStringLiteral(", %1 contours").arg(m_section.cut->contours.size());
+		}
+	}
+	if (text != m_shownSection) {
+		m_shownSection = text;
+		emit sectionUpdated(text);
+	}
+}
+
+void OpenGLRenderer::startRecording(const QVector<std::shared_ptr<SceneObject>>& objects)
+{
+	m_recording = std::make_unique<SessionRecording>();
+	m_recordedObjects = objects;
+	const QSize size = this->size() * devicePixelRatioF();
+	m_recording->width = size.width();
+	m_recording->height = size.height();
+	m_recording->wireframe = Mode::WIREFRAME == m_drawingMode;
+	m_recording->occlusionCulling = m_occlusionCulling;
+	m_recordingStart = m_frameRenderer->seconds();
+	//the replay starts from the view the recording started in
+	recordInput();
+}
+
+std::unique_ptr<SessionRecording> OpenGLRenderer::stopRecording()
+{
+	m_recordedObjects.clear();
+	return std::move(m_recording);
+}
+
+void OpenGLRenderer::recordInput()
+{
+	if (nullptr == m_recording) {
+		return;
+	}
+	SessionRecording::Frame frame;
+	frame.time = m_frameRenderer->seconds() - m_recordingStart;
+	frame.camera = m_camera.getState();
+	const auto& current_obj = m_scene.getCurrentObjSelection();
+	//objects loaded later are not in the workspace, the replay keeps the previous selection then
+	frame.object = m_recordedObjects.indexOf(current_obj);
+	if (frame.object >= 0) {
+		frame.translation = current_obj->getTranslationVec();
+		frame.rotation = current_obj->getRotationQuart();
+	}
+	m_recording->frames.push_back(frame);
+}
+
+bool OpenGLRenderer::startReplay(const SessionRecording& recording, const std::vector<SessionRecording::Frame>& frames,
+	const QVector<std::shared_ptr<SceneObject>>& objects)
+{
+	if (frames.empty() || isReplaying() || isRecording()) {
+		return false;
+	}
+	m_replay = Replay();
+	m_replay.frames = frames;
+	m_replay.objects = objects;
+	m_replay.size = QSize(recording.width, recording.height);
+	m_replay.timings.renderer = FrameTimings::VIEWER_RENDERER;
+	m_replay.timings.width = recording.width;
+	m_replay.timings.height = recording.height;
+	m_replay.timings.frames.reserve(frames.size());
+	//drawn the way they were recorded
+	m_drawingMode = recording.wireframe ? Mode::WIREFRAME : Mode::SOLID;
+	emit drawingModeChanged(m_drawingMode == Mode::SOLID ? "solid" : "wireframe");
+	m_occlusionCulling = recording.occlusionCulling;
+	m_restoreTimer.stop();
+	replayNextFrame();
+	return true;
+}
+
+void OpenGLRenderer::stopReplay()
+{
+	if (!isReplaying()) {
+		return;
+	}
+	m_replay = Replay();
+	m_timedFrame = 0;
+	redraw();
+	emit replayFinished(FrameTimings());
+}
+
+void OpenGLRenderer::replayNextFrame()
+{
+	if (m_replay.next >= m_replay.frames.size()) {
+		const auto timings = std::move(m_replay.timings);
+		m_replay = Replay();
+		m_timedFrame = 0;
+		redraw();
+		emit replayFinished(timings);
+		return;
+	}
+	const auto& frame = m_replay.frames[m_replay.next];
+	if (frame.object >= 0 && frame.object < m_replay.objects.size()) {
+		const auto& obj = m_replay.objects[frame.object];
+		if (obj != m_scene.getCurrentObjSelection()) {
+			//selecting resets the camera, which is set below
+			emit selectionWanted(obj->getID());
+		}
+		obj->setTranslationVec(frame.translation);
+		obj->setRotationQuart(frame.rotation);
+		emit objectMoved(obj->getID());
+	}
+	m_camera.setState(frame.camera);
+	m_timedFrame = ++m_lastTimedFrame;
+	redraw();
+}
+
+void OpenGLRenderer::handleFrameTimed(quint64 timedFrame, double milliseconds)
+{
+	//a frame of a stopped replay may still be reported
+	if (!isReplaying() || timedFrame != m_timedFrame) {
+		return;
+	}
+	m_replay.timings.frames.push_back(milliseconds);
+	++m_replay.next;
+	replayNextFrame();
+}
@@ -0,0 +1,219 @@
+#include <QtMath>
+
+#include <queue>
+
+#include "PointCloudStreamer.h"
+#include "JobSystem.h"
+
+namespace {
+	constexpr std::uint64_t PAGE_SIZE = 4096;
+}
+
+PointCloudStreamer::PointCloudStreamer(const std::shared_ptr<SceneObject>& obj) :
+	m_object(obj),
+	m_cloud(obj->pointCloud),
+	m_geometryVersion(obj->getGeometryVersion()),
+	m_residency(std::make_shared<Residency>(obj->pointCloud->nodes.size())),
+	m_nodeSlot(obj->pointCloud->nodes.size(), -1)
+{
+	//points on the heap are resident already, only mapped ones are paged in first
+	if (!m_cloud->points.isOutOfCore()) {
+		for (auto& state : m_residency->states) {
+			state.store(LOADED);
+		}
+	}
+}
+
+void PointCloudStreamer::initialize(QOpenGLShaderProgram* program)
+{
+	//small clouds get a pool of their own size
+	const int slots = std::min<int>(POOL_SLOTS, static_cast<int>(m_cloud->nodes.size()));
+	m_slotNode.assign(slots, -1);
+	m_slotFrame.assign(slots, 0);
+	const auto bytes = static_cast<std::uint64_t>(slots) * POINTCLOUD_API::NODE_POINTS * sizeof(PointVertex);
+	m_vbo.create();
+	m_vbo.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+	m_vbo.bind();
+	m_vbo.allocate(static_cast<int>(bytes));
+	m_vao.create();
+	m_vao.bind();
+	program->bind();
+	//m_position
+	program->enableAttributeArray(0);
+	program->setAttributeBuffer(0, GL_FLOAT, 0, 3, sizeof(PointVertex));
+	//color, normalized bytes
+	program->enableAttributeArray(1);
+	program->setAttributeBuffer(1, GL_UNSIGNED_BYTE, sizeof(QVector3D), 4, sizeof(PointVertex));
+	m_vao.release();
+	m_vbo.release();
+	MemoryTracker::setObjectBytes(m_object->getID(), QString(), MemoryTracker::Category::GPU_BUFFERS, bytes);
+}
+
+void PointCloudStreamer::destroy()
+{
+	m_vao.destroy();
+	m_vbo.destroy();
+	m_slotNode.clear();
+	m_slotFrame.clear();
+	std::fill(m_nodeSlot.begin(), m_nodeSlot.end(), -1);
+	MemoryTracker::setObjectBytes(m_object->getID(), QString(), MemoryTracker::Category::GPU_BUFFERS, 0);
+}
+
+bool PointCloudStreamer::update(const View& view)
+{
+	++m_frame;
+	m_drawFirst.clear();
+	m_drawCount.clear();
+	m_drawnPoints = 0;
+	if (m_cloud->nodes.empty() || m_slotNode.empty()) {
+		return false;
+	}
+	//clip planes of the object space frustum
+	const auto& mvp = view.modelViewProjection;
+	for (int i = 0; i < 3; ++i) {
+		m_frustum[i * 2] = mvp.row(3) + mvp.row(i);
+		m_frustum[i * 2 + 1] = mvp.row(3) - mvp.row(i);
+	}
+
+	using Candidate = std::pair<float, int>;
+	std::priority_queue<Candidate> candidates;
+	std::vector<int> missing;
+	if (isVisible(m_cloud->nodes[0])) {
+		candidates.push({ projectedSize(m_cloud->nodes[0], view), 0 });
+	}
+	while (!candidates.empty()) {
+		const auto candidate = candidates.top();
+		candidates.pop();
+		const auto& node = m_cloud->nodes[candidate.second];
+		const auto count = node.count;
+		if (m_drawnPoints + count > POINT_BUDGET) {
+			continue;
+		}
+		const int slot = m_nodeSlot[candidate.second];
+		if (slot < 0) {
+			//the children wait for their parent, holes are never shown in its place
+			missing.push_back(candidate.second);
+			continue;
+		}
+		m_slotFrame[slot] = m_frame;
+		m_drawFirst.push_back(static_cast<GLint>(slot * POINTCLOUD_API::NODE_POINTS));
+		m_drawCount.push_back(static_cast<GLsizei>(count));
+		m_drawnPoints += count;
+		//surface samples, the spacing falls with the square root of the count
+		const float spacing = candidate.first / std::sqrt(static_cast<float>(std::max(1u, node.count)));
+		if (spacing <= TARGET_SPACING) {
+			continue;
+		}
+		for (const auto child : node.children) {
+			if (child >= 0 && isVisible(m_cloud->nodes[child])) {
+				candidates.push({ projectedSize(m_cloud->nodes[child], view), child });
+			}
+		}
+	}
+
+	//missing nodes are in the order of their screen size
+	int uploads = 0;
+	for (const auto node : missing) {
+		const int state = m_residency->states[node].load();
+		if (LOADED == state && uploads < MAX_UPLOADS_PER_FRAME) {
+			const int slot = acquireSlot();
+			if (slot < 0) {
+				break;
+			}
+			upload(node, slot);
+			++uploads;
+		}
+		else if (NOT_LOADED == state && m_residency->inFlight.load() < MAX_PREFETCHES) {
+			prefetch(node);
+		}
+	}
+	return !missing.empty();
+}
+
+void PointCloudStreamer::draw(QOpenGLFunctions_3_3_Core* functions)
+{
+	if (m_drawFirst.empty()) {
+		return;
+	}
+	m_vao.bind();
+	functions->glMultiDrawArrays(GL_POINTS, m_drawFirst.data(), m_drawCount.data(), static_cast<GLsizei>(m_drawFirst.size()));
+	m_vao.release();
+}
+
+bool PointCloudStreamer::isVisible(const OctreeNode& node) const
+{
+	//bounding sphere of the cube against every plane
+	const float radius = node.halfSize * 1.7320508f;
+	for (const auto& plane : m_frustum) {
+		const float distance = plane.x() * node.center.x() + plane.y() * node.center.y() + plane.z() * node.center.z() + plane.w();
+		if (distance < -radius * plane.toVector3D().length()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+float PointCloudStreamer::projectedSize(const OctreeNode& node, const View& view) const
+{
+	const float depth = -view.modelView.map(node.center).z();
+	//nodes around the camera are the biggest ones
+	const float distance = std::max(depth, node.halfSize * 0.01f);
+	return 2.0f * node.halfSize * view.pixelsPerUnit / distance;
+}
+
+void PointCloudStreamer::prefetch(int node)
+{
+	m_residency->states[node].store(LOADING);
+	++m_residency->inFlight;
+	const auto residency = m_residency;
+	//the cloud is held by the job, a reload may replace the one of the object meanwhile
+	const auto cloud = m_cloud;
+	JobSystem::instance().submit([residency, cloud, node]() {
+		const auto& cloud_node = cloud->nodes[node];
+		const auto count = cloud_node.count;
+		const auto bytes = reinterpret_cast<const unsigned char*>(cloud->points.data() + cloud_node.first);
+		volatile unsigned char sink = 0;
+		for (std::uint64_t offset = 0; offset < count * sizeof(PointVertex); offset += PAGE_SIZE) {
+			sink = sink + bytes[offset];
+		}
+		residency->states[node].store(LOADED);
+		--residency->inFlight;
+	}, JobSystem::Priority::LOAD);
+}
+
+int PointCloudStreamer::acquireSlot()
+{
+	int oldest = -1;
+	for (int slot = 0; slot < static_cast<int>(m_slotNode.size()); ++slot) {
+		if (m_slotNode[slot] < 0) {
+			return slot;
+		}
+		//slots drawn in this frame stay
+		if (m_slotFrame[slot] < m_frame && (oldest < 0 || m_slotFrame[slot] < m_slotFrame[oldest])) {
+			oldest = slot;
+		}
+	}
+	if (oldest >= 0) {
+		const int evicted = m_slotNode[oldest];
+		m_nodeSlot[evicted] = -1;
+		m_slotNode[oldest] = -1;
+		if (m_cloud->points.isOutOfCore()) {
+			m_residency->states[evicted].store(NOT_LOADED);
+		}
+	}
+	return oldest;
+}
+
+void PointCloudStreamer::upload(int node, int slot)
+{
+	const auto& cloud_node = m_cloud->nodes[node];
+	//every node fits a slot, dense cubes are chained by the octree
+	const auto count = cloud_node.count;
+	m_vbo.bind();
+	m_vbo.write(static_cast<int>(static_cast<std::uint64_t>(slot) * POINTCLOUD_API::NODE_POINTS * sizeof(PointVertex)),
+		m_cloud->points.data() + cloud_node.first, static_cast<int>(count * sizeof(PointVertex)));
+	m_vbo.release();
+	m_nodeSlot[node] = slot;
+	m_slotNode[slot] = node;
+	m_slotFrame[slot] = m_frame;
+}
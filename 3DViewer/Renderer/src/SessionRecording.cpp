@@ -0,0 +1,358 @@
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "SessionRecording.h"
+
+namespace {
+	QJsonArray toJson(const QVector3D& vec)
+	{
+		return { vec.x(), vec.y(), vec.z() };
+	}
+
+	QVector3D vec3FromJson(const QJsonValue& value)
+	{
+		const auto array = value.toArray();
+		return QVector3D(array[0].toDouble(), array[1].toDouble(), array[2].toDouble());
+	}
+
+	bool writeJson(const QString& path, const QJsonObject& object)
+	{
+		QSaveFile file(path);
+		if (!file.open(QIODevice::WriteOnly) || file.write(QJsonDocument(object).toJson()) < 0 || !file.commit()) {
+			qCritical() << "Critical: cannot write " << path;
+			return false;
+		}
+		return true;
+	}
+
+	bool readJson(const QString& path, QJsonObject& object)
+	{
+		QFile file(path);
+		if (!file.open(QIODevice::ReadOnly)) {
+			qCritical() << "Critical: cannot open " << path;
+			return false;
+		}
+		QJsonParseError error;
+		object = QJsonDocument::fromJson(file.readAll(), &error).object();
+		if (QJsonParseError::NoError != error.error) {
+			qCritical() << "Critical: cannot parse " << path << " " << error.errorString();
+			return false;
+		}
+		return true;
+	}
+
+	//linear between the closest ranks
+	double quantile(const std::vector<double>& sorted, double q)
+	{
+		const double position = q * (sorted.size() - 1);
+		const auto lower = static_cast<std::size_t>(position);
+		const auto upper = std::min(lower + 1, sorted.size() - 1);
+		return sorted[lower] + (sorted[upper] - sorted[lower]) * (position - lower);
+	}
+
+	//ranks from one, tied values share the mean of their ranks, returns the tie correction sum of t^3 - t
+	double rankValues(const std::vector<double>& values, std::vector<double>& ranks)
+	{
+		std::vector<std::size_t> order(values.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&values](std::size_t a, std::size_t b) { return values[a] < values[b]; });
+		ranks.resize(values.size());
+		double ties = 0.0;
+		for (std::size_t i = 0; i < order.size();) {
+			auto j = i + 1;
+			while (j < order.size() && values[order[j]] == values[order[i]]) {
+				++j;
+			}
+			const double rank = (i + j + 1) * 0.5;
+			for (auto k = i; k < j; ++k) {
+				ranks[order[k]] = rank;
+			}
+			const double count = static_cast<double>(j - i);
+			ties += count * count * count - count;
+			i = j;
+		}
+		return ties;
+	}
+
+	double twoSidedPValue(double z)
+	{
+		return std::erfc(std::abs(z) / std::sqrt(2.0));
+	}
+
+	//Wilcoxon signed rank test of the candidate minus the baseline per frame
+	double signedRankZ(const std::vector<double>& baseline, const std::vector<double>& candidate)
+	{
+		std::vector<double> differences;
+		std::vector<double> magnitudes;
+		for (std::size_t i = 0; i < baseline.size(); ++i) {
+			const double difference = candidate[i] - baseline[i];
+			//equal frames carry no sign
+			if (0.0 != difference) {
+				differences.push_back(difference);
+				magnitudes.push_back(std::abs(difference));
+			}
+		}
+		if (differences.empty()) {
+			return 0.0;
+		}
+		std::vector<double> ranks;
+		const double ties = rankValues(magnitudes, ranks);
+		double positive = 0.0;
+		for (std::size_t i = 0; i < differences.size(); ++i) {
+			positive += differences[i] > 0.0 ? ranks[i] : 0.0;
+		}
+		const double n = static_cast<double>(differences.size());
+		const double mean = n * (n + 1.0) / 4.0;
+		const double variance = n * (n + 1.0) * (2.0 * n + 1.0) / 24.0 - ties / 48.0;
+		return variance > 0.0 ? (positive - mean) / std::sqrt(variance) : 0.0;
+	}
+
+	//Mann-Whitney rank sum test of the two samples
+	double rankSumZ(const std::vector<double>& baseline, const std::vector<double>& candidate)
+	{
+		std::vector<double> values(baseline);
+		values.insert(values.end(), candidate.begin(), candidate.end());
+		std::vector<double> ranks;
+		const double ties = rankValues(values, ranks);
+		const double n1 = static_cast<double>(baseline.size());
+		const double n2 = static_cast<double>(candidate.size());
+		const double n = n1 + n2;
+		const double rank_sum = std::accumulate(ranks.begin() + baseline.size(), ranks.end(), 0.0);
+		const double u = rank_sum - n2 * (n2 + 1.0) / 2.0;
+		const double mean = n1 * n2 / 2.0;
+		const double variance = n1 * n2 / 12.0 * ((n + 1.0) - ties / (n * (n - 1.0)));
+		return variance > 0.0 ? (u - mean) / std::sqrt(variance) : 0.0;
+	}
+
+	double relativeChange(double baseline, double candidate)
+	{
+		return baseline > 0.0 ? candidate / baseline - 1.0 : 0.0;
+	}
+}
+
+bool RECORDING_API::writeRecording(const QString& path, const SessionRecording& recording)
+{
+	QJsonArray frames;
+	for (const auto& frame : recording.frames) {
+		const auto& rotation = frame.rotation;
+		frames.append(QJsonObject{
+			{ "time",        frame.time },
+			{ "camera",      QJsonObject{
+				{ "position", toJson(frame.camera.position) },
+				{ "yaw",      frame.camera.yaw },
+				{ "pitch",    frame.camera.pitch },
+				{ "zoom",     frame.camera.zoom } } },
+			{ "object",      frame.object },
+			{ "translation", toJson(frame.translation) },
+			{ "rotation",    QJsonArray{ rotation.scalar(), rotation.x(), rotation.y(), rotation.z() } }
+		});
+	}
+	return writeJson(path, QJsonObject{
+		{ "version",          SessionRecording::VERSION },
+		{ "workspace",        recording.workspace },
+		{ "width",            recording.width },
+		{ "height",           recording.height },
+		{ "wireframe",        recording.wireframe },
+		{ "occlusionCulling", recording.occlusionCulling },
+		{ "frames",           frames }
+	});
+}
+
+std::unique_ptr<SessionRecording> RECORDING_API::readRecording(const QString& path)
+{
+	QJsonObject table;
+	if (!readJson(path, table)) {
+		return nullptr;
+	}
+	if (SessionRecording::VERSION != table["version"].toInt()) {
+		qCritical() << "Critical: " << path << " is not a compatible session recording.";
+		return nullptr;
+	}
+	auto recording = std::make_unique<SessionRecording>();
+	recording->workspace = table["workspace"].toString();
+	recording->width = std::max(1, table["width"].toInt());
+	recording->height = std::max(1, table["height"].toInt());
+	recording->wireframe = table["wireframe"].toBool();
+	recording->occlusionCulling = table["occlusionCulling"].toBool(true);
+	for (const auto& value : table["frames"].toArray()) {
+		const auto object = value.toObject();
+		const auto camera = object["camera"].toObject();
+		const auto rotation = object["rotation"].toArray();
+		SessionRecording::Frame frame;
+		frame.time = object["time"].toDouble();
+		frame.camera.position = vec3FromJson(camera["position"]);
+		frame.camera.yaw = static_cast<float>(camera["yaw"].toDouble(-90.0));
+		frame.camera.pitch = static_cast<float>(camera["pitch"].toDouble());
+		frame.camera.zoom = static_cast<float>(camera["zoom"].toDouble(45.0));
+		frame.object = object["object"].toInt(-1);
+		frame.translation = vec3FromJson(object["translation"]);
+		frame.rotation = QQuaternion(rotation[0].toDouble(1.0), rotation[1].toDouble(), rotation[2].toDouble(), rotation[3].toDouble());
+		recording->frames.push_back(frame);
+	}
+	if (recording->frames.empty()) {
+		qCritical() << "Critical: session recording " << path << " has no frames.";
+		return nullptr;
+	}
+	return recording;
+}
+
+QString RECORDING_API::workspacePath(const QString& recordingPath, const SessionRecording& recording)
+{
+	return QFileInfo(recordingPath).dir().absoluteFilePath(recording.workspace);
+}
+
+std::vector<SessionRecording::Frame> RECORDING_API::resample(const std::vector<SessionRecording::Frame>& frames, int frameCount)
+{
+	if (frameCount < 1 || frames.empty()) {
+		return frames;
+	}
+	//a recording of a single instant is spread by its samples instead of their times
+	const bool timed = frames.back().time > frames.front().time;
+	const auto position = [&frames, timed](std::size_t i) {
+		return timed ? frames[i].time : static_cast<double>(i);
+	};
+	const double first = position(0);
+	const double last = position(frames.size() - 1);
+	std::vector<SessionRecording::Frame> resampled;
+	resampled.reserve(static_cast<std::size_t>(frameCount));
+	std::size_t segment = 0;
+	for (int i = 0; i < frameCount; ++i) {
+		const double at = frameCount > 1 ? first + (last - first) * i / (frameCount - 1) : first;
+		while (segment + 2 < frames.size() && position(segment + 1) < at) {
+			++segment;
+		}
+		const auto& from = frames[segment];
+		const auto& to = frames[std::min(segment + 1, frames.size() - 1)];
+		const double span = position(std::min(segment + 1, frames.size() - 1)) - position(segment);
+		const float t = span > 0.0 ? static_cast<float>(qBound(0.0, (at - position(segment)) / span, 1.0)) : 0.0f;
+		//another selection is taken over at the sample it happened
+		SessionRecording::Frame frame = t < 1.0f ? from : to;
+		frame.time = from.time + (to.time - from.time) * t;
+		frame.camera.position = from.camera.position + (to.camera.position - from.camera.position) * t;
+		frame.camera.yaw = from.camera.yaw + (to.camera.yaw - from.camera.yaw) * t;
+		frame.camera.pitch = from.camera.pitch + (to.camera.pitch - from.camera.pitch) * t;
+		frame.camera.zoom = from.camera.zoom + (to.camera.zoom - from.camera.zoom) * t;
+		if (from.object == to.object) {
+			frame.translation = from.translation + (to.translation - from.translation) * t;
+			frame.rotation = QQuaternion::slerp(from.rotation, to.rotation, t);
+		}
+		resampled.push_back(frame);
+	}
+	return resampled;
+}
+
+bool RECORDING_API::writeTimings(const QString& path, const FrameTimings& timings)
+{
+	QJsonArray frames;
+	for (const auto duration : timings.frames) {
+		frames.append(duration);
+	}
+	const auto summary = summarize(timings.frames);
+	return writeJson(path, QJsonObject{
+		{ "version",   SessionRecording::VERSION },
+		{ "recording", timings.recording },
+		{ "renderer",  timings.renderer },
+		{ "width",     timings.width },
+		{ "height",    timings.height },
+		{ "frames",    frames },
+		//for reading by eye, the comparison works on the frames
+		{ "summary",   QJsonObject{
+			{ "count",  static_cast<qint64>(summary.count) },
+			{ "mean",   summary.mean },
+			{ "stddev", summary.stddev },
+			{ "min",    summary.min },
+			{ "median", summary.median },
+			{ "p95",    summary.p95 },
+			{ "p99",    summary.p99 },
+			{ "max",    summary.max } } }
+	});
+}
+
+std::unique_ptr<FrameTimings> RECORDING_API::readTimings(const QString& path)
+{
+	QJsonObject table;
+	if (!readJson(path, table)) {
+		return nullptr;
+	}
+	auto timings = std::make_unique<FrameTimings>();
+	timings->recording = table["recording"].toString();
+	timings->renderer = table["renderer"].toString();
+	timings->width = table["width"].toInt();
+	timings->height = table["height"].toInt();
+	for (const auto& value : table["frames"].toArray()) {
+		timings->frames.push_back(value.toDouble());
+	}
+	if (timings->frames.empty()) {
+		qCritical() << "Critical: frame timings " << path << " have no frames.";
+		return nullptr;
+	}
+	return timings;
+}
+
+RECORDING_API::Summary RECORDING_API::summarize(const std::vector<double>& values)
+{
+	Summary summary;
+	summary.count = values.size();
+	if (values.empty()) {
+		return summary;
+	}
+	std::vector<double> sorted(values);
+	std::sort(sorted.begin(), sorted.end());
+	summary.mean = std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+	double squares = 0.0;
+	for (const auto value : sorted) {
+		squares += (value - summary.mean) * (value - summary.mean);
+	}
+	summary.stddev = sorted.size() > 1 ? std::sqrt(squares / (sorted.size() - 1)) : 0.0;
+	summary.min = sorted.front();
+	summary.median = quantile(sorted, 0.5);
+	summary.p95 = quantile(sorted, 0.95);
+	summary.p99 = quantile(sorted, 0.99);
+	summary.max = sorted.back();
+	return summary;
+}
+
+bool RECORDING_API::isComparable(const FrameTimings& baseline, const FrameTimings& candidate, QString& reason)
+{
+	if (baseline.recording != candidate.recording) {
+		reason = QStringLiteral("the timings come from the sessions %1 and %2").arg(baseline.recording, candidate.recording);
+	}
+	else if (baseline.renderer != candidate.renderer) {
+		reason = QStringLiteral("the timings come from the %1 and the %2 renderer").arg(baseline.renderer, candidate.renderer);
+	}
+	else if (baseline.width != candidate.width || baseline.height != candidate.height) {
+		reason = QStringLiteral("the timings were drawn at %1x%2 and %3x%4")
+			.arg(baseline.width).arg(baseline.height).arg(candidate.width).arg(candidate.height);
+	}
+	else {
+		reason.clear();
+	}
+	return reason.isEmpty();
+}
+
+RECORDING_API::Comparison RECORDING_API::compare(const std::vector<double>& baseline, const std::vector<double>& candidate)
+{
+	Comparison comparison;
+	comparison.baseline = summarize(baseline);
+	comparison.candidate = summarize(candidate);
+	comparison.medianChange = relativeChange(comparison.baseline.median, comparison.candidate.median);
+	comparison.meanChange = relativeChange(comparison.baseline.mean, comparison.candidate.mean);
+	if (baseline.empty() || candidate.empty()) {
+		return comparison;
+	}
+	//frame times are skewed by the occasional long frame, so ranks rather than means are compared
+	comparison.paired = baseline.size() == candidate.size();
+	comparison.z = comparison.paired ? signedRankZ(baseline, candidate) : rankSumZ(baseline, candidate);
+	comparison.pValue = twoSidedPValue(comparison.z);
+	return comparison;
+}
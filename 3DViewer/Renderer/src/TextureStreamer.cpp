@@ -0,0 +1,122 @@
+#include <QDebug>
+
+#include <algorithm>
+
+#include "TextureStreamer.h"
+#include "GpuUploader.h"
+#include "TextureCache.h"
+
+TextureStreamer::TextureStreamer(GpuUploader* uploader) :
+	m_uploader(uploader)
+{
+}
+
+GLuint TextureStreamer::acquire(const QString& path)
+{
+	auto& texture = m_textures[path];
+	if (nullptr == texture) {
+		texture = std::make_shared<StreamedTexture>();
+		m_jobs.erase(std::remove_if(m_jobs.begin(), m_jobs.end(),
+			[](const JobSystem::JobHandle& job) { return job->isFinished(); }), m_jobs.end());
+		//the streamer waits for its jobs before the uploader is destroyed
+		auto uploader = m_uploader;
+		m_jobs.push_back(JobSystem::instance().submit([texture, path, uploader]() {
+			std::shared_ptr<MipChain> chain = TEXTURE_API::loadTexture(path);
+			if (nullptr == chain || JobSystem::cancellationRequested()) {
+				texture->state.store(StreamedTexture::State::FAILED);
+				return;
+			}
+			texture->state.store(StreamedTexture::State::UPLOADING);
+			uploader->enqueueTexture(texture, chain);
+		}, JobSystem::Priority::BACKGROUND, {}, m_token));
+		return 0;
+	}
+	return (texture->baseLevel >= 0) ? texture->id.load() : 0;
+}
+
+bool TextureStreamer::drainFences(QOpenGLFunctions_3_3_Core* functions)
+{
+	//every texture, a hidden or culled object keeps its levels coming in as well
+	bool pending = false;
+	for (const auto& texture : m_textures) {
+		std::vector<std::pair<int, GLsync>> fenced;
+		{
+			std::lock_guard<std::mutex> lock(texture->mutex);
+			fenced.swap(texture->fencedLevels);
+		}
+		if (fenced.empty()) {
+			continue;
+		}
+		int base_level = texture->baseLevel;
+		std::vector<std::pair<int, GLsync>> waiting;
+		for (const auto& level : fenced) {
+			//never block the frame, a level not copied yet is looked at again on the next poll
+			const auto status = functions->glClientWaitSync(level.second, 0, 0);
+			if (GL_ALREADY_SIGNALED == status || GL_CONDITION_SATISFIED == status) {
+				functions->glDeleteSync(level.second);
+				base_level = (base_level < 0) ? level.first : std::min(base_level, level.first);
+			}
+			else {
+				waiting.push_back(level);
+			}
+		}
+		if (!waiting.empty()) {
+			pending = true;
+			std::lock_guard<std::mutex> lock(texture->mutex);
+			texture->fencedLevels.insert(texture->fencedLevels.begin(), waiting.begin(), waiting.end());
+		}
+		if (base_level != texture->baseLevel) {
+			//the finer levels are sampled only once they are complete
+			texture->baseLevel = base_level;
+			functions->glBindTexture(GL_TEXTURE_2D, texture->id.load());
+			functions->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, base_level);
+			functions->glBindTexture(GL_TEXTURE_2D, 0);
+		}
+	}
+	return pending;
+}
+
+void TextureStreamer::releaseUnused(const QSet<QString>& used, QOpenGLFunctions_3_3_Core* functions)
+{
+	for (auto it = m_textures.begin(); it != m_textures.end();) {
+		const auto state = it.value()->state.load();
+		//loads in flight still hand their levels over, they are released once finished
+		if (!used.contains(it.key()) &&
+			(StreamedTexture::State::READY == state || StreamedTexture::State::FAILED == state)) {
+			destroyTexture(*it.value(), functions);
+			it = m_textures.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+void TextureStreamer::stop()
+{
+	m_token.cancel();
+	JobSystem::instance().wait(m_jobs);
+	m_jobs.clear();
+	m_token = JobSystem::CancellationToken();
+}
+
+void TextureStreamer::destroy(QOpenGLFunctions_3_3_Core* functions)
+{
+	for (const auto& texture : m_textures) {
+		destroyTexture(*texture, functions);
+	}
+	m_textures.clear();
+}
+
+void TextureStreamer::destroyTexture(StreamedTexture& texture, QOpenGLFunctions_3_3_Core* functions)
+{
+	std::lock_guard<std::mutex> lock(texture.mutex);
+	for (const auto& level : texture.fencedLevels) {
+		functions->glDeleteSync(level.second);
+	}
+	texture.fencedLevels.clear();
+	const GLuint id = texture.id.exchange(0);
+	if (0 != id) {
+		functions->glDeleteTextures(1, &id);
+	}
+}
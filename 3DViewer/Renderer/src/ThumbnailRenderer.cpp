@@ -0,0 +1,160 @@
+#include <QDebug>
+#include <QOpenGLBuffer>
+#include <QOpenGLVertexArrayObject>
+#include <QSurfaceFormat>
+#include <QtMath>
+
+#include <algorithm>
+
+#include "Scene.h"
+#include "ThumbnailRenderer.h"
+
+namespace {
+	//from the front right and above, the way most models are modelled to be seen
+	const QVector3D VIEW_DIRECTION = QVector3D(1.0f, 0.8f, 1.3f).normalized();
+	constexpr float FIELD_OF_VIEW = 30.0f;
+	constexpr int SAMPLES = 4;
+}
+
+ThumbnailRenderer::ThumbnailRenderer(int size) :
+	m_size(size),
+	m_surface(new QOffscreenSurface()),
+	m_context(new QOpenGLContext())
+{
+	QSurfaceFormat format;
+	format.setVersion(3, 3);
+	format.setProfile(QSurfaceFormat::CoreProfile);
+	m_surface->setFormat(format);
+	m_surface->create();
+	m_context->setFormat(format);
+	m_available = m_surface->isValid() && m_context->create();
+	if (!m_available) {
+		qCritical() << "Critical: cannot create OpenGL context for thumbnails.";
+	}
+	m_context->moveToThread(&m_thread);
+	moveToThread(&m_thread);
+	m_thread.setObjectName("ThumbnailRenderer");
+	m_thread.start();
+}
+
+ThumbnailRenderer::~ThumbnailRenderer()
+{
+	//the framebuffer and the program belong to the context of the thread
+	QMetaObject::invokeMethod(this, [this]() { releaseResources(); }, Qt::BlockingQueuedConnection);
+	m_thread.quit();
+	m_thread.wait();
+	delete m_context;
+	delete m_surface;
+}
+
+void ThumbnailRenderer::enqueue(const QString& path, const std::shared_ptr<const Preview>& preview)
+{
+	QMetaObject::invokeMethod(this, [this, path, preview]() { render(path, preview); }, Qt::QueuedConnection);
+}
+
+bool ThumbnailRenderer::initializeResources()
+{
+	if (!m_available || !m_context->makeCurrent(m_surface)) {
+		qCritical() << "Critical: cannot make thumbnail context current.";
+		return false;
+	}
+	if (nullptr != m_frameBuffer) {
+		return true;
+	}
+	m_functions = m_context->versionFunctions<QOpenGLFunctions_3_3_Core>();
+	if (nullptr == m_functions || !m_functions->initializeOpenGLFunctions()) {
+		qCritical() << "Critical: thumbnail context does not support OpenGL 3.3 core.";
+		m_available = false;
+		return false;
+	}
+	//the shaders of the viewer, so a preview looks like the model once opened
+	m_program = std::make_unique<QOpenGLShaderProgram>();
+	if (!m_program->addShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/main_vert.glsl") ||
+		!m_program->addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/main_frag.glsl") ||
+		!m_program->link()) {
+		qCritical() << "Critical: error while loading thumbnail shaders.";
+		m_available = false;
+		return false;
+	}
+	QOpenGLFramebufferObjectFormat format;
+	format.setAttachment(QOpenGLFramebufferObject::Depth);
+	format.setSamples(SAMPLES);
+	m_frameBuffer = std::make_unique<QOpenGLFramebufferObject>(m_size, m_size, format);
+	return true;
+}
+
+void ThumbnailRenderer::releaseResources()
+{
+	if (nullptr == m_frameBuffer || !m_context->makeCurrent(m_surface)) {
+		return;
+	}
+	m_frameBuffer.reset();
+	m_program.reset();
+	m_context->doneCurrent();
+}
+
+void ThumbnailRenderer::render(const QString& path, const std::shared_ptr<const Preview>& preview)
+{
+	if (!initializeResources()) {
+		emit rendered(path, QImage());
+		return;
+	}
+	//the model is placed in front of the camera, so the lights of the shader follow the view
+	const auto center = (preview->minBounds + preview->maxBounds) * 0.5f;
+	const float radius = std::max(0.5f * (preview->maxBounds - preview->minBounds).length(), 1e-6f);
+	const float distance = radius / qSin(qDegreesToRadians(0.5f * FIELD_OF_VIEW));
+	QMatrix4x4 model;
+	model.lookAt(center + VIEW_DIRECTION * distance, center, QVector3D(0.0f, 1.0f, 0.0f));
+	QMatrix4x4 projection;
+	projection.perspective(FIELD_OF_VIEW, 1.0f, std::max(distance - radius, distance * 0.01f), distance + radius);
+
+	m_frameBuffer->bind();
+	m_functions->glViewport(0, 0, m_size, m_size);
+	m_functions->glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	m_functions->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	m_functions->glEnable(GL_DEPTH_TEST);
+
+	QOpenGLVertexArrayObject vao;
+	vao.create();
+	vao.bind();
+	QOpenGLBuffer vbo;
+	vbo.create();
+	vbo.setUsagePattern(QOpenGLBuffer::StreamDraw);
+	vbo.bind();
+	vbo.allocate(preview->vertices.data(), static_cast<int>(preview->vertices.sizeInBytes()));
+	m_program->bind();
+	m_program->enableAttributeArray(0);
+	m_program->setAttributeBuffer(0, GL_FLOAT, 0, 3, sizeof(Vertex));
+	m_program->enableAttributeArray(1);
+	m_program->setAttributeBuffer(1, GL_FLOAT, sizeof(QVector3D), 3, sizeof(Vertex));
+	m_program->setUniformValue("viewMatrix", QMatrix4x4());
+	m_program->setUniformValue("projectionMatrix", projection);
+	m_program->setUniformValue("modelMatrix", model);
+	m_program->setUniformValue("clipPlane", QVector4D());
+	m_program->setUniformValue("lightDirectionFront", QVector3D(0.0f, 0.0f, -1.0f));
+	m_program->setUniformValue("lightDirectionBack", QVector3D(0.0f, 0.0f, 1.0f));
+	m_program->setUniformValue("lightColor", QVector3D(1.0f, 1.0f, 1.0f));
+	const auto material = Scene::defaultMaterial();
+	m_program->setUniformValue("objectColor", material.objectColor);
+	m_program->setUniformValue("diffuseMap", 0);
+	m_program->setUniformValue("normalMap", 1);
+	m_program->setUniformValue("bumpMap", 2);
+	m_program->setUniformValue("hasDiffuseMap", false);
+	m_program->setUniformValue("hasNormalMap", false);
+	m_program->setUniformValue("hasBumpMap", false);
+	m_program->setUniformValue("ambientStrength", material.ambientStrength);
+	m_program->setUniformValue("specularStrength", material.specularStrength);
+	m_program->setUniformValue("shininess", material.shininess);
+	m_functions->glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(preview->vertices.size()));
+	m_program->release();
+	vao.release();
+	vbo.release();
+	vao.destroy();
+	vbo.destroy();
+
+	//resolves the samples into a plain framebuffer first
+	const auto image = m_frameBuffer->toImage();
+	m_frameBuffer->release();
+	m_context->doneCurrent();
+	emit rendered(path, image);
+}
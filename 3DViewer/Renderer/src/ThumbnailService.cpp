@@ -0,0 +1,137 @@
+#include <algorithm>
+
+#include "ThumbnailService.h"
+#include "MemoryTracker.h"
+
+ThumbnailService::ThumbnailService(QObject* parent) :
+	QObject(parent),
+	m_renderer(std::make_unique<ThumbnailRenderer>())
+{
+	connect(m_renderer.get(), &ThumbnailRenderer::rendered, this, &ThumbnailService::handleRendered, Qt::QueuedConnection);
+}
+
+ThumbnailService::~ThumbnailService()
+{
+	//the jobs hand their previews to the renderer
+	m_token.cancel();
+	JobSystem::instance().wait(m_jobs);
+}
+
+void ThumbnailService::request(const QString& path)
+{
+	if (m_pending.contains(path)) {
+		return;
+	}
+	m_pending.insert(path);
+	pruneJobs();
+	//only a png to decode when cached, still behind the loads of the viewer
+	m_jobs.push_back(JobSystem::instance().submit([this, path]() {
+		const auto image = THUMBNAIL_API::readThumbnail(path);
+		if (image.isNull()) {
+			QMetaObject::invokeMethod(this, [this, path]() { generate(path); }, Qt::QueuedConnection);
+		}
+		else {
+			QMetaObject::invokeMethod(this, [this, path, image]() { finish(path, image); }, Qt::QueuedConnection);
+		}
+	}, JobSystem::Priority::BACKGROUND, {}, m_token));
+}
+
+void ThumbnailService::cancelPending()
+{
+	m_token.cancel();
+	m_token = JobSystem::CancellationToken();
+	m_pending.clear();
+	m_queued.clear();
+}
+
+void ThumbnailService::generate(const QString& path)
+{
+	//cancelled meanwhile
+	if (!m_pending.contains(path)) {
+		return;
+	}
+	if (!m_renderer->isAvailable()) {
+		finish(path, QImage());
+		return;
+	}
+	if (THUMBNAIL_API::estimateBuildBytes(path) > PREVIEW_MEMORY_BUDGET) {
+		finish(path, QImage());
+		return;
+	}
+	m_queued.push_back(path);
+	startBuilds();
+}
+
+void ThumbnailService::startBuilds()
+{
+	while (!m_queued.empty() && m_building < MAX_PREVIEW_BUILDS) {
+		const auto path = m_queued.front();
+		//cancelled meanwhile
+		if (!m_pending.contains(path)) {
+			m_queued.pop_front();
+			continue;
+		}
+		const auto bytes = THUMBNAIL_API::estimateBuildBytes(path);
+		if (m_building > 0 && m_buildingBytes + bytes > PREVIEW_MEMORY_BUDGET) {
+			break;
+		}
+		m_queued.pop_front();
+		++m_building;
+		m_buildingBytes += bytes;
+		pruneJobs();
+		//behind the loads of the viewer, the models are read as a whole
+		const auto build = JobSystem::instance().submit([this, path]() {
+			MemoryTracker::LoadScope scope;
+			auto preview = std::make_shared<ThumbnailRenderer::Preview>();
+			if (THUMBNAIL_API::buildPreviewMesh(path, preview->vertices, preview->minBounds, preview->maxBounds)) {
+				m_renderer->enqueue(path, preview);
+			}
+			else if (!JobSystem::cancellationRequested()) {
+				QMetaObject::invokeMethod(this, [this, path]() { finish(path, QImage()); }, Qt::QueuedConnection);
+			}
+		}, JobSystem::Priority::BACKGROUND, {}, m_token);
+		m_jobs.push_back(build);
+		//runs once the build is done, also when it was cancelled before it started
+		m_jobs.push_back(JobSystem::instance().submit([this, bytes]() {
+			QMetaObject::invokeMethod(this, [this, bytes]() { handleBuildFinished(bytes); }, Qt::QueuedConnection);
+		}, JobSystem::Priority::BACKGROUND, { build }));
+	}
+}
+
+void ThumbnailService::handleBuildFinished(std::uint64_t bytes)
+{
+	--m_building;
+	m_buildingBytes -= bytes;
+	startBuilds();
+}
+
+void ThumbnailService::handleRendered(const QString& path, const QImage& image)
+{
+	if (!image.isNull()) {
+		pruneJobs();
+		//kept even when the request was cancelled meanwhile, the next visit finds it
+		m_jobs.push_back(JobSystem::instance().submit([path, image]() {
+			THUMBNAIL_API::writeThumbnail(path, image);
+		}, JobSystem::Priority::BACKGROUND));
+	}
+	finish(path, image);
+}
+
+void ThumbnailService::finish(const QString& path, const QImage& image)
+{
+	if (!m_pending.remove(path)) {
+		return;
+	}
+	if (image.isNull()) {
+		emit thumbnailFailed(path);
+	}
+	else {
+		emit thumbnailReady(path, image);
+	}
+}
+
+void ThumbnailService::pruneJobs()
+{
+	m_jobs.erase(std::remove_if(m_jobs.begin(), m_jobs.end(),
+		[](const JobSystem::JobHandle& job) { return job->isFinished(); }), m_jobs.end());
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QMatrix4x4>
+
+#include <memory>
+#include <vector>
+
+#include "JobSystem.h"
+#include "SceneObject.h"
+#include "TriangleBvh.h"
+
+// Finds the pairs of objects closer to each other than the clearance, in their placement on the
+// scene. Every object gets a hierarchy of its triangles, built once per geometry version, the
+// pairs whose placed bounds overlap are swept out along x and tested in parallel. Moving an
+// object re-tests only its own pairs, one check runs at a time and the next one takes all the
+// objects moved meanwhile.
+class ClearanceChecker : public QObject {
+	Q_OBJECT
+public:
+	static constexpr float DEFAULT_CLEARANCE = 0.1f;
+	// the hierarchies kept between the checks in the memory report
+	static constexpr const char* MEMORY_CACHE = "clearance hierarchies";
+
+	// two objects too close to each other
+	struct Contact {
+		unsigned int objA = 0;
+		unsigned int objB = 0;
+		float distance = 0.0f;
+		bool intersecting = false;
+		// offending triangles of both objects, in their own coordinates
+		std::shared_ptr<const std::vector<Vertex>> trianglesA;
+		std::shared_ptr<const std::vector<Vertex>> trianglesB;
+		unsigned int versionA = 0;
+		unsigned int versionB = 0;
+	};
+	// offending triangles of one object against all the others
+	struct Highlight {
+		std::shared_ptr<const std::vector<Vertex>> triangles;
+		unsigned int version = 0;
+	};
+
+	ClearanceChecker() = default;
+	~ClearanceChecker();
+
+	void setEnabled(bool enabled);
+	void setClearance(float clearance);
+	// objects on the scene, held by the checks running until they finish
+	void setObjects(const QVector<std::shared_ptr<SceneObject>>& objects);
+	// placement or geometry changed, its pairs are tested again
+	void markMoved(unsigned int objId);
+	void removeObject(unsigned int objId);
+	// cancels the check in progress and waits for it, before the objects go away
+	void stop();
+
+	inline bool isEnabled() const { return this->m_enabled; }
+	inline float getClearance() const { return this->m_clearance; }
+	inline bool isChecking() const { return this->m_running; }
+	inline const QHash<quint64, Contact>& getContacts() const { return this->m_contacts; }
+	inline Highlight getHighlight(unsigned int objId) const { return this->m_highlights.value(objId); }
+	// hierarchy kept for the object, null before its first check
+	std::shared_ptr<const TriangleBvh> getHierarchy(unsigned int objId) const;
+	// contact count and the worst pair, for the status bar
+	QString summary() const;
+
+signals:
+	void contactsUpdated(QString) const;
+	// the highlights changed
+	void checkFinished() const;
+
+private:
+	struct CachedBvh {
+		unsigned int version = 0;
+		TriangleBvh bvh;
+	};
+	// object of a check with its placement at the time the check started
+	struct Placed {
+		std::shared_ptr<SceneObject> object;
+		QMatrix4x4 world;
+		std::shared_ptr<const CachedBvh> bvh;
+	};
+	struct Result {
+		bool all = false;
+		QSet<unsigned int> moved;
+		std::vector<Contact> contacts;
+		std::vector<std::pair<unsigned int, std::shared_ptr<const CachedBvh>>> built;
+	};
+
+	static inline quint64 pairKey(unsigned int a, unsigned int b) {
+		return a < b ? (static_cast<quint64>(a) << 32) | b : (static_cast<quint64>(b) << 32) | a;
+	}
+	// the objects whose hierarchy is missing or out of date get a new one
+	static bool buildMissing(std::vector<Placed>& placed, Result& result);
+	static void findCandidates(const std::vector<Placed>& placed, const Result& result, float clearance,
+		std::vector<std::pair<std::uint32_t, std::uint32_t>>& candidates);
+	static std::shared_ptr<const std::vector<Vertex>> collectTriangles(const TriangleBvh& bvh,
+		const std::vector<std::uint32_t>& indices);
+
+	void startCheck();
+	void handleCheckFinished(const std::shared_ptr<Result>& result, std::uint64_t generation);
+	void updateHighlights();
+	void clearContacts();
+	void trackMemory() const;
+
+	bool m_enabled = false;
+	float m_clearance = DEFAULT_CLEARANCE;
+	QVector<std::shared_ptr<SceneObject>> m_objects;
+	// waiting for the next check, all of them after a clearance change
+	QSet<unsigned int> m_moved;
+	bool m_checkAll = false;
+	bool m_running = false;
+	// per object ID, kept while the geometry version matches
+	QHash<unsigned int, std::shared_ptr<const CachedBvh>> m_bvhs;
+	QHash<quint64, Contact> m_contacts;
+	QHash<unsigned int, Highlight> m_highlights;
+	JobSystem::CancellationToken m_token;
+	std::vector<JobSystem::JobHandle> m_jobs;
+	// results of checks started before a clearance change or a disable are dropped
+	std::uint64_t m_generation = 0;
+};
@@ -0,0 +1,117 @@
+#pragma once
+#include <QObject>
+#include <QHash>
+
+#include <memory>
+#include <vector>
+
+#include "JobSystem.h"
+#include "ScalarField.h"
+#include "SceneObject.h"
+#include "TriangleBvh.h"
+
+// Computes the analysis field of the selected object in the background. The soup is copied
+// under the geometry lock, its corners are gathered and welded from the copy once per geometry
+// version, the fields are computed while the object keeps being drawn. Finished fields are kept
+// per object until its geometry changes, so switching back to one is instant, the least recently
+// shown ones are dropped beyond a bounded size. One computation runs at a time, a change of the
+// field, the selection or the geometry cancels it and the next one starts from the latest state.
+class FieldAnalyzer : public QObject {
+	Q_OBJECT
+public:
+	// field of one object, shown while the version matches its geometry
+	struct Field {
+		std::shared_ptr<const ScalarField> field;
+		unsigned int objId = 0;
+		unsigned int version = 0;
+	};
+
+	// the fields, corners and hierarchy kept, in the shared caches of the memory report
+	static constexpr const char* MEMORY_CACHE = "analysis fields";
+	// finished fields of the objects not shown beyond this size are dropped least recently shown first
+	static constexpr std::uint64_t FIELD_CACHE_BYTES = 256ull * 1024 * 1024;
+	// larger corners or hierarchies are built again for the next field instead of being kept
+	static constexpr std::uint64_t SOUP_CACHE_BYTES = 512ull * 1024 * 1024;
+
+	FieldAnalyzer() = default;
+	~FieldAnalyzer();
+
+	void setKind(FieldKind kind);
+	// object the deviation is measured against, nullptr clears it
+	void setReference(const std::shared_ptr<SceneObject>& reference);
+	// selected object, held by the computation running until it finishes
+	void setTarget(const std::shared_ptr<SceneObject>& target);
+	// geometry reloaded, the field of the object or the deviation against it is computed again
+	void markChanged(unsigned int objId);
+	void removeObject(unsigned int objId);
+	// cancels the computation in progress and waits for it, before the objects go away
+	void stop();
+
+	inline FieldKind getKind() const { return this->m_kind; }
+	inline bool isComputing() const { return this->m_running; }
+	inline std::shared_ptr<SceneObject> getReference() const { return this->m_reference; }
+	// the latest finished field of the object, empty for the other objects
+	Field getField(unsigned int objId) const;
+	// field kind and its range, for the status bar
+	QString summary() const;
+
+signals:
+	void fieldUpdated(QString) const;
+	// the field to draw changed
+	void fieldReady() const;
+
+private:
+	struct CachedSoup {
+		unsigned int objId = 0;
+		unsigned int version = 0;
+		WeldedSoup welded;
+	};
+	// fields of one geometry version by kind, the deviation against the reference it was measured from
+	struct CachedFields {
+		unsigned int version = 0;
+		QHash<int, std::shared_ptr<const ScalarField>> fields;
+		unsigned int referenceId = 0;
+		std::uint64_t lastUsed = 0;
+	};
+	struct CachedBvh {
+		unsigned int objId = 0;
+		unsigned int version = 0;
+		TriangleBvh bvh;
+	};
+	struct Result {
+		Field field;
+		std::shared_ptr<const CachedSoup> soup;
+		std::shared_ptr<const CachedBvh> bvh;
+	};
+
+	// copies and welds the corners unless the cached ones match the geometry
+	static std::shared_ptr<const CachedSoup> prepareSoup(SceneObject& obj, const std::shared_ptr<const CachedSoup>& cached);
+	static std::shared_ptr<const CachedBvh> prepareBvh(SceneObject& obj, const std::shared_ptr<const CachedBvh>& cached);
+
+	// finished field of the target for the current kind and reference
+	std::shared_ptr<const ScalarField> cachedField() const;
+	void restart();
+	void startComputation();
+	void handleFinished(const std::shared_ptr<Result>& result, std::uint64_t generation);
+	void cancel();
+	// drops the least recently shown fields beyond the cache size
+	void trimFields();
+	void trackMemory() const;
+
+	FieldKind m_kind = FieldKind::NONE;
+	std::shared_ptr<SceneObject> m_target;
+	std::shared_ptr<SceneObject> m_reference;
+	Field m_field;
+	bool m_running = false;
+	// per object ID, dropped when the geometry of the object changes
+	QHash<unsigned int, CachedFields> m_fields;
+	std::uint64_t m_fieldUses = 0;
+	// welded corners of the last target and the hierarchy of the last reference, reused while
+	// their geometry versions match and kept up to SOUP_CACHE_BYTES each
+	std::shared_ptr<const CachedSoup> m_soup;
+	std::shared_ptr<const CachedBvh> m_referenceBvh;
+	JobSystem::CancellationToken m_token;
+	std::vector<JobSystem::JobHandle> m_jobs;
+	// results of computations started before a change are dropped
+	std::uint64_t m_generation = 0;
+};
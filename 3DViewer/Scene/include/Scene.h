@@ -1,15 +1,45 @@
 #pragma once
 #include <QListWidget>
+#include <QHash>
 
+#include <array>
+
+#include "ClearanceChecker.h"
+#include "FieldAnalyzer.h"
 #include "SceneObject.h"
+#include "SceneSnapshot.h"
 
 class Scene : public QObject {
 	Q_OBJECT
-	class MaterialProperties;
 public:
 	static constexpr auto TRANSLATION_SPEED = 0.02f;
 	static constexpr auto ANGLE_ROTATION_SCALE = 7.0f;
 
+	struct MaterialProperties {
+		MaterialProperties(
+			const QString& name,
+			const QVector3D& color,
+			float ambientStrength,
+			float specularStrength,
+			float shininess) :
+			name{ name },
+			objectColor{ color },
+			ambientStrength{ ambientStrength },
+			specularStrength{ specularStrength },
+			shininess{ shininess }
+		{
+		}
+		QString name;
+		QVector3D objectColor;
+		float ambientStrength;
+		float specularStrength;
+		float shininess;
+
+		MaterialProperties() = default;
+	};
+	// material the scene starts with, also used by the offscreen renderers
+	static MaterialProperties defaultMaterial();
+
 	Scene();
 	~Scene();
 
@@ -22,6 +52,11 @@ signals:
 	void lengthUpdated	(QString) const;
 	void heightUpdated	(QString) const;
 	void nameUpdated	(QString) const;
+	void cpuMemoryUpdated(QString) const;
+	void gpuMemoryUpdated(QString) const;
+	void loadPeakUpdated(QString) const;
+	void clearanceUpdated(QString) const;
+	void fieldUpdated	(QString) const;
 	void redrawRenderer	(void)    const;
     void updateCamera	(float)   const;
 
@@ -31,42 +66,57 @@ public slots:
 	void removeCurrentObjSelection();
 	void setCurrentObjVisibility(int state);
 	void setCurrentMaterial(const QString& str);
+	void updateMemoryDetails() const;
+	void handleGeometrySwapped(unsigned int objId);
+	// geometry reloaded in the background, swapped in by the render thread once its buffers are ready
+	void setPendingGeometry(unsigned int objId, const std::shared_ptr<SceneObject>& pending);
+	// placement changed by the user, its clearance is checked again
+	void handleObjectMoved(unsigned int objId);
+	void setClearanceCheck(bool enabled);
+	void setClearance(float clearance);
+	void setFieldKind(FieldKind kind);
+	// object the deviation of the selected one is measured against
+	void setFieldReference(unsigned int objId);
 
 public:
 	inline QVector<std::shared_ptr<SceneObject>> getObjectsLst() const { return this->m_sceneObjectsLst; };
 	inline std::shared_ptr<SceneObject> getCurrentObjSelection() const { return this->m_currentSelection; };
 	inline MaterialProperties getCurrentMaterial()				 const { return this->m_currentMaterial; }
+	inline const ClearanceChecker& getClearanceChecker()		 const { return this->m_clearanceChecker; }
+	inline const FieldAnalyzer& getFieldAnalyzer()				 const { return this->m_fieldAnalyzer; }
 	void updateObjDetails(const std::shared_ptr<SceneObject>& obj) const;
 	std::shared_ptr<SceneObject> getObjectByID(unsigned int id) const;
+	// objects, selection and material of the next frame, the camera is added by the renderer
+	void fillSnapshot(SceneSnapshot& snapshot) const;
 
 private:
-	void createMaterials();
-
-	struct MaterialProperties {
-		MaterialProperties(
-			const QString& name,
-			const QVector3D& color,
-			float ambientStrength,
-			float specularStrength,
-			float shininess) :
-			name{ name },
-			objectColor{ color },
-			ambientStrength{ ambientStrength },
-			specularStrength{ specularStrength },
-			shininess{ shininess }
-		{
-		}
-		QString name;
-		QVector3D objectColor;
-		float ambientStrength;
-		float specularStrength;
-		float shininess;
-
-		MaterialProperties() = default;
+	// details shown in the side panel, emitted only when the text changes
+	enum Detail {
+		NAME,
+		VERTICES,
+		FACES,
+		EDGES,
+		ID,
+		WIDTH,
+		HEIGHT,
+		LENGTH,
+		CPU_MEMORY,
+		GPU_MEMORY,
+		LOAD_PEAK,
+		DETAIL_COUNT
 	};
+	void createMaterials();
+	void emitDetail(Detail detail, void (Scene::*signal)(QString) const, const QString& text) const;
 
 	QVector<std::shared_ptr<SceneObject>> m_sceneObjectsLst;
 	QVector<MaterialProperties> m_sceneMaterialsLst;
 	std::shared_ptr<SceneObject> m_currentSelection;
+	// latest reload per object, a newer one replaces the one still waiting
+	QHash<unsigned int, std::shared_ptr<SceneObject>> m_pendingGeometry;
 	MaterialProperties m_currentMaterial;
+	ClearanceChecker m_clearanceChecker;
+	FieldAnalyzer m_fieldAnalyzer;
+	mutable std::array<QString, DETAIL_COUNT> m_shownDetails;
+	// object the geometry details shown belong to, 0 for none
+	mutable unsigned int m_detailsObjId = 0;
 };
\ No newline at end of file
@@ -8,36 +8,102 @@
 #include <QQuaternion>
 #include <QDir>
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
 #include "CgalApi.h"
+#include "IndexedMesh.h"
+#include "MemoryTracker.h"
+#include "PointCloud.h"
+#include "SurfaceMaterial.h"
+
+class FrameRenderer;
 
-struct Vertex {
-	QVector3D position;
-	QVector3D normal;
-	QVector2D texture;
+// part of the object geometry uploaded into a single bounded-size GPU buffer
+struct BufferChunk {
+	QOpenGLBuffer vbo;
+	std::unique_ptr<QOpenGLVertexArrayObject> vao;
+	std::uint64_t firstVertex = 0;
+	std::uint64_t vertexCount = 0;
 };
 
-class OpenGLRenderer;
+// triangles of one buffer chunk with their bounds, the unit of the occlusion culling
+struct DrawCluster {
+	int chunk = 0;
+	std::uint64_t firstVertex = 0;
+	std::uint64_t vertexCount = 0;
+	QVector3D minBounds;
+	QVector3D maxBounds;
+};
 
 class SceneObject {
 public:
+	// lifecycle of the GPU copy, written by the render and the upload threads
+	enum class UploadState {
+		NONE,
+		QUEUED,
+		UPLOADING,
+		FENCED,
+		READY,
+		RELEASED
+	};
+	// coarse copy drawn while the user interacts with a dense object
+	enum class ProxyState {
+		NONE,
+		BUILDING,
+		BUILT,
+		READY,
+		RELEASED
+	};
+	// objects above twice this amount of triangles get a proxy
+	static constexpr std::uint64_t PROXY_TRIANGLE_BUDGET = 100000;
+
 	SceneObject() = default;
-	~SceneObject() = default;
+	~SceneObject();
 	SceneObject(const SceneObject&) = delete;
-	SceneObject(const QString& filepath, const QString& name, const QVector<Vertex>& vertices,
-		unsigned int vertices_count, unsigned int faces_count, unsigned int edges_count);
+	SceneObject(const QString& filepath, const QString& name, MappedArray<Vertex>&& vertices,
+		std::uint64_t vertices_count, std::uint64_t faces_count, std::uint64_t edges_count);
+	// restores an object with already known bounds without walking the vertices
+	SceneObject(const QString& filepath, const QString& name, MappedArray<Vertex>&& vertices,
+		std::uint64_t vertices_count, std::uint64_t faces_count, std::uint64_t edges_count,
+		const QVector3D& minBounds, const QVector3D& maxBounds);
+	// point cloud with a built octree, drawn by streaming its nodes instead of uploading buffers
+	SceneObject(const QString& filepath, const QString& name, std::unique_ptr<PointCloud>&& cloud);
 
-	template <typename T> inline static std::shared_ptr<SceneObject> makeObject(const QFileInfo& fileInfo, const T& mesh);
+	template <typename T> inline static std::shared_ptr<SceneObject> makeObject(const QFileInfo& fileInfo, const T& mesh,
+		const SurfaceAttributes* attributes = nullptr);
+	static std::shared_ptr<SceneObject> makeObject(const QFileInfo& fileInfo, const std::unique_ptr<IndexedMesh>& mesh);
 
-	void draw(OpenGLRenderer* renderer);
-	void intializeBuffers(OpenGLRenderer* renderer);
+	void draw(FrameRenderer* renderer);
+	void intializeBuffers(FrameRenderer* renderer);
 	void release();
 	void calculateBoundingBox();
+	// clusters the vertices into the proxy, runs on a background job
+	void buildProxy();
+	void markProxyReady();
+	// takes over the geometry and the buffers of the reloaded object keeping the ID, transform and
+	// visibility, runs on the render thread. False while the uploader, the proxy job or the GUI
+	// thread still read the current geometry
+	bool swapGeometry(SceneObject& pending);
+	// held by the GUI thread while it reads the vertices, counts or bounds, which a swap replaces
+	inline std::unique_lock<std::mutex> lockGeometry() const { return std::unique_lock<std::mutex>(this->m_geometryMutex); }
+	// owns no lock while another thread holds the geometry, for readers that can do without it
+	inline std::unique_lock<std::mutex> tryLockGeometry() const { return std::unique_lock<std::mutex>(this->m_geometryMutex, std::try_to_lock); }
+	// copies the vertices under the geometry lock and returns the geometry version of the copy, so a swap or
+	// the GUI thread waits only for the copy while the caches are built from it. Nothing is copied when the
+	// version is still *upToDate, the copy is also left empty when it cannot be allocated
+	unsigned int copyVertices(MappedArray<Vertex>& copy, const unsigned int* upToDate = nullptr) const;
+	void setBoundingBox(const QVector3D& minBounds, const QVector3D& maxBounds);
+	// calls f(first, count, material) for the material runs within the vertices, -1 without a material
+	template <typename F> inline void forEachMaterialRun(std::uint64_t first, std::uint64_t count, F&& f) const;
 
 	void reset();
 
-	inline constexpr unsigned int getNumberOfVertices() const { return this->m_num_vertices; };
-	inline constexpr unsigned int getNumberOfFaces()    const { return this->m_num_faces; };
-	inline constexpr unsigned int getNumberOfEdges()    const { return this->m_num_edges; }
+	inline constexpr std::uint64_t getNumberOfVertices() const { return this->m_num_vertices; };
+	inline constexpr std::uint64_t getNumberOfFaces()    const { return this->m_num_faces; };
+	inline constexpr std::uint64_t getNumberOfEdges()    const { return this->m_num_edges; }
 	inline constexpr unsigned int getID()				const { return this->m_objID; };
 	inline constexpr float		  getWidth()			const { return this->m_width; };
 	inline constexpr float		  getHeight()			const { return this->m_height; };
@@ -47,29 +113,59 @@ public:
 	inline QString				  getFilePath()			const { return this->m_filepath; }
 	inline int					  isVisible()			const { return this->m_isVisible; };
 	inline bool					  isBuffersInited()		const { return this->m_buffersInited; };
+	inline bool					  isPointCloud()		const { return nullptr != this->pointCloud; }
+	inline UploadState			  getUploadState()		const { return this->m_uploadState.load(); }
+	inline GLsync				  getUploadFence()		const { return this->m_uploadFence; }
+	inline ProxyState			  getProxyState()		const { return this->m_proxyState.load(); }
+	inline unsigned int			  getGeometryVersion()	const { return this->m_geometryVersion; }
+	inline bool					  needsProxy()			const { return this->vertices.size() / 3 > 2 * PROXY_TRIANGLE_BUDGET; }
 	inline QVector3D			  getObjectCenter()		const { return this->m_center; }
+	inline QVector3D			  getMinBounds()		const { return this->m_minBounds; }
+	inline QVector3D			  getMaxBounds()		const { return this->m_maxBounds; }
 	inline QVector3D			  getTranslationVec()	const { return this->m_translationVec; };
 	inline QQuaternion			  getRotationQuart()	const { return this->m_rotationQuaternion; };
 
 	inline void					  setBuffersInited(bool inited) { this->m_buffersInited = inited; };
+	// state transitions, false when the object was released in between
+	bool queueUpload();
+	bool beginUpload();
+	bool finishUpload(std::vector<BufferChunk>& chunks, std::vector<DrawCluster>& clusters, GLsync fence);
+	void markBuffersReady();
 	inline void					  setTranslationVec(const QVector3D& vec) { this->m_translationVec = vec; };
 	inline void					  setRotationQuart(const QQuaternion& quart) { this->m_rotationQuaternion = quart; };
 	inline void					  setVisible(int state) { this->m_isVisible = state; };
 
-	QOpenGLBuffer vbo;
-	QOpenGLVertexArrayObject vao;
-	QVector<Vertex> vertices;
+	std::vector<BufferChunk> bufferChunks;
+	// published together with the chunks
+	std::vector<DrawCluster> drawClusters;
+	MappedArray<Vertex> vertices;
+	// the CPU copy is freed once uploaded into the proxy chunk
+	BufferChunk proxyChunk;
+	MappedArray<Vertex> proxyVertices;
+	// shared with the page-in jobs of the streamer
+	std::shared_ptr<PointCloud> pointCloud;
+	// from the mtl libraries of an obj file, the ranges cover the soup in order
+	std::vector<SurfaceMaterial> materials;
+	std::vector<MaterialRange> materialRanges;
 
 private:
+	void trackMemory();
+
 	static unsigned int m_idCounter;
 	bool m_buffersInited;
+	std::atomic<UploadState> m_uploadState{ UploadState::NONE };
+	std::atomic<ProxyState> m_proxyState{ ProxyState::NONE };
+	GLsync m_uploadFence = nullptr;
+	// swaps are rare, the frames never take it
+	mutable std::mutex m_geometryMutex;
+	unsigned int m_geometryVersion = 0;
 	// obj data
 	QString m_filepath;
 	QString m_name;
-	unsigned int m_num_vertices;
-	unsigned int m_num_faces;
-	unsigned int m_num_edges;
-	unsigned int m_objID;
+	std::uint64_t m_num_vertices;
+	std::uint64_t m_num_faces;
+	std::uint64_t m_num_edges;
+	unsigned int m_objID = 0;
 	float m_width;
 	float m_height;
 	float m_length;
@@ -78,10 +174,35 @@ private:
 	QQuaternion m_rotationQuaternion;
 	QVector3D m_translationVec;
 	QVector3D m_center;
+	QVector3D m_minBounds;
+	QVector3D m_maxBounds;
 };
 
+template<typename F>
+inline void SceneObject::forEachMaterialRun(std::uint64_t first, std::uint64_t count, F&& f) const
+{
+	if (this->materialRanges.empty()) {
+		f(first, count, -1);
+		return;
+	}
+	const std::uint64_t end = first + count;
+	auto range = std::upper_bound(this->materialRanges.begin(), this->materialRanges.end(), first,
+		[](std::uint64_t vertex, const MaterialRange& r) { return vertex < r.firstVertex; });
+	if (range != this->materialRanges.begin()) {
+		--range;
+	}
+	for (; range != this->materialRanges.end() && range->firstVertex < end; ++range) {
+		const auto run_begin = std::max(first, range->firstVertex);
+		const auto run_end = std::min(end, range->firstVertex + range->vertexCount);
+		if (run_begin < run_end) {
+			f(run_begin, run_end - run_begin, range->material);
+		}
+	}
+}
+
 template<typename T>
-inline static std::shared_ptr<SceneObject> SceneObject::makeObject(const QFileInfo& fileInfo, const T& mesh)
+inline static std::shared_ptr<SceneObject> SceneObject::makeObject(const QFileInfo& fileInfo, const T& mesh,
+	const SurfaceAttributes* attributes)
 {
 	if (nullptr == mesh) {
 		return nullptr;
@@ -91,32 +212,29 @@ inline static std::shared_ptr<SceneObject> SceneObject::makeObject(const QFileIn
 		QElapsedTimer timer;
 		timer.start();
 		qDebug() << "Message: scene object creation has been started";
-		QVector<Vertex> vertices;
-		for (const auto& face : mesh->faces()) {
-			for (const auto& vertex : mesh->vertices_around_face(mesh->halfedge(face))) {
-				Vertex custom_vertex;
-				const auto& vertex_point = mesh->point(vertex);
-				custom_vertex.position = {
-					static_cast<float>(CGAL::to_double(vertex_point.x())),
-					static_cast<float>(CGAL::to_double(vertex_point.y())),
-					static_cast<float>(CGAL::to_double(vertex_point.z()))
-				};
-				custom_vertex.normal = CGAL_API::computeVertexNormal(mesh, vertex);
-				custom_vertex.texture = { 0, 0 };
-				vertices.push_back(custom_vertex);
-			}
+		const auto normals = CGAL_API::computeVertexNormals(mesh);
+		MemoryTracker::LoadScope::add(normals.capacity() * sizeof(QVector3D));
+		MappedArray<Vertex> vertices;
+		if (!CGAL_API::buildTriangleSoup(mesh, normals, vertices, attributes)) {
+			return nullptr;
 		}
+		MemoryTracker::LoadScope::add(vertices.sizeInBytes());
 		qDebug() << "Message: scene object creation took" << 
 			static_cast<double>(timer.nsecsElapsed()) / 1000000000.0 << "sec to execute";
 
-		return std::make_shared<SceneObject>(
+		auto object = std::make_shared<SceneObject>(
 			fileInfo.absoluteFilePath(),
 			fileInfo.baseName(),
-			vertices,
+			std::move(vertices),
 			mesh->number_of_vertices(),
 			mesh->number_of_faces(),
 			mesh->number_of_edges()
 		);
+		if (nullptr != attributes && attributes->faceMaterials.size() * 3 == object->vertices.size()) {
+			object->materials = attributes->materials;
+			object->materialRanges = MTL_API::buildMaterialRanges(attributes->faceMaterials);
+		}
+		return object;
 	}
 	catch (const std::exception& exp)
 	{
@@ -0,0 +1,68 @@
+#pragma once
+#include <QMatrix4x4>
+#include <QSize>
+#include <QVector3D>
+
+#include <memory>
+#include <vector>
+
+#include "CrossSection.h"
+#include "ScalarField.h"
+#include "SceneObject.h"
+
+// State of the scene a frame is drawn from, filled by the GUI thread and read by the render
+// thread. Transforms, visibility, material and camera are copied, so the GUI keeps changing
+// them while a frame is drawn. Objects are shared, the render thread owns their GPU state.
+struct SceneSnapshot {
+	struct Object {
+		std::shared_ptr<SceneObject> object;
+		// reloaded geometry waiting to be swapped in
+		std::shared_ptr<SceneObject> pending;
+		QMatrix4x4 model;
+		bool visible = true;
+		// triangles closer than the clearance to other objects, drawn while they match the geometry
+		std::shared_ptr<const std::vector<Vertex>> contacts;
+		unsigned int contactsVersion = 0;
+		// analysis values per vertex, drawn while they match the geometry
+		std::shared_ptr<const ScalarField> field;
+		unsigned int fieldVersion = 0;
+	};
+	struct Material {
+		QVector3D objectColor;
+		float ambientStrength = 0.0f;
+		float specularStrength = 0.0f;
+		float shininess = 1.0f;
+	};
+	// clipping plane of the selected object, in its own coordinates
+	struct Section {
+		// axis the plane is perpendicular to, -1 without a section
+		int axis = -1;
+		// fraction of the object bounds along the axis
+		float position = 0.5f;
+		// keeps the part below the plane instead of the one above
+		bool flipped = false;
+		// latest finished cut, drawn only while it matches the plane and the geometry of the object
+		std::shared_ptr<const CrossSection> cut;
+		unsigned int cutObjId = 0;
+		unsigned int cutVersion = 0;
+	};
+
+	std::vector<Object> objects;
+	// index of the selected object, -1 without a selection
+	int current = -1;
+	Material material;
+	QMatrix4x4 view;
+	float zoom = 45.0f;
+	// widget size, the recorded one during a replay
+	int width = 1;
+	int height = 1;
+	// pixels drawn during a replay, the widget size times its pixel ratio when empty
+	QSize frameSize;
+	bool wireframe = false;
+	bool occlusionCulling = true;
+	Section section;
+	// time of the last camera or object input on the render clock
+	double lastInputTime = -1.0;
+	// nonzero for a frame of a replayed session, drawn in full quality and timed once it is complete
+	std::uint64_t timedFrame = 0;
+};
@@ -0,0 +1,40 @@
+#pragma once
+#include <QString>
+#include <QVector>
+
+#include "Scene.h"
+#include "Camera.h"
+
+// Single-file workspace container: a JSON scene table (objects, transforms, visibility,
+// material, camera) plus the GPU-ready vertex soup of every object at page-aligned offsets.
+// Restoring maps the file and hands the mapped vertices to the objects without copying them.
+class WorkspaceSnapshot {
+public:
+	static constexpr std::uint32_t VERSION = 1;
+	static constexpr std::uint64_t BLOB_ALIGNMENT = 4096;
+	static constexpr auto FILE_SUFFIX = "3dvws";
+
+	struct Workspace {
+		QVector<std::shared_ptr<SceneObject>> objects;
+		int currentIndex = -1;
+		QString materialName;
+		CameraState camera;
+	};
+
+	static bool save(const QString& path, const Scene& scene, const CameraState& camera);
+	// the objects are only read, so the workspace can be written on a worker while the scene goes on
+	static bool save(const QString& path, const Workspace& workspace);
+	static std::unique_ptr<Workspace> capture(const Scene& scene, const CameraState& camera);
+	static std::unique_ptr<Workspace> restore(const QString& path);
+	// faults the mapped vertices in on a worker thread, objects in order
+	static void prefetch(const QVector<std::shared_ptr<SceneObject>>& objects);
+
+private:
+	struct Header {
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t vertexSize;
+		std::uint64_t tableOffset;
+		std::uint64_t tableSize;
+	};
+};
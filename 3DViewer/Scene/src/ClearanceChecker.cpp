@@ -0,0 +1,374 @@
+#include <algorithm>
+#include <limits>
+
+#include "ClearanceChecker.h"
+
+ClearanceChecker::~ClearanceChecker()
+{
+	stop();
+	m_bvhs.clear();
+	trackMemory();
+}
+
+void ClearanceChecker::stop()
+{
+	//a check in progress stops at its next cancellation point
+	clearContacts();
+	JobSystem::instance().wait(m_jobs);
+	m_jobs.clear();
+}
+
+void ClearanceChecker::setEnabled(bool enabled)
+{
+	if (enabled == m_enabled) {
+		return;
+	}
+	m_enabled = enabled;
+	clearContacts();
+	if (m_enabled) {
+		m_checkAll = true;
+		startCheck();
+	}
+	emit contactsUpdated(summary());
+	emit checkFinished();
+}
+
+void ClearanceChecker::setClearance(float clearance)
+{
+	m_clearance = std::max(0.0f, clearance);
+	if (!m_enabled) {
+		return;
+	}
+	//the contacts found with the old clearance are dropped together with the check running
+	clearContacts();
+	m_checkAll = true;
+	startCheck();
+	emit contactsUpdated(summary());
+	emit checkFinished();
+}
+
+void ClearanceChecker::setObjects(const QVector<std::shared_ptr<SceneObject>>& objects)
+{
+	m_objects = objects;
+}
+
+void ClearanceChecker::markMoved(unsigned int objId)
+{
+	if (!m_enabled) {
+		return;
+	}
+	m_moved.insert(objId);
+	startCheck();
+}
+
+void ClearanceChecker::removeObject(unsigned int objId)
+{
+	if (m_bvhs.remove(objId) > 0) {
+		trackMemory();
+	}
+	m_moved.remove(objId);
+	bool removed = false;
+	for (auto it = m_contacts.begin(); it != m_contacts.end();) {
+		if (objId == it->objA || objId == it->objB) {
+			it = m_contacts.erase(it);
+			removed = true;
+		}
+		else {
+			++it;
+		}
+	}
+	if (removed) {
+		updateHighlights();
+		emit contactsUpdated(summary());
+		emit checkFinished();
+	}
+}
+
+std::shared_ptr<const TriangleBvh> ClearanceChecker::getHierarchy(unsigned int objId) const
+{
+	const auto cached = m_bvhs.value(objId);
+	return nullptr != cached ? std::shared_ptr<const TriangleBvh>(cached, &cached->bvh) : nullptr;
+}
+
+QString ClearanceChecker::summary() const
+{
+	if (!m_enabled) {
+		return QStringLiteral("off");
+	}
+	QString text;
+	if (m_contacts.isEmpty()) {
+		text = QStringLiteral("clear");
+	}
+	else {
+		int intersecting = 0;
+		float closest = std::numeric_limits<float>::max();
+		for (const auto& contact : m_contacts) {
+			intersecting += contact.intersecting ? 1 : 0;
+			closest = std::min(closest, contact.distance);
+		}
+		text = QStringLiteral("%1 pairs, %2 intersecting").arg(m_contacts.size()).arg(intersecting);
+		if (intersecting < m_contacts.size()) {
+			text += QStringLiteral(", closest %1").arg(closest, 0, 'f', 3);
+		}
+	}
+	if (m_running) {
+		text += QStringLiteral(", checking");
+	}
+	return text;
+}
+
+void ClearanceChecker::startCheck()
+{
+	if (!m_enabled || m_running || (m_moved.isEmpty() && !m_checkAll)) {
+		return;
+	}
+	m_jobs.erase(std::remove_if(m_jobs.begin(), m_jobs.end(),
+		[](const JobSystem::JobHandle& job) { return job->isFinished(); }), m_jobs.end());
+	//the placements are copied, the objects keep being moved while the check runs
+	std::vector<Placed> placed;
+	placed.reserve(m_objects.size());
+	for (const auto& obj : m_objects) {
+		if (obj->isPointCloud()) {
+			continue;
+		}
+		Placed entry;
+		entry.object = obj;
+		entry.world.translate(obj->getTranslationVec());
+		entry.world.rotate(obj->getRotationQuart());
+		entry.bvh = m_bvhs.value(obj->getID());
+		placed.push_back(std::move(entry));
+	}
+	auto result = std::make_shared<Result>();
+	result->all = m_checkAll;
+	result->moved = m_moved;
+	m_checkAll = false;
+	m_moved.clear();
+	m_running = true;
+	const auto clearance = m_clearance;
+	const auto generation = m_generation;
+	m_jobs.push_back(JobSystem::instance().submit([this, placed, result, clearance, generation]() mutable {
+		if (!buildMissing(placed, *result)) {
+			return;
+		}
+		std::vector<std::pair<std::uint32_t, std::uint32_t>> candidates;
+		findCandidates(placed, *result, clearance, candidates);
+		//a pair per subrange, the triangle tests of a pair run in parallel as well
+		std::vector<Contact> contacts(candidates.size());
+		JobSystem::instance().parallelFor(candidates.size(), 1, [&](std::uint64_t begin, std::uint64_t end) {
+			for (auto i = begin; i < end; ++i) {
+				const auto& a = placed[candidates[i].first];
+				const auto& b = placed[candidates[i].second];
+				Proximity proximity;
+				if (!BVH_API::findCloseTriangles(a.bvh->bvh, b.bvh->bvh, a.world.inverted() * b.world, clearance, proximity) ||
+					proximity.trianglesA.empty()) {
+					continue;
+				}
+				auto& contact = contacts[i];
+				contact.objA = a.object->getID();
+				contact.objB = b.object->getID();
+				contact.distance = proximity.distance;
+				contact.intersecting = proximity.intersecting;
+				contact.trianglesA = collectTriangles(a.bvh->bvh, proximity.trianglesA);
+				contact.trianglesB = collectTriangles(b.bvh->bvh, proximity.trianglesB);
+				contact.versionA = a.bvh->version;
+				contact.versionB = b.bvh->version;
+			}
+		});
+		if (JobSystem::cancellationRequested()) {
+			return;
+		}
+		for (auto& contact : contacts) {
+			if (nullptr != contact.trianglesA) {
+				result->contacts.push_back(std::move(contact));
+			}
+		}
+		QMetaObject::invokeMethod(this, [this, result, generation]() {
+			handleCheckFinished(result, generation);
+		}, Qt::QueuedConnection);
+	}, JobSystem::Priority::BACKGROUND, {}, m_token));
+	emit contactsUpdated(summary());
+}
+
+bool ClearanceChecker::buildMissing(std::vector<Placed>& placed, Result& result)
+{
+	std::vector<std::shared_ptr<CachedBvh>> built(placed.size());
+	JobSystem::instance().parallelFor(placed.size(), 1, [&](std::uint64_t begin, std::uint64_t end) {
+		for (auto i = begin; i < end; ++i) {
+			auto& entry = placed[i];
+			auto cached = std::make_shared<CachedBvh>();
+			MemoryTracker::LoadScope scope;
+			MappedArray<Vertex> soup;
+			cached->version = entry.object->copyVertices(soup, nullptr != entry.bvh ? &entry.bvh->version : nullptr);
+			if ((nullptr != entry.bvh && entry.bvh->version == cached->version) || soup.isEmpty()) {
+				continue;
+			}
+			MemoryTracker::LoadScope::add(soup.sizeInBytes());
+			if (!BVH_API::gatherTriangles(soup, cached->bvh)) {
+				continue;
+			}
+			MemoryTracker::LoadScope::add(-static_cast<std::int64_t>(soup.sizeInBytes()));
+			soup.release();
+			if (BVH_API::buildHierarchy(cached->bvh)) {
+				built[i] = std::move(cached);
+			}
+		}
+	});
+	if (JobSystem::cancellationRequested()) {
+		return false;
+	}
+	for (std::size_t i = 0; i < placed.size(); ++i) {
+		if (nullptr == built[i]) {
+			continue;
+		}
+		placed[i].bvh = built[i];
+		result.built.emplace_back(placed[i].object->getID(), built[i]);
+		//a new geometry is tested against all the others
+		result.moved.insert(placed[i].object->getID());
+	}
+	return true;
+}
+
+void ClearanceChecker::findCandidates(const std::vector<Placed>& placed, const Result& result, float clearance,
+	std::vector<std::pair<std::uint32_t, std::uint32_t>>& candidates)
+{
+	struct Bounds {
+		std::uint32_t index;
+		QVector3D min;
+		QVector3D max;
+		bool moved;
+	};
+	std::vector<Bounds> bounds;
+	bounds.reserve(placed.size());
+	for (std::uint32_t i = 0; i < placed.size(); ++i) {
+		const auto& entry = placed[i];
+		if (nullptr == entry.bvh || entry.bvh->bvh.nodes.empty()) {
+			continue;
+		}
+		//the root box placed on the scene, grown by the clearance
+		const auto& root = entry.bvh->bvh.nodes.front();
+		Bounds box{ i, QVector3D(1.0f, 1.0f, 1.0f) * std::numeric_limits<float>::max(), QVector3D(1.0f, 1.0f, 1.0f) * -std::numeric_limits<float>::max(),
+			result.all || result.moved.contains(entry.object->getID()) };
+		for (int bits = 0; bits < 8; ++bits) {
+			const auto corner = entry.world.map(QVector3D((bits & 1) ? root.maxBounds.x() : root.minBounds.x(),
+				(bits & 2) ? root.maxBounds.y() : root.minBounds.y(), (bits & 4) ? root.maxBounds.z() : root.minBounds.z()));
+			for (int axis = 0; axis < 3; ++axis) {
+				box.min[axis] = std::min(box.min[axis], corner[axis]);
+				box.max[axis] = std::max(box.max[axis], corner[axis]);
+			}
+		}
+		box.max += QVector3D(clearance, clearance, clearance);
+		bounds.push_back(box);
+	}
+	//sweep and prune along x, only the boxes starting before the current one ends can overlap it
+	std::sort(bounds.begin(), bounds.end(), [](const Bounds& a, const Bounds& b) { return a.min.x() < b.min.x(); });
+	for (std::size_t i = 0; i < bounds.size(); ++i) {
+		for (std::size_t j = i + 1; j < bounds.size() && bounds[j].min.x() <= bounds[i].max.x(); ++j) {
+			if (!bounds[i].moved && !bounds[j].moved) {
+				continue;
+			}
+			if (bounds[j].min.y() <= bounds[i].max.y() && bounds[i].min.y() <= bounds[j].max.y() &&
+				bounds[j].min.z() <= bounds[i].max.z() && bounds[i].min.z() <= bounds[j].max.z()) {
+				candidates.emplace_back(bounds[i].index, bounds[j].index);
+			}
+		}
+	}
+}
+
+std::shared_ptr<const std::vector<Vertex>> ClearanceChecker::collectTriangles(const TriangleBvh& bvh,
+	const std::vector<std::uint32_t>& indices)
+{
+	auto triangles = std::make_shared<std::vector<Vertex>>();
+	triangles->reserve(indices.size() * 3);
+	for (const auto index : indices) {
+		const auto& corners = bvh.triangles[index].corners;
+		const auto normal = QVector3D::normal(corners[0], corners[1], corners[2]);
+		for (const auto& corner : corners) {
+			triangles->push_back({ corner, normal, QVector2D() });
+		}
+	}
+	return triangles;
+}
+
+void ClearanceChecker::handleCheckFinished(const std::shared_ptr<Result>& result, std::uint64_t generation)
+{
+	if (generation != m_generation) {
+		return;
+	}
+	m_running = false;
+	QSet<unsigned int> present;
+	for (const auto& obj : m_objects) {
+		present.insert(obj->getID());
+	}
+	//objects removed while the check ran are left out
+	for (const auto& built : result->built) {
+		if (present.contains(built.first)) {
+			m_bvhs.insert(built.first, built.second);
+		}
+	}
+	trackMemory();
+	for (auto it = m_contacts.begin(); it != m_contacts.end();) {
+		if (result->all || result->moved.contains(it->objA) || result->moved.contains(it->objB)) {
+			it = m_contacts.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+	for (const auto& contact : result->contacts) {
+		if (present.contains(contact.objA) && present.contains(contact.objB)) {
+			m_contacts.insert(pairKey(contact.objA, contact.objB), contact);
+		}
+	}
+	updateHighlights();
+	//the objects moved meanwhile are checked next
+	startCheck();
+	emit contactsUpdated(summary());
+	emit checkFinished();
+}
+
+void ClearanceChecker::updateHighlights()
+{
+	QHash<unsigned int, std::shared_ptr<std::vector<Vertex>>> merged;
+	const auto append = [this, &merged](unsigned int objId, const std::shared_ptr<const std::vector<Vertex>>& triangles,
+		unsigned int version) {
+		//pairs tested before a reload wait for their new test, the frames would hide them anyway
+		const auto cached = m_bvhs.value(objId);
+		if (nullptr == cached || cached->version != version) {
+			return;
+		}
+		auto& target = merged[objId];
+		if (nullptr == target) {
+			target = std::make_shared<std::vector<Vertex>>();
+		}
+		target->insert(target->end(), triangles->begin(), triangles->end());
+	};
+	for (const auto& contact : m_contacts) {
+		append(contact.objA, contact.trianglesA, contact.versionA);
+		append(contact.objB, contact.trianglesB, contact.versionB);
+	}
+	m_highlights.clear();
+	for (auto it = merged.begin(); it != merged.end(); ++it) {
+		m_highlights.insert(it.key(), { it.value(), m_bvhs.value(it.key())->version });
+	}
+}
+
+void ClearanceChecker::trackMemory() const
+{
+	std::uint64_t bytes = 0;
+	for (const auto& cached : m_bvhs) {
+		bytes += cached->bvh.sizeInBytes();
+	}
+	MemoryTracker::setCacheBytes(MEMORY_CACHE, bytes);
+}
+
+void ClearanceChecker::clearContacts()
+{
+	m_token.cancel();
+	m_token = JobSystem::CancellationToken();
+	++m_generation;
+	m_running = false;
+	m_moved.clear();
+	m_checkAll = false;
+	m_contacts.clear();
+	m_highlights.clear();
+}
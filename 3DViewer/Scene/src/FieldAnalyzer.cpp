@@ -0,0 +1,358 @@
+#include <algorithm>
+
+#include "FieldAnalyzer.h"
+#include "MemoryTracker.h"
+
+namespace {
+	std::uint64_t fieldBytes(const QHash<int, std::shared_ptr<const ScalarField>>& fields)
+	{
+		std::uint64_t bytes = 0;
+		for (const auto& field : fields) {
+			bytes += field->sizeInBytes();
+		}
+		return bytes;
+	}
+}
+
+FieldAnalyzer::~FieldAnalyzer()
+{
+	stop();
+	m_fields.clear();
+	m_soup.reset();
+	m_referenceBvh.reset();
+	trackMemory();
+}
+
+void FieldAnalyzer::stop()
+{
+	//a computation in progress stops at its next cancellation point
+	cancel();
+	JobSystem::instance().wait(m_jobs);
+	m_jobs.clear();
+}
+
+void FieldAnalyzer::setKind(FieldKind kind)
+{
+	if (kind == m_kind) {
+		return;
+	}
+	m_kind = kind;
+	if (FieldKind::NONE == m_kind) {
+		//nothing to reuse them for until a field is shown again
+		m_soup.reset();
+		m_referenceBvh.reset();
+		trackMemory();
+	}
+	restart();
+}
+
+void FieldAnalyzer::setReference(const std::shared_ptr<SceneObject>& reference)
+{
+	if (reference == m_reference) {
+		return;
+	}
+	m_reference = reference;
+	if (FieldKind::DEVIATION == m_kind) {
+		restart();
+	}
+	else {
+		emit fieldUpdated(summary());
+	}
+}
+
+void FieldAnalyzer::setTarget(const std::shared_ptr<SceneObject>& target)
+{
+	if (target == m_target) {
+		return;
+	}
+	m_target = target;
+	restart();
+}
+
+void FieldAnalyzer::markChanged(unsigned int objId)
+{
+	//the deviations measured against it are outdated as well
+	m_fields.remove(objId);
+	for (auto& cached : m_fields) {
+		if (objId == cached.referenceId) {
+			cached.fields.remove(static_cast<int>(FieldKind::DEVIATION));
+		}
+	}
+	trackMemory();
+	const bool target = nullptr != m_target && objId == m_target->getID();
+	const bool reference = nullptr != m_reference && objId == m_reference->getID() && FieldKind::DEVIATION == m_kind;
+	if (target || reference) {
+		restart();
+	}
+}
+
+void FieldAnalyzer::removeObject(unsigned int objId)
+{
+	m_fields.remove(objId);
+	if (nullptr != m_soup && objId == m_soup->objId) {
+		m_soup.reset();
+	}
+	bool changed = false;
+	if (nullptr != m_target && objId == m_target->getID()) {
+		m_target.reset();
+		changed = true;
+	}
+	if (nullptr != m_reference && objId == m_reference->getID()) {
+		m_reference.reset();
+		m_referenceBvh.reset();
+		changed = true;
+	}
+	trackMemory();
+	if (changed) {
+		restart();
+	}
+}
+
+FieldAnalyzer::Field FieldAnalyzer::getField(unsigned int objId) const
+{
+	return nullptr != m_field.field && objId == m_field.objId ? m_field : Field();
+}
+
+QString FieldAnalyzer::summary() const
+{
+	if (FieldKind::NONE == m_kind) {
+		return QStringLiteral("off");
+	}
+	QString text = FIELD_API::kindName(m_kind);
+	if (nullptr == m_target || m_target->isPointCloud()) {
+		return text + QStringLiteral(", no surface selected");
+	}
+	if (FieldKind::DEVIATION == m_kind && (nullptr == m_reference || m_reference == m_target)) {
+		return text + QStringLiteral(", no reference");
+	}
+	if (m_running) {
+		return text + QStringLiteral(", computing");
+	}
+	if (nullptr == m_field.field) {
+		return text + QStringLiteral(", failed");
+	}
+	const auto& field = *m_field.field;
+	text += QStringLiteral(" %1 to %2").arg(field.lowValue, 0, 'g', 4).arg(field.highValue, 0, 'g', 4);
+	if (FieldKind::DEVIATION == m_kind) {
+		text += QStringLiteral(", max %1").arg(field.maxValue, 0, 'g', 4);
+	}
+	return text;
+}
+
+std::shared_ptr<const ScalarField> FieldAnalyzer::cachedField() const
+{
+	if (nullptr == m_target || !m_fields.contains(m_target->getID())) {
+		return nullptr;
+	}
+	const auto& cached = m_fields[m_target->getID()];
+	if (FieldKind::DEVIATION == m_kind && (nullptr == m_reference || cached.referenceId != m_reference->getID())) {
+		return nullptr;
+	}
+	return cached.fields.value(static_cast<int>(m_kind));
+}
+
+void FieldAnalyzer::restart()
+{
+	//the field shown belongs to the previous state, the new one replaces it once ready
+	cancel();
+	m_field = Field();
+	const auto cached = cachedField();
+	if (nullptr != cached && FieldKind::NONE != m_kind) {
+		m_field.field = cached;
+		m_field.objId = m_target->getID();
+		auto& entry = m_fields[m_field.objId];
+		m_field.version = entry.version;
+		entry.lastUsed = ++m_fieldUses;
+	}
+	else {
+		startComputation();
+	}
+	emit fieldUpdated(summary());
+	emit fieldReady();
+}
+
+void FieldAnalyzer::startComputation()
+{
+	if (FieldKind::NONE == m_kind || nullptr == m_target || m_target->isPointCloud()) {
+		return;
+	}
+	std::shared_ptr<SceneObject> reference;
+	if (FieldKind::DEVIATION == m_kind) {
+		if (nullptr == m_reference || m_reference == m_target || m_reference->isPointCloud()) {
+			return;
+		}
+		reference = m_reference;
+	}
+	m_jobs.erase(std::remove_if(m_jobs.begin(), m_jobs.end(),
+		[](const JobSystem::JobHandle& job) { return job->isFinished(); }), m_jobs.end());
+	m_running = true;
+	const auto target = m_target;
+	const auto kind = m_kind;
+	const auto cached_soup = nullptr != m_soup && m_soup->objId == target->getID() ? m_soup : nullptr;
+	const auto cached_bvh = nullptr != reference && nullptr != m_referenceBvh && m_referenceBvh->objId == reference->getID() ?
+		m_referenceBvh : nullptr;
+	const auto generation = m_generation;
+	m_jobs.push_back(JobSystem::instance().submit([this, target, reference, kind, cached_soup, cached_bvh, generation]() {
+		auto result = std::make_shared<Result>();
+		result->field.objId = target->getID();
+		result->soup = prepareSoup(*target, cached_soup);
+		if (nullptr != reference && nullptr != result->soup) {
+			result->bvh = prepareBvh(*reference, cached_bvh);
+		}
+		auto field = std::make_shared<ScalarField>();
+		bool computed = false;
+		if (nullptr != result->soup && (nullptr == reference || nullptr != result->bvh)) {
+			const auto& welded = result->soup->welded;
+			switch (kind) {
+			case FieldKind::CURVATURE:
+				computed = FIELD_API::computeCurvature(welded, *field);
+				break;
+			case FieldKind::ASPECT_RATIO:
+				computed = FIELD_API::computeAspectRatio(welded, *field);
+				break;
+			case FieldKind::EDGE_LENGTH:
+				computed = FIELD_API::computeEdgeLength(welded, *field);
+				break;
+			case FieldKind::DEVIATION:
+				computed = FIELD_API::computeDeviation(welded, result->bvh->bvh, *field);
+				break;
+			default:
+				break;
+			}
+		}
+		if (JobSystem::cancellationRequested()) {
+			return;
+		}
+		//a failure is reported as well, the status would read computing otherwise
+		if (computed) {
+			result->field.field = std::move(field);
+			result->field.version = result->soup->version;
+		}
+		QMetaObject::invokeMethod(this, [this, result, generation]() {
+			handleFinished(result, generation);
+		}, Qt::QueuedConnection);
+	}, JobSystem::Priority::BACKGROUND, {}, m_token));
+}
+
+std::shared_ptr<const FieldAnalyzer::CachedSoup> FieldAnalyzer::prepareSoup(SceneObject& obj,
+	const std::shared_ptr<const CachedSoup>& cached)
+{
+	auto soup = std::make_shared<CachedSoup>();
+	soup->objId = obj.getID();
+	MemoryTracker::LoadScope scope;
+	MappedArray<Vertex> copy;
+	soup->version = obj.copyVertices(copy, nullptr != cached ? &cached->version : nullptr);
+	if (nullptr != cached && cached->version == soup->version) {
+		return cached;
+	}
+	if (copy.isEmpty()) {
+		return nullptr;
+	}
+	MemoryTracker::LoadScope::add(copy.sizeInBytes());
+	if (!FIELD_API::gatherCorners(copy, soup->welded)) {
+		return nullptr;
+	}
+	MemoryTracker::LoadScope::add(-static_cast<std::int64_t>(copy.sizeInBytes()));
+	copy.release();
+	return FIELD_API::weldCorners(soup->welded) ? soup : nullptr;
+}
+
+std::shared_ptr<const FieldAnalyzer::CachedBvh> FieldAnalyzer::prepareBvh(SceneObject& obj,
+	const std::shared_ptr<const CachedBvh>& cached)
+{
+	auto bvh = std::make_shared<CachedBvh>();
+	bvh->objId = obj.getID();
+	MemoryTracker::LoadScope scope;
+	MappedArray<Vertex> copy;
+	bvh->version = obj.copyVertices(copy, nullptr != cached ? &cached->version : nullptr);
+	if (nullptr != cached && cached->version == bvh->version) {
+		return cached;
+	}
+	if (copy.isEmpty()) {
+		return nullptr;
+	}
+	MemoryTracker::LoadScope::add(copy.sizeInBytes());
+	if (!BVH_API::gatherTriangles(copy, bvh->bvh)) {
+		return nullptr;
+	}
+	MemoryTracker::LoadScope::add(-static_cast<std::int64_t>(copy.sizeInBytes()));
+	copy.release();
+	return BVH_API::buildHierarchy(bvh->bvh) ? bvh : nullptr;
+}
+
+void FieldAnalyzer::handleFinished(const std::shared_ptr<Result>& result, std::uint64_t generation)
+{
+	if (generation != m_generation) {
+		return;
+	}
+	m_running = false;
+	//kept for the next field of the same geometry unless they would take more than the geometry is worth
+	if (nullptr != result->soup) {
+		m_soup = result->soup->welded.sizeInBytes() <= SOUP_CACHE_BYTES ? result->soup : nullptr;
+	}
+	if (nullptr != result->bvh) {
+		m_referenceBvh = result->bvh->bvh.sizeInBytes() <= SOUP_CACHE_BYTES ? result->bvh : nullptr;
+	}
+	m_field = result->field;
+	if (nullptr != m_field.field) {
+		auto& cached = m_fields[m_field.objId];
+		if (cached.version != m_field.version) {
+			cached = CachedFields();
+			cached.version = m_field.version;
+		}
+		if (FieldKind::DEVIATION == m_field.field->kind) {
+			cached.referenceId = result->bvh->objId;
+		}
+		cached.fields.insert(static_cast<int>(m_field.field->kind), m_field.field);
+		cached.lastUsed = ++m_fieldUses;
+		trimFields();
+	}
+	trackMemory();
+	emit fieldUpdated(summary());
+	emit fieldReady();
+}
+
+void FieldAnalyzer::cancel()
+{
+	m_token.cancel();
+	m_token = JobSystem::CancellationToken();
+	++m_generation;
+	m_running = false;
+}
+
+void FieldAnalyzer::trimFields()
+{
+	std::uint64_t bytes = 0;
+	for (const auto& cached : m_fields) {
+		bytes += fieldBytes(cached.fields);
+	}
+	while (bytes > FIELD_CACHE_BYTES) {
+		//the fields of the object shown stay
+		auto oldest = m_fields.end();
+		for (auto it = m_fields.begin(); it != m_fields.end(); ++it) {
+			if (it.key() != m_field.objId && (m_fields.end() == oldest || it->lastUsed < oldest->lastUsed)) {
+				oldest = it;
+			}
+		}
+		if (m_fields.end() == oldest) {
+			break;
+		}
+		bytes -= fieldBytes(oldest->fields);
+		m_fields.erase(oldest);
+	}
+}
+
+void FieldAnalyzer::trackMemory() const
+{
+	std::uint64_t bytes = 0;
+	for (const auto& cached : m_fields) {
+		bytes += fieldBytes(cached.fields);
+	}
+	if (nullptr != m_soup) {
+		bytes += m_soup->welded.sizeInBytes();
+	}
+	if (nullptr != m_referenceBvh) {
+		bytes += m_referenceBvh->bvh.sizeInBytes();
+	}
+	MemoryTracker::setCacheBytes(MEMORY_CACHE, bytes);
+}
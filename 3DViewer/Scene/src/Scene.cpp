@@ -1,18 +1,121 @@
 #include "Scene.h"
+#include "JobSystem.h"
 
 void Scene::addObjectOnScene(const std::shared_ptr<SceneObject>& obj)
 {
 	m_sceneObjectsLst.push_back(obj);
 	m_currentSelection = obj;
+	if (obj->needsProxy()) {
+		JobSystem::instance().submit([obj]() { obj->buildProxy(); }, JobSystem::Priority::BACKGROUND);
+	}
+	m_clearanceChecker.setObjects(m_sceneObjectsLst);
+	m_clearanceChecker.markMoved(obj->getID());
+	m_fieldAnalyzer.setTarget(obj);
+}
+
+void Scene::handleGeometrySwapped(unsigned int objId)
+{
+	//dropped from the next snapshot, unless a newer reload took its place meanwhile
+	const auto pending = m_pendingGeometry.value(objId);
+	if (nullptr != pending && SceneObject::UploadState::RELEASED == pending->getUploadState()) {
+		m_pendingGeometry.remove(objId);
+	}
+	const auto obj = getObjectByID(objId);
+	if (nullptr == obj) {
+		return;
+	}
+	bool needs_proxy = false;
+	{
+		const auto lock = obj->lockGeometry();
+		needs_proxy = obj->needsProxy();
+	}
+	//the proxy of the old geometry was dropped with it
+	if (needs_proxy) {
+		JobSystem::instance().submit([obj]() { obj->buildProxy(); }, JobSystem::Priority::BACKGROUND);
+	}
+	if (obj == m_currentSelection) {
+		updateObjDetails(obj);
+	}
+	//the hierarchy of the old geometry is rebuilt by the next check
+	m_clearanceChecker.markMoved(objId);
+	m_fieldAnalyzer.markChanged(objId);
+}
+
+void Scene::setPendingGeometry(unsigned int objId, const std::shared_ptr<SceneObject>& pending)
+{
+	//the replaced one is released by the render thread once it is gone from the snapshots
+	m_pendingGeometry.insert(objId, pending);
+	emit redrawRenderer();
+}
+
+void Scene::handleObjectMoved(unsigned int objId)
+{
+	m_clearanceChecker.markMoved(objId);
+}
+
+void Scene::setClearanceCheck(bool enabled)
+{
+	m_clearanceChecker.setEnabled(enabled);
+}
+
+void Scene::setClearance(float clearance)
+{
+	m_clearanceChecker.setClearance(clearance);
+}
+
+void Scene::setFieldKind(FieldKind kind)
+{
+	m_fieldAnalyzer.setKind(kind);
+}
+
+void Scene::setFieldReference(unsigned int objId)
+{
+	m_fieldAnalyzer.setReference(getObjectByID(objId));
+}
+
+void Scene::fillSnapshot(SceneSnapshot& snapshot) const
+{
+	snapshot.objects.clear();
+	snapshot.current = -1;
+	for (const auto& obj : m_sceneObjectsLst) {
+		if (obj == m_currentSelection) {
+			snapshot.current = static_cast<int>(snapshot.objects.size());
+		}
+		SceneSnapshot::Object entry;
+		entry.object = obj;
+		entry.pending = m_pendingGeometry.value(obj->getID());
+		entry.model.translate(obj->getTranslationVec());
+		entry.model.rotate(obj->getRotationQuart());
+		entry.visible = Qt::CheckState::Checked == obj->isVisible();
+		const auto highlight = m_clearanceChecker.getHighlight(obj->getID());
+		entry.contacts = highlight.triangles;
+		entry.contactsVersion = highlight.version;
+		const auto field = m_fieldAnalyzer.getField(obj->getID());
+		entry.field = field.field;
+		entry.fieldVersion = field.version;
+		snapshot.objects.push_back(std::move(entry));
+	}
+	snapshot.material.objectColor = m_currentMaterial.objectColor;
+	snapshot.material.ambientStrength = m_currentMaterial.ambientStrength;
+	snapshot.material.specularStrength = m_currentMaterial.specularStrength;
+	snapshot.material.shininess = m_currentMaterial.shininess;
 }
 
 Scene::Scene() : m_sceneObjectsLst{ }, m_currentSelection{ nullptr }
 {
 	createMaterials();
+	connect(&m_clearanceChecker, &ClearanceChecker::contactsUpdated, this, &Scene::clearanceUpdated);
+	connect(&m_clearanceChecker, &ClearanceChecker::checkFinished, this, &Scene::redrawRenderer);
+	connect(&m_fieldAnalyzer, &FieldAnalyzer::fieldUpdated, this, &Scene::fieldUpdated);
+	connect(&m_fieldAnalyzer, &FieldAnalyzer::fieldReady, this, &Scene::redrawRenderer);
 }
 
 Scene::~Scene()
 {
+	//the checks read the vertices of the objects
+	m_clearanceChecker.stop();
+	m_fieldAnalyzer.stop();
+	//the render thread has stopped with the renderer, objects still held by it were released there
 	for (const auto& obj : m_sceneObjectsLst) {
 		obj->release();
 	}
@@ -23,7 +126,13 @@ void Scene::handleSceneItemChanged(QListWidgetItem* current, QListWidgetItem* pr
 	if (nullptr != current) {
 		auto current_id = current->data(Qt::UserRole);
 		m_currentSelection = std::move(getObjectByID(current_id.toUInt()));
-        emit updateCamera(m_currentSelection->getBoundingBoxLength());
+		m_fieldAnalyzer.setTarget(m_currentSelection);
+		float bb_length = 0.0f;
+		{
+			const auto lock = m_currentSelection->lockGeometry();
+			bb_length = m_currentSelection->getBoundingBoxLength();
+		}
+        emit updateCamera(bb_length);
         emit redrawRenderer();
 	}
 }
@@ -38,9 +147,14 @@ std::shared_ptr<SceneObject> Scene::getObjectByID(unsigned int id) const
 	return nullptr;
 }
 
+Scene::MaterialProperties Scene::defaultMaterial()
+{
+	return MaterialProperties("Metal", QVector3D(0.6f, 0.6f, 0.6f), 0.2f, 0.5f, 128.0f);
+}
+
 void Scene::createMaterials()
 {
-	MaterialProperties metal_material = MaterialProperties("Metal", QVector3D(0.6f, 0.6f, 0.6f), 0.2f, 0.5f, 128.0f);
+	MaterialProperties metal_material = defaultMaterial();
 	MaterialProperties  bone_material = MaterialProperties("Skelet", QVector3D(0.9f, 0.85f, 0.7f), 0.1f, 0.1f, 32.0f);
 	m_sceneMaterialsLst.push_back(bone_material);
 	m_sceneMaterialsLst.push_back(metal_material);
@@ -54,12 +168,16 @@ void Scene::removeCurrentObjSelection()
 	if (nullptr == current_obj) {
 		return;
 	}
-	current_obj->release();
+	//its GPU buffers are released by the render thread, which may still draw it
+	m_pendingGeometry.remove(current_obj->getID());
 	auto founded_it = std::find(m_sceneObjectsLst.begin(), m_sceneObjectsLst.end(), current_obj);
 	if (founded_it != m_sceneObjectsLst.end()) {
 		m_sceneObjectsLst.erase(founded_it);
 		m_currentSelection.reset();
 	}
+	m_clearanceChecker.setObjects(m_sceneObjectsLst);
+	m_clearanceChecker.removeObject(current_obj->getID());
+	m_fieldAnalyzer.removeObject(current_obj->getID());
 }
 
 void Scene::setCurrentObjVisibility(int state)
@@ -86,23 +204,67 @@ void Scene::setCurrentMaterial(const QString& str)
 void Scene::updateObjDetails(const std::shared_ptr<SceneObject>& obj) const
 {
 	if (nullptr != obj) {
-		emit nameUpdated(obj->getName());
-		emit verticesUpdated(QString::number(obj->getNumberOfVertices()));
-		emit facesUpdated(QString::number(obj->getNumberOfFaces()));
-		emit edgesUpdated(QString::number(obj->getNumberOfEdges()));
-		emit IdUpdated(QString::number(obj->getID()));
-		emit widthUpdated(QString::number(obj->getWidth(), 'f', 2) + " cm");
-		emit heightUpdated(QString::number(obj->getHeight(), 'f', 2) + " cm");
-		emit lengthUpdated(QString::number(obj->getLength(), 'f', 2) + " cm");
+		emitDetail(NAME, &Scene::nameUpdated, obj->getName());
+		emitDetail(ID, &Scene::IdUpdated, QString::number(obj->getID()));
+		//a background job holding the geometry never stalls the input, the details shown stay meanwhile
+		const auto lock = obj->tryLockGeometry();
+		if (lock.owns_lock()) {
+			emitDetail(VERTICES, &Scene::verticesUpdated, QString::number(obj->getNumberOfVertices()));
+			emitDetail(FACES, &Scene::facesUpdated, QString::number(obj->getNumberOfFaces()));
+			emitDetail(EDGES, &Scene::edgesUpdated, QString::number(obj->getNumberOfEdges()));
+			emitDetail(WIDTH, &Scene::widthUpdated, QString::number(obj->getWidth(), 'f', 2) + " cm");
+			emitDetail(HEIGHT, &Scene::heightUpdated, QString::number(obj->getHeight(), 'f', 2) + " cm");
+			emitDetail(LENGTH, &Scene::lengthUpdated, QString::number(obj->getLength(), 'f', 2) + " cm");
+			m_detailsObjId = obj->getID();
+		}
+		else if (m_detailsObjId != obj->getID()) {
+			//details of another object are not shown for this one, the next update fills them in
+			emitDetail(VERTICES, &Scene::verticesUpdated, "...");
+			emitDetail(FACES, &Scene::facesUpdated, "...");
+			emitDetail(EDGES, &Scene::edgesUpdated, "...");
+			emitDetail(WIDTH, &Scene::widthUpdated, "...");
+			emitDetail(HEIGHT, &Scene::heightUpdated, "...");
+			emitDetail(LENGTH, &Scene::lengthUpdated, "...");
+		}
 	}
 	else {
-		emit nameUpdated("Unknown");
-		emit verticesUpdated("0");
-		emit facesUpdated("0");
-		emit edgesUpdated("0");
-		emit IdUpdated("N/A");
-		emit widthUpdated("0.0");
-		emit heightUpdated("0.0");
-		emit lengthUpdated("0.0");
+		emitDetail(NAME, &Scene::nameUpdated, "Unknown");
+		emitDetail(VERTICES, &Scene::verticesUpdated, "0");
+		emitDetail(FACES, &Scene::facesUpdated, "0");
+		emitDetail(EDGES, &Scene::edgesUpdated, "0");
+		emitDetail(ID, &Scene::IdUpdated, "N/A");
+		emitDetail(WIDTH, &Scene::widthUpdated, "0.0");
+		emitDetail(HEIGHT, &Scene::heightUpdated, "0.0");
+		emitDetail(LENGTH, &Scene::lengthUpdated, "0.0");
+		m_detailsObjId = 0;
+	}
+	updateMemoryDetails();
+}
+
+void Scene::updateMemoryDetails() const
+{
+	if (nullptr == m_currentSelection) {
+		emitDetail(CPU_MEMORY, &Scene::cpuMemoryUpdated, "0");
+		emitDetail(GPU_MEMORY, &Scene::gpuMemoryUpdated, "0");
+		emitDetail(LOAD_PEAK, &Scene::loadPeakUpdated, "0");
+		return;
+	}
+	const auto usage = MemoryTracker::getObjectUsage(m_currentSelection->getID());
+	const auto cpu_bytes = usage.bytes[static_cast<int>(MemoryTracker::Category::CPU_GEOMETRY)];
+	const auto cache_bytes = usage.bytes[static_cast<int>(MemoryTracker::Category::CACHES)];
+	emitDetail(CPU_MEMORY, &Scene::cpuMemoryUpdated, 0 != cache_bytes ?
+		MemoryTracker::formatBytes(cache_bytes) + " mapped" : MemoryTracker::formatBytes(cpu_bytes));
+	emitDetail(GPU_MEMORY, &Scene::gpuMemoryUpdated,
+		MemoryTracker::formatBytes(usage.bytes[static_cast<int>(MemoryTracker::Category::GPU_BUFFERS)]));
+	emitDetail(LOAD_PEAK, &Scene::loadPeakUpdated, MemoryTracker::formatBytes(usage.loadPeak));
+}
+
+void Scene::emitDetail(Detail detail, void (Scene::*signal)(QString) const, const QString& text) const
+{
+	//labels are relaid out on every setText, skip the unchanged ones
+	if (!m_shownDetails[detail].isNull() && m_shownDetails[detail] == text) {
+		return;
 	}
+	m_shownDetails[detail] = text;
+	emit (this->*signal)(text);
 }
\ No newline at end of file
@@ -1,48 +1,276 @@
 #include "SceneObject.h"
-#include "OpenGLRenderer.h"
+#include "FrameRenderer.h"
+#include "GpuUploader.h"
 
 unsigned int SceneObject::m_idCounter = 0;
 
 SceneObject::SceneObject(
-    const QString& filepath, const QString& name, const QVector<Vertex>& vertices,
-	unsigned int vertices_count, unsigned int faces_count, unsigned int edges_count
+    const QString& filepath, const QString& name, MappedArray<Vertex>&& vertices,
+	std::uint64_t vertices_count, std::uint64_t faces_count, std::uint64_t edges_count
 ) :
 	m_filepath(filepath), m_name(name), m_num_vertices(vertices_count), 
-    m_num_faces(faces_count), m_num_edges(edges_count), vertices(vertices), 
+    m_num_faces(faces_count), m_num_edges(edges_count), vertices(std::move(vertices)), 
     m_objID(++m_idCounter),	m_buffersInited(false), m_isVisible(Qt::CheckState::Checked)
 {
     calculateBoundingBox();
+    m_translationVec = -m_center; //move obj to center coordinate system
+    trackMemory();
 }
 
-void SceneObject::draw(OpenGLRenderer* renderer)
+SceneObject::SceneObject(
+    const QString& filepath, const QString& name, MappedArray<Vertex>&& vertices,
+    std::uint64_t vertices_count, std::uint64_t faces_count, std::uint64_t edges_count,
+    const QVector3D& minBounds, const QVector3D& maxBounds
+) :
+    m_filepath(filepath), m_name(name), m_num_vertices(vertices_count),
+    m_num_faces(faces_count), m_num_edges(edges_count), vertices(std::move(vertices)),
+    m_objID(++m_idCounter), m_buffersInited(false), m_isVisible(Qt::CheckState::Checked)
+{
+    setBoundingBox(minBounds, maxBounds);
+    m_translationVec = -m_center;
+    trackMemory();
+}
+
+SceneObject::SceneObject(const QString& filepath, const QString& name, std::unique_ptr<PointCloud>&& cloud) :
+    m_filepath(filepath), m_name(name), m_num_vertices(cloud->points.size()),
+    m_num_faces(0), m_num_edges(0), pointCloud(std::move(cloud)),
+    m_objID(++m_idCounter), m_buffersInited(false), m_isVisible(Qt::CheckState::Checked)
+{
+    setBoundingBox(pointCloud->minBounds, pointCloud->maxBounds);
+    m_translationVec = -m_center;
+    trackMemory();
+}
+
+SceneObject::~SceneObject()
+{
+    if (0 != m_objID) {
+        MemoryTracker::removeObject(m_objID);
+    }
+}
+
+void SceneObject::trackMemory()
+{
+    //mapped workspace and cache files are backed by the page cache, not by the heap
+    MemoryTracker::setObjectBytes(m_objID, m_name,
+        vertices.isFileView() ? MemoryTracker::Category::CACHES : MemoryTracker::Category::CPU_GEOMETRY,
+        vertices.sizeInBytes() + (isPointCloud() ? pointCloud->sizeInBytes() : 0));
+}
+
+std::shared_ptr<SceneObject> SceneObject::makeObject(const QFileInfo& fileInfo, const std::unique_ptr<IndexedMesh>& mesh)
+{
+    if (nullptr == mesh) {
+        return nullptr;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    qDebug() << "Message: scene object creation has been started";
+    MappedArray<Vertex> vertices;
+    if (!MESH_API::buildTriangleSoup(*mesh, vertices)) {
+        return nullptr;
+    }
+    MemoryTracker::LoadScope::add(vertices.sizeInBytes());
+    qDebug() << "Message: scene object creation took" <<
+        static_cast<double>(timer.nsecsElapsed()) / 1000000000.0 << "sec to execute";
+
+    return std::make_shared<SceneObject>(
+        fileInfo.absoluteFilePath(),
+        fileInfo.baseName(),
+        std::move(vertices),
+        mesh->num_vertices,
+        mesh->num_faces,
+        mesh->num_edges
+    );
+}
+
+void SceneObject::draw(FrameRenderer* renderer)
 {
     renderer->drawObject(*this);
 }
 
-void SceneObject::intializeBuffers(OpenGLRenderer* renderer)
+void SceneObject::intializeBuffers(FrameRenderer* renderer)
 {
     renderer->initObjectBuffers(*this);
 }
 
 void SceneObject::release()
 {
-    vbo.destroy();
-    vao.destroy();
+    const auto previous = m_uploadState.exchange(UploadState::RELEASED);
+    //buffers in flight belong to the upload thread, it retires them itself
+    if (UploadState::FENCED == previous || UploadState::READY == previous) {
+        GpuUploader::retire(std::move(bufferChunks), m_uploadFence);
+        bufferChunks.clear();
+        drawClusters.clear();
+        m_uploadFence = nullptr;
+        MemoryTracker::setObjectBytes(m_objID, QString(), MemoryTracker::Category::GPU_BUFFERS, 0);
+    }
+    //a proxy job still running finds the state changed and drops its result
+    if (ProxyState::READY == m_proxyState.exchange(ProxyState::RELEASED)) {
+        std::vector<BufferChunk> proxy;
+        proxy.push_back(std::move(proxyChunk));
+        GpuUploader::retire(std::move(proxy));
+    }
+    m_buffersInited = false;
 }
 
-void SceneObject::calculateBoundingBox()
+unsigned int SceneObject::copyVertices(MappedArray<Vertex>& copy, const unsigned int* upToDate) const
 {
-    QVector3D minBounds = QVector3D(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
-    QVector3D maxBounds = QVector3D(-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max());
-    for (const auto& vertex : vertices) {
-        minBounds.setX(std::min(minBounds.x(), vertex.position.x()));
-        minBounds.setY(std::min(minBounds.y(), vertex.position.y()));
-        minBounds.setZ(std::min(minBounds.z(), vertex.position.z()));
+    const auto lock = lockGeometry();
+    if (nullptr == upToDate || *upToDate != m_geometryVersion) {
+        copy.copyFrom(vertices);
+    }
+    return m_geometryVersion;
+}
+
+bool SceneObject::swapGeometry(SceneObject& pending)
+{
+    //never waits, an export or a workspace save of the GUI thread delays the swap instead
+    std::unique_lock<std::mutex> lock(m_geometryMutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return false;
+    }
+    const auto pending_state = pending.m_uploadState.load();
+    if (UploadState::NONE != pending_state && UploadState::READY != pending_state) {
+        return false;
+    }
+    //the state change stops queued uploads, a running one still reads the vertices
+    auto upload_state = m_uploadState.load();
+    do {
+        if (UploadState::UPLOADING == upload_state) {
+            return false;
+        }
+    } while (!m_uploadState.compare_exchange_weak(upload_state, UploadState::RELEASED));
+    auto proxy_state = m_proxyState.load();
+    do {
+        if (ProxyState::BUILDING == proxy_state) {
+            //dropped queued uploads are enqueued again by the renderer
+            m_uploadState.store(UploadState::QUEUED == upload_state ? UploadState::NONE : upload_state);
+            return false;
+        }
+    } while (!m_proxyState.compare_exchange_weak(proxy_state, ProxyState::RELEASED));
+
+    //the old buffers are retired only now, the new ones take their place in the same frame
+    GpuUploader::retire(std::move(bufferChunks), UploadState::FENCED == upload_state ? m_uploadFence : nullptr);
+    bufferChunks.clear();
+    if (ProxyState::READY == proxy_state) {
+        std::vector<BufferChunk> proxy;
+        proxy.push_back(std::move(proxyChunk));
+        GpuUploader::retire(std::move(proxy));
+    }
+    proxyChunk = BufferChunk();
+    proxyVertices.release();
 
-        maxBounds.setX(std::max(maxBounds.x(), vertex.position.x()));
-        maxBounds.setY(std::max(maxBounds.y(), vertex.position.y()));
-        maxBounds.setZ(std::max(maxBounds.z(), vertex.position.z()));
+    std::uint64_t gpu_bytes = 0;
+    for (const auto& chunk : pending.bufferChunks) {
+        gpu_bytes += chunk.vertexCount * sizeof(Vertex);
     }
+    bufferChunks.swap(pending.bufferChunks);
+    drawClusters.swap(pending.drawClusters);
+    pending.drawClusters.clear();
+    materials.swap(pending.materials);
+    materialRanges.swap(pending.materialRanges);
+    vertices = std::move(pending.vertices);
+    pointCloud = std::move(pending.pointCloud);
+    m_num_vertices = pending.m_num_vertices;
+    m_num_faces = pending.m_num_faces;
+    m_num_edges = pending.m_num_edges;
+    setBoundingBox(pending.m_minBounds, pending.m_maxBounds);
+    m_uploadFence = nullptr;
+    m_buffersInited = UploadState::READY == pending_state;
+    pending.m_uploadState.store(UploadState::RELEASED);
+    m_proxyState.store(ProxyState::NONE);
+    m_uploadState.store(UploadState::READY == pending_state ? UploadState::READY : UploadState::NONE);
+    ++m_geometryVersion;
+
+    trackMemory();
+    MemoryTracker::setObjectBytes(m_objID, QString(), MemoryTracker::Category::GPU_BUFFERS, gpu_bytes);
+    return true;
+}
+
+void SceneObject::buildProxy()
+{
+    auto expected = ProxyState::NONE;
+    if (!m_proxyState.compare_exchange_strong(expected, ProxyState::BUILDING)) {
+        return;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    MappedArray<Vertex> proxy;
+    if (!MESH_API::buildClusteredProxy(vertices, m_minBounds, m_maxBounds, PROXY_TRIANGLE_BUDGET, proxy)) {
+        qCritical() << "Critical: cannot build the interaction proxy of" << m_name;
+        expected = ProxyState::BUILDING;
+        m_proxyState.compare_exchange_strong(expected, ProxyState::NONE);
+        return;
+    }
+    proxyVertices = std::move(proxy);
+    expected = ProxyState::BUILDING;
+    if (!m_proxyState.compare_exchange_strong(expected, ProxyState::BUILT)) {
+        return;
+    }
+    qDebug() << "Message: proxy of" << proxyVertices.size() / 3 << "triangles took" <<
+        static_cast<double>(timer.nsecsElapsed()) / 1000000000.0 << "sec to build";
+}
+
+void SceneObject::markProxyReady()
+{
+    MemoryTracker::setObjectBytes(m_objID, QString(), MemoryTracker::Category::GPU_BUFFERS,
+        vertices.size() * sizeof(Vertex) + proxyChunk.vertexCount * sizeof(Vertex));
+    proxyVertices.release();
+    m_proxyState.store(ProxyState::READY);
+}
+
+bool SceneObject::queueUpload()
+{
+    auto expected = UploadState::NONE;
+    return m_uploadState.compare_exchange_strong(expected, UploadState::QUEUED);
+}
+
+bool SceneObject::beginUpload()
+{
+    auto expected = UploadState::QUEUED;
+    return m_uploadState.compare_exchange_strong(expected, UploadState::UPLOADING);
+}
+
+bool SceneObject::finishUpload(std::vector<BufferChunk>& chunks, std::vector<DrawCluster>& clusters, GLsync fence)
+{
+    std::uint64_t gpu_bytes = 0;
+    for (const auto& chunk : chunks) {
+        gpu_bytes += chunk.vertexCount * sizeof(Vertex);
+    }
+    //accounted before publishing, release after the state change sets it back to zero
+    MemoryTracker::setObjectBytes(m_objID, QString(), MemoryTracker::Category::GPU_BUFFERS, gpu_bytes);
+    //chunks and fence are published by the state change
+    bufferChunks.swap(chunks);
+    drawClusters.swap(clusters);
+    m_uploadFence = fence;
+    auto expected = UploadState::UPLOADING;
+    if (m_uploadState.compare_exchange_strong(expected, UploadState::FENCED)) {
+        return true;
+    }
+    bufferChunks.swap(chunks);
+    drawClusters.swap(clusters);
+    m_uploadFence = nullptr;
+    MemoryTracker::setObjectBytes(m_objID, QString(), MemoryTracker::Category::GPU_BUFFERS, 0);
+    return false;
+}
+
+void SceneObject::markBuffersReady()
+{
+    m_uploadFence = nullptr;
+    m_buffersInited = true;
+    m_uploadState.store(UploadState::READY);
+}
+
+void SceneObject::calculateBoundingBox()
+{
+    QVector3D minBounds, maxBounds;
+    MESH_API::computeBounds(vertices, minBounds, maxBounds);
+    setBoundingBox(minBounds, maxBounds);
+}
+
+void SceneObject::setBoundingBox(const QVector3D& minBounds, const QVector3D& maxBounds)
+{
+    m_minBounds         = minBounds;
+    m_maxBounds         = maxBounds;
     //converting to cm
     m_length            = (maxBounds.x() - minBounds.x()) * 100.0f;
     m_width             = (maxBounds.y() - minBounds.y()) * 100.0f;
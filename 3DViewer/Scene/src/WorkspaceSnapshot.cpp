@@ -0,0 +1,219 @@
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+#include <cstring>
+
+#include "WorkspaceSnapshot.h"
+#include "JobSystem.h"
+
+namespace {
+    constexpr char SNAPSHOT_MAGIC[8] = { '3', 'D', 'V', 'W', 'K', 'S', 'P', '\0' };
+    constexpr qint64 WRITE_BLOCK_SIZE = 64 * 1024 * 1024;
+    constexpr std::uint64_t PAGE_SIZE = 4096;
+
+    QJsonArray toJson(const QVector3D& vec)
+    {
+        return { vec.x(), vec.y(), vec.z() };
+    }
+
+    QVector3D vec3FromJson(const QJsonValue& value)
+    {
+        const auto array = value.toArray();
+        return QVector3D(array[0].toDouble(), array[1].toDouble(), array[2].toDouble());
+    }
+
+    bool writeBlock(QSaveFile& file, const char* data, std::uint64_t size)
+    {
+        while (size > 0) {
+            const auto block = std::min<std::uint64_t>(size, WRITE_BLOCK_SIZE);
+            if (file.write(data, static_cast<qint64>(block)) != static_cast<qint64>(block)) {
+                return false;
+            }
+            data += block;
+            size -= block;
+        }
+        return true;
+    }
+}
+
+bool WorkspaceSnapshot::save(const QString& path, const Scene& scene, const CameraState& camera)
+{
+    return save(path, *capture(scene, camera));
+}
+
+std::unique_ptr<WorkspaceSnapshot::Workspace> WorkspaceSnapshot::capture(const Scene& scene, const CameraState& camera)
+{
+    auto workspace = std::make_unique<Workspace>();
+    workspace->objects = scene.getObjectsLst();
+    workspace->currentIndex = workspace->objects.indexOf(scene.getCurrentObjSelection());
+    workspace->materialName = scene.getCurrentMaterial().name;
+    workspace->camera = camera;
+    return workspace;
+}
+
+bool WorkspaceSnapshot::save(const QString& path, const Workspace& workspace)
+{
+    QElapsedTimer timer;
+    timer.start();
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCritical() << "Critical: cannot open workspace file " << path;
+        return false;
+    }
+    Header header;
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.vertexSize = sizeof(Vertex);
+    header.tableOffset = 0;
+    header.tableSize = 0;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    QJsonArray objects;
+    int current_index = -1;
+    for (int i = 0; i < workspace.objects.size(); ++i) {
+        const auto& obj = workspace.objects[i];
+        //a reload is not swapped in by the render thread while the object is written
+        const auto lock = obj->lockGeometry();
+        if (obj->isPointCloud()) {
+            //the octree order is rebuilt from the source file, only the soups are stored
+            qDebug() << "Message: point cloud is not stored in the workspace:" << obj->getFilePath();
+            continue;
+        }
+        //page aligned blobs can be mapped and uploaded directly
+        const auto offset = (static_cast<std::uint64_t>(file.pos()) + BLOB_ALIGNMENT - 1) / BLOB_ALIGNMENT * BLOB_ALIGNMENT;
+        const QByteArray padding(static_cast<int>(offset - static_cast<std::uint64_t>(file.pos())), '\0');
+        if (file.write(padding) != padding.size() ||
+            !writeBlock(file, reinterpret_cast<const char*>(obj->vertices.data()), obj->vertices.sizeInBytes())) {
+            qCritical() << "Critical: cannot write workspace file " << path;
+            file.cancelWriting();
+            return false;
+        }
+        if (i == workspace.currentIndex) {
+            current_index = objects.size();
+        }
+        const auto rotation = obj->getRotationQuart();
+        objects.append(QJsonObject{
+            { "name",         obj->getName() },
+            { "filePath",     obj->getFilePath() },
+            { "visible",      obj->isVisible() },
+            { "translation",  toJson(obj->getTranslationVec()) },
+            { "rotation",     QJsonArray{ rotation.scalar(), rotation.x(), rotation.y(), rotation.z() } },
+            { "minBounds",    toJson(obj->getMinBounds()) },
+            { "maxBounds",    toJson(obj->getMaxBounds()) },
+            { "numVertices",  static_cast<qint64>(obj->getNumberOfVertices()) },
+            { "numFaces",     static_cast<qint64>(obj->getNumberOfFaces()) },
+            { "numEdges",     static_cast<qint64>(obj->getNumberOfEdges()) },
+            { "vertexOffset", static_cast<qint64>(offset) },
+            { "vertexCount",  static_cast<qint64>(obj->vertices.size()) }
+        });
+    }
+    const QJsonObject table{
+        { "objects",      objects },
+        { "currentIndex", current_index },
+        { "material",     workspace.materialName },
+        { "camera",       QJsonObject{
+            { "position", toJson(workspace.camera.position) },
+            { "yaw",      workspace.camera.yaw },
+            { "pitch",    workspace.camera.pitch },
+            { "zoom",     workspace.camera.zoom } } }
+    };
+    const auto table_data = QJsonDocument(table).toJson(QJsonDocument::Compact);
+    header.tableOffset = static_cast<std::uint64_t>(file.pos());
+    header.tableSize = static_cast<std::uint64_t>(table_data.size());
+    if (file.write(table_data) != table_data.size() || !file.seek(0) ||
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != sizeof(header) || !file.commit()) {
+        qCritical() << "Critical: cannot write workspace file " << path;
+        return false;
+    }
+    qDebug() << "Message: workspace saving took" <<
+        static_cast<double>(timer.nsecsElapsed()) / 1000000000.0 << "sec:" << path;
+    return true;
+}
+
+std::unique_ptr<WorkspaceSnapshot::Workspace> WorkspaceSnapshot::restore(const QString& path)
+{
+    QElapsedTimer timer;
+    timer.start();
+    auto file = std::make_shared<QFile>(path);
+    if (!file->open(QIODevice::ReadOnly) || file->size() < static_cast<qint64>(sizeof(Header))) {
+        qCritical() << "Critical: cannot open workspace file " << path;
+        return nullptr;
+    }
+    const auto file_size = static_cast<std::uint64_t>(file->size());
+    //private mapping, pages are shared with the page cache until somebody writes to them
+    uchar* data = file->map(0, file->size(), QFileDevice::MapPrivateOption);
+    if (nullptr == data) {
+        qCritical() << "Critical: cannot map workspace file " << path;
+        return nullptr;
+    }
+    Header header;
+    std::memcpy(&header, data, sizeof(header));
+    if (0 != std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) || VERSION != header.version ||
+        sizeof(Vertex) != header.vertexSize || header.tableOffset + header.tableSize > file_size) {
+        qCritical() << "Critical: " << path << " is not a compatible workspace file.";
+        return nullptr;
+    }
+    QJsonParseError error;
+    const auto table = QJsonDocument::fromJson(QByteArray::fromRawData(
+        reinterpret_cast<const char*>(data + header.tableOffset), static_cast<int>(header.tableSize)), &error).object();
+    if (QJsonParseError::NoError != error.error) {
+        qCritical() << "Critical: cannot parse workspace table " << error.errorString();
+        return nullptr;
+    }
+
+    auto workspace = std::make_unique<Workspace>();
+    for (const auto& value : table["objects"].toArray()) {
+        const auto object = value.toObject();
+        const auto offset = static_cast<std::uint64_t>(object["vertexOffset"].toDouble());
+        const auto count = static_cast<std::uint64_t>(object["vertexCount"].toDouble());
+        if (offset % alignof(Vertex) != 0 || offset > file_size || count > (file_size - offset) / sizeof(Vertex)) {
+            qCritical() << "Critical: workspace object " << object["name"].toString() << " is out of file bounds.";
+            return nullptr;
+        }
+        auto obj = std::make_shared<SceneObject>(
+            object["filePath"].toString(),
+            object["name"].toString(),
+            MappedArray<Vertex>(file, reinterpret_cast<Vertex*>(data + offset), count),
+            static_cast<std::uint64_t>(object["numVertices"].toDouble()),
+            static_cast<std::uint64_t>(object["numFaces"].toDouble()),
+            static_cast<std::uint64_t>(object["numEdges"].toDouble()),
+            vec3FromJson(object["minBounds"]),
+            vec3FromJson(object["maxBounds"])
+        );
+        const auto rotation = object["rotation"].toArray();
+        obj->setTranslationVec(vec3FromJson(object["translation"]));
+        obj->setRotationQuart(QQuaternion(rotation[0].toDouble(), rotation[1].toDouble(), rotation[2].toDouble(), rotation[3].toDouble()));
+        obj->setVisible(object["visible"].toInt(Qt::CheckState::Checked));
+        workspace->objects.push_back(obj);
+    }
+    workspace->currentIndex = table["currentIndex"].toInt(-1);
+    workspace->materialName = table["material"].toString();
+    const auto camera = table["camera"].toObject();
+    workspace->camera.position = vec3FromJson(camera["position"]);
+    workspace->camera.yaw = static_cast<float>(camera["yaw"].toDouble(-90.0));
+    workspace->camera.pitch = static_cast<float>(camera["pitch"].toDouble());
+    workspace->camera.zoom = static_cast<float>(camera["zoom"].toDouble(45.0));
+    qDebug() << "Message: workspace restoring took" <<
+        static_cast<double>(timer.nsecsElapsed()) / 1000000000.0 << "sec:" << path;
+    return workspace;
+}
+
+void WorkspaceSnapshot::prefetch(const QVector<std::shared_ptr<SceneObject>>& objects)
+{
+    //lowest priority, loads and interactive work go first
+    JobSystem::instance().submit([objects]() {
+        volatile unsigned char sink = 0;
+        for (const auto& obj : objects) {
+            const auto lock = obj->lockGeometry();
+            const auto bytes = reinterpret_cast<const unsigned char*>(obj->vertices.data());
+            for (std::uint64_t offset = 0; offset < obj->vertices.sizeInBytes(); offset += PAGE_SIZE) {
+                sink = sink + bytes[offset];
+            }
+        }
+    }, JobSystem::Priority::BACKGROUND);
+}
@@ -1,11 +1,26 @@
 #pragma once
 
 #include <QMainWindow>
-#include <QtConcurrent>
 #include <QLabel>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <QSet>
+#include <QHash>
+#include <QDir>
 
 #include "OpenGLRenderer.h"
 #include "SceneObject.h"
+#include "ObjStreamReader.h"
+#include "BinaryImporters.h"
+#include "PointCloud.h"
+#include "WorkspaceSnapshot.h"
+#include "MeshCache.h"
+#include "MeshCodec.h"
+#include "MeshExporter.h"
+#include "JobSystem.h"
+#include "ReloadTracker.h"
+#include "ThumbnailService.h"
+#include "SessionRecording.h"
 
 namespace Ui {
 class Viewer;
@@ -16,12 +31,24 @@ class Viewer : public QMainWindow
     Q_OBJECT
 
 public:
+    //files starting from this size are loaded through the out-of-core streaming reader
+    static constexpr qint64 OUT_OF_CORE_FILE_SIZE = 512ll * 1024ll * 1024ll;
+    //changed files are reloaded once they were left alone for this long
+    static constexpr int RELOAD_DEBOUNCE_MS = 500;
+
     explicit Viewer(QWidget *parent = nullptr);
     ~Viewer();
     void addFileToTreeList(const QString& file, unsigned int objId);
 
 public slots:
     void openFile();
+    void openPointCloud();
+    void exportCompressed();
+    //all the mesh objects into one file, placed as they are on the scene
+    void exportScene();
+    void openWorkspace();
+    void saveWorkspace();
+    void restoreLastSession();
 
 signals:
     void sceneUpdated(const std::shared_ptr<SceneObject>&);
@@ -30,16 +57,44 @@ signals:
 protected:
     void resizeEvent(QResizeEvent* event) override;
     void keyPressEvent(QKeyEvent* event) override;
+    void closeEvent(QCloseEvent* event) override;
 
 private slots:
-    void handleObjectConstruction();
+    void handleObjectConstruction(const std::shared_ptr<SceneObject>& obj);
     void authorInfo();
     void hotkeysInfo();
+    void memoryReport();
+    void schedulerStats();
+    void setClearance();
+    void clearanceReport();
+    void handleClearanceUpdated(const QString& text);
+    void setDeviationReference();
+    // saves the scene as the workspace of the recording when it starts, the recording when it stops
+    void recordSession(bool record);
+    void replaySession();
+    void handleReplayFinished(const FrameTimings& timings);
+    void selectObject(unsigned int objId);
+    void handleFileChanged(const QString& file);
+    void reloadChangedFiles();
+    //title of the export action, for the warning of a failed one
+    void handleExportFinished(const QString& title, const QString& path, bool written);
+    void handleSessionSaved(const QString& path, bool saved);
 private:
-    std::shared_ptr<SceneObject> constructObject(const QString& file);
+    void loadFile(const QString& file, bool asPointCloud = false);
+    std::shared_ptr<SceneObject> constructObject(const QString& file, bool asPointCloud = false);
+    // without detectPointCloud an obj file is read as the kind asPointCloud asks for, whatever its content
+    std::shared_ptr<SceneObject> loadObject(const QString& file, bool asPointCloud = false, bool detectPointCloud = true);
     void connectSignalsSlots();
     void createStatusBar();
     void handleObjectRemovement();
+    // the restored objects, empty when the workspace cannot be read
+    QVector<std::shared_ptr<SceneObject>> restoreWorkspace(const QString& path);
+    void watchFile(const QString& file);
+    void handleObjectReloaded(const std::shared_ptr<SceneObject>& target, const std::shared_ptr<SceneObject>& reloaded,
+        std::uint64_t generation);
+    QString sessionDirectory() const;
+    // the newest saved session, empty when there is none
+    QString lastSessionPath() const;
 
     OpenGLRenderer* m_openGLRenderer;
     Ui::Viewer *ui;
@@ -49,7 +104,27 @@ private:
     QLabel* m_framerateLbl;
     QLabel* m_statusLbl;
     QLabel* m_drawingModeLbl;
+    QLabel* m_qualityLbl;
+    QLabel* m_occlusionLbl;
+    QLabel* m_sectionLbl;
+    QLabel* m_clearanceLbl;
+    QLabel* m_fieldLbl;
 
-    QFutureWatcher<std::shared_ptr<SceneObject>> watcher;
+    JobSystem::CancellationToken m_loadToken;
+    std::vector<JobSystem::JobHandle> m_loadJobs;
+    //the session written on close, the window closes once it is done
+    JobSystem::JobHandle m_sessionSave;
+    bool m_sessionSaved = false;
+    //hot reload of the files of the loaded objects
+    QFileSystemWatcher m_fileWatcher;
+    QTimer m_reloadTimer;
+    QSet<QString> m_changedFiles;
+    //latest reload per object, superseded ones are cancelled and their results dropped
+    ReloadTracker m_reloads;
+    //previews of the open dialog, created with the first dialog
+    std::unique_ptr<ThumbnailService> m_thumbnails;
+    QString m_openDirectory = QDir::homePath();
+    QString m_recordingPath;
+    QString m_replayPath;
 };
 
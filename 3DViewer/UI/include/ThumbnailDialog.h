@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QDir>
+#include <QHash>
+#include <QLineEdit>
+#include <QListWidget>
+
+#include "ThumbnailService.h"
+
+// Open dialog showing the models of a folder as previews. Previews seen before are taken from
+// the cache at once, the others fill in as they are rendered, moving to another folder drops
+// the requests still waiting.
+class ThumbnailDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    //nameFilters like "*.obj", matched case insensitively
+    ThumbnailDialog(ThumbnailService* thumbnails, const QStringList& nameFilters, QWidget* parent = nullptr);
+    ~ThumbnailDialog();
+
+    void setDirectory(const QString& path);
+    inline QString directory()    const { return this->m_directory.absolutePath(); }
+    inline QString selectedFile() const { return this->m_selectedFile; }
+
+private slots:
+    void goUp();
+    void openTypedPath();
+    void activateItem(QListWidgetItem* item);
+    void acceptSelection();
+    void handleThumbnailReady(const QString& path, const QImage& image);
+    void handleThumbnailFailed(const QString& path);
+
+private:
+    ThumbnailService* m_thumbnails;
+    QStringList m_nameFilters;
+    QDir m_directory;
+    QString m_selectedFile;
+    QLineEdit* m_pathEdit;
+    QListWidget* m_listWidget;
+    QDialogButtonBox* m_buttons;
+    //items of the files waiting for their previews
+    QHash<QString, QListWidgetItem*> m_waiting;
+};
@@ -1,8 +1,18 @@
 #include "3DViewer.h"
 #include "ui_3DViewer.h"
+#include "ThumbnailDialog.h"
 
+#include <QActionGroup>
+#include <QDateTime>
 #include <QFileDialog>
+#include <QInputDialog>
+#include <QJsonDocument>
 #include <QMessageBox>
+#include <QSaveFile>
+#include <QSignalBlocker>
+#include <QStandardPaths>
+
+#include <algorithm>
 
 Viewer::Viewer(QWidget *parent) :
     QMainWindow(parent),
@@ -12,16 +22,28 @@ Viewer::Viewer(QWidget *parent) :
     m_mousePosLbl   (new QLabel("x = 0, y = 0", this)),
     m_framerateLbl  (new QLabel("0.00", this)),
     m_drawingModeLbl(new QLabel("solid", this)),
+    m_qualityLbl    (new QLabel("full", this)),
+    m_occlusionLbl  (new QLabel("off", this)),
+    m_sectionLbl    (new QLabel("off", this)),
+    m_clearanceLbl  (new QLabel("off", this)),
+    m_fieldLbl      (new QLabel("off", this)),
     m_statusLbl     (new QLabel(this))
 {
     ui->setupUi(this);
     m_openGLRenderer = new OpenGLRenderer(ui->openGLWidget, m_scene);
+    m_reloadTimer.setSingleShot(true);
+    m_reloadTimer.setInterval(RELOAD_DEBOUNCE_MS);
     connectSignalsSlots();
     createStatusBar(); 
 }
 
 Viewer::~Viewer()
 {
+    //loads in progress stop at their next cancellation point
+    m_loadToken.cancel();
+    m_reloads.cancelAll();
+    JobSystem::instance().wait(m_loadJobs);
+    m_thumbnails.reset();
     delete ui;
 }
 
@@ -42,27 +64,155 @@ void Viewer::keyPressEvent(QKeyEvent* event)
 {
     switch (event->key()) {
     case Qt::Key_Delete:
+        if (const auto current = m_scene.getCurrentObjSelection()) {
+            m_reloads.remove(current->getID());
+        }
         emit objectRemoved();
         handleObjectRemovement();
-        m_openGLRenderer->update();
+        m_openGLRenderer->redraw();
         break;
     case Qt::Key_Escape:
-        QApplication::quit();
+        if (m_openGLRenderer->isReplaying()) {
+            m_openGLRenderer->stopReplay();
+        }
+        else {
+            close();
+        }
         break;
     }
 }
 
+void Viewer::closeEvent(QCloseEvent* event)
+{
+    //keep the session so it can be restored on the next start
+    if (!m_sessionSaved && !m_scene.getObjectsLst().isEmpty()) {
+        //the soups are written on a worker with the window already gone, the close is repeated once they are
+        event->ignore();
+        if (nullptr != m_sessionSave) {
+            return;
+        }
+        hide();
+        QDir().mkpath(sessionDirectory());
+        //the restored objects may still map the previous session, it is not overwritten
+        const auto path = QDir(sessionDirectory()).filePath("last_session_" +
+            QDateTime::currentDateTimeUtc().toString("yyyyMMddhhmmsszzz") + "." + WorkspaceSnapshot::FILE_SUFFIX);
+        std::shared_ptr<WorkspaceSnapshot::Workspace> workspace =
+            WorkspaceSnapshot::capture(m_scene, m_openGLRenderer->getCamera().getState());
+        m_sessionSave = JobSystem::instance().submit([this, path, workspace]() {
+            const bool saved = WorkspaceSnapshot::save(path, *workspace);
+            QMetaObject::invokeMethod(this, [this, path, saved]() { handleSessionSaved(path, saved); }, Qt::QueuedConnection);
+        }, JobSystem::Priority::LOAD);
+        m_loadJobs.push_back(m_sessionSave);
+        return;
+    }
+    QMainWindow::closeEvent(event);
+}
+
+void Viewer::handleSessionSaved(const QString& path, bool saved)
+{
+    if (saved) {
+        //older sessions still mapped by this process are removed on a later start
+        const QDir dir(sessionDirectory());
+        for (const auto& file : dir.entryList({ "last_session*." + QString(WorkspaceSnapshot::FILE_SUFFIX) }, QDir::Files)) {
+            if (dir.filePath(file) != path) {
+                QFile::remove(dir.filePath(file));
+            }
+        }
+    }
+    m_sessionSaved = true;
+    close();
+}
+
 void Viewer::handleObjectRemovement()
 {
     QListWidgetItem* selectedItem = ui->objsListWidget->currentItem();
     delete selectedItem;
 }
 
-std::shared_ptr<SceneObject> Viewer::constructObject(const QString& file)
+std::shared_ptr<SceneObject> Viewer::constructObject(const QString& file, bool asPointCloud)
 {
-    std::unique_ptr<Surface_mesh> mesh = CGAL_API::constructMeshFromObj(file.toStdString());
+    //transient buffers of this load are reported into the scope
+    MemoryTracker::LoadScope load_scope;
+    auto obj = loadObject(file, asPointCloud);
+    if (nullptr != obj) {
+        load_scope.attach(obj->getID());
+    }
+    return obj;
+}
+
+std::shared_ptr<SceneObject> Viewer::loadObject(const QString& file, bool asPointCloud, bool detectPointCloud)
+{
+    QFileInfo file_info(file);
+    const auto suffix = file_info.suffix().toLower();
+    if ("obj" == suffix && (asPointCloud || (detectPointCloud && POINTCLOUD_API::looksLikePointCloud(file.toStdString())))) {
+        //vertex only scans, and meshes opened only to look at their points
+        auto cloud = POINTCLOUD_API::constructPointCloudFromObj(file.toStdString());
+        if (nullptr == cloud) {
+            return nullptr;
+        }
+        return std::make_shared<SceneObject>(file_info.absoluteFilePath(), file_info.baseName(), std::move(cloud));
+    }
+    if (CACHE_API::FILE_SUFFIX == suffix) {
+        //prebuilt by the batch tool, only mapped
+        auto cached = CACHE_API::readMeshCache(file);
+        if (nullptr == cached) {
+            return nullptr;
+        }
+        if (CACHE_API::isSourceChanged(*cached)) {
+            //the model was edited after the cache was built, it is loaded instead and the cache rebuilt from it
+            const auto source = cached->sourcePath;
+            qDebug() << "Message: cache is out of date, rebuilding it from" << source;
+            //unmapped before it is replaced
+            cached.reset();
+            auto obj = loadObject(source);
+            if (nullptr != obj && !obj->isPointCloud()) {
+                const QFileInfo source_info(source);
+                CachedMesh rebuilt;
+                rebuilt.num_vertices = obj->getNumberOfVertices();
+                rebuilt.num_faces = obj->getNumberOfFaces();
+                rebuilt.num_edges = obj->getNumberOfEdges();
+                rebuilt.minBounds = obj->getMinBounds();
+                rebuilt.maxBounds = obj->getMaxBounds();
+                rebuilt.sourcePath = source_info.absoluteFilePath();
+                rebuilt.sourceSize = static_cast<std::uint64_t>(source_info.size());
+                rebuilt.sourceModified = source_info.lastModified().toMSecsSinceEpoch();
+                CACHE_API::writeMeshCache(file, rebuilt, obj->vertices);
+            }
+            return obj;
+        }
+        return std::make_shared<SceneObject>(file_info.absoluteFilePath(), file_info.baseName(),
+            std::move(cached->vertices), cached->num_vertices, cached->num_faces, cached->num_edges,
+            cached->minBounds, cached->maxBounds);
+    }
+    if (CODEC_API::FILE_SUFFIX == suffix) {
+        //chunks are decoded in parallel straight into the soup
+        auto decoded = CODEC_API::readCompressedMesh(file);
+        if (nullptr == decoded) {
+            return nullptr;
+        }
+        return std::make_shared<SceneObject>(file_info.absoluteFilePath(), file_info.baseName(),
+            std::move(decoded->vertices), decoded->num_vertices, decoded->num_faces, decoded->num_edges,
+            decoded->minBounds, decoded->maxBounds);
+    }
+    if ("stl" == suffix || "ply" == suffix || "glb" == suffix) {
+        std::unique_ptr<IndexedMesh> indexed_mesh =
+            ("stl" == suffix) ? IMPORT_API::constructMeshFromStl(file.toStdString()) :
+            ("ply" == suffix) ? IMPORT_API::constructMeshFromPly(file.toStdString()) :
+                                IMPORT_API::constructMeshFromGlb(file.toStdString());
+        MemoryTracker::LoadScope::add(nullptr != indexed_mesh ? indexed_mesh->sizeInBytes() : 0);
+        return SceneObject::makeObject(file_info, indexed_mesh);
+    }
+    if (file_info.size() >= OUT_OF_CORE_FILE_SIZE) {
+        //too big for the in-memory surface mesh, stream it
+        std::unique_ptr<IndexedMesh> indexed_mesh = OBJ_STREAM_API::constructMeshFromObj(file.toStdString());
+        MemoryTracker::LoadScope::add(nullptr != indexed_mesh ? indexed_mesh->sizeInBytes() : 0);
+        return SceneObject::makeObject(file_info, indexed_mesh);
+    }
+    //texture coordinates and materials are kept by the surface mesh path only
+    SurfaceAttributes attributes;
+    std::unique_ptr<Surface_mesh> mesh = CGAL_API::constructMeshFromObj(file.toStdString(), &attributes);
     if (nullptr != mesh) {
-        std::shared_ptr<SceneObject> obj = SceneObject::makeObject(QFileInfo(file), mesh);
+        std::shared_ptr<SceneObject> obj = SceneObject::makeObject(file_info, mesh, &attributes);
         return obj;
     }
     return nullptr;
@@ -72,10 +222,39 @@ void Viewer::connectSignalsSlots()
 {
     //file menu
     connect(ui->actionOpen,    &QAction::triggered, this, &Viewer::openFile);
-    connect(ui->actionExit,    &QAction::triggered, this, &QApplication::quit);
+    connect(ui->actionOpenPointCloud, &QAction::triggered, this, &Viewer::openPointCloud);
+    connect(ui->actionExportCompressed, &QAction::triggered, this, &Viewer::exportCompressed);
+    connect(ui->actionExportScene, &QAction::triggered, this, &Viewer::exportScene);
+    connect(ui->actionExit,    &QAction::triggered, this, &QWidget::close);
+    connect(ui->actionOpenWorkspace,  &QAction::triggered, this, &Viewer::openWorkspace);
+    connect(ui->actionSaveWorkspace,  &QAction::triggered, this, &Viewer::saveWorkspace);
+    connect(ui->actionRestoreSession, &QAction::triggered, this, &Viewer::restoreLastSession);
+    //tools menu
+    connect(ui->actionClearanceCheck,  &QAction::toggled,   &m_scene, &Scene::setClearanceCheck);
+    connect(ui->actionSetClearance,    &QAction::triggered, this,     &Viewer::setClearance);
+    connect(ui->actionClearanceReport, &QAction::triggered, this,     &Viewer::clearanceReport);
+    connect(ui->actionSetDeviationReference, &QAction::triggered, this, &Viewer::setDeviationReference);
+    connect(ui->actionRecordSession, &QAction::toggled,   this, &Viewer::recordSession);
+    connect(ui->actionReplaySession, &QAction::triggered, this, &Viewer::replaySession);
+    //one field at a time
+    auto field_group = new QActionGroup(this);
+    const std::pair<QAction*, FieldKind> field_actions[] = {
+        { ui->actionFieldNone,        FieldKind::NONE },
+        { ui->actionFieldCurvature,   FieldKind::CURVATURE },
+        { ui->actionFieldAspectRatio, FieldKind::ASPECT_RATIO },
+        { ui->actionFieldEdgeLength,  FieldKind::EDGE_LENGTH },
+        { ui->actionFieldDeviation,   FieldKind::DEVIATION }
+    };
+    for (const auto& field_action : field_actions) {
+        field_group->addAction(field_action.first);
+        const auto kind = field_action.second;
+        connect(field_action.first, &QAction::triggered, &m_scene, [this, kind]() { m_scene.setFieldKind(kind); });
+    }
     //help menu
     connect(ui->actionAuthor,  &QAction::triggered, this, &Viewer::authorInfo);
     connect(ui->actionHotkeys, &QAction::triggered, this, &Viewer::hotkeysInfo);
+    connect(ui->actionMemoryReport, &QAction::triggered, this, &Viewer::memoryReport);
+    connect(ui->actionSchedulerStats, &QAction::triggered, this, &Viewer::schedulerStats);
 
     //details frame
     connect(&m_scene, &Scene::verticesUpdated, ui->objDataVerticesLbl, &QLabel::setText);
@@ -86,20 +265,31 @@ void Viewer::connectSignalsSlots()
     connect(&m_scene, &Scene::heightUpdated,   ui->objDataHeightLbl,   &QLabel::setText);
     connect(&m_scene, &Scene::lengthUpdated,   ui->objDataLengthLbl,   &QLabel::setText);
     connect(&m_scene, &Scene::nameUpdated,     ui->objDataNameLbl,     &QLabel::setText);
+    connect(&m_scene, &Scene::cpuMemoryUpdated, ui->objDataCpuMemoryLbl, &QLabel::setText);
+    connect(&m_scene, &Scene::gpuMemoryUpdated, ui->objDataGpuMemoryLbl, &QLabel::setText);
+    connect(&m_scene, &Scene::loadPeakUpdated,  ui->objDataLoadPeakLbl,  &QLabel::setText);
 
     //renderer actions
     connect(&m_scene, &Scene::redrawRenderer, m_openGLRenderer, &OpenGLRenderer::redraw);
     connect(&m_scene, &Scene::updateCamera,   m_openGLRenderer, &OpenGLRenderer::updateCamera);
+    connect(m_openGLRenderer, &OpenGLRenderer::geometrySwapped, &m_scene, &Scene::handleGeometrySwapped);
+    connect(m_openGLRenderer, &OpenGLRenderer::objectMoved,     &m_scene, &Scene::handleObjectMoved);
+    connect(m_openGLRenderer, &OpenGLRenderer::selectionWanted, this,     &Viewer::selectObject);
+    connect(m_openGLRenderer, &OpenGLRenderer::replayFinished,  this,     &Viewer::handleReplayFinished);
+
+    //hot reload
+    connect(&m_fileWatcher, &QFileSystemWatcher::fileChanged, this, &Viewer::handleFileChanged);
+    connect(&m_reloadTimer, &QTimer::timeout,                 this, &Viewer::reloadChangedFiles);
 
     //status bar
     connect(m_openGLRenderer, &OpenGLRenderer::mouseMoved,         m_mousePosLbl,       &QLabel::setText);
     connect(m_openGLRenderer, &OpenGLRenderer::framerateUpdated,   m_framerateLbl,      &QLabel::setText);
     connect(m_openGLRenderer, &OpenGLRenderer::drawingModeChanged, m_drawingModeLbl,    &QLabel::setText);
-
-    //loading obj
-    connect(&watcher, &QFutureWatcher<std::shared_ptr<SceneObject>>::finished,  this, &Viewer::handleObjectConstruction);
-    connect(&watcher, &QFutureWatcher<std::shared_ptr<SceneObject>>::started,  [this]() { m_statusLbl->setText("\"" + watcher.property("filename").toString() + "\" is loading"); });
-    connect(&watcher, &QFutureWatcher<std::shared_ptr<SceneObject>>::finished, [this]() { m_statusLbl->setText(""); });
+    connect(m_openGLRenderer, &OpenGLRenderer::qualityChanged,     m_qualityLbl,        &QLabel::setText);
+    connect(m_openGLRenderer, &OpenGLRenderer::occlusionUpdated,   m_occlusionLbl,      &QLabel::setText);
+    connect(m_openGLRenderer, &OpenGLRenderer::sectionUpdated,     m_sectionLbl,        &QLabel::setText);
+    connect(&m_scene,         &Scene::clearanceUpdated,            this,                &Viewer::handleClearanceUpdated);
+    connect(&m_scene,         &Scene::fieldUpdated,                m_fieldLbl,          &QLabel::setText);
 
     //scene
     connect(ui->objVisibleCB,            &QCheckBox::stateChanged,         &m_scene, &Scene::setCurrentObjVisibility);
@@ -121,26 +311,342 @@ void Viewer::createStatusBar()
 
     statusBar()->addWidget(new QLabel("Drawing mode:", this));
     statusBar()->addWidget(m_drawingModeLbl);
+
+    statusBar()->addWidget(new QLabel("Quality:", this));
+    statusBar()->addWidget(m_qualityLbl);
+
+    statusBar()->addWidget(new QLabel("Occlusion:", this));
+    statusBar()->addWidget(m_occlusionLbl);
+
+    statusBar()->addWidget(new QLabel("Section:", this));
+    statusBar()->addWidget(m_sectionLbl);
+
+    statusBar()->addWidget(new QLabel("Clearance:", this));
+    statusBar()->addWidget(m_clearanceLbl);
+
+    statusBar()->addWidget(new QLabel("Field:", this));
+    statusBar()->addWidget(m_fieldLbl);
 }
 
-void Viewer::handleObjectConstruction()
+void Viewer::handleObjectConstruction(const std::shared_ptr<SceneObject>& obj)
 {
-    const auto& obj = std::move(watcher.result());
+    //drop the handles of the finished loads
+    m_loadJobs.erase(std::remove_if(m_loadJobs.begin(), m_loadJobs.end(),
+        [](const JobSystem::JobHandle& job) { return job->isFinished(); }), m_loadJobs.end());
+    if (m_loadJobs.empty()) {
+        m_statusLbl->setText("");
+    }
     if (nullptr != obj) {
         emit sceneUpdated(obj);
         addFileToTreeList(obj->getFilePath(), obj->getID()); 
+        watchFile(obj->getFilePath());
+    }
+}
+
+void Viewer::watchFile(const QString& file)
+{
+    if (!m_fileWatcher.files().contains(file)) {
+        m_fileWatcher.addPath(file);
+    }
+}
+
+void Viewer::handleFileChanged(const QString& file)
+{
+    //every write restarts the timer, a file being written is reloaded once
+    m_changedFiles.insert(file);
+    m_reloadTimer.start();
+}
+
+void Viewer::reloadChangedFiles()
+{
+    QSet<QString> missing;
+    for (const auto& file : m_changedFiles) {
+        std::vector<std::shared_ptr<SceneObject>> targets;
+        for (const auto& obj : m_scene.getObjectsLst()) {
+            if (obj->getFilePath() == file) {
+                targets.push_back(obj);
+            }
+        }
+        if (targets.empty()) {
+            m_fileWatcher.removePath(file);
+            continue;
+        }
+        if (!QFileInfo::exists(file)) {
+            //replaced by a rename, the new file shows up a moment later
+            missing.insert(file);
+            continue;
+        }
+        //saving through a temporary file drops the path from the watcher
+        watchFile(file);
+        for (const auto& target : targets) {
+            //the reload in progress is cancelled, this one runs once it has stopped
+            const auto reload = m_reloads.begin(target->getID());
+            bool as_point_cloud = false;
+            {
+                const auto lock = target->lockGeometry();
+                as_point_cloud = target->isPointCloud();
+            }
+            const auto generation = reload.generation;
+            const auto job = JobSystem::instance().submit([this, file, target, as_point_cloud, generation]() {
+                //a mesh saved half way may look like a point cloud, the object keeps its kind
+                std::shared_ptr<SceneObject> reloaded = loadObject(file, as_point_cloud, false);
+                QMetaObject::invokeMethod(this, [this, target, reloaded, generation]() {
+                    handleObjectReloaded(target, reloaded, generation);
+                }, Qt::QueuedConnection);
+            }, JobSystem::Priority::LOAD, reload.previous, reload.token);
+            m_reloads.setJob(target->getID(), job);
+            m_loadJobs.push_back(job);
+        }
+        m_statusLbl->setText("\"" + file + "\" is reloading");
+    }
+    m_changedFiles = missing;
+    if (!m_changedFiles.isEmpty()) {
+        m_reloadTimer.start();
     }
 }
 
+void Viewer::handleObjectReloaded(const std::shared_ptr<SceneObject>& target, const std::shared_ptr<SceneObject>& reloaded,
+    std::uint64_t generation)
+{
+    m_loadJobs.erase(std::remove_if(m_loadJobs.begin(), m_loadJobs.end(),
+        [](const JobSystem::JobHandle& job) { return job->isFinished(); }), m_loadJobs.end());
+    if (m_loadJobs.empty()) {
+        m_statusLbl->setText("");
+    }
+    //superseded by a later reload or removed from the scene meanwhile
+    if (!m_reloads.finish(target->getID(), generation) || nullptr == m_scene.getObjectByID(target->getID())) {
+        return;
+    }
+    if (nullptr == reloaded) {
+        //half written files fail to parse, the next change reloads them again
+        qCritical() << "Critical: cannot reload " << target->getFilePath() << ", the previous geometry is kept.";
+        return;
+    }
+    //swapped by the render thread between two frames, the old geometry is drawn until then
+    m_scene.setPendingGeometry(target->getID(), reloaded);
+}
+
 void Viewer::openFile()
 {
-    QFileDialog dialog(this, tr("Open File"));
-    dialog.setNameFilter("*.obj");
+    //the headless renderer is set up on the first use only
+    if (nullptr == m_thumbnails) {
+        m_thumbnails = std::make_unique<ThumbnailService>();
+    }
+    ThumbnailDialog dialog(m_thumbnails.get(), { "*.obj", "*.stl", "*.ply", "*.glb",
+        QString("*.%1").arg(CACHE_API::FILE_SUFFIX), QString("*.%1").arg(CODEC_API::FILE_SUFFIX) }, this);
+    dialog.setDirectory(m_openDirectory);
+
+    if (dialog.exec() == QDialog::Accepted && !dialog.selectedFile().isEmpty()) {
+        m_openDirectory = QFileInfo(dialog.selectedFile()).absolutePath();
+        loadFile(dialog.selectedFile());
+    }
+}
+
+void Viewer::openPointCloud()
+{
+    const auto file = QFileDialog::getOpenFileName(this, tr("Open Point Cloud"), QString(), tr("Point clouds (*.obj)"));
+    if (!file.isEmpty()) {
+        loadFile(file, true);
+    }
+}
+
+void Viewer::exportCompressed()
+{
+    const auto obj = m_scene.getCurrentObjSelection();
+    bool is_mesh = false;
+    if (nullptr != obj) {
+        const auto lock = obj->lockGeometry();
+        is_mesh = !obj->isPointCloud() && !obj->vertices.isEmpty();
+    }
+    if (!is_mesh) {
+        QMessageBox::information(this, tr("Export Compressed"), tr("Select a mesh object to export."));
+        return;
+    }
+    const auto path = QFileDialog::getSaveFileName(this, tr("Export Compressed"),
+        obj->getName() + "." + CODEC_API::FILE_SUFFIX, QString("Compressed mesh (*.%1)").arg(CODEC_API::FILE_SUFFIX));
+    if (path.isEmpty()) {
+        return;
+    }
+    m_statusLbl->setText("\"" + path + "\" is exporting");
+    m_loadJobs.push_back(JobSystem::instance().submit([this, path, obj]() {
+        MemoryTracker::LoadScope scope;
+        MappedArray<Vertex> soup;
+        std::uint64_t num_vertices = 0;
+        std::uint64_t num_faces = 0;
+        std::uint64_t num_edges = 0;
+        bool copied = false;
+        {
+            //copied under the lock, the encoding waits for its own jobs and must not hold it
+            const auto lock = obj->lockGeometry();
+            copied = soup.copyFrom(obj->vertices);
+            num_vertices = obj->getNumberOfVertices();
+            num_faces = obj->getNumberOfFaces();
+            num_edges = obj->getNumberOfEdges();
+        }
+        MemoryTracker::LoadScope::add(soup.sizeInBytes());
+        const bool written = copied && CODEC_API::writeCompressedMesh(path, soup, num_vertices, num_faces, num_edges);
+        QMetaObject::invokeMethod(this, [this, path, written]() {
+            handleExportFinished(tr("Export Compressed"), path, written);
+        }, Qt::QueuedConnection);
+    }, JobSystem::Priority::BACKGROUND, {}, m_loadToken));
+}
+
+void Viewer::exportScene()
+{
+    QVector<std::shared_ptr<SceneObject>> objects;
+    for (const auto& obj : m_scene.getObjectsLst()) {
+        const auto lock = obj->lockGeometry();
+        if (!obj->isPointCloud() && !obj->vertices.isEmpty()) {
+            objects.push_back(obj);
+        }
+    }
+    if (objects.isEmpty()) {
+        QMessageBox::information(this, tr("Export Scene"), tr("There are no mesh objects to export."));
+        return;
+    }
+    QString filter;
+    auto path = QFileDialog::getSaveFileName(this, tr("Export Scene"), "scene.obj",
+        tr("Wavefront OBJ (*.obj);;Binary PLY (*.ply);;Binary STL (*.stl)"), &filter);
+    if (path.isEmpty()) {
+        return;
+    }
+    //a name typed without the suffix gets the one of the chosen filter
+    if (QFileInfo(path).suffix().isEmpty()) {
+        path += filter.contains("*.ply") ? ".ply" : filter.contains("*.stl") ? ".stl" : ".obj";
+    }
+    EXPORT_API::Format format;
+    if (!EXPORT_API::formatFromSuffix(QFileInfo(path).suffix(), format)) {
+        QMessageBox::warning(this, tr("Export Scene"), tr("Unknown model format of ") + path);
+        return;
+    }
+    m_statusLbl->setText("\"" + path + "\" is exporting");
+    m_loadJobs.push_back(JobSystem::instance().submit([this, path, format, objects]() {
+        //each object is copied under a short lock, the render thread may swap in a reload while the file is written
+        MemoryTracker::LoadScope scope;
+        std::vector<MappedArray<Vertex>> soups(static_cast<std::size_t>(objects.size()));
+        std::vector<std::vector<SurfaceMaterial>> materials(soups.size());
+        std::vector<std::vector<MaterialRange>> ranges(soups.size());
+        std::vector<ExportPart> parts;
+        bool copied = true;
+        for (int i = 0; i < objects.size() && copied; ++i) {
+            const auto& obj = objects[i];
+            ExportPart part;
+            {
+                const auto lock = obj->lockGeometry();
+                copied = soups[i].copyFrom(obj->vertices);
+                materials[i] = obj->materials;
+                ranges[i] = obj->materialRanges;
+                part.model.translate(obj->getTranslationVec());
+                part.model.rotate(obj->getRotationQuart());
+            }
+            MemoryTracker::LoadScope::add(soups[i].sizeInBytes());
+            part.name = obj->getName();
+            part.soup = &soups[i];
+            part.materials = &materials[i];
+            part.materialRanges = &ranges[i];
+            parts.push_back(part);
+        }
+        const bool written = copied && !JobSystem::cancellationRequested() && EXPORT_API::exportMeshes(path, format, parts);
+        QMetaObject::invokeMethod(this, [this, path, written]() {
+            handleExportFinished(tr("Export Scene"), path, written);
+        }, Qt::QueuedConnection);
+    }, JobSystem::Priority::LOAD, {}, m_loadToken));
+}
+
+void Viewer::handleExportFinished(const QString& title, const QString& path, bool written)
+{
+    m_loadJobs.erase(std::remove_if(m_loadJobs.begin(), m_loadJobs.end(),
+        [](const JobSystem::JobHandle& job) { return job->isFinished(); }), m_loadJobs.end());
+    if (m_loadJobs.empty()) {
+        m_statusLbl->setText("");
+    }
+    //a cancelled export is not reported, the viewer is closing then
+    if (!written && !m_loadToken.isCancelled()) {
+        QMessageBox::warning(this, title, tr("Cannot export to ") + path);
+    }
+}
+
+void Viewer::loadFile(const QString& file, bool asPointCloud)
+{
+    m_statusLbl->setText("\"" + file + "\" is loading");
+    m_loadJobs.push_back(JobSystem::instance().submit([this, file, asPointCloud]() {
+        auto obj = constructObject(file, asPointCloud);
+        //the result is handed over on the GUI thread, dropped if the viewer is gone
+        QMetaObject::invokeMethod(this, [this, obj]() { handleObjectConstruction(obj); }, Qt::QueuedConnection);
+    }, JobSystem::Priority::LOAD, {}, m_loadToken));
+}
 
-    if (dialog.exec() == QDialog::Accepted) {           
-        watcher.setProperty("filename", dialog.selectedFiles().first());
-        watcher.setFuture(QtConcurrent::run(this, &Viewer::constructObject, dialog.selectedFiles().first()));
-    }    
+void Viewer::openWorkspace()
+{
+    const auto path = QFileDialog::getOpenFileName(this, tr("Open Workspace"), QString(),
+        QString("Workspace (*.%1)").arg(WorkspaceSnapshot::FILE_SUFFIX));
+    if (!path.isEmpty()) {
+        restoreWorkspace(path);
+    }
+}
+
+void Viewer::saveWorkspace()
+{
+    const auto path = QFileDialog::getSaveFileName(this, tr("Save Workspace"), QString(),
+        QString("Workspace (*.%1)").arg(WorkspaceSnapshot::FILE_SUFFIX));
+    if (path.isEmpty()) {
+        return;
+    }
+    m_statusLbl->setText("Saving workspace...");
+    if (!WorkspaceSnapshot::save(path, m_scene, m_openGLRenderer->getCamera().getState())) {
+        QMessageBox::warning(this, tr("Save Workspace"), tr("Cannot save workspace to ") + path);
+    }
+    m_statusLbl->setText("");
+}
+
+void Viewer::restoreLastSession()
+{
+    const auto path = lastSessionPath();
+    if (path.isEmpty()) {
+        QMessageBox::information(this, tr("Restore Last Session"), tr("There is no saved session yet."));
+        return;
+    }
+    restoreWorkspace(path);
+}
+
+QVector<std::shared_ptr<SceneObject>> Viewer::restoreWorkspace(const QString& path)
+{
+    const auto workspace = WorkspaceSnapshot::restore(path);
+    if (nullptr == workspace) {
+        QMessageBox::warning(this, tr("Open Workspace"), tr("Cannot open workspace ") + path);
+        return {};
+    }
+    for (const auto& obj : workspace->objects) {
+        emit sceneUpdated(obj);
+        addFileToTreeList(obj->getFilePath(), obj->getID());
+        watchFile(obj->getFilePath());
+    }
+    if (workspace->currentIndex >= 0 && workspace->currentIndex < workspace->objects.size()) {
+        const auto first_row = ui->objsListWidget->count() - workspace->objects.size();
+        ui->objsListWidget->setCurrentRow(first_row + workspace->currentIndex);
+    }
+    if (!workspace->materialName.isEmpty()) {
+        ui->objDataMaterialComboBox->setCurrentText(workspace->materialName);
+    }
+    //selecting items above resets the camera, so it goes last
+    m_openGLRenderer->getCamera().setState(workspace->camera);
+    //geometry is uploaded when drawn, meanwhile the pages are faulted in behind the viewport
+    WorkspaceSnapshot::prefetch(workspace->objects);
+    m_openGLRenderer->redraw();
+    return workspace->objects;
+}
+
+QString Viewer::sessionDirectory() const
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+}
+
+QString Viewer::lastSessionPath() const
+{
+    //every session goes to a file of its own, the newest one sorts last
+    const QDir dir(sessionDirectory());
+    const auto sessions = dir.entryList({ "last_session*." + QString(WorkspaceSnapshot::FILE_SUFFIX) }, QDir::Files, QDir::Name);
+    return sessions.isEmpty() ? QString() : dir.filePath(sessions.last());
 }
 
 void Viewer::hotkeysInfo()
@@ -155,8 +661,12 @@ void Viewer::hotkeysInfo()
         "    LButton + RButton      \tobject translation\n"
         "    C                      \t\tswitch drawing mode\n"
         "    R                      \t\treset object and camera position\n"
+        "    O                      \t\tswitch occlusion culling\n"
+        "    X                      \t\tcycle section plane axis\n"
+        "    V                      \t\tflip kept side of the section\n"
+        "    Ctrl + LButton, PgUp/PgDn\tmove section plane\n"
         "\nApplication:\n"
-        "    ESC                    \t\tclose app\n"
+        "    ESC                    \t\tstop session replay, close app otherwise\n"
         "    DELETE                 \tremove current selected object";
 
     QMessageBox* msgBox = new QMessageBox(this);
@@ -169,6 +679,249 @@ void Viewer::hotkeysInfo()
     msgBox->show();
 }
 
+void Viewer::memoryReport()
+{
+    QMessageBox msgBox(this);
+    msgBox.setIcon(QMessageBox::Information);
+    msgBox.setStandardButtons(QMessageBox::Save | QMessageBox::Ok);
+    msgBox.setWindowTitle(tr("Memory Report"));
+    msgBox.setText(MemoryTracker::textReport());
+    if (QMessageBox::Save != msgBox.exec()) {
+        return;
+    }
+    const auto path = QFileDialog::getSaveFileName(this, tr("Save Memory Report"), "memory_report.json", "JSON (*.json)");
+    if (path.isEmpty()) {
+        return;
+    }
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) ||
+        file.write(QJsonDocument(MemoryTracker::report()).toJson()) < 0 || !file.commit()) {
+        QMessageBox::warning(this, tr("Save Memory Report"), tr("Cannot save memory report to ") + path);
+    }
+}
+
+void Viewer::schedulerStats()
+{
+    const auto stats = JobSystem::instance().getWorkerStats();
+    QString text;
+    for (std::size_t i = 0; i < stats.size(); ++i) {
+        text += QString("Worker %1: %2 jobs, %3 stolen, busy %4 sec, utilisation %5%\n").arg(
+            QString::number(i), QString::number(stats[i].executed), QString::number(stats[i].stolen),
+            QString::number(stats[i].busySeconds, 'f', 2), QString::number(stats[i].utilisation * 100.0, 'f', 1));
+    }
+    QMessageBox msgBox(this);
+    msgBox.setIcon(QMessageBox::Information);
+    msgBox.setStandardButtons(QMessageBox::Reset | QMessageBox::Ok);
+    msgBox.setWindowTitle(tr("Scheduler Statistics"));
+    msgBox.setText(text);
+    if (QMessageBox::Reset == msgBox.exec()) {
+        JobSystem::instance().resetStats();
+    }
+}
+
+void Viewer::setClearance()
+{
+    bool ok = false;
+    const double clearance = QInputDialog::getDouble(this, tr("Set Clearance"), tr("Minimal distance between objects:"),
+        m_scene.getClearanceChecker().getClearance(), 0.0, 1000.0, 3, &ok);
+    if (ok) {
+        m_scene.setClearance(static_cast<float>(clearance));
+    }
+}
+
+void Viewer::clearanceReport()
+{
+    const auto& checker = m_scene.getClearanceChecker();
+    QString text;
+    if (!checker.isEnabled()) {
+        text = tr("Clearance check is off.");
+    }
+    else if (checker.getContacts().isEmpty()) {
+        text = tr("No objects closer than %1.").arg(checker.getClearance(), 0, 'f', 3);
+    }
+    for (const auto& contact : checker.getContacts()) {
+        const auto a = m_scene.getObjectByID(contact.objA);
+        const auto b = m_scene.getObjectByID(contact.objB);
+        if (nullptr == a || nullptr == b) {
+            continue;
+        }
+        text += QString("%1 - %2: %3, %4 and %5 triangles\n").arg(a->getName(), b->getName(),
+            contact.intersecting ? QString("intersecting") : QString("distance ") + QString::number(contact.distance, 'f', 3),
+            QString::number(contact.trianglesA->size() / 3), QString::number(contact.trianglesB->size() / 3));
+    }
+    QMessageBox msgBox(this);
+    msgBox.setIcon(QMessageBox::Information);
+    msgBox.setStandardButtons(QMessageBox::Ok);
+    msgBox.setWindowTitle(tr("Clearance Report"));
+    msgBox.setText(text);
+    msgBox.exec();
+}
+
+void Viewer::handleClearanceUpdated(const QString& text)
+{
+    m_clearanceLbl->setText(text);
+    //objects too close to another one are marked in the list
+    QSet<unsigned int> in_contact;
+    for (const auto& contact : m_scene.getClearanceChecker().getContacts()) {
+        in_contact.insert(contact.objA);
+        in_contact.insert(contact.objB);
+    }
+    for (int row = 0; row < ui->objsListWidget->count(); ++row) {
+        auto item = ui->objsListWidget->item(row);
+        const bool marked = in_contact.contains(item->data(Qt::UserRole).toUInt());
+        item->setForeground(marked ? QBrush(Qt::red) : QBrush());
+    }
+}
+
+void Viewer::setDeviationReference()
+{
+    //the other mesh objects, the selected one is measured against the chosen one
+    const auto current = m_scene.getCurrentObjSelection();
+    QStringList names;
+    QVector<unsigned int> ids;
+    int selected = 0;
+    for (const auto& obj : m_scene.getObjectsLst()) {
+        if (obj == current || obj->isPointCloud()) {
+            continue;
+        }
+        if (obj == m_scene.getFieldAnalyzer().getReference()) {
+            selected = names.size();
+        }
+        names.push_back(QString("%1 (%2)").arg(obj->getName()).arg(obj->getID()));
+        ids.push_back(obj->getID());
+    }
+    if (names.isEmpty()) {
+        QMessageBox::information(this, tr("Set Deviation Reference"), tr("Load another mesh to compare the selected one with."));
+        return;
+    }
+    bool ok = false;
+    const auto name = QInputDialog::getItem(this, tr("Set Deviation Reference"), tr("Measure the selected object against:"),
+        names, selected, false, &ok);
+    if (ok) {
+        m_scene.setFieldReference(ids[names.indexOf(name)]);
+        ui->actionFieldDeviation->trigger();
+    }
+}
+
+void Viewer::recordSession(bool record)
+{
+    if (!record) {
+        const auto recording = m_openGLRenderer->stopRecording();
+        if (nullptr != recording && !RECORDING_API::writeRecording(m_recordingPath, *recording)) {
+            QMessageBox::warning(this, tr("Record Session"), tr("Cannot save session recording to ") + m_recordingPath);
+        }
+        m_statusLbl->setText("");
+        return;
+    }
+    const auto cancel = [this]() {
+        const QSignalBlocker blocker(ui->actionRecordSession);
+        ui->actionRecordSession->setChecked(false);
+    };
+    if (m_scene.getObjectsLst().isEmpty() || m_openGLRenderer->isReplaying()) {
+        QMessageBox::information(this, tr("Record Session"), tr("Load the models of the session first."));
+        cancel();
+        return;
+    }
+    const auto path = QFileDialog::getSaveFileName(this, tr("Record Session"), QString(),
+        QString("Session Recording (*.%1)").arg(SessionRecording::FILE_SUFFIX));
+    if (path.isEmpty()) {
+        cancel();
+        return;
+    }
+    //the models and their placement go with the recording, so it replays on another machine as well
+    const QFileInfo recording_info(path);
+    const auto workspace = recording_info.completeBaseName() + "." + WorkspaceSnapshot::FILE_SUFFIX;
+    m_statusLbl->setText("Saving workspace...");
+    if (!WorkspaceSnapshot::save(recording_info.dir().filePath(workspace), m_scene, m_openGLRenderer->getCamera().getState())) {
+        QMessageBox::warning(this, tr("Record Session"), tr("Cannot save workspace of the session to ") + workspace);
+        m_statusLbl->setText("");
+        cancel();
+        return;
+    }
+    //in the order of the workspace, which leaves out the point clouds
+    QVector<std::shared_ptr<SceneObject>> objects;
+    for (const auto& obj : m_scene.getObjectsLst()) {
+        if (!obj->isPointCloud()) {
+            objects.push_back(obj);
+        }
+    }
+    m_recordingPath = path;
+    m_openGLRenderer->startRecording(objects);
+    m_statusLbl->setText("Recording session");
+}
+
+void Viewer::replaySession()
+{
+    if (m_openGLRenderer->isRecording() || m_openGLRenderer->isReplaying()) {
+        return;
+    }
+    const auto path = QFileDialog::getOpenFileName(this, tr("Replay Session"), QString(),
+        QString("Session Recording (*.%1)").arg(SessionRecording::FILE_SUFFIX));
+    if (path.isEmpty()) {
+        return;
+    }
+    const auto recording = RECORDING_API::readRecording(path);
+    if (nullptr == recording) {
+        QMessageBox::warning(this, tr("Replay Session"), tr("Cannot read session recording ") + path);
+        return;
+    }
+    bool ok = false;
+    const int frame_count = QInputDialog::getInt(this, tr("Replay Session"),
+        tr("Frames to draw, 0 for one per recorded input:"), 0, 0, 1000000, 1, &ok);
+    if (!ok) {
+        return;
+    }
+    const auto objects = restoreWorkspace(RECORDING_API::workspacePath(path, *recording));
+    if (objects.isEmpty()) {
+        return;
+    }
+    m_replayPath = path;
+    m_statusLbl->setText("Replaying session, ESC stops it");
+    m_openGLRenderer->startReplay(*recording, RECORDING_API::resample(recording->frames, frame_count), objects);
+}
+
+void Viewer::handleReplayFinished(const FrameTimings& timings)
+{
+    m_statusLbl->setText("");
+    if (timings.frames.empty()) {
+        return;
+    }
+    const auto summary = RECORDING_API::summarize(timings.frames);
+    QString text = QString("%1 frames at %2x%3 by the %10 renderer\nmean %4 ms, stddev %5 ms\nmedian %6 ms, 95%: %7 ms, 99%: %8 ms, max %9 ms")
+        .arg(summary.count).arg(timings.width).arg(timings.height)
+        .arg(summary.mean, 0, 'f', 2).arg(summary.stddev, 0, 'f', 2).arg(summary.median, 0, 'f', 2)
+        .arg(summary.p95, 0, 'f', 2).arg(summary.p99, 0, 'f', 2).arg(summary.max, 0, 'f', 2).arg(timings.renderer);
+    QMessageBox msgBox(this);
+    msgBox.setIcon(QMessageBox::Information);
+    msgBox.setStandardButtons(QMessageBox::Save | QMessageBox::Ok);
+    msgBox.setWindowTitle(tr("Session Replay"));
+    msgBox.setText(text);
+    if (QMessageBox::Save != msgBox.exec()) {
+        return;
+    }
+    const QFileInfo recording_info(m_replayPath);
+    const auto path = QFileDialog::getSaveFileName(this, tr("Save Frame Timings"),
+        recording_info.dir().filePath(recording_info.completeBaseName() + "_timings.json"), "JSON (*.json)");
+    if (path.isEmpty()) {
+        return;
+    }
+    auto saved = timings;
+    saved.recording = recording_info.fileName();
+    if (!RECORDING_API::writeTimings(path, saved)) {
+        QMessageBox::warning(this, tr("Save Frame Timings"), tr("Cannot save frame timings to ") + path);
+    }
+}
+
+void Viewer::selectObject(unsigned int objId)
+{
+    for (int row = 0; row < ui->objsListWidget->count(); ++row) {
+        if (objId == ui->objsListWidget->item(row)->data(Qt::UserRole).toUInt()) {
+            ui->objsListWidget->setCurrentRow(row);
+            return;
+        }
+    }
+}
+
 void Viewer::authorInfo()
 {
     QString text =
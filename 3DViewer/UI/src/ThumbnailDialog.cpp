@@ -0,0 +1,144 @@
+#include "ThumbnailDialog.h"
+
+#include <QHBoxLayout>
+#include <QPixmap>
+#include <QPushButton>
+#include <QStyle>
+#include <QToolButton>
+#include <QVBoxLayout>
+
+namespace {
+    constexpr int PATH_ROLE = Qt::UserRole;
+    constexpr int IS_DIR_ROLE = Qt::UserRole + 1;
+    //room for the file name under the preview
+    constexpr int CELL_MARGIN = 24;
+}
+
+ThumbnailDialog::ThumbnailDialog(ThumbnailService* thumbnails, const QStringList& nameFilters, QWidget* parent) :
+    QDialog(parent),
+    m_thumbnails(thumbnails),
+    m_nameFilters(nameFilters),
+    m_pathEdit(new QLineEdit(this)),
+    m_listWidget(new QListWidget(this)),
+    m_buttons(new QDialogButtonBox(QDialogButtonBox::Open | QDialogButtonBox::Cancel, this))
+{
+    setWindowTitle(tr("Open File"));
+    resize(900, 600);
+
+    auto up_button = new QToolButton(this);
+    up_button->setIcon(style()->standardIcon(QStyle::SP_FileDialogToParent));
+    up_button->setToolTip(tr("Parent folder"));
+    auto path_layout = new QHBoxLayout();
+    path_layout->addWidget(up_button);
+    path_layout->addWidget(m_pathEdit);
+
+    const QSize icon_size(THUMBNAIL_API::THUMBNAIL_SIZE, THUMBNAIL_API::THUMBNAIL_SIZE);
+    m_listWidget->setViewMode(QListView::IconMode);
+    m_listWidget->setIconSize(icon_size);
+    m_listWidget->setGridSize(icon_size + QSize(CELL_MARGIN, CELL_MARGIN + fontMetrics().height()));
+    m_listWidget->setResizeMode(QListView::Adjust);
+    m_listWidget->setMovement(QListView::Static);
+    m_listWidget->setUniformItemSizes(true);
+    m_listWidget->setWordWrap(true);
+
+    auto layout = new QVBoxLayout(this);
+    layout->addLayout(path_layout);
+    layout->addWidget(m_listWidget);
+    layout->addWidget(m_buttons);
+
+    connect(up_button, &QToolButton::clicked, this, &ThumbnailDialog::goUp);
+    connect(m_pathEdit, &QLineEdit::returnPressed, this, &ThumbnailDialog::openTypedPath);
+    connect(m_listWidget, &QListWidget::itemActivated, this, &ThumbnailDialog::activateItem);
+    connect(m_buttons, &QDialogButtonBox::accepted, this, &ThumbnailDialog::acceptSelection);
+    connect(m_buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    connect(m_thumbnails, &ThumbnailService::thumbnailReady, this, &ThumbnailDialog::handleThumbnailReady);
+    connect(m_thumbnails, &ThumbnailService::thumbnailFailed, this, &ThumbnailDialog::handleThumbnailFailed);
+}
+
+ThumbnailDialog::~ThumbnailDialog()
+{
+    //previews already rendering still end up in the cache
+    m_thumbnails->cancelPending();
+}
+
+void ThumbnailDialog::setDirectory(const QString& path)
+{
+    QDir directory(path);
+    if (!directory.exists()) {
+        directory = QDir::home();
+    }
+    m_directory = QDir(directory.absolutePath());
+    m_pathEdit->setText(QDir::toNativeSeparators(m_directory.absolutePath()));
+    m_thumbnails->cancelPending();
+    m_waiting.clear();
+    m_listWidget->clear();
+
+    const auto folder_icon = style()->standardIcon(QStyle::SP_DirIcon);
+    for (const auto& info : m_directory.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name | QDir::IgnoreCase)) {
+        auto item = new QListWidgetItem(folder_icon, info.fileName(), m_listWidget);
+        item->setData(PATH_ROLE, info.absoluteFilePath());
+        item->setData(IS_DIR_ROLE, true);
+    }
+    const auto file_icon = style()->standardIcon(QStyle::SP_FileIcon);
+    m_directory.setNameFilters(m_nameFilters);
+    for (const auto& info : m_directory.entryInfoList(QDir::Files, QDir::Name | QDir::IgnoreCase)) {
+        auto item = new QListWidgetItem(file_icon, info.fileName(), m_listWidget);
+        item->setData(PATH_ROLE, info.absoluteFilePath());
+        item->setData(IS_DIR_ROLE, false);
+        item->setToolTip(QString("%1\n%2 MB").arg(info.fileName(), QString::number(info.size() / 1048576.0, 'f', 1)));
+        m_waiting.insert(info.absoluteFilePath(), item);
+        m_thumbnails->request(info.absoluteFilePath());
+    }
+}
+
+void ThumbnailDialog::goUp()
+{
+    QDir parent = m_directory;
+    if (parent.cdUp()) {
+        setDirectory(parent.absolutePath());
+    }
+}
+
+void ThumbnailDialog::openTypedPath()
+{
+    const QFileInfo info(QDir::fromNativeSeparators(m_pathEdit->text().trimmed()));
+    if (info.isFile()) {
+        m_selectedFile = info.absoluteFilePath();
+        accept();
+    }
+    else {
+        setDirectory(info.absoluteFilePath());
+    }
+}
+
+void ThumbnailDialog::activateItem(QListWidgetItem* item)
+{
+    if (item->data(IS_DIR_ROLE).toBool()) {
+        setDirectory(item->data(PATH_ROLE).toString());
+        return;
+    }
+    m_selectedFile = item->data(PATH_ROLE).toString();
+    accept();
+}
+
+void ThumbnailDialog::acceptSelection()
+{
+    const auto item = m_listWidget->currentItem();
+    if (nullptr != item) {
+        activateItem(item);
+    }
+}
+
+void ThumbnailDialog::handleThumbnailReady(const QString& path, const QImage& image)
+{
+    const auto item = m_waiting.take(path);
+    if (nullptr != item) {
+        item->setIcon(QIcon(QPixmap::fromImage(image)));
+    }
+}
+
+void ThumbnailDialog::handleThumbnailFailed(const QString& path)
+{
+    //keeps the plain file icon
+    m_waiting.remove(path);
+}
@@ -1,14 +1,71 @@
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+
+#include <cstdio>
 
 #include "3DViewer.h"
+#include "OffscreenReplay.h"
+#include "SessionRecording.h"
+#include "WorkspaceSnapshot.h"
+
+namespace {
+    // draws a recorded session headless and writes its frame timings, returns the process exit code
+    int replayOffscreen(const QString& recordingPath, const QString& timingsPath, int frameCount)
+    {
+        const auto recording = RECORDING_API::readRecording(recordingPath);
+        if (nullptr == recording) {
+            return 2;
+        }
+        const auto workspace = WorkspaceSnapshot::restore(RECORDING_API::workspacePath(recordingPath, *recording));
+        if (nullptr == workspace) {
+            qCritical() << "Critical: cannot open the workspace of the session " << recording->workspace;
+            return 2;
+        }
+        FrameTimings timings;
+        timings.recording = QFileInfo(recordingPath).fileName();
+        OffscreenReplay replay;
+        if (!replay.run(*recording, RECORDING_API::resample(recording->frames, frameCount), workspace->objects, timings) ||
+            !RECORDING_API::writeTimings(timingsPath, timings)) {
+            return 2;
+        }
+        const auto summary = RECORDING_API::summarize(timings.frames);
+        std::printf("%s renderer, %d frames at %dx%d: mean %.2f ms, median %.2f ms, 95%% %.2f ms, 99%% %.2f ms, max %.2f ms\n",
+            qPrintable(timings.renderer), static_cast<int>(summary.count), timings.width, timings.height, summary.mean, summary.median,
+            summary.p95, summary.p99, summary.max);
+        return 0;
+    }
+}
 
 int main(int argc, char *argv[]) {
 
 	QApplication app(argc, argv);
     QGuiApplication::setApplicationDisplayName(Viewer::tr("3DViewer"));
 
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Viewer of 3D models.");
+    parser.addHelpOption();
+    QCommandLineOption replay_option("replay", "Replays a recorded session headless and exits, "
+        "with QT_QPA_PLATFORM=offscreen no display is needed.", "recording");
+    QCommandLineOption timings_option("timings", "Frame timings of the replay, <recording>_timings.json by default.", "file");
+    QCommandLineOption frames_option("frames", "Frames the replay draws, one per recorded input by default.", "count", "0");
+    parser.addOptions({ replay_option, timings_option, frames_option });
+    parser.process(app);
+
+    if (parser.isSet(replay_option)) {
+        const auto recording = parser.value(replay_option);
+        auto timings = parser.value(timings_option);
+        if (timings.isEmpty()) {
+            const QFileInfo recording_info(recording);
+            timings = recording_info.dir().filePath(recording_info.completeBaseName() + "_timings.json");
+        }
+        return replayOffscreen(recording, timings, parser.value(frames_option).toInt());
+    }
+
     Viewer viewer;
     viewer.show();
 
     return app.exec();
-}   
\ No newline at end of file
+}
@@ -0,0 +1,155 @@
+#include <QtTest/QtTest>
+
+#include "AdaptiveQuality.h"
+
+namespace {
+    // draws a frame at the time now with input, the GPU reports it as taking cost seconds
+    AdaptiveQuality::Level drawFrame(AdaptiveQuality& quality, double now, double cost, bool hasProxy = true)
+    {
+        quality.inputReceived(now);
+        const auto level = quality.beginFrame(now, hasProxy);
+        quality.frameTimed(level, cost);
+        return level;
+    }
+
+    // the same, with the cost depending on the level drawn
+    AdaptiveQuality::Level drawFrame(AdaptiveQuality& quality, double now, double fullCost, double proxyCost)
+    {
+        quality.inputReceived(now);
+        const auto level = quality.beginFrame(now, true);
+        quality.frameTimed(level, AdaptiveQuality::Level::FULL == level ? fullCost : proxyCost);
+        return level;
+    }
+}
+
+class AdaptiveQualityTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testFastFramesStayFull() {
+        AdaptiveQuality quality(0.05);
+        double now = 1.0;
+        for (int i = 0; i < 20; ++i, now += 0.016) {
+            QCOMPARE(drawFrame(quality, now, 0.01), AdaptiveQuality::Level::FULL);
+        }
+    }
+    void testSlowFramesDegrade() {
+        AdaptiveQuality quality(0.05);
+        double now = 1.0;
+        const auto frame = [&quality, &now](double cost) {
+            const auto level = drawFrame(quality, now, cost);
+            now += 0.016;
+            return level;
+        };
+        QCOMPARE(frame(0.1), AdaptiveQuality::Level::FULL);
+        //a single slow frame is not enough
+        QCOMPARE(frame(0.1), AdaptiveQuality::Level::FULL);
+        QCOMPARE(frame(0.1), AdaptiveQuality::Level::FULL);
+        QCOMPARE(frame(0.1), AdaptiveQuality::Level::PROXY);
+        //the proxy is measured from scratch and is slow too
+        QCOMPARE(frame(0.1), AdaptiveQuality::Level::PROXY);
+        QCOMPARE(frame(0.1), AdaptiveQuality::Level::PROXY);
+        QCOMPARE(frame(0.1), AdaptiveQuality::Level::BOUNDS);
+        QCOMPARE(frame(0.1), AdaptiveQuality::Level::BOUNDS);
+    }
+    void testInputRateIsNotFrameTime() {
+        //input events far apart with cheap frames in between are a slow hand, not a slow frame
+        AdaptiveQuality quality(0.05);
+        double now = 1.0;
+        for (int i = 0; i < 20; ++i, now += 0.1) {
+            QCOMPARE(drawFrame(quality, now, 0.005), AdaptiveQuality::Level::FULL);
+        }
+    }
+    void testWithoutProxy() {
+        AdaptiveQuality quality(0.05);
+        double now = 1.0;
+        for (int i = 0; i < AdaptiveQuality::MIN_SAMPLES; ++i, now += 0.016) {
+            drawFrame(quality, now, 0.1, false);
+        }
+        QCOMPARE(drawFrame(quality, now, 0.1, false), AdaptiveQuality::Level::BOUNDS);
+    }
+    void testUpgradeAgain() {
+        AdaptiveQuality quality(0.05);
+        double now = 1.0;
+        while (AdaptiveQuality::Level::FULL == drawFrame(quality, now, 0.1, 0.01)) {
+            now += 0.016;
+        }
+        QCOMPARE(quality.getLevel(), AdaptiveQuality::Level::PROXY);
+        //the proxy is cheap, the full geometry is tried again once the delay has passed
+        const double proxy_start = now;
+        now += 0.016;
+        while (AdaptiveQuality::Level::PROXY == drawFrame(quality, now, 0.03, 0.01)) {
+            now += 0.016;
+        }
+        QCOMPARE(quality.getLevel(), AdaptiveQuality::Level::FULL);
+        QVERIFY(now - proxy_start >= AdaptiveQuality::UPGRADE_DELAY - 1e-9);
+        QVERIFY(now - proxy_start < AdaptiveQuality::UPGRADE_DELAY + 0.05);
+        now += 0.016;
+        //the full geometry got cheaper meanwhile, it stays
+        for (int i = 0; i < 10; ++i, now += 0.016) {
+            QCOMPARE(drawFrame(quality, now, 0.03, 0.01), AdaptiveQuality::Level::FULL);
+        }
+    }
+    void testFailedUpgradeBacksOff() {
+        AdaptiveQuality quality(0.05);
+        double now = 1.0;
+        //the proxy is cheap, the full geometry is still slow whenever it is tried
+        const auto next = [&quality, &now](AdaptiveQuality::Level level) {
+            const double start = now;
+            while (level != drawFrame(quality, now, 0.1, 0.01)) {
+                now += 0.016;
+            }
+            now += 0.016;
+            return now - start;
+        };
+        next(AdaptiveQuality::Level::PROXY);
+        const auto first = next(AdaptiveQuality::Level::FULL);
+        QVERIFY(first >= AdaptiveQuality::UPGRADE_DELAY);
+        QVERIFY(first < AdaptiveQuality::UPGRADE_DELAY + 0.1);
+        next(AdaptiveQuality::Level::PROXY);
+        const auto second = next(AdaptiveQuality::Level::FULL);
+        QVERIFY(second >= AdaptiveQuality::UPGRADE_DELAY * 2.0);
+        QVERIFY(second < AdaptiveQuality::UPGRADE_DELAY * 2.0 + 0.1);
+    }
+    void testRestoreAfterInput() {
+        AdaptiveQuality quality(0.05);
+        double now = 1.0;
+        for (int i = 0; i <= AdaptiveQuality::MIN_SAMPLES; ++i, now += 0.016) {
+            drawFrame(quality, now, 0.1);
+        }
+        QCOMPARE(quality.getLevel(), AdaptiveQuality::Level::PROXY);
+        QVERIFY(quality.isInteracting(now - 0.016 + AdaptiveQuality::RESTORE_DELAY / 2.0));
+        const double idle = now + AdaptiveQuality::RESTORE_DELAY * 2.0;
+        QVERIFY(!quality.isInteracting(idle));
+        QCOMPARE(quality.beginFrame(idle, true), AdaptiveQuality::Level::FULL);
+
+        //the next drag starts on the level the last one ended with
+        quality.inputReceived(5.0);
+        QCOMPARE(quality.beginFrame(5.0, true), AdaptiveQuality::Level::PROXY);
+        quality.reset();
+        quality.inputReceived(9.0);
+        QCOMPARE(quality.beginFrame(9.0, true), AdaptiveQuality::Level::FULL);
+    }
+    void testCheapIdleFramesRestoreFull() {
+        AdaptiveQuality quality(0.05);
+        double now = 1.0;
+        for (int i = 0; i <= AdaptiveQuality::MIN_SAMPLES; ++i, now += 0.016) {
+            drawFrame(quality, now, 0.1);
+        }
+        QCOMPARE(quality.getLevel(), AdaptiveQuality::Level::PROXY);
+        //full frames drawn without input, after the window was made smaller
+        now += AdaptiveQuality::RESTORE_DELAY * 2.0;
+        for (int i = 0; i < 5; ++i, now += 0.5) {
+            const auto level = quality.beginFrame(now, true);
+            QCOMPARE(level, AdaptiveQuality::Level::FULL);
+            quality.frameTimed(level, 0.02);
+        }
+        QVERIFY(quality.getAverageFrameTime(AdaptiveQuality::Level::FULL) < 0.05);
+        quality.inputReceived(now);
+        QCOMPARE(quality.beginFrame(now, true), AdaptiveQuality::Level::FULL);
+    }
+};
+
+QTEST_APPLESS_MAIN(AdaptiveQualityTest)
+#include "AdaptiveQuality_test.moc"
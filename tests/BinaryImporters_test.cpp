@@ -0,0 +1,310 @@
+#include <QtTest/QtTest>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include "BinaryImporters.h"
+#include "ObjStreamReader.h"
+#include "CgalApi.h"
+#include "MeshExporter.h"
+#include "MemoryTracker.h"
+
+namespace {
+    template <typename T>
+    void appendValue(QByteArray& bytes, const T& value)
+    {
+        bytes.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    bool writeFile(const QString& path, const QByteArray& bytes)
+    {
+        QFile file(path);
+        return file.open(QIODevice::WriteOnly) && file.write(bytes) == bytes.size();
+    }
+
+    QByteArray makeStl(const IndexedMesh& mesh)
+    {
+        QByteArray bytes(80, '\0');
+        appendValue(bytes, static_cast<std::uint32_t>(mesh.numberOfTriangles()));
+        for (std::uint64_t i = 0; i < mesh.indices.size(); i += 3) {
+            appendValue(bytes, QVector3D(0.0f, 0.0f, 0.0f));
+            for (std::uint64_t corner = 0; corner < 3; ++corner) {
+                appendValue(bytes, mesh.positions[mesh.indices[i + corner]]);
+            }
+            appendValue(bytes, static_cast<std::uint16_t>(0));
+        }
+        return bytes;
+    }
+
+    QByteArray makePly(const IndexedMesh& mesh)
+    {
+        QByteArray bytes = "ply\nformat binary_little_endian 1.0\ncomment generated by tests\n"
+            "element vertex " + QByteArray::number(static_cast<qulonglong>(mesh.positions.size())) + "\n"
+            "property float x\nproperty float y\nproperty float z\n"
+            "element face " + QByteArray::number(static_cast<qulonglong>(mesh.numberOfTriangles())) + "\n"
+            "property list uchar int vertex_indices\nend_header\n";
+        bytes.append(reinterpret_cast<const char*>(mesh.positions.data()), static_cast<int>(mesh.positions.sizeInBytes()));
+        for (std::uint64_t i = 0; i < mesh.indices.size(); i += 3) {
+            appendValue(bytes, static_cast<std::uint8_t>(3));
+            for (std::uint64_t corner = 0; corner < 3; ++corner) {
+                appendValue(bytes, static_cast<std::int32_t>(mesh.indices[i + corner]));
+            }
+        }
+        return bytes;
+    }
+
+    QByteArray makeGlb(const IndexedMesh& mesh)
+    {
+        QByteArray bin(reinterpret_cast<const char*>(mesh.positions.data()), static_cast<int>(mesh.positions.sizeInBytes()));
+        bin.append(reinterpret_cast<const char*>(mesh.indices.data()), static_cast<int>(mesh.indices.sizeInBytes()));
+        const QJsonObject gltf{
+            { "asset", QJsonObject{ { "version", "2.0" } } },
+            { "buffers", QJsonArray{ QJsonObject{ { "byteLength", bin.size() } } } },
+            { "bufferViews", QJsonArray{
+                QJsonObject{ { "buffer", 0 }, { "byteOffset", 0 }, { "byteLength", static_cast<qint64>(mesh.positions.sizeInBytes()) } },
+                QJsonObject{ { "buffer", 0 }, { "byteOffset", static_cast<qint64>(mesh.positions.sizeInBytes()) },
+                             { "byteLength", static_cast<qint64>(mesh.indices.sizeInBytes()) } } } },
+            { "accessors", QJsonArray{
+                QJsonObject{ { "bufferView", 0 }, { "componentType", 5126 }, { "count", static_cast<qint64>(mesh.positions.size()) }, { "type", "VEC3" } },
+                QJsonObject{ { "bufferView", 1 }, { "componentType", 5125 }, { "count", static_cast<qint64>(mesh.indices.size()) }, { "type", "SCALAR" } } } },
+            { "meshes", QJsonArray{ QJsonObject{ { "primitives", QJsonArray{
+                QJsonObject{ { "attributes", QJsonObject{ { "POSITION", 0 } } }, { "indices", 1 } } } } } } },
+            { "nodes", QJsonArray{ QJsonObject{ { "mesh", 0 } } } },
+            { "scenes", QJsonArray{ QJsonObject{ { "nodes", QJsonArray{ 0 } } } } },
+            { "scene", 0 }
+        };
+        auto json = QJsonDocument(gltf).toJson(QJsonDocument::Compact);
+        while (json.size() % 4 != 0) json.append(' ');
+        while (bin.size() % 4 != 0) bin.append('\0');
+        QByteArray bytes;
+        appendValue(bytes, static_cast<std::uint32_t>(0x46546C67));
+        appendValue(bytes, static_cast<std::uint32_t>(2));
+        appendValue(bytes, static_cast<std::uint32_t>(12 + 8 + json.size() + 8 + bin.size()));
+        appendValue(bytes, static_cast<std::uint32_t>(json.size()));
+        appendValue(bytes, static_cast<std::uint32_t>(0x4E4F534A));
+        bytes.append(json);
+        appendValue(bytes, static_cast<std::uint32_t>(bin.size()));
+        appendValue(bytes, static_cast<std::uint32_t>(0x004E4942));
+        bytes.append(bin);
+        return bytes;
+    }
+}
+
+class BinaryImportersTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    static void customMessageHandler(QtMsgType type, const QMessageLogContext& context, const QString& msg) {
+        if (type != QtDebugMsg) {
+            QTextStream(stdout) << msg << "\n";
+        }
+    }
+    void initTestCase() {
+        qInstallMessageHandler(customMessageHandler);
+        QVERIFY(m_dir.isValid());
+        //same model in every format
+        const auto& mesh = OBJ_STREAM_API::constructMeshFromObj("FinalBaseMesh.obj");
+        QVERIFY(nullptr != mesh);
+        QVERIFY(writeFile(m_dir.filePath("FinalBaseMesh.stl"), makeStl(*mesh)));
+        QVERIFY(writeFile(m_dir.filePath("FinalBaseMesh.ply"), makePly(*mesh)));
+        QVERIFY(writeFile(m_dir.filePath("FinalBaseMesh.glb"), makeGlb(*mesh)));
+    }
+    void cleanupTestCase() {
+        qInstallMessageHandler(nullptr);
+    }
+    void testInvalidFiles() {
+        QVERIFY(nullptr == IMPORT_API::constructMeshFromStl("abc.stl"));
+        QVERIFY(nullptr == IMPORT_API::constructMeshFromPly("tmp.obj"));
+        QVERIFY(nullptr == IMPORT_API::constructMeshFromGlb("FinalBaseMesh.obj"));
+    }
+    void testStlWelding() {
+        const auto& result = IMPORT_API::constructMeshFromStl(m_dir.filePath("FinalBaseMesh.stl").toStdString());
+        QVERIFY(nullptr != result);
+        QCOMPARE(result->num_faces, static_cast<std::uint64_t>(48918));
+        //corners of the soup are welded back to the shared vertices
+        QVERIFY(result->num_vertices > 0);
+        QVERIFY(result->num_vertices <= static_cast<std::uint64_t>(24461));
+        QCOMPARE(result->normals.size(), result->positions.size());
+    }
+    void testPly() {
+        const auto& result = IMPORT_API::constructMeshFromPly(m_dir.filePath("FinalBaseMesh.ply").toStdString());
+        QVERIFY(nullptr != result);
+        QCOMPARE(result->num_vertices, static_cast<std::uint64_t>(24461));
+        QCOMPARE(result->num_faces, static_cast<std::uint64_t>(48918));
+    }
+    void testBigEndianPly() {
+        QByteArray bytes = "ply\nformat binary_big_endian 1.0\nelement vertex 4\nproperty double x\nproperty double y\n"
+            "property double z\nproperty uchar red\nelement face 1\nproperty list uchar ushort vertex_indices\nend_header\n";
+        auto appendBigEndian = [&bytes](auto value) {
+            QByteArray raw(reinterpret_cast<const char*>(&value), sizeof(value));
+            std::reverse(raw.begin(), raw.end());
+            bytes.append(raw);
+        };
+        const double quad[4][3] = { { 0, 0, 0 }, { 1, 0, 0 }, { 1, 1, 0 }, { 0, 1, 0 } };
+        for (const auto& vertex : quad) {
+            for (const auto coord : vertex) {
+                appendBigEndian(coord);
+            }
+            appendBigEndian(static_cast<std::uint8_t>(255));
+        }
+        appendBigEndian(static_cast<std::uint8_t>(4));
+        for (std::uint16_t index = 0; index < 4; ++index) {
+            appendBigEndian(index);
+        }
+        QVERIFY(writeFile(m_dir.filePath("quad.ply"), bytes));
+        const auto& result = IMPORT_API::constructMeshFromPly(m_dir.filePath("quad.ply").toStdString());
+        QVERIFY(nullptr != result);
+        QCOMPARE(result->num_faces, static_cast<std::uint64_t>(2));
+        QVERIFY(qFuzzyCompare(result->positions[2], QVector3D(1.0f, 1.0f, 0.0f)));
+        QCOMPARE(result->indices[5], 3u);
+        //four sides and the diagonal of the fan
+        QCOMPARE(result->num_edges, static_cast<std::uint64_t>(5));
+    }
+    void testGlb() {
+        const auto& result = IMPORT_API::constructMeshFromGlb(m_dir.filePath("FinalBaseMesh.glb").toStdString());
+        QVERIFY(nullptr != result);
+        QCOMPARE(result->num_vertices, static_cast<std::uint64_t>(24461));
+        QCOMPARE(result->num_faces, static_cast<std::uint64_t>(48918));
+        const auto& constructed = CGAL_API::constructMeshFromObj("FinalBaseMesh.obj");
+        QVERIFY(nullptr != constructed);
+        QCOMPARE(result->num_edges, static_cast<std::uint64_t>(constructed->number_of_edges()));
+    }
+    void testExportRoundTrip_data() {
+        QTest::addColumn<QString>("suffix");
+        QTest::newRow("obj") << "obj";
+        QTest::newRow("ply") << "ply";
+        QTest::newRow("stl") << "stl";
+    }
+    void testExportRoundTrip() {
+        QFETCH(QString, suffix);
+        const auto& mesh = CGAL_API::constructMeshFromObj("FinalBaseMesh.obj");
+        QVERIFY(nullptr != mesh);
+        MappedArray<Vertex> soup;
+        QVERIFY(CGAL_API::buildTriangleSoup(mesh, CGAL_API::computeVertexNormals(mesh), soup));
+        QVector3D min_bounds, max_bounds;
+        MESH_API::computeBounds(soup, min_bounds, max_bounds);
+        //a quarter turn around z followed by a shift, x of the result is -y of the source
+        ExportPart part;
+        part.name = "FinalBaseMesh";
+        part.soup = &soup;
+        part.model.translate(10.0f, 0.0f, 0.0f);
+        part.model.rotate(90.0f, 0.0f, 0.0f, 1.0f);
+        EXPORT_API::Format format;
+        QVERIFY(EXPORT_API::formatFromSuffix(suffix, format));
+        const auto path = m_dir.filePath("exported." + suffix);
+        QVERIFY(EXPORT_API::exportMeshes(path, format, { part }));
+
+        std::unique_ptr<IndexedMesh> result;
+        if ("obj" == suffix) {
+            result = OBJ_STREAM_API::constructMeshFromObj(path.toStdString());
+        }
+        else if ("ply" == suffix) {
+            result = IMPORT_API::constructMeshFromPly(path.toStdString());
+        }
+        else {
+            result = IMPORT_API::constructMeshFromStl(path.toStdString());
+        }
+        QVERIFY(nullptr != result);
+        QCOMPARE(result->numberOfTriangles(), soup.size() / 3);
+        QVector3D result_min = result->positions[0], result_max = result->positions[0];
+        for (const auto& position : result->positions) {
+            for (int axis = 0; axis < 3; ++axis) {
+                result_min[axis] = std::min(result_min[axis], position[axis]);
+                result_max[axis] = std::max(result_max[axis], position[axis]);
+            }
+        }
+        QVERIFY(std::abs(result_min.x() - (10.0f - max_bounds.y())) < 1e-4f);
+        QVERIFY(std::abs(result_max.y() - max_bounds.x()) < 1e-4f);
+        QVERIFY(std::abs(result_min.z() - min_bounds.z()) < 1e-4f);
+        QVERIFY(std::abs(result_max.z() - max_bounds.z()) < 1e-4f);
+    }
+    void testExportObjMaterials() {
+        //a quad of two triangles, one material each, with texture coordinates equal to the positions
+        MappedArray<Vertex> soup;
+        QVERIFY(soup.allocate(6));
+        const QVector3D corners[6] = { { 0, 0, 0 }, { 1, 0, 0 }, { 1, 1, 0 }, { 0, 0, 0 }, { 1, 1, 0 }, { 0, 1, 0 } };
+        for (int i = 0; i < 6; ++i) {
+            soup[i] = { corners[i], QVector3D(0.0f, 0.0f, 1.0f), QVector2D(corners[i].x(), corners[i].y()) };
+        }
+        std::vector<SurfaceMaterial> materials(2);
+        materials[0].name = "red";
+        materials[0].diffuse = QVector3D(1.0f, 0.0f, 0.0f);
+        materials[0].diffuseMap = m_dir.filePath("maps/red.png");
+        materials[1].name = "blue";
+        materials[1].bumpMap = m_dir.filePath("blue_height.png");
+        materials[1].bumpScale = 0.5f;
+        const auto ranges = MTL_API::buildMaterialRanges({ 0, 1 });
+        ExportPart part;
+        part.name = "quad";
+        part.soup = &soup;
+        part.materials = &materials;
+        part.materialRanges = &ranges;
+        const auto path = m_dir.filePath("materials.obj");
+        {
+            MemoryTracker::LoadScope scope;
+            QVERIFY(EXPORT_API::exportMeshes(path, EXPORT_API::Format::OBJ, { part }));
+            //the buffer pool is reported while the file is written
+            QVERIFY(scope.getPeak() >= EXPORT_API::BUFFER_POOL_SIZE);
+        }
+        QVERIFY(QFileInfo::exists(m_dir.filePath("materials.mtl")));
+
+        SurfaceAttributes attributes;
+        const auto& mesh = CGAL_API::constructMeshFromObj(path.toStdString(), &attributes);
+        QVERIFY(nullptr != mesh);
+        QCOMPARE(attributes.materials.size(), static_cast<std::size_t>(2));
+        QCOMPARE(attributes.materials[0].name, QString("p0_red"));
+        QCOMPARE(attributes.materials[0].diffuse, QVector3D(1.0f, 0.0f, 0.0f));
+        QCOMPARE(attributes.materials[0].diffuseMap, QDir::cleanPath(m_dir.filePath("maps/red.png")));
+        QCOMPARE(attributes.materials[1].bumpMap, QDir::cleanPath(m_dir.filePath("blue_height.png")));
+        QCOMPARE(attributes.materials[1].bumpScale, 0.5f);
+        QCOMPARE(attributes.faceMaterials, std::vector<int>({ 0, 1 }));
+        MappedArray<Vertex> result;
+        QVERIFY(CGAL_API::buildTriangleSoup(mesh, CGAL_API::computeVertexNormals(mesh), result, &attributes));
+        QCOMPARE(result.size(), soup.size());
+        for (const auto& vertex : result) {
+            QCOMPARE(vertex.texture, QVector2D(vertex.position.x(), vertex.position.y()));
+        }
+    }
+    void testExportUnknownFormat() {
+        EXPORT_API::Format format;
+        QVERIFY(!EXPORT_API::formatFromSuffix("glb", format));
+    }
+    void benchmarkLoad_data() {
+        QTest::addColumn<QString>("format");
+        QTest::newRow("obj-cgal") << "obj-cgal";
+        QTest::newRow("obj-stream") << "obj-stream";
+        QTest::newRow("stl") << "stl";
+        QTest::newRow("ply") << "ply";
+        QTest::newRow("glb") << "glb";
+    }
+    void benchmarkLoad() {
+        QFETCH(QString, format);
+        const auto stem = m_dir.filePath("FinalBaseMesh.").toStdString();
+        bool loaded = false;
+        QBENCHMARK {
+            if ("obj-cgal" == format) {
+                loaded = nullptr != CGAL_API::constructMeshFromObj("FinalBaseMesh.obj");
+            }
+            else if ("obj-stream" == format) {
+                loaded = nullptr != OBJ_STREAM_API::constructMeshFromObj("FinalBaseMesh.obj");
+            }
+            else if ("stl" == format) {
+                loaded = nullptr != IMPORT_API::constructMeshFromStl(stem + "stl");
+            }
+            else if ("ply" == format) {
+                loaded = nullptr != IMPORT_API::constructMeshFromPly(stem + "ply");
+            }
+            else {
+                loaded = nullptr != IMPORT_API::constructMeshFromGlb(stem + "glb");
+            }
+        }
+        QVERIFY(loaded);
+    }
+
+private:
+    QTemporaryDir m_dir;
+};
+
+QTEST_APPLESS_MAIN(BinaryImportersTest)
+#include "BinaryImporters_test.moc"
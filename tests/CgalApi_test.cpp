@@ -1,11 +1,48 @@
 #include <QtTest/QtTest>
 
+#include <algorithm>
+#include <cstring>
+
 #include "CgalApi.h"
+#include "CrossSection.h"
+#include "IndexedMesh.h"
+#include "MeshCache.h"
 
 class CgalApiTest : public QObject
 {
     Q_OBJECT
 
+private:
+    // side walls of the box [min, max] x [min, max] x [0, 1] as a soup, facing out or in
+    static void appendWalls(std::vector<Vertex>& soup, float min, float max, bool inward) {
+        const QVector3D corners[4] = { { min, min, 0.0f }, { max, min, 0.0f }, { max, max, 0.0f }, { min, max, 0.0f } };
+        const QVector3D up(0.0f, 0.0f, 1.0f);
+        for (int i = 0; i < 4; ++i) {
+            const auto& a = corners[i];
+            const auto& b = corners[(i + 1) % 4];
+            QVector3D quad[4] = { a, b, b + up, a + up };
+            if (inward) {
+                std::swap(quad[1], quad[3]);
+            }
+            for (const int corner : { 0, 1, 2, 0, 2, 3 }) {
+                soup.push_back({ quad[corner], QVector3D(), QVector2D() });
+            }
+        }
+    }
+    static void toSoup(const std::vector<Vertex>& vertices, MappedArray<Vertex>& soup) {
+        QVERIFY(soup.allocate(vertices.size()));
+        std::copy(vertices.begin(), vertices.end(), soup.begin());
+    }
+    static float capArea(const CrossSection& section) {
+        float area = 0.0f;
+        for (std::size_t i = 0; i + 2 < section.cap.size(); i += 3) {
+            const auto normal = QVector3D::crossProduct(section.cap[i + 1] - section.cap[i], section.cap[i + 2] - section.cap[i]);
+            //facing the removed side
+            area -= QVector3D::dotProduct(normal, section.normal) * 0.5f;
+        }
+        return area;
+    }
+
 private slots:
     static void customMessageHandler(QtMsgType type, const QMessageLogContext& context, const QString& msg) {
         if (type != QtDebugMsg) {
@@ -38,6 +75,188 @@ private slots:
         // compare edges
         QCOMPARE(result->number_of_edges(), 73377);
     }
+    void testConstructMeshFromQuadObj() {
+        QTemporaryDir dir;
+        const auto path = dir.filePath("cube.obj");
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        //unit cube of quads, the last face with relative indices
+        file.write("# cube\no cube\n"
+            "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nv 0 0 1\nv 1 0 1\nv 1 1 1\nv 0 1 1\n"
+            "vn 0 0 1\n"
+            "f 1 4 3 2\nf 5 6 7 8\nf 1 2 6 5\nf 2 3 7 6\nf 3 4 8 7\r\nf -4 -1 -5 -8\n");
+        file.close();
+        const auto& result = CGAL_API::constructMeshFromObj(path.toStdString());
+        QVERIFY(nullptr != result);
+        QVERIFY(CGAL::is_triangle_mesh(*result));
+        QCOMPARE(result->number_of_vertices(), 8);
+        QCOMPARE(result->number_of_faces(), 12);
+        QCOMPARE(result->number_of_edges(), 18);
+    }
+    void testConstructMeshFromObjWithInvalidIndex() {
+        QTemporaryDir dir;
+        const auto path = dir.filePath("invalid.obj");
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("v 0 0 0\nv 1 0 0\nv 1 1 0\nf 1 2 4\n");
+        file.close();
+        QVERIFY(nullptr == CGAL_API::constructMeshFromObj(path.toStdString()));
+    }
+    void testBuildTriangleSoup() {
+        const auto& result = CGAL_API::constructMeshFromObj("FinalBaseMesh.obj");
+        QVERIFY(nullptr != result);
+        const auto normals = CGAL_API::computeVertexNormals(result);
+        QCOMPARE(normals.size(), static_cast<std::size_t>(result->number_of_vertices()));
+        MappedArray<Vertex> soup;
+        QVERIFY(CGAL_API::buildTriangleSoup(result, normals, soup));
+        QCOMPARE(soup.size(), static_cast<std::uint64_t>(result->number_of_faces()) * 3);
+        for (const auto& vertex : soup) {
+            QVERIFY(qFuzzyCompare(vertex.normal.length(), 1.0f));
+        }
+    }
+    void testBuildClusteredProxy() {
+        const auto& result = CGAL_API::constructMeshFromObj("FinalBaseMesh.obj");
+        QVERIFY(nullptr != result);
+        MappedArray<Vertex> soup;
+        QVERIFY(CGAL_API::buildTriangleSoup(result, CGAL_API::computeVertexNormals(result), soup));
+        QVector3D min_bounds, max_bounds;
+        MESH_API::computeBounds(soup, min_bounds, max_bounds);
+        const std::uint64_t budget = soup.size() / 3 / 8;
+        MappedArray<Vertex> proxy;
+        QVERIFY(MESH_API::buildClusteredProxy(soup, min_bounds, max_bounds, budget, proxy));
+        QVERIFY(!proxy.isEmpty());
+        QVERIFY(proxy.size() < soup.size());
+        for (const auto& vertex : proxy) {
+            //cell averages stay inside the bounds of the source
+            QVERIFY(vertex.position.x() >= min_bounds.x() - 1e-4f && vertex.position.x() <= max_bounds.x() + 1e-4f);
+            QVERIFY(vertex.position.y() >= min_bounds.y() - 1e-4f && vertex.position.y() <= max_bounds.y() + 1e-4f);
+            QVERIFY(vertex.position.z() >= min_bounds.z() - 1e-4f && vertex.position.z() <= max_bounds.z() + 1e-4f);
+        }
+    }
+    void testMeshCacheRoundTrip() {
+        const auto& result = CGAL_API::constructMeshFromObj("FinalBaseMesh.obj");
+        QVERIFY(nullptr != result);
+        CachedMesh cached;
+        QVERIFY(CGAL_API::buildTriangleSoup(result, CGAL_API::computeVertexNormals(result), cached.vertices));
+        MESH_API::computeBounds(cached.vertices, cached.minBounds, cached.maxBounds);
+        cached.num_vertices = result->number_of_vertices();
+        cached.num_faces = result->number_of_faces();
+        cached.num_edges = result->number_of_edges();
+        QTemporaryDir dir;
+        const auto path = dir.filePath("FinalBaseMesh.3dvc");
+        QVERIFY(CACHE_API::writeMeshCache(path, cached));
+
+        const auto restored = CACHE_API::readMeshCache(path);
+        QVERIFY(nullptr != restored);
+        QVERIFY(restored->vertices.isOutOfCore());
+        QCOMPARE(restored->vertices.size(), cached.vertices.size());
+        QCOMPARE(restored->num_vertices, cached.num_vertices);
+        QCOMPARE(restored->num_faces, cached.num_faces);
+        QCOMPARE(restored->num_edges, cached.num_edges);
+        QCOMPARE(restored->minBounds, cached.minBounds);
+        QCOMPARE(restored->maxBounds, cached.maxBounds);
+        QVERIFY(0 == std::memcmp(restored->vertices.data(), cached.vertices.data(), cached.vertices.sizeInBytes()));
+    }
+    void testMeshCacheSourceChanged() {
+        QTemporaryDir dir;
+        const auto source_path = dir.filePath("model.obj");
+        QFile source(source_path);
+        QVERIFY(source.open(QIODevice::WriteOnly));
+        source.write("v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n");
+        source.close();
+        const QFileInfo source_info(source_path);
+        CachedMesh cached;
+        QVERIFY(cached.vertices.allocate(3));
+        cached.sourcePath = source_info.absoluteFilePath();
+        cached.sourceSize = static_cast<std::uint64_t>(source_info.size());
+        cached.sourceModified = source_info.lastModified().toMSecsSinceEpoch();
+        const auto path = dir.filePath("model.3dvc");
+        QVERIFY(CACHE_API::writeMeshCache(path, cached));
+
+        auto restored = CACHE_API::readMeshCache(path);
+        QVERIFY(nullptr != restored);
+        QCOMPARE(restored->sourcePath, cached.sourcePath);
+        QCOMPARE(restored->vertices.size(), static_cast<std::uint64_t>(3));
+        QVERIFY(!CACHE_API::isSourceChanged(*restored));
+        //edited model
+        QVERIFY(source.open(QIODevice::Append));
+        source.write("v 0 0 1\n");
+        source.close();
+        QVERIFY(CACHE_API::isSourceChanged(*restored));
+        //same size, touched later
+        restored->sourceSize = static_cast<std::uint64_t>(QFileInfo(source_path).size());
+        const auto modified = QDateTime::fromMSecsSinceEpoch(cached.sourceModified);
+        QVERIFY(source.open(QIODevice::ReadWrite));
+        QVERIFY(source.setFileTime(modified.addSecs(60), QFileDevice::FileModificationTime));
+        QVERIFY(CACHE_API::isSourceChanged(*restored));
+        QVERIFY(source.setFileTime(modified, QFileDevice::FileModificationTime));
+        source.close();
+        QVERIFY(!CACHE_API::isSourceChanged(*restored));
+        //nothing to rebuild from
+        QVERIFY(QFile::remove(source_path));
+        QVERIFY(!CACHE_API::isSourceChanged(*restored));
+    }
+    void testReadInvalidMeshCache() {
+        QTemporaryDir dir;
+        const auto path = dir.filePath("invalid.3dvc");
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(QByteArray(8192, 'x'));
+        file.close();
+        QVERIFY(nullptr == CACHE_API::readMeshCache(path));
+    }
+    void testSliceTriangleSoup() {
+        std::vector<Vertex> vertices;
+        appendWalls(vertices, 0.0f, 1.0f, false);
+        MappedArray<Vertex> soup;
+        toSoup(vertices, soup);
+        CrossSection section;
+        QVERIFY(SECTION_API::sliceTriangleSoup(soup, QVector3D(0.0f, 0.0f, 1.0f), 0.5f, section));
+        QCOMPARE(section.contours.size(), static_cast<std::size_t>(1));
+        QVERIFY(section.contours[0].closed);
+        //four vertical edges and four diagonals are crossed
+        QCOMPARE(section.contours[0].points.size(), static_cast<std::size_t>(8));
+        for (const auto& point : section.contours[0].points) {
+            QVERIFY(qFuzzyCompare(point.z(), 0.5f));
+        }
+        QVERIFY(SECTION_API::sliceTriangleSoup(soup, QVector3D(0.0f, 0.0f, 1.0f), 2.0f, section));
+        QVERIFY(section.contours.empty());
+    }
+    void testSliceOpenSurface() {
+        //a single wall leaves the contour open
+        std::vector<Vertex> vertices;
+        appendWalls(vertices, 0.0f, 1.0f, false);
+        vertices.resize(6);
+        MappedArray<Vertex> soup;
+        toSoup(vertices, soup);
+        CrossSection section;
+        QVERIFY(SECTION_API::sliceTriangleSoup(soup, QVector3D(0.0f, 0.0f, 1.0f), 0.5f, section));
+        QCOMPARE(section.contours.size(), static_cast<std::size_t>(1));
+        QVERIFY(!section.contours[0].closed);
+        QCOMPARE(section.contours[0].points.size(), static_cast<std::size_t>(3));
+        QVERIFY(CGAL_API::triangulateSectionCap(section));
+        QVERIFY(section.cap.empty());
+    }
+    void testTriangulateSectionCap() {
+        //a square tube, the inner contour is a hole of the cap
+        std::vector<Vertex> vertices;
+        appendWalls(vertices, 0.0f, 1.0f, false);
+        appendWalls(vertices, 0.25f, 0.75f, true);
+        MappedArray<Vertex> soup;
+        toSoup(vertices, soup);
+        CrossSection section;
+        QVector3D normal;
+        float offset = 0.0f;
+        SECTION_API::axisPlane(QVector3D(0.0f, 0.0f, 0.0f), QVector3D(1.0f, 1.0f, 1.0f), 2, 0.5f, true, normal, offset);
+        QVERIFY(SECTION_API::sliceTriangleSoup(soup, normal, offset, section));
+        QCOMPARE(section.contours.size(), static_cast<std::size_t>(2));
+        QVERIFY(CGAL_API::triangulateSectionCap(section));
+        QVERIFY(!section.cap.empty());
+        QVERIFY(std::abs(capArea(section) - 0.75f) < 1e-4f);
+        for (const auto& point : section.cap) {
+            QVERIFY(std::abs(point.z() - 0.5f) < 1e-5f);
+        }
+    }
 };
 
 QTEST_APPLESS_MAIN(CgalApiTest)
@@ -0,0 +1,91 @@
+#include <QtTest/QtTest>
+
+#include "ClearanceChecker.h"
+#include "TestObjects.h"
+
+class ClearanceCheckerTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    // the result of a check is handed over through the event loop
+    static bool waitForCheck(const ClearanceChecker& checker) {
+        QElapsedTimer timer;
+        timer.start();
+        while (checker.isChecking() && timer.elapsed() < 10000) {
+            QTest::qWait(10);
+        }
+        return !checker.isChecking();
+    }
+
+private slots:
+    void testMoveKeepsHierarchies() {
+        const auto a = TEST_FIXTURES::makeTriangle(1.0f);
+        const auto b = TEST_FIXTURES::makeTriangle(1.0f);
+        QVERIFY(nullptr != a && nullptr != b);
+        ClearanceChecker checker;
+        checker.setObjects({ a, b });
+        checker.setEnabled(true);
+        QVERIFY(waitForCheck(checker));
+        //both are placed around the origin, on top of each other
+        QCOMPARE(checker.getContacts().size(), 1);
+        QVERIFY(checker.getContacts().begin()->intersecting);
+        const auto bvh_a = checker.getHierarchy(a->getID());
+        const auto bvh_b = checker.getHierarchy(b->getID());
+        QVERIFY(nullptr != bvh_a && nullptr != bvh_b);
+
+        b->setTranslationVec(b->getTranslationVec() + QVector3D(10.0f, 0.0f, 0.0f));
+        checker.markMoved(b->getID());
+        QVERIFY(waitForCheck(checker));
+        QVERIFY(checker.getContacts().isEmpty());
+        //a move tests the pair again on the hierarchies already built
+        QCOMPARE(checker.getHierarchy(a->getID()), bvh_a);
+        QCOMPARE(checker.getHierarchy(b->getID()), bvh_b);
+        QCOMPARE(MemoryTracker::getCacheBytes(ClearanceChecker::MEMORY_CACHE), bvh_a->sizeInBytes() + bvh_b->sizeInBytes());
+    }
+    void testNewGeometryIsRebuilt() {
+        const auto a = TEST_FIXTURES::makeTriangle(1.0f);
+        const auto b = TEST_FIXTURES::makeTriangle(1.0f);
+        QVERIFY(nullptr != a && nullptr != b);
+        ClearanceChecker checker;
+        checker.setObjects({ a, b });
+        checker.setEnabled(true);
+        QVERIFY(waitForCheck(checker));
+        const auto bvh_a = checker.getHierarchy(a->getID());
+        const auto bvh_b = checker.getHierarchy(b->getID());
+
+        const auto reloaded = TEST_FIXTURES::makeTriangle(4.0f);
+        QVERIFY(nullptr != reloaded);
+        QVERIFY(a->swapGeometry(*reloaded));
+        checker.markMoved(a->getID());
+        QVERIFY(waitForCheck(checker));
+        const auto rebuilt = checker.getHierarchy(a->getID());
+        QVERIFY(nullptr != rebuilt);
+        QVERIFY(rebuilt != bvh_a);
+        QCOMPARE(rebuilt->nodes.front().maxBounds, QVector3D(4.0f, 4.0f, 0.0f));
+        QCOMPARE(checker.getHierarchy(b->getID()), bvh_b);
+        //the highlight follows the new geometry
+        QCOMPARE(checker.getHighlight(a->getID()).version, a->getGeometryVersion());
+    }
+    void testRemoveDropsHierarchy() {
+        const auto a = TEST_FIXTURES::makeTriangle(1.0f);
+        const auto b = TEST_FIXTURES::makeTriangle(1.0f);
+        QVERIFY(nullptr != a && nullptr != b);
+        {
+            ClearanceChecker checker;
+            checker.setObjects({ a, b });
+            checker.setEnabled(true);
+            QVERIFY(waitForCheck(checker));
+            const auto bytes = MemoryTracker::getCacheBytes(ClearanceChecker::MEMORY_CACHE);
+            checker.setObjects({ a });
+            checker.removeObject(b->getID());
+            QVERIFY(nullptr == checker.getHierarchy(b->getID()));
+            QVERIFY(checker.getContacts().isEmpty());
+            QVERIFY(MemoryTracker::getCacheBytes(ClearanceChecker::MEMORY_CACHE) < bytes);
+        }
+        QCOMPARE(MemoryTracker::getCacheBytes(ClearanceChecker::MEMORY_CACHE), std::uint64_t(0));
+    }
+};
+
+QTEST_MAIN(ClearanceCheckerTest)
+#include "ClearanceChecker_test.moc"
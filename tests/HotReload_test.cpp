@@ -0,0 +1,115 @@
+#include <QtTest/QtTest>
+
+#include <thread>
+
+#include "ReloadTracker.h"
+#include "SceneObject.h"
+#include "TestObjects.h"
+
+class HotReloadTest : public QObject
+{
+    Q_OBJECT
+
+private:
+
+private slots:
+    void testLatestGenerationWins() {
+        ReloadTracker tracker;
+        const auto first = tracker.begin(1);
+        const auto second = tracker.begin(1);
+        QVERIFY(second.generation > first.generation);
+        QVERIFY(first.token.isCancelled());
+        QVERIFY(!second.token.isCancelled());
+        QVERIFY(tracker.isReloading(1));
+        //the superseded result arriving late is dropped
+        QVERIFY(!tracker.finish(1, first.generation));
+        QVERIFY(tracker.isReloading(1));
+        QVERIFY(tracker.finish(1, second.generation));
+        QVERIFY(!tracker.isReloading(1));
+        //still stale after the latest one finished
+        QVERIFY(!tracker.finish(1, first.generation));
+        //the objects are independent
+        QCOMPARE(tracker.begin(2).generation, first.generation);
+    }
+    void testNextReloadRunsAfterPrevious() {
+        ReloadTracker tracker;
+        QVERIFY(tracker.begin(1).previous.empty());
+        const auto job = JobSystem::instance().submit([]() {});
+        tracker.setJob(1, job);
+        const auto next = tracker.begin(1);
+        QCOMPARE(next.previous.size(), std::size_t(1));
+        QCOMPARE(next.previous.front(), job);
+        JobSystem::instance().wait(job);
+    }
+    void testSupersededJobIsCancelled() {
+        ReloadTracker tracker;
+        std::atomic<bool> release(false);
+        std::atomic<bool> ran(false);
+        //keeps the reload waiting until it is superseded
+        const auto blocker = JobSystem::instance().submit([&release]() {
+            while (!release) {
+                std::this_thread::yield();
+            }
+        });
+        const auto reload = tracker.begin(1);
+        const auto job = JobSystem::instance().submit([&ran]() { ran = true; }, JobSystem::Priority::LOAD,
+            { blocker }, reload.token);
+        tracker.setJob(1, job);
+        const auto next = tracker.begin(1);
+        release = true;
+        JobSystem::instance().wait(job);
+        QVERIFY(!ran);
+        QVERIFY(job->wasCancelled());
+        QVERIFY(!next.token.isCancelled());
+    }
+    void testRemoveCancels() {
+        ReloadTracker tracker;
+        const auto reload = tracker.begin(3);
+        tracker.remove(3);
+        QVERIFY(reload.token.isCancelled());
+        QVERIFY(!tracker.isReloading(3));
+        QVERIFY(!tracker.finish(3, reload.generation + 1));
+        const auto other = tracker.begin(4);
+        tracker.cancelAll();
+        QVERIFY(other.token.isCancelled());
+    }
+    void testSwapGeometry() {
+        const auto target = TEST_FIXTURES::makeTriangle(1.0f);
+        const auto pending = TEST_FIXTURES::makeTriangle(4.0f);
+        QVERIFY(nullptr != target && nullptr != pending);
+        const auto id = target->getID();
+        const auto version = target->getGeometryVersion();
+        target->setTranslationVec(QVector3D(1.0f, 2.0f, 3.0f));
+
+        QVERIFY(target->swapGeometry(*pending));
+        QCOMPARE(target->getID(), id);
+        QCOMPARE(target->getGeometryVersion(), version + 1);
+        QCOMPARE(target->getNumberOfVertices(), std::uint64_t(3));
+        QCOMPARE(target->vertices[1].position, QVector3D(4.0f, 0.0f, 0.0f));
+        QCOMPARE(target->getMaxBounds(), QVector3D(4.0f, 4.0f, 0.0f));
+        //the transform stays with the object
+        QCOMPARE(target->getTranslationVec(), QVector3D(1.0f, 2.0f, 3.0f));
+        QCOMPARE(pending->getUploadState(), SceneObject::UploadState::RELEASED);
+    }
+    void testSwapWaitsForGeometryLock() {
+        const auto target = TEST_FIXTURES::makeTriangle(1.0f);
+        const auto pending = TEST_FIXTURES::makeTriangle(2.0f);
+        QVERIFY(nullptr != target && nullptr != pending);
+        const auto version = target->getGeometryVersion();
+        bool swapped = true;
+        {
+            const auto lock = target->lockGeometry();
+            //the render thread never blocks on a reader of the GUI thread
+            std::thread render([&]() { swapped = target->swapGeometry(*pending); });
+            render.join();
+        }
+        QVERIFY(!swapped);
+        QCOMPARE(target->getGeometryVersion(), version);
+        QCOMPARE(target->getMaxBounds(), QVector3D(1.0f, 1.0f, 0.0f));
+        QVERIFY(target->swapGeometry(*pending));
+        QCOMPARE(target->getMaxBounds(), QVector3D(2.0f, 2.0f, 0.0f));
+    }
+};
+
+QTEST_MAIN(HotReloadTest)
+#include "HotReload_test.moc"
@@ -0,0 +1,186 @@
+#include <QtTest/QtTest>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "JobSystem.h"
+
+class JobSystemTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testDependencies() {
+        JobSystem jobs(4);
+        std::atomic<int> step{ 0 };
+        int first_step = -1;
+        int second_step = -1;
+        const auto first = jobs.submit([&]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            first_step = step++;
+        });
+        const auto second = jobs.submit([&]() { second_step = step++; }, JobSystem::Priority::LOAD, { first });
+        jobs.wait(second);
+        QVERIFY(first->isFinished());
+        QCOMPARE(first_step, 0);
+        QCOMPARE(second_step, 1);
+    }
+    void testCancellation() {
+        JobSystem jobs(2);
+        JobSystem::CancellationToken token;
+        std::atomic<bool> started{ false };
+        std::atomic<bool> release{ false };
+        bool noticed = false;
+        const auto running = jobs.submit([&]() {
+            started = true;
+            while (!release) {
+                std::this_thread::yield();
+            }
+            noticed = JobSystem::cancellationRequested();
+        }, JobSystem::Priority::LOAD, {}, token);
+        bool executed = false;
+        const auto blocked = jobs.submit([&]() { executed = true; }, JobSystem::Priority::LOAD, { running }, token);
+        while (!started) {
+            std::this_thread::yield();
+        }
+        token.cancel();
+        release = true;
+        jobs.wait(blocked);
+        //the running job polls the token, the dependent one is skipped
+        QVERIFY(noticed);
+        QVERIFY(!running->wasCancelled());
+        QVERIFY(blocked->wasCancelled());
+        QVERIFY(!executed);
+    }
+    void testParallelFor() {
+        JobSystem jobs(4);
+        const std::uint64_t count = 100003;
+        std::vector<int> visits(count, 0);
+        jobs.parallelFor(count, 1000, [&visits](std::uint64_t begin, std::uint64_t end) {
+            for (auto i = begin; i < end; ++i) {
+                ++visits[i];
+            }
+        });
+        for (const auto visit : visits) {
+            QCOMPARE(visit, 1);
+        }
+    }
+    void testNestedParallelFor() {
+        //the workers help while waiting, nested loops on a small pool do not deadlock
+        JobSystem jobs(2);
+        std::atomic<std::uint64_t> sum{ 0 };
+        std::vector<JobSystem::JobHandle> handles;
+        for (int i = 0; i < 8; ++i) {
+            handles.push_back(jobs.submit([&jobs, &sum]() {
+                jobs.parallelFor(1000, 10, [&sum](std::uint64_t begin, std::uint64_t end) {
+                    sum += end - begin;
+                });
+            }));
+        }
+        jobs.wait(handles);
+        QCOMPARE(sum.load(), static_cast<std::uint64_t>(8000));
+
+        const auto stats = jobs.getWorkerStats();
+        QCOMPARE(stats.size(), static_cast<std::size_t>(2));
+        std::uint64_t executed = 0;
+        for (const auto& worker : stats) {
+            executed += worker.executed;
+        }
+        QVERIFY(executed > 0);
+    }
+    void testWaitHelpsOnlyOwnFamily() {
+        JobSystem jobs(2);
+        std::atomic<bool> child_started{ false };
+        std::atomic<bool> release{ false };
+        std::atomic<bool> outer_finished{ false };
+        std::thread::id outer_thread;
+        const auto outer = jobs.submit([&]() {
+            outer_thread = std::this_thread::get_id();
+            //the second range is left to the other worker, the first one waits for it
+            jobs.parallelFor(2, 1, [&](std::uint64_t begin, std::uint64_t) {
+                if (0 == begin) {
+                    while (!child_started) {
+                        std::this_thread::yield();
+                    }
+                    return;
+                }
+                child_started = true;
+                while (!release) {
+                    std::this_thread::yield();
+                }
+            });
+            outer_finished = true;
+        });
+        while (!child_started) {
+            std::this_thread::yield();
+        }
+        //queued while the outer job waits for its range, it is not run on the stack of the outer job
+        bool inside_outer = true;
+        const auto unrelated = jobs.submit([&]() {
+            inside_outer = std::this_thread::get_id() == outer_thread && !outer_finished;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        QVERIFY(!unrelated->isFinished());
+        release = true;
+        jobs.wait(unrelated);
+        jobs.wait(outer);
+        QVERIFY(!inside_outer);
+    }
+    void testParallelForThrows() {
+        JobSystem jobs(2);
+        std::atomic<int> finished{ 0 };
+        bool thrown = false;
+        try {
+            jobs.parallelFor(4, 1, [&finished](std::uint64_t begin, std::uint64_t) {
+                if (0 == begin) {
+                    throw std::runtime_error("first range failed");
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                ++finished;
+            });
+        }
+        catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        //the other ranges are done before the exception leaves, they used the function
+        QVERIFY(thrown);
+        QCOMPARE(finished.load(), 3);
+    }
+    void testParallelForRethrowsOtherRange() {
+        JobSystem jobs(2);
+        std::atomic<int> finished{ 0 };
+        bool thrown = false;
+        try {
+            jobs.parallelFor(4, 1, [&finished](std::uint64_t begin, std::uint64_t) {
+                if (2 == begin) {
+                    //not an std::exception, must not end the worker thread
+                    throw 42;
+                }
+                ++finished;
+            });
+        }
+        catch (int value) {
+            thrown = 42 == value;
+        }
+        QVERIFY(thrown);
+        QCOMPARE(finished.load(), 3);
+        //the workers survived and run the next jobs outside of any job
+        QVERIFY(!JobSystem::cancellationRequested());
+        std::atomic<bool> ran{ false };
+        jobs.wait(jobs.submit([&ran]() { ran = true; }));
+        QVERIFY(ran);
+    }
+    void testFailedJobKeepsException() {
+        JobSystem jobs(2);
+        const auto job = jobs.submit([]() { throw std::runtime_error("load failed"); });
+        jobs.wait(job);
+        QVERIFY(nullptr != job->getException());
+        QVERIFY(!job->wasCancelled());
+    }
+};
+
+QTEST_MAIN(JobSystemTest)
+#include "JobSystem_test.moc"
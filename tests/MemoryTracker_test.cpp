@@ -0,0 +1,82 @@
+#include <QtTest/QtTest>
+#include <QJsonArray>
+
+#include "MemoryTracker.h"
+
+class MemoryTrackerTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testObjectBytes() {
+        using Category = MemoryTracker::Category;
+        const auto cpu_before = MemoryTracker::getTotal(Category::CPU_GEOMETRY);
+        MemoryTracker::setObjectBytes(1, "first", Category::CPU_GEOMETRY, 1000);
+        MemoryTracker::setObjectBytes(1, QString(), Category::GPU_BUFFERS, 400);
+        MemoryTracker::setObjectBytes(2, "second", Category::CPU_GEOMETRY, 500);
+        QCOMPARE(MemoryTracker::getTotal(Category::CPU_GEOMETRY), cpu_before + 1500);
+
+        const auto usage = MemoryTracker::getObjectUsage(1);
+        QCOMPARE(usage.name, QString("first"));
+        QCOMPARE(usage.total(), static_cast<std::uint64_t>(1400));
+
+        //replacing the value of a category is not an addition
+        MemoryTracker::setObjectBytes(1, QString(), Category::CPU_GEOMETRY, 200);
+        QCOMPARE(MemoryTracker::getTotal(Category::CPU_GEOMETRY), cpu_before + 700);
+        MemoryTracker::removeObject(1);
+        MemoryTracker::removeObject(2);
+        QCOMPARE(MemoryTracker::getTotal(Category::CPU_GEOMETRY), cpu_before);
+        QVERIFY(MemoryTracker::getPeak(Category::CPU_GEOMETRY) >= cpu_before + 1500);
+        QCOMPARE(MemoryTracker::getObjectUsage(1).total(), static_cast<std::uint64_t>(0));
+    }
+    void testLoadScopePeak() {
+        using Category = MemoryTracker::Category;
+        //outside of a scope nothing is accounted
+        MemoryTracker::LoadScope::add(100);
+        QCOMPARE(MemoryTracker::getTotal(Category::TRANSIENT), static_cast<std::uint64_t>(0));
+        {
+            MemoryTracker::LoadScope scope;
+            MemoryTracker::LoadScope::add(300);
+            {
+                MemoryTracker::LoadScope nested;
+                MemoryTracker::LoadScope::add(200);
+                QCOMPARE(nested.getPeak(), static_cast<std::uint64_t>(200));
+            }
+            //the nested load freed its buffers
+            QCOMPARE(MemoryTracker::getTotal(Category::TRANSIENT), static_cast<std::uint64_t>(300));
+            MemoryTracker::LoadScope::add(-300);
+            MemoryTracker::LoadScope::add(100);
+            QCOMPARE(scope.getPeak(), static_cast<std::uint64_t>(500));
+            MemoryTracker::setObjectBytes(3, "loaded", Category::CPU_GEOMETRY, 100);
+            scope.attach(3);
+        }
+        QCOMPARE(MemoryTracker::getTotal(Category::TRANSIENT), static_cast<std::uint64_t>(0));
+        QCOMPARE(MemoryTracker::getObjectUsage(3).loadPeak, static_cast<std::uint64_t>(500));
+        MemoryTracker::removeObject(3);
+    }
+    void testCacheBytes() {
+        using Category = MemoryTracker::Category;
+        const auto caches_before = MemoryTracker::getTotal(Category::CACHES);
+        MemoryTracker::setCacheBytes("hierarchies", 3000);
+        MemoryTracker::setCacheBytes("fields", 1000);
+        QCOMPARE(MemoryTracker::getTotal(Category::CACHES), caches_before + 4000);
+        MemoryTracker::setCacheBytes("hierarchies", 2000);
+        QCOMPARE(MemoryTracker::getCacheBytes("hierarchies"), static_cast<std::uint64_t>(2000));
+        QCOMPARE(MemoryTracker::report()["caches"].toObject()["fields"].toInt(), 1000);
+        MemoryTracker::setCacheBytes("hierarchies", 0);
+        MemoryTracker::setCacheBytes("fields", 0);
+        QCOMPARE(MemoryTracker::getTotal(Category::CACHES), caches_before);
+        QVERIFY(MemoryTracker::report()["caches"].toObject().isEmpty());
+    }
+    void testReport() {
+        MemoryTracker::setObjectBytes(4, "reported", MemoryTracker::Category::CACHES, 4096);
+        const auto report = MemoryTracker::report();
+        QCOMPARE(report["objects"].toArray().size(), 1);
+        QCOMPARE(report["objects"].toArray()[0].toObject()["caches"].toInt(), 4096);
+        QVERIFY(report.contains("peakRss"));
+        MemoryTracker::removeObject(4);
+    }
+};
+
+QTEST_APPLESS_MAIN(MemoryTrackerTest)
+#include "MemoryTracker_test.moc"
@@ -0,0 +1,55 @@
+#include <QtTest/QtTest>
+
+#include <algorithm>
+
+#include "CgalApi.h"
+#include "IndexedMesh.h"
+#include "MeshCodec.h"
+
+class MeshCodecTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testCompressedMeshRoundTrip() {
+        const auto& result = CGAL_API::constructMeshFromObj("FinalBaseMesh.obj");
+        QVERIFY(nullptr != result);
+        MappedArray<Vertex> soup;
+        QVERIFY(CGAL_API::buildTriangleSoup(result, CGAL_API::computeVertexNormals(result), soup));
+        QVector3D min_bounds, max_bounds;
+        MESH_API::computeBounds(soup, min_bounds, max_bounds);
+        QTemporaryDir dir;
+        const auto path = dir.filePath("FinalBaseMesh.3dvz");
+        QVERIFY(CODEC_API::writeCompressedMesh(path, soup,
+            result->number_of_vertices(), result->number_of_faces(), result->number_of_edges()));
+        QVERIFY(QFileInfo(path).size() < static_cast<qint64>(soup.sizeInBytes() / 4));
+
+        const auto restored = CODEC_API::readCompressedMesh(path);
+        QVERIFY(nullptr != restored);
+        QCOMPARE(restored->vertices.size(), soup.size());
+        QCOMPARE(restored->num_vertices, static_cast<std::uint64_t>(result->number_of_vertices()));
+        QCOMPARE(restored->num_faces, static_cast<std::uint64_t>(result->number_of_faces()));
+        QCOMPARE(restored->num_edges, static_cast<std::uint64_t>(result->number_of_edges()));
+        QCOMPARE(restored->minBounds, min_bounds);
+        QCOMPARE(restored->maxBounds, max_bounds);
+        //16-bit positions are off by half a quantisation step at most
+        const auto extent = max_bounds - min_bounds;
+        const float position_error = std::max({ extent.x(), extent.y(), extent.z() }) / 65535.0f;
+        for (std::uint64_t i = 0; i < soup.size(); ++i) {
+            QVERIFY((restored->vertices[i].position - soup[i].position).length() <= position_error);
+            QVERIFY((restored->vertices[i].normal - soup[i].normal).length() < 1e-3f);
+        }
+    }
+    void testReadInvalidCompressedMesh() {
+        QTemporaryDir dir;
+        const auto path = dir.filePath("invalid.3dvz");
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(QByteArray(8192, 'x'));
+        file.close();
+        QVERIFY(nullptr == CODEC_API::readCompressedMesh(path));
+    }
+};
+
+QTEST_MAIN(MeshCodecTest)
+#include "MeshCodec_test.moc"
@@ -0,0 +1,140 @@
+#include <QtTest/QtTest>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "ObjStreamReader.h"
+#include "CgalApi.h"
+#include "MemoryInfo.h"
+
+class ObjStreamReaderTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    static void customMessageHandler(QtMsgType type, const QMessageLogContext& context, const QString& msg) {
+        if (type != QtDebugMsg) {
+            QTextStream(stdout) << msg << "\n";
+        }
+    }
+    void initTestCase() {
+        qInstallMessageHandler(customMessageHandler);
+    }
+    void cleanupTestCase() {
+        MappedArrayBase::setOutOfCoreThreshold(MappedArrayBase::DEFAULT_OUT_OF_CORE_THRESHOLD);
+        qInstallMessageHandler(nullptr);
+    }
+    void testStreamInvalidObj() {
+        const auto& result = OBJ_STREAM_API::constructMeshFromObj("abc.obj");
+        QVERIFY(nullptr == result);
+    }
+    void testStreamEmptyObj() {
+        const auto& result = OBJ_STREAM_API::constructMeshFromObj("tmp.obj");
+        QVERIFY(nullptr == result);
+    }
+    void testStreamMatchesCgal() {
+        const auto& streamed = OBJ_STREAM_API::constructMeshFromObj("FinalBaseMesh.obj");
+        const auto& constructed = CGAL_API::constructMeshFromObj("FinalBaseMesh.obj");
+        QVERIFY(nullptr != streamed);
+        QVERIFY(nullptr != constructed);
+        QCOMPARE(streamed->num_vertices, static_cast<std::uint64_t>(constructed->number_of_vertices()));
+        QCOMPARE(streamed->num_faces, static_cast<std::uint64_t>(constructed->number_of_faces()));
+        QCOMPARE(streamed->num_edges, static_cast<std::uint64_t>(constructed->number_of_edges()));
+        QCOMPARE(streamed->normals.size(), streamed->positions.size());
+    }
+    void testStreamOutOfCore() {
+        //force every array into memory-mapped temporary files
+        MappedArrayBase::setOutOfCoreThreshold(1);
+        const auto& result = OBJ_STREAM_API::constructMeshFromObj("FinalBaseMesh.obj");
+        MappedArrayBase::setOutOfCoreThreshold(MappedArrayBase::DEFAULT_OUT_OF_CORE_THRESHOLD);
+        QVERIFY(nullptr != result);
+        QVERIFY(result->positions.isOutOfCore());
+        QVERIFY(result->indices.isOutOfCore());
+        QCOMPARE(result->num_vertices, static_cast<std::uint64_t>(24461));
+        QCOMPARE(result->numberOfTriangles(), static_cast<std::uint64_t>(48918));
+    }
+    void testStreamRelativeIndices() {
+        QTemporaryFile file;
+        QVERIFY(file.open());
+        file.write("v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nf -4 -3 -2 -1\r\n");
+        file.close();
+        const auto& result = OBJ_STREAM_API::constructMeshFromObj(file.fileName().toStdString());
+        QVERIFY(nullptr != result);
+        QCOMPARE(result->numberOfTriangles(), static_cast<std::uint64_t>(2));
+        QCOMPARE(result->indices[5], 3u);
+        QCOMPARE(result->num_edges, static_cast<std::uint64_t>(5));
+        QVERIFY(qFuzzyCompare(result->normals[0], QVector3D(0.0f, 0.0f, 1.0f)));
+    }
+    void testIndentedLines() {
+        QTemporaryFile file;
+        QVERIFY(file.open());
+        file.write("# indented\n  v 0 0 0\n\tv 1 0 0\n \t v 1 1 0\n   f 1 2 3\n\t\n");
+        file.close();
+        const auto& streamed = OBJ_STREAM_API::constructMeshFromObj(file.fileName().toStdString());
+        QVERIFY(nullptr != streamed);
+        QCOMPARE(streamed->num_vertices, static_cast<std::uint64_t>(3));
+        QCOMPARE(streamed->numberOfTriangles(), static_cast<std::uint64_t>(1));
+        const auto& constructed = CGAL_API::readMeshFromObj(file.fileName().toStdString());
+        QVERIFY(nullptr != constructed);
+        QCOMPARE(constructed->number_of_vertices(), static_cast<Surface_mesh::size_type>(3));
+        QCOMPARE(constructed->number_of_faces(), static_cast<Surface_mesh::size_type>(1));
+    }
+    void testStreamGeneratedLargeObj() {
+        //multi-GB run is opt-in: VIEWER_LARGE_OBJ_GB=5 ./3DViewer_stream_tests
+        const auto size_gb = qEnvironmentVariableIntValue("VIEWER_LARGE_OBJ_GB");
+        if (0 == size_gb) {
+            QSKIP("VIEWER_LARGE_OBJ_GB is not set");
+        }
+        QTemporaryFile file(QDir::tempPath() + "/3DViewer_large_XXXXXX.obj");
+        QVERIFY(file.open());
+        //grid of quads, every row adds ~100 bytes per vertex and face
+        const std::uint64_t row = 4096;
+        const std::uint64_t target = static_cast<std::uint64_t>(size_gb) * 1024ull * 1024ull * 1024ull;
+        std::uint64_t rows = 0;
+        QByteArray block;
+        while (static_cast<std::uint64_t>(file.size()) < target) {
+            block.clear();
+            for (std::uint64_t x = 0; x < row; ++x) {
+                block += "v " + QByteArray::number(static_cast<double>(x)) + " " + QByteArray::number(static_cast<double>(rows)) + " 0\n";
+            }
+            if (rows > 0) {
+                for (std::uint64_t x = 0; x + 1 < row; ++x) {
+                    const auto a = (rows - 1) * row + x + 1;
+                    block += "f " + QByteArray::number(a) + " " + QByteArray::number(a + 1) + " " +
+                        QByteArray::number(a + row + 1) + " " + QByteArray::number(a + row) + "\n";
+                }
+            }
+            file.write(block);
+            ++rows;
+        }
+        file.close();
+        //the mapped arrays are paged by the OS, only the memory not backed by a file has to stay bounded
+        const auto baseline = MEMORY_API::currentAnonymousRss();
+        if (0 == baseline) {
+            QSKIP("anonymous resident memory is not reported on this platform");
+        }
+        std::atomic<bool> parsing(true);
+        std::atomic<std::uint64_t> peak(baseline);
+        std::thread sampler([&parsing, &peak]() {
+            while (parsing) {
+                peak = std::max(peak.load(), MEMORY_API::currentAnonymousRss());
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        });
+        const auto& result = OBJ_STREAM_API::constructMeshFromObj(file.fileName().toStdString());
+        parsing = false;
+        sampler.join();
+        QVERIFY(nullptr != result);
+        QCOMPARE(result->num_vertices, rows * row);
+        QCOMPARE(result->numberOfTriangles(), (rows - 1) * (row - 1) * 2);
+        QCOMPARE(result->num_edges, (rows - 1) * row + rows * (row - 1) + (rows - 1) * (row - 1));
+        //read block, edge keys and bookkeeping, an order of magnitude below the file size
+        const std::uint64_t budget = 512ull * 1024ull * 1024ull;
+        QVERIFY2(peak - baseline < budget, qPrintable(QString("peak anonymous memory grew by %1 MB")
+            .arg((peak - baseline) / (1024 * 1024))));
+    }
+};
+
+QTEST_APPLESS_MAIN(ObjStreamReaderTest)
+#include "ObjStreamReader_test.moc"
@@ -0,0 +1,86 @@
+#include <QtTest/QtTest>
+
+#include "OcclusionCuller.h"
+
+class OcclusionCullerTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    // a soup of the given triangles on a deterministic zigzag
+    static void makeSoup(std::uint64_t triangles, MappedArray<Vertex>& vertices) {
+        QVERIFY(vertices.allocate(triangles * 3));
+        for (std::uint64_t i = 0; i < vertices.size(); ++i) {
+            vertices[i] = { QVector3D(static_cast<float>(i), static_cast<float>(i % 7), -static_cast<float>(i % 13)),
+                QVector3D(0.0f, 0.0f, 1.0f), QVector2D() };
+        }
+    }
+    // chunks of the given vertex counts one after another
+    static std::vector<BufferChunk> makeChunks(const std::vector<std::uint64_t>& counts) {
+        std::vector<BufferChunk> chunks;
+        std::uint64_t first = 0;
+        for (const auto count : counts) {
+            chunks.emplace_back();
+            chunks.back().firstVertex = first;
+            chunks.back().vertexCount = count;
+            first += count;
+        }
+        return chunks;
+    }
+
+private slots:
+    void testSmallObjectIsDrawnWhole() {
+        MappedArray<Vertex> vertices;
+        makeSoup(OcclusionCuller::MIN_CULLED_TRIANGLES - 1, vertices);
+        const auto chunks = makeChunks({ vertices.size() });
+        QVERIFY(OcclusionCuller::buildClusters(vertices, chunks).empty());
+    }
+    void testClustersCoverChunks() {
+        MappedArray<Vertex> vertices;
+        const std::uint64_t triangles = OcclusionCuller::MIN_CULLED_TRIANGLES * 3 + 5;
+        makeSoup(triangles, vertices);
+        //the split of the uploader, the first chunk ends within a cluster
+        const std::uint64_t first_chunk = (triangles / 3 + 1) * 3;
+        const auto chunks = makeChunks({ first_chunk, vertices.size() - first_chunk });
+        const auto clusters = OcclusionCuller::buildClusters(vertices, chunks);
+        QVERIFY(clusters.size() > 1);
+        QVERIFY(clusters.size() <= OcclusionCuller::MAX_CLUSTERS + chunks.size());
+
+        std::vector<std::uint64_t> covered(chunks.size(), 0);
+        for (const auto& cluster : clusters) {
+            QVERIFY(cluster.chunk >= 0 && cluster.chunk < static_cast<int>(chunks.size()));
+            //contiguous whole triangles that never cross the end of their chunk
+            QCOMPARE(cluster.firstVertex, covered[cluster.chunk]);
+            QCOMPARE(cluster.vertexCount % 3, std::uint64_t(0));
+            QVERIFY(cluster.vertexCount >= 3);
+            covered[cluster.chunk] += cluster.vertexCount;
+            QVERIFY(covered[cluster.chunk] <= chunks[cluster.chunk].vertexCount);
+
+            QVector3D min = vertices[chunks[cluster.chunk].firstVertex + cluster.firstVertex].position;
+            QVector3D max = min;
+            for (std::uint64_t i = 0; i < cluster.vertexCount; ++i) {
+                const auto& position = vertices[chunks[cluster.chunk].firstVertex + cluster.firstVertex + i].position;
+                for (int axis = 0; axis < 3; ++axis) {
+                    min[axis] = std::min(min[axis], position[axis]);
+                    max[axis] = std::max(max[axis], position[axis]);
+                }
+            }
+            QCOMPARE(cluster.minBounds, min);
+            QCOMPARE(cluster.maxBounds, max);
+        }
+        for (std::size_t chunk = 0; chunk < chunks.size(); ++chunk) {
+            QCOMPARE(covered[chunk], chunks[chunk].vertexCount);
+        }
+    }
+    void testClusterCountIsBounded() {
+        MappedArray<Vertex> vertices;
+        makeSoup(OcclusionCuller::MAX_CLUSTERS * OcclusionCuller::MIN_CLUSTER_TRIANGLES + 7, vertices);
+        const auto chunks = makeChunks({ vertices.size() });
+        const auto clusters = OcclusionCuller::buildClusters(vertices, chunks);
+        QVERIFY(clusters.size() <= OcclusionCuller::MAX_CLUSTERS);
+        QVERIFY(clusters.size() > OcclusionCuller::MAX_CLUSTERS / 2);
+    }
+};
+
+QTEST_MAIN(OcclusionCullerTest)
+#include "OcclusionCuller_test.moc"
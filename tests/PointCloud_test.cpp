@@ -0,0 +1,125 @@
+#include <QtTest/QtTest>
+
+#include <random>
+
+#include "PointCloud.h"
+
+class PointCloudTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    QString writeFile(const QTemporaryDir& dir, const QString& name, const QByteArray& content) {
+        const auto path = dir.filePath(name);
+        QFile file(path);
+        file.open(QIODevice::WriteOnly);
+        file.write(content);
+        return path;
+    }
+
+private slots:
+    void testLooksLikePointCloud() {
+        QTemporaryDir dir;
+        const auto points = writeFile(dir, "points.obj", "v 0 0 0\nv 1 0 0\nv 0 1 0\n");
+        const auto mesh = writeFile(dir, "mesh.obj", "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n");
+        QVERIFY(POINTCLOUD_API::looksLikePointCloud(points.toStdString()));
+        QVERIFY(!POINTCLOUD_API::looksLikePointCloud(mesh.toStdString()));
+    }
+    void testReadColoredPoints() {
+        QTemporaryDir dir;
+        const auto path = writeFile(dir, "colored.obj", "# scan\nv 0 0 0 1 0 0\nv 1 2 3 0 1 0\r\nv -1 0.5 2 0 0 1\nf 1 2 3\n");
+        const auto cloud = POINTCLOUD_API::constructPointCloudFromObj(path.toStdString());
+        QVERIFY(nullptr != cloud);
+        QCOMPARE(cloud->points.size(), static_cast<std::uint64_t>(3));
+        QVERIFY(cloud->hasColors);
+        QCOMPARE(cloud->minBounds, QVector3D(-1.0f, 0.0f, 0.0f));
+        QCOMPARE(cloud->maxBounds, QVector3D(1.0f, 2.0f, 3.0f));
+        QCOMPARE(cloud->nodes.size(), static_cast<std::size_t>(1));
+        QCOMPARE(cloud->nodes[0].count, 3u);
+    }
+    void testReadInvalidPoints() {
+        QTemporaryDir dir;
+        const auto path = writeFile(dir, "invalid.obj", "v 0 0\n");
+        QVERIFY(nullptr == POINTCLOUD_API::readPointCloudFromObj(path.toStdString()));
+        QVERIFY(nullptr == POINTCLOUD_API::readPointCloudFromObj(dir.filePath("missing.obj").toStdString()));
+    }
+    void testOctreeInvariants() {
+        const std::uint64_t num_points = POINTCLOUD_API::NODE_POINTS * 40;
+        PointCloud cloud;
+        QVERIFY(cloud.points.allocate(num_points));
+        std::mt19937 generator(7);
+        std::uniform_real_distribution<float> coordinate(-1.0f, 1.0f);
+        for (std::uint64_t i = 0; i < num_points; ++i) {
+            //a flat slab with a pile of coincident points, which stops at the depth limit
+            const QVector3D position = (0 == i % 5) ? QVector3D(0.5f, 0.25f, 0.0f) :
+                QVector3D(coordinate(generator), coordinate(generator), coordinate(generator) * 0.1f);
+            cloud.points[i] = { position, static_cast<std::uint32_t>(i) };
+        }
+        cloud.minBounds = QVector3D(-1.0f, -1.0f, -0.1f);
+        cloud.maxBounds = QVector3D(1.0f, 1.0f, 0.1f);
+        QVERIFY(POINTCLOUD_API::buildOctree(cloud));
+        QVERIFY(cloud.nodes.size() > 1);
+        QCOMPARE(cloud.nodes[0].depth, 0u);
+
+        //every point is owned by exactly one node and lies inside its cube
+        std::vector<char> owned(num_points, 0);
+        for (const auto& node : cloud.nodes) {
+            for (auto i = node.first; i < node.first + node.count; ++i) {
+                QCOMPARE(owned[i], static_cast<char>(0));
+                owned[i] = 1;
+                const auto offset = cloud.points[i].position - node.center;
+                const float limit = node.halfSize * 1.0001f;
+                QVERIFY(std::abs(offset.x()) <= limit && std::abs(offset.y()) <= limit && std::abs(offset.z()) <= limit);
+            }
+            for (const auto child : node.children) {
+                if (child >= 0) {
+                    QCOMPARE(cloud.nodes[child].depth, node.depth + 1);
+                    //an octant, or the next node of a chained cube at the depth limit
+                    const bool chained = node.depth >= POINTCLOUD_API::MAX_DEPTH;
+                    QCOMPARE(cloud.nodes[child].halfSize, chained ? node.halfSize : node.halfSize * 0.5f);
+                }
+            }
+        }
+        QVERIFY(std::all_of(owned.begin(), owned.end(), [](char value) { return 1 == value; }));
+        //inner nodes own a sample of the fixed size
+        QCOMPARE(cloud.nodes[0].count, POINTCLOUD_API::NODE_POINTS);
+    }
+    void testDenseLeafIsChained() {
+        //more coincident points than the nodes above the depth limit sample
+        const std::uint64_t dense = (POINTCLOUD_API::MAX_DEPTH + 3) * static_cast<std::uint64_t>(POINTCLOUD_API::NODE_POINTS) + 5;
+        const std::uint64_t num_points = dense + 1;
+        PointCloud cloud;
+        QVERIFY(cloud.points.allocate(num_points));
+        for (std::uint64_t i = 0; i < dense; ++i) {
+            cloud.points[i] = { QVector3D(0.25f, 0.25f, 0.25f), static_cast<std::uint32_t>(i) };
+        }
+        cloud.points[dense] = { QVector3D(-1.0f, -1.0f, -1.0f), 0u };
+        cloud.minBounds = QVector3D(-1.0f, -1.0f, -1.0f);
+        cloud.maxBounds = QVector3D(1.0f, 1.0f, 1.0f);
+        QVERIFY(POINTCLOUD_API::buildOctree(cloud));
+
+        //every node fits a streaming slot and no point is dropped
+        std::uint64_t owned = 0;
+        std::uint32_t deepest = 0;
+        for (const auto& node : cloud.nodes) {
+            QVERIFY(node.count <= POINTCLOUD_API::NODE_POINTS);
+            owned += node.count;
+            deepest = std::max(deepest, node.depth);
+        }
+        QCOMPARE(owned, num_points);
+        QVERIFY(deepest > POINTCLOUD_API::MAX_DEPTH);
+        //the sampled nodes above the limit leave a little more than three full nodes to the chain
+        int chained = 0;
+        for (const auto& node : cloud.nodes) {
+            if (node.depth >= POINTCLOUD_API::MAX_DEPTH) {
+                ++chained;
+                const auto next = std::count_if(node.children.begin(), node.children.end(), [](std::int32_t child) { return child >= 0; });
+                QVERIFY(next <= 1);
+            }
+        }
+        QCOMPARE(chained, 4);
+    }
+};
+
+QTEST_APPLESS_MAIN(PointCloudTest)
+#include "PointCloud_test.moc"
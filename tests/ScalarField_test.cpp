@@ -0,0 +1,170 @@
+#include <QtTest/QtTest>
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "ScalarField.h"
+#include "TestGeometry.h"
+
+class ScalarFieldTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    // closed sphere around the origin, the triangles facing outwards
+    static bool makeSphere(float radius, int stacks, int slices, MappedArray<Vertex>& soup) {
+        //the poles and the seam are computed once, so their corners weld
+        const auto point = [=](int i, int j) {
+            if (0 == i || stacks == i) {
+                return QVector3D(0.0f, 0.0f, 0 == i ? radius : -radius);
+            }
+            const float theta = qDegreesToRadians(180.0f * i / stacks);
+            const float phi = qDegreesToRadians(360.0f * (j % slices) / slices);
+            return QVector3D(std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta)) * radius;
+        };
+        std::vector<Vertex> vertices;
+        const auto addTriangle = [&vertices](QVector3D a, QVector3D b, QVector3D c) {
+            if (QVector3D::dotProduct(QVector3D::crossProduct(b - a, c - a), a + b + c) < 0.0f) {
+                std::swap(b, c);
+            }
+            const auto normal = QVector3D::normal(a, b, c);
+            for (const auto& corner : { a, b, c }) {
+                vertices.push_back({ corner, normal, QVector2D() });
+            }
+        };
+        for (int i = 0; i < stacks; ++i) {
+            for (int j = 0; j < slices; ++j) {
+                if (0 != i) {
+                    addTriangle(point(i, j), point(i + 1, j), point(i, j + 1));
+                }
+                if (stacks - 1 != i) {
+                    addTriangle(point(i, j + 1), point(i + 1, j), point(i + 1, j + 1));
+                }
+            }
+        }
+        if (!soup.allocate(vertices.size())) {
+            return false;
+        }
+        std::copy(vertices.begin(), vertices.end(), soup.begin());
+        return true;
+    }
+    static bool makeWelded(const MappedArray<Vertex>& soup, WeldedSoup& welded) {
+        return FIELD_API::gatherCorners(soup, welded) && FIELD_API::weldCorners(welded);
+    }
+
+private slots:
+    void testWeldCorners() {
+        MappedArray<Vertex> soup;
+        QVERIFY(TEST_FIXTURES::makeGrid(8, soup));
+        WeldedSoup welded;
+        QVERIFY(makeWelded(soup, welded));
+        QCOMPARE(welded.vertexCount(), static_cast<std::uint64_t>(9 * 9));
+        for (std::uint64_t v = 0; v < welded.vertexCount(); ++v) {
+            for (auto i = welded.vertexOffsets[v]; i < welded.vertexOffsets[v + 1]; ++i) {
+                const auto corner = welded.vertexCorners[i];
+                QCOMPARE(welded.cornerVertex[corner], static_cast<std::uint32_t>(v));
+                QVERIFY(welded.corners[corner] == welded.corners[welded.vertexCorners[welded.vertexOffsets[v]]]);
+            }
+        }
+    }
+    void testWeldLargeSoup() {
+        //several sorted runs merged over more than one round, an odd one left over
+        MappedArray<Vertex> soup;
+        QVERIFY(TEST_FIXTURES::makeGrid(512, soup));
+        WeldedSoup welded;
+        QVERIFY(makeWelded(soup, welded));
+        QCOMPARE(welded.vertexCount(), static_cast<std::uint64_t>(513 * 513));
+        QCOMPARE(welded.vertexOffsets.back(), static_cast<std::uint32_t>(soup.size()));
+        for (std::uint64_t i = 1; i < welded.vertexCorners.size(); ++i) {
+            const auto& a = welded.corners[welded.vertexCorners[i - 1]];
+            const auto& b = welded.corners[welded.vertexCorners[i]];
+            QVERIFY(a.x() < b.x() || (a.x() == b.x() && (a.y() < b.y() || (a.y() == b.y() && a.z() <= b.z()))));
+        }
+        for (std::uint64_t v = 0; v < welded.vertexCount(); ++v) {
+            for (auto i = welded.vertexOffsets[v]; i < welded.vertexOffsets[v + 1]; ++i) {
+                QCOMPARE(welded.cornerVertex[welded.vertexCorners[i]], static_cast<std::uint32_t>(v));
+            }
+        }
+    }
+    void testCurvature() {
+        MappedArray<Vertex> soup;
+        QVERIFY(makeSphere(2.0f, 24, 48, soup));
+        WeldedSoup welded;
+        QVERIFY(makeWelded(soup, welded));
+        ScalarField field;
+        QVERIFY(FIELD_API::computeCurvature(welded, field));
+        QCOMPARE(field.values.size(), static_cast<std::size_t>(soup.size()));
+        //convex everywhere, the regular part of the sphere at 1 / radius
+        QVERIFY(field.minValue > 0.0f);
+        std::vector<float> sorted(field.values);
+        std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+        QVERIFY(std::abs(sorted[sorted.size() / 2] - 0.5f) < 0.01f);
+
+        //flat inside, the border of the grid only sees part of its neighbourhood
+        QVERIFY(TEST_FIXTURES::makeGrid(8, soup));
+        QVERIFY(makeWelded(soup, welded));
+        QVERIFY(FIELD_API::computeCurvature(welded, field));
+        for (std::uint64_t c = 0; c < soup.size(); ++c) {
+            const auto& position = soup[c].position;
+            if (position.x() > 0.0f && position.x() < 1.0f && position.y() > 0.0f && position.y() < 1.0f) {
+                QVERIFY(std::abs(field.values[c]) < 1e-4f);
+            }
+        }
+    }
+    void testAspectRatio() {
+        MappedArray<Vertex> soup;
+        QVERIFY(soup.allocate(3));
+        soup[0].position = QVector3D(0.0f, 0.0f, 0.0f);
+        soup[1].position = QVector3D(1.0f, 0.0f, 0.0f);
+        soup[2].position = QVector3D(0.5f, std::sqrt(0.75f), 0.0f);
+        WeldedSoup welded;
+        QVERIFY(makeWelded(soup, welded));
+        ScalarField field;
+        QVERIFY(FIELD_API::computeAspectRatio(welded, field));
+        QVERIFY(std::abs(field.values[0] - 1.0f) < 1e-4f);
+
+        //half squares, R / 2r = (sqrt(2) / 2) / (2 - sqrt(2))
+        QVERIFY(TEST_FIXTURES::makeGrid(4, soup));
+        QVERIFY(makeWelded(soup, welded));
+        QVERIFY(FIELD_API::computeAspectRatio(welded, field));
+        const float expected = std::sqrt(2.0f) * 0.5f / (2.0f - std::sqrt(2.0f));
+        QVERIFY(std::all_of(field.values.begin(), field.values.end(), [expected](float value) { return std::abs(value - expected) < 1e-4f; }));
+
+        //collapsed to a line
+        QVERIFY(soup.allocate(3));
+        soup[0].position = QVector3D(0.0f, 0.0f, 0.0f);
+        soup[1].position = QVector3D(1.0f, 0.0f, 0.0f);
+        soup[2].position = QVector3D(2.0f, 0.0f, 0.0f);
+        QVERIFY(makeWelded(soup, welded));
+        QVERIFY(FIELD_API::computeAspectRatio(welded, field));
+        QCOMPARE(field.values[0], FIELD_API::MAX_ASPECT_RATIO);
+    }
+    void testEdgeLengthAndDeviation() {
+        MappedArray<Vertex> soup;
+        QVERIFY(TEST_FIXTURES::makeGrid(10, soup));
+        WeldedSoup welded;
+        QVERIFY(makeWelded(soup, welded));
+        ScalarField field;
+        QVERIFY(FIELD_API::computeEdgeLength(welded, field));
+        //between the side and the diagonal of a cell
+        QVERIFY(field.minValue >= 0.1f - 1e-5f);
+        QVERIFY(field.maxValue <= 0.1f * std::sqrt(2.0f) + 1e-5f);
+        QVERIFY(field.lowValue >= field.minValue && field.highValue <= field.maxValue);
+
+        //a lifted copy of a finer grid, every vertex at the same distance
+        TriangleBvh reference;
+        QVERIFY(TEST_FIXTURES::makeBvh(16, reference));
+        for (auto& vertex : soup) {
+            vertex.position += QVector3D(0.0f, 0.0f, 0.2f);
+        }
+        QVERIFY(makeWelded(soup, welded));
+        QVERIFY(FIELD_API::computeDeviation(welded, reference, field));
+        QVERIFY(std::all_of(field.values.begin(), field.values.end(), [](float value) { return std::abs(value - 0.2f) < 1e-5f; }));
+        QVERIFY(!FIELD_API::computeDeviation(welded, TriangleBvh(), field));
+    }
+};
+
+QTEST_MAIN(ScalarFieldTest)
+#include "ScalarField_test.moc"
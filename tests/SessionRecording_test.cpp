@@ -0,0 +1,197 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+
+#include "SessionRecording.h"
+
+namespace {
+    SessionRecording::Frame makeFrame(double time, float yaw, int object, const QVector3D& translation)
+    {
+        SessionRecording::Frame frame;
+        frame.time = time;
+        frame.camera = { QVector3D(0.0f, 0.0f, 20.0f), yaw, 0.0f, 45.0f };
+        frame.object = object;
+        frame.translation = translation;
+        frame.rotation = QQuaternion();
+        return frame;
+    }
+
+    //frame times around base with some spread, the same for every run
+    std::vector<double> makeTimings(double base, std::size_t count)
+    {
+        std::vector<double> timings;
+        for (std::size_t i = 0; i < count; ++i) {
+            timings.push_back(base + static_cast<double>((i * 7) % 11) * 0.1);
+        }
+        return timings;
+    }
+}
+
+class SessionRecordingTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testRecordingRoundTrip() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        SessionRecording recording;
+        recording.workspace = "session.3dvws";
+        recording.width = 800;
+        recording.height = 600;
+        recording.wireframe = true;
+        recording.frames.push_back(makeFrame(0.0, -90.0f, 0, QVector3D()));
+        recording.frames.push_back(makeFrame(0.5, -80.0f, 1, QVector3D(1.0f, 2.0f, 3.0f)));
+        recording.frames.back().rotation = QQuaternion::fromAxisAndAngle(QVector3D(0.0f, 1.0f, 0.0f), 30.0f);
+        const auto path = dir.filePath("session.3dvrec");
+        QVERIFY(RECORDING_API::writeRecording(path, recording));
+
+        const auto read = RECORDING_API::readRecording(path);
+        QVERIFY(nullptr != read);
+        QCOMPARE(read->width, 800);
+        QCOMPARE(read->height, 600);
+        QVERIFY(read->wireframe);
+        QCOMPARE(read->frames.size(), std::size_t(2));
+        const auto& frame = read->frames.back();
+        QCOMPARE(frame.time, 0.5);
+        QCOMPARE(frame.object, 1);
+        QCOMPARE(frame.camera.yaw, -80.0f);
+        QVERIFY(qFuzzyCompare(frame.translation, QVector3D(1.0f, 2.0f, 3.0f)));
+        QVERIFY(qFuzzyCompare(frame.rotation, recording.frames.back().rotation));
+        QCOMPARE(RECORDING_API::workspacePath(path, *read), dir.filePath("session.3dvws"));
+    }
+    void testReadInvalid() {
+        QTemporaryDir dir;
+        QVERIFY(nullptr == RECORDING_API::readRecording(dir.filePath("missing.3dvrec")));
+        QFile file(dir.filePath("empty.3dvrec"));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("{ \"version\": 1, \"frames\": [] }");
+        file.close();
+        QVERIFY(nullptr == RECORDING_API::readRecording(file.fileName()));
+    }
+    void testResample() {
+        const std::vector<SessionRecording::Frame> frames = {
+            makeFrame(0.0, 0.0f, 0, QVector3D(0.0f, 0.0f, 0.0f)),
+            makeFrame(1.0, 10.0f, 0, QVector3D(2.0f, 0.0f, 0.0f)),
+            makeFrame(3.0, 30.0f, 1, QVector3D(5.0f, 0.0f, 0.0f))
+        };
+        //the recorded samples themselves
+        QCOMPARE(RECORDING_API::resample(frames, 0).size(), frames.size());
+
+        const auto resampled = RECORDING_API::resample(frames, 7);
+        QCOMPARE(resampled.size(), std::size_t(7));
+        QCOMPARE(resampled.front().time, 0.0);
+        QCOMPARE(resampled.back().time, 3.0);
+        QCOMPARE(resampled.back().object, 1);
+        //half way to the second sample
+        QCOMPARE(resampled[1].time, 0.5);
+        QCOMPARE(resampled[1].camera.yaw, 5.0f);
+        QVERIFY(qFuzzyCompare(resampled[1].translation, QVector3D(1.0f, 0.0f, 0.0f)));
+        //the camera moves on, the object is taken over at the sample it was selected
+        QCOMPARE(resampled[3].time, 1.5);
+        QCOMPARE(resampled[3].camera.yaw, 15.0f);
+        QCOMPARE(resampled[3].object, 0);
+        QVERIFY(qFuzzyCompare(resampled[3].translation, QVector3D(2.0f, 0.0f, 0.0f)));
+    }
+    void testResampleSingleInstant() {
+        const std::vector<SessionRecording::Frame> frames = {
+            makeFrame(0.0, 0.0f, 0, QVector3D()),
+            makeFrame(0.0, 20.0f, 0, QVector3D())
+        };
+        const auto resampled = RECORDING_API::resample(frames, 3);
+        QCOMPARE(resampled.size(), std::size_t(3));
+        QCOMPARE(resampled[1].camera.yaw, 10.0f);
+        QCOMPARE(RECORDING_API::resample({ frames.front() }, 4).size(), std::size_t(4));
+    }
+    void testSummary() {
+        std::vector<double> values;
+        for (int i = 100; i >= 1; --i) {
+            values.push_back(i);
+        }
+        const auto summary = RECORDING_API::summarize(values);
+        QCOMPARE(summary.count, std::size_t(100));
+        QCOMPARE(summary.min, 1.0);
+        QCOMPARE(summary.max, 100.0);
+        QCOMPARE(summary.mean, 50.5);
+        QCOMPARE(summary.median, 50.5);
+        QVERIFY(qFuzzyCompare(summary.p95, 95.05));
+        QVERIFY(qAbs(summary.stddev - 29.011) < 0.001);
+        QCOMPARE(RECORDING_API::summarize({}).count, std::size_t(0));
+    }
+    void testCompareSame() {
+        const auto timings = makeTimings(10.0, 500);
+        const auto comparison = RECORDING_API::compare(timings, timings);
+        QVERIFY(comparison.paired);
+        QCOMPARE(comparison.z, 0.0);
+        QVERIFY(!comparison.isSignificant());
+        QCOMPARE(comparison.medianChange, 0.0);
+    }
+    void testCompareSlower() {
+        const auto baseline = makeTimings(10.0, 500);
+        auto candidate = baseline;
+        for (auto& value : candidate) {
+            value *= 1.1;
+        }
+        const auto comparison = RECORDING_API::compare(baseline, candidate);
+        QVERIFY(comparison.paired);
+        QVERIFY(comparison.isSignificant());
+        QVERIFY(comparison.z > 0.0);
+        QVERIFY(qAbs(comparison.medianChange - 0.1) < 1e-9);
+
+        const auto faster = RECORDING_API::compare(candidate, baseline);
+        QVERIFY(faster.isSignificant());
+        QVERIFY(faster.z < 0.0);
+    }
+    void testCompareUnpaired() {
+        const auto baseline = makeTimings(10.0, 400);
+        const auto candidate = makeTimings(10.5, 300);
+        const auto comparison = RECORDING_API::compare(baseline, candidate);
+        QVERIFY(!comparison.paired);
+        QVERIFY(comparison.isSignificant());
+        QVERIFY(comparison.z > 0.0);
+        //the same distribution sampled a different number of times
+        const auto same = RECORDING_API::compare(makeTimings(10.0, 440), makeTimings(10.0, 220));
+        QVERIFY(!same.isSignificant());
+    }
+    void testTimingsRoundTrip() {
+        QTemporaryDir dir;
+        FrameTimings timings;
+        timings.recording = "session.3dvrec";
+        timings.renderer = "offscreen";
+        timings.width = 640;
+        timings.height = 480;
+        timings.frames = makeTimings(4.0, 20);
+        const auto path = dir.filePath("timings.json");
+        QVERIFY(RECORDING_API::writeTimings(path, timings));
+        const auto read = RECORDING_API::readTimings(path);
+        QVERIFY(nullptr != read);
+        QCOMPARE(read->recording, timings.recording);
+        QCOMPARE(read->renderer, timings.renderer);
+        QCOMPARE(read->width, 640);
+        QCOMPARE(read->frames, timings.frames);
+    }
+    void testComparable() {
+        FrameTimings baseline;
+        baseline.recording = "session.3dvrec";
+        baseline.renderer = FrameTimings::VIEWER_RENDERER;
+        baseline.width = 640;
+        baseline.height = 480;
+        FrameTimings candidate = baseline;
+        QString reason;
+        QVERIFY(RECORDING_API::isComparable(baseline, candidate, reason));
+        QVERIFY(reason.isEmpty());
+        //the headless replay draws less than the viewer
+        candidate.renderer = FrameTimings::OFFSCREEN_RENDERER;
+        QVERIFY(!RECORDING_API::isComparable(baseline, candidate, reason));
+        QVERIFY(reason.contains(FrameTimings::OFFSCREEN_RENDERER));
+        candidate.renderer = baseline.renderer;
+        candidate.height = 720;
+        QVERIFY(!RECORDING_API::isComparable(baseline, candidate, reason));
+        QVERIFY(reason.contains("640x720"));
+        candidate.height = baseline.height;
+        candidate.recording = "other.3dvrec";
+        QVERIFY(!RECORDING_API::isComparable(baseline, candidate, reason));
+    }
+};
+
+QTEST_MAIN(SessionRecordingTest)
+#include "SessionRecording_test.moc"
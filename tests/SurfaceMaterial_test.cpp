@@ -0,0 +1,181 @@
+#include <QtTest/QtTest>
+
+#include "CgalApi.h"
+#include "SceneObject.h"
+#include "SurfaceMaterial.h"
+#include "TextureCache.h"
+#include "TextureStreamer.h"
+
+class SurfaceMaterialTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    static void writeFile(const QString& path, const char* content) {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(content);
+        file.close();
+    }
+    // a soup of the given triangles without any geometry worth looking at
+    static std::shared_ptr<SceneObject> makeObject(std::uint64_t triangles) {
+        MappedArray<Vertex> vertices;
+        if (!vertices.allocate(triangles * 3)) {
+            return nullptr;
+        }
+        for (auto& vertex : vertices) {
+            vertex = { QVector3D(), QVector3D(0.0f, 0.0f, 1.0f), QVector2D() };
+        }
+        return std::make_shared<SceneObject>("runs.obj", "runs", std::move(vertices), triangles * 3, triangles, triangles * 3);
+    }
+    static std::vector<MaterialRange> collectRuns(const SceneObject& obj, std::uint64_t first, std::uint64_t count) {
+        std::vector<MaterialRange> runs;
+        obj.forEachMaterialRun(first, count, [&runs](std::uint64_t begin, std::uint64_t vertices, int material) {
+            runs.push_back({ begin, vertices, material });
+        });
+        return runs;
+    }
+
+private slots:
+    void testConstructTexturedObj() {
+        QTemporaryDir dir;
+        writeFile(dir.filePath("quad.mtl"),
+            "newmtl red\nKd 1 0 0\nmap_Kd -s 1 1 1 maps/red.png\nnorm red_normal.png\nmap_Bump -bm 0.5 red_height.png\n"
+            "newmtl blue\nKd 0 0 1\nbump blue_height.png\n");
+        const auto path = dir.filePath("quad.obj");
+        //texture coordinates equal to the positions, a quad of one material and a triangle of the other
+        writeFile(path, "mtllib quad.mtl\n"
+            "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nv 0.5 1.5 0\n"
+            "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\nvt 0.5 1.5\nvn 0 0 1\n"
+            "usemtl red\nf 1/1/1 2/2/1 3/3/1 4/4/1\nusemtl blue\nf 4/4/1 3/3/1 5/5/1\n");
+        SurfaceAttributes attributes;
+        const auto& result = CGAL_API::constructMeshFromObj(path.toStdString(), &attributes);
+        QVERIFY(nullptr != result);
+        QCOMPARE(result->number_of_faces(), 3);
+        QCOMPARE(attributes.materials.size(), static_cast<std::size_t>(2));
+        QCOMPARE(attributes.materials[0].diffuse, QVector3D(1.0f, 0.0f, 0.0f));
+        QCOMPARE(attributes.materials[0].diffuseMap, QDir::cleanPath(dir.filePath("maps/red.png")));
+        QCOMPARE(attributes.materials[0].normalMap, QDir::cleanPath(dir.filePath("red_normal.png")));
+        //heights, kept apart from the normal map
+        QCOMPARE(attributes.materials[0].bumpMap, QDir::cleanPath(dir.filePath("red_height.png")));
+        QCOMPARE(attributes.materials[0].bumpScale, 0.5f);
+        QVERIFY(attributes.materials[1].diffuseMap.isEmpty());
+        QVERIFY(attributes.materials[1].normalMap.isEmpty());
+        QCOMPARE(attributes.materials[1].bumpMap, QDir::cleanPath(dir.filePath("blue_height.png")));
+        QCOMPARE(attributes.materials[1].bumpScale, 1.0f);
+        QCOMPARE(attributes.faceMaterials, std::vector<int>({ 0, 0, 1 }));
+        QCOMPARE(attributes.texcoords.size(), static_cast<std::size_t>(9));
+
+        MappedArray<Vertex> soup;
+        QVERIFY(CGAL_API::buildTriangleSoup(result, CGAL_API::computeVertexNormals(result), soup, &attributes));
+        for (const auto& vertex : soup) {
+            QCOMPARE(vertex.texture, QVector2D(vertex.position.x(), vertex.position.y()));
+        }
+        const auto ranges = MTL_API::buildMaterialRanges(attributes.faceMaterials);
+        QCOMPARE(ranges.size(), static_cast<std::size_t>(2));
+        QCOMPARE(ranges[0].firstVertex, static_cast<std::uint64_t>(0));
+        QCOMPARE(ranges[0].vertexCount, static_cast<std::uint64_t>(6));
+        QCOMPARE(ranges[1].firstVertex, static_cast<std::uint64_t>(6));
+        QCOMPARE(ranges[1].material, 1);
+    }
+    void testTexcoordsAcrossSeam() {
+        QTemporaryDir dir;
+        const auto path = dir.filePath("seam.obj");
+        //both triangles share the diagonal, the second one samples another island of the texture
+        writeFile(path, "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+            "vt 0 0\nvt 1 0\nvt 1 1\nvt 10 0\nvt 11 1\nvt 10 1\n"
+            "f 1/1 2/2 3/3\nf 1/4 3/5 4/6\n");
+        SurfaceAttributes attributes;
+        const auto& result = CGAL_API::constructMeshFromObj(path.toStdString(), &attributes);
+        QVERIFY(nullptr != result);
+        QCOMPARE(result->number_of_vertices(), 4);
+        MappedArray<Vertex> soup;
+        QVERIFY(CGAL_API::buildTriangleSoup(result, CGAL_API::computeVertexNormals(result), soup, &attributes));
+        QCOMPARE(soup.size(), static_cast<std::uint64_t>(6));
+        for (std::uint64_t i = 0; i < soup.size(); ++i) {
+            //the shared corners take the coordinate of the face they belong to
+            const QVector2D offset = (i < 3) ? QVector2D(0.0f, 0.0f) : QVector2D(10.0f, 0.0f);
+            QCOMPARE(soup[i].texture, QVector2D(soup[i].position.x(), soup[i].position.y()) + offset);
+        }
+    }
+    void testTextureCacheRoundTrip() {
+        //top row red, bottom row blue, odd width
+        QImage image(5, 2, QImage::Format_RGB32);
+        for (int x = 0; x < image.width(); ++x) {
+            image.setPixel(x, 0, qRgb(255, 0, 0));
+            image.setPixel(x, 1, qRgb(0, 0, 255));
+        }
+        const auto chain = TEXTURE_API::buildMipLevels(image);
+        QVERIFY(nullptr != chain);
+        QCOMPARE(chain->levels.size(), static_cast<std::size_t>(3));
+        QCOMPARE(chain->levels[1].size(), QSize(2, 1));
+        QCOMPARE(chain->levels[2].size(), QSize(1, 1));
+        //flipped for GL, the first row is the bottom one
+        QCOMPARE(chain->levels[0].pixel(0, 0), qRgba(0, 0, 255, 255));
+        QCOMPARE(chain->levels[1].pixel(0, 0), qRgba(128, 0, 128, 255));
+
+        QTemporaryDir dir;
+        const auto path = dir.filePath("texture.3dvt");
+        chain->sourceSize = 1234;
+        chain->sourceModified = 5678;
+        QVERIFY(TEXTURE_API::writeTextureCache(path, *chain));
+        const auto restored = TEXTURE_API::readTextureCache(path);
+        QVERIFY(nullptr != restored);
+        QCOMPARE(restored->sourceSize, chain->sourceSize);
+        QCOMPARE(restored->sourceModified, chain->sourceModified);
+        QCOMPARE(restored->levels.size(), chain->levels.size());
+        for (std::size_t i = 0; i < chain->levels.size(); ++i) {
+            QCOMPARE(restored->levels[i], chain->levels[i]);
+        }
+
+        writeFile(dir.filePath("invalid.3dvt"), QByteArray(64, 'x').constData());
+        QVERIFY(nullptr == TEXTURE_API::readTextureCache(dir.filePath("invalid.3dvt")));
+    }
+    void testMaterialRuns() {
+        const auto obj = makeObject(10);
+        QVERIFY(nullptr != obj);
+        //without materials the whole range is a single run
+        auto runs = collectRuns(*obj, 3, 12);
+        QCOMPARE(runs.size(), static_cast<std::size_t>(1));
+        QCOMPARE(runs[0].firstVertex, static_cast<std::uint64_t>(3));
+        QCOMPARE(runs[0].vertexCount, static_cast<std::uint64_t>(12));
+        QCOMPARE(runs[0].material, -1);
+
+        obj->materialRanges = MTL_API::buildMaterialRanges({ 0, 0, 1, 1, 1, -1, 2, 2, 2, 2 });
+        QCOMPARE(obj->materialRanges.size(), static_cast<std::size_t>(4));
+        //a chunk starting and ending within a run is cut at both ends
+        runs = collectRuns(*obj, 3, 18);
+        QCOMPARE(runs.size(), static_cast<std::size_t>(4));
+        QCOMPARE(runs[0].firstVertex, static_cast<std::uint64_t>(3));
+        QCOMPARE(runs[0].vertexCount, static_cast<std::uint64_t>(3));
+        QCOMPARE(runs[0].material, 0);
+        QCOMPARE(runs[1].firstVertex, static_cast<std::uint64_t>(6));
+        QCOMPARE(runs[1].vertexCount, static_cast<std::uint64_t>(9));
+        QCOMPARE(runs[1].material, 1);
+        QCOMPARE(runs[2].material, -1);
+        QCOMPARE(runs[3].firstVertex, static_cast<std::uint64_t>(18));
+        QCOMPARE(runs[3].vertexCount, static_cast<std::uint64_t>(3));
+        QCOMPARE(runs[3].material, 2);
+        //inside a single run
+        runs = collectRuns(*obj, 21, 6);
+        QCOMPARE(runs.size(), static_cast<std::size_t>(1));
+        QCOMPARE(runs[0].material, 2);
+        QVERIFY(collectRuns(*obj, 30, 0).empty());
+    }
+    void testStreamerFailedLoad() {
+        QTemporaryDir dir;
+        TextureStreamer streamer(nullptr);
+        const auto path = dir.filePath("missing.png");
+        //never sampled until a level arrived, a failed load never reaches the uploader
+        QCOMPARE(streamer.acquire(path), GLuint(0));
+        streamer.stop();
+        QCOMPARE(streamer.acquire(path), GLuint(0));
+        //nothing was uploaded, so there is no fence to wait for and no GL call to make
+        QVERIFY(!streamer.drainFences(nullptr));
+        streamer.releaseUnused({}, nullptr);
+        streamer.destroy(nullptr);
+    }
+};
+
+QTEST_MAIN(SurfaceMaterialTest)
+#include "SurfaceMaterial_test.moc"
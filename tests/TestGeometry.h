@@ -0,0 +1,40 @@
+#pragma once
+
+#include <QVector2D>
+#include <QVector3D>
+
+#include <algorithm>
+#include <vector>
+
+#include "TriangleBvh.h"
+
+// Triangle soups shared by the geometry tests. The helpers return false instead of
+// failing the test themselves, the caller wraps them in QVERIFY so the failure stops its slot.
+namespace TEST_FIXTURES {
+	// square [0, 1] x [0, 1] at z = 0 split into cells * cells quads
+	inline bool makeGrid(int cells, MappedArray<Vertex>& soup) {
+		std::vector<Vertex> vertices;
+		const float size = 1.0f / cells;
+		for (int y = 0; y < cells; ++y) {
+			for (int x = 0; x < cells; ++x) {
+				const QVector3D corner(x * size, y * size, 0.0f);
+				const QVector3D quad[4] = { corner, corner + QVector3D(size, 0.0f, 0.0f),
+					corner + QVector3D(size, size, 0.0f), corner + QVector3D(0.0f, size, 0.0f) };
+				for (const int c : { 0, 1, 2, 0, 2, 3 }) {
+					vertices.push_back({ quad[c], QVector3D(0.0f, 0.0f, 1.0f), QVector2D() });
+				}
+			}
+		}
+		if (!soup.allocate(vertices.size())) {
+			return false;
+		}
+		std::copy(vertices.begin(), vertices.end(), soup.begin());
+		return true;
+	}
+
+	// hierarchy over the grid of makeGrid
+	inline bool makeBvh(int cells, TriangleBvh& bvh) {
+		MappedArray<Vertex> soup;
+		return makeGrid(cells, soup) && BVH_API::gatherTriangles(soup, bvh) && BVH_API::buildHierarchy(bvh);
+	}
+}
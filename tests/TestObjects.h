@@ -0,0 +1,23 @@
+#pragma once
+
+#include <QVector2D>
+#include <QVector3D>
+
+#include <memory>
+
+#include "SceneObject.h"
+
+// Scene objects shared by the scene tests, see TestGeometry.h for the bare triangle soups.
+namespace TEST_FIXTURES {
+	// a single triangle spanning [0, size] on x and y, placed around the origin of the scene, null when it cannot be allocated
+	inline std::shared_ptr<SceneObject> makeTriangle(float size) {
+		MappedArray<Vertex> vertices;
+		if (!vertices.allocate(3)) {
+			return nullptr;
+		}
+		vertices[0] = { QVector3D(0.0f, 0.0f, 0.0f), QVector3D(0.0f, 0.0f, 1.0f), QVector2D() };
+		vertices[1] = { QVector3D(size, 0.0f, 0.0f), QVector3D(0.0f, 0.0f, 1.0f), QVector2D() };
+		vertices[2] = { QVector3D(0.0f, size, 0.0f), QVector3D(0.0f, 0.0f, 1.0f), QVector2D() };
+		return std::make_shared<SceneObject>("triangle.obj", "triangle", std::move(vertices), 3, 1, 3);
+	}
+}
@@ -0,0 +1,92 @@
+#include <QtTest/QtTest>
+
+#include "ObjStreamReader.h"
+#include "ThumbnailCache.h"
+
+namespace {
+    template <typename T>
+    void appendValue(QByteArray& bytes, const T& value)
+    {
+        bytes.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    bool writeFile(const QString& path, const QByteArray& bytes)
+    {
+        QFile file(path);
+        return file.open(QIODevice::WriteOnly) && file.write(bytes) == bytes.size();
+    }
+
+    QByteArray makeStl(const IndexedMesh& mesh)
+    {
+        QByteArray bytes(80, '\0');
+        appendValue(bytes, static_cast<std::uint32_t>(mesh.numberOfTriangles()));
+        for (std::uint64_t i = 0; i < mesh.indices.size(); i += 3) {
+            appendValue(bytes, QVector3D(0.0f, 0.0f, 0.0f));
+            for (std::uint64_t corner = 0; corner < 3; ++corner) {
+                appendValue(bytes, mesh.positions[mesh.indices[i + corner]]);
+            }
+            appendValue(bytes, static_cast<std::uint16_t>(0));
+        }
+        return bytes;
+    }
+}
+
+class ThumbnailCacheTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase() {
+        //the previews go to a cache directory of the tests, never to the one of the user
+        QStandardPaths::setTestModeEnabled(true);
+        QVERIFY(m_dir.isValid());
+        const auto& mesh = OBJ_STREAM_API::constructMeshFromObj("FinalBaseMesh.obj");
+        QVERIFY(nullptr != mesh);
+        QVERIFY(writeFile(m_dir.filePath("FinalBaseMesh.stl"), makeStl(*mesh)));
+    }
+    void testThumbnailCache() {
+        const auto model = m_dir.filePath("thumbnail.stl");
+        QVERIFY(QFile::copy(m_dir.filePath("FinalBaseMesh.stl"), model));
+        QImage image(THUMBNAIL_API::THUMBNAIL_SIZE, THUMBNAIL_API::THUMBNAIL_SIZE, QImage::Format_ARGB32);
+        image.fill(qRgba(10, 20, 30, 255));
+        QVERIFY(THUMBNAIL_API::writeThumbnail(model, image));
+        const auto restored = THUMBNAIL_API::readThumbnail(model);
+        QVERIFY(!restored.isNull());
+        QCOMPARE(restored.pixel(5, 5), image.pixel(5, 5));
+        //other sizes have previews of their own
+        QVERIFY(THUMBNAIL_API::readThumbnail(model, THUMBNAIL_API::THUMBNAIL_SIZE * 2).isNull());
+        //a changed model invalidates its preview
+        QFile file(model);
+        QVERIFY(file.open(QIODevice::Append));
+        file.write("x");
+        file.close();
+        QVERIFY(THUMBNAIL_API::readThumbnail(model).isNull());
+        QFile::remove(THUMBNAIL_API::cachePath(model));
+    }
+    void testBuildPreviewMesh() {
+        MappedArray<Vertex> preview;
+        QVector3D min_bounds, max_bounds;
+        QVERIFY(THUMBNAIL_API::buildPreviewMesh(m_dir.filePath("FinalBaseMesh.stl"), preview, min_bounds, max_bounds));
+        QCOMPARE(preview.size() % 3, static_cast<std::uint64_t>(0));
+        QVERIFY(!preview.isEmpty());
+        QVERIFY(preview.size() / 3 < 48918);
+        QVERIFY(max_bounds.x() > min_bounds.x() && max_bounds.y() > min_bounds.y() && max_bounds.z() > min_bounds.z());
+
+        //vertex only scans have nothing to draw
+        QVERIFY(writeFile(m_dir.filePath("points.obj"), "v 0 0 0\nv 1 0 0\nv 0 1 0\n"));
+        QVERIFY(!THUMBNAIL_API::buildPreviewMesh(m_dir.filePath("points.obj"), preview, min_bounds, max_bounds));
+    }
+    void testEstimateBuildBytes() {
+        //the soup of a binary stl takes about twice the file, with the indexed mesh next to it
+        const auto stl = m_dir.filePath("FinalBaseMesh.stl");
+        const auto triangles = static_cast<std::uint64_t>((QFileInfo(stl).size() - 84) / 50);
+        QVERIFY(THUMBNAIL_API::estimateBuildBytes(stl) >= triangles * 3 * sizeof(Vertex));
+        QCOMPARE(THUMBNAIL_API::estimateBuildBytes(m_dir.filePath("missing.obj")), static_cast<std::uint64_t>(0));
+    }
+
+private:
+    QTemporaryDir m_dir;
+};
+
+QTEST_APPLESS_MAIN(ThumbnailCacheTest)
+#include "ThumbnailCache_test.moc"
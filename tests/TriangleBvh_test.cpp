@@ -0,0 +1,104 @@
+#include <QtTest/QtTest>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "TestGeometry.h"
+#include "TriangleBvh.h"
+
+class TriangleBvhTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    static bool contains(const BvhNode& node, const QVector3D& point) {
+        return point.x() >= node.minBounds.x() && point.y() >= node.minBounds.y() && point.z() >= node.minBounds.z() &&
+            point.x() <= node.maxBounds.x() && point.y() <= node.maxBounds.y() && point.z() <= node.maxBounds.z();
+    }
+
+private slots:
+    void testTriangleDistance() {
+        const QVector3D a[3] = { { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f } };
+        //above the face
+        const QVector3D above[3] = { { 0.2f, 0.2f, 0.5f }, { 0.3f, 0.2f, 0.5f }, { 0.2f, 0.3f, 0.5f } };
+        QVERIFY(qFuzzyCompare(BVH_API::triangleDistance(a, above), 0.5f));
+        //piercing the face
+        const QVector3D crossing[3] = { { 0.2f, 0.2f, -1.0f }, { 0.3f, 0.2f, 1.0f }, { 0.2f, 0.3f, 1.0f } };
+        QCOMPARE(BVH_API::triangleDistance(a, crossing), 0.0f);
+        QCOMPARE(BVH_API::triangleDistance(crossing, a), 0.0f);
+        //closest between the edges, beside the hypotenuse
+        const QVector3D beside[3] = { { 1.0f, 1.0f, -1.0f }, { 1.0f, 1.0f, 1.0f }, { 2.0f, 2.0f, 0.0f } };
+        QVERIFY(std::abs(BVH_API::triangleDistance(a, beside) - std::sqrt(0.5f)) < 1e-5f);
+    }
+    void testBuildHierarchy() {
+        TriangleBvh bvh;
+        QVERIFY(TEST_FIXTURES::makeBvh(32, bvh));
+        QCOMPARE(bvh.triangles.size(), static_cast<std::uint64_t>(32 * 32 * 2));
+        std::vector<int> owners(bvh.triangles.size(), 0);
+        for (std::size_t i = 0; i < bvh.nodes.size(); ++i) {
+            const auto& node = bvh.nodes[i];
+            if (!node.isLeaf()) {
+                //the children stay inside their parent
+                for (const auto child : { static_cast<std::uint32_t>(i + 1), node.first }) {
+                    QVERIFY(contains(node, bvh.nodes[child].minBounds));
+                    QVERIFY(contains(node, bvh.nodes[child].maxBounds));
+                }
+                continue;
+            }
+            QVERIFY(node.count <= BVH_API::LEAF_TRIANGLES);
+            for (auto t = node.first; t < node.first + node.count; ++t) {
+                ++owners[t];
+                for (const auto& corner : bvh.triangles[t].corners) {
+                    QVERIFY(contains(node, corner));
+                }
+            }
+        }
+        //every triangle in exactly one leaf
+        QVERIFY(std::all_of(owners.begin(), owners.end(), [](int owner) { return 1 == owner; }));
+    }
+    void testFindCloseTriangles() {
+        TriangleBvh a, b;
+        QVERIFY(TEST_FIXTURES::makeBvh(16, a));
+        QVERIFY(TEST_FIXTURES::makeBvh(24, b));
+        QMatrix4x4 lifted;
+        lifted.translate(0.0f, 0.0f, 0.1f);
+        Proximity result;
+        QVERIFY(BVH_API::findCloseTriangles(a, b, lifted, 0.05f, result));
+        QVERIFY(result.trianglesA.empty());
+        QVERIFY(result.trianglesB.empty());
+
+        QVERIFY(BVH_API::findCloseTriangles(a, b, lifted, 0.15f, result));
+        QVERIFY(!result.intersecting);
+        QVERIFY(std::abs(result.distance - 0.1f) < 1e-5f);
+        QCOMPARE(result.trianglesA.size(), static_cast<std::size_t>(a.triangles.size()));
+        QCOMPARE(result.trianglesB.size(), static_cast<std::size_t>(b.triangles.size()));
+
+        //b stands upright through the middle of a, only the triangles along the cut touch
+        QMatrix4x4 upright;
+        upright.translate(0.0f, 0.5f, -0.5f);
+        upright.rotate(90.0f, 1.0f, 0.0f, 0.0f);
+        QVERIFY(BVH_API::findCloseTriangles(a, b, upright, 0.0f, result));
+        QVERIFY(result.intersecting);
+        QCOMPARE(result.distance, 0.0f);
+        QVERIFY(!result.trianglesA.empty() && result.trianglesA.size() < a.triangles.size() / 4);
+        QVERIFY(!result.trianglesB.empty() && result.trianglesB.size() < b.triangles.size() / 4);
+        for (const auto index : result.trianglesA) {
+            for (const auto& corner : a.triangles[index].corners) {
+                QVERIFY(std::abs(corner.y() - 0.5f) <= 1.0f / 16.0f + 1e-5f);
+            }
+        }
+    }
+    void testPointDistance() {
+        TriangleBvh bvh;
+        QVERIFY(TEST_FIXTURES::makeBvh(16, bvh));
+        QVERIFY(std::abs(BVH_API::pointDistance(bvh, QVector3D(0.3f, 0.7f, 0.25f)) - 0.25f) < 1e-5f);
+        QVERIFY(BVH_API::pointDistance(bvh, QVector3D(0.5f, 0.5f, 0.0f)) < 1e-5f);
+        //beside the corner of the grid
+        QVERIFY(std::abs(BVH_API::pointDistance(bvh, QVector3D(-3.0f, -4.0f, 0.0f)) - 5.0f) < 1e-4f);
+        QCOMPARE(BVH_API::pointDistance(TriangleBvh(), QVector3D()), std::numeric_limits<float>::max());
+    }
+};
+
+QTEST_MAIN(TriangleBvhTest)
+#include "TriangleBvh_test.moc"
@@ -0,0 +1,72 @@
+#include <QtTest/QtTest>
+
+#include <array>
+#include <atomic>
+#include <thread>
+
+#include "TripleBuffer.h"
+
+class TripleBufferTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testLatestValueWins() {
+        TripleBuffer<int> buffer;
+        QVERIFY(!buffer.acquire());
+        for (int value = 1; value <= 3; ++value) {
+            buffer.back() = value;
+            buffer.publish();
+        }
+        //the intermediate values are skipped
+        QVERIFY(buffer.acquire());
+        QCOMPARE(buffer.front(), 3);
+        QVERIFY(!buffer.acquire());
+        QCOMPARE(buffer.front(), 3);
+
+        buffer.back() = 4;
+        buffer.publish();
+        QVERIFY(buffer.acquire());
+        QCOMPARE(buffer.front(), 4);
+    }
+    void testConcurrentHandoff() {
+        //every element carries the sequence, a torn value would mix two of them
+        using Value = std::array<std::uint64_t, 64>;
+        TripleBuffer<Value> buffer;
+        constexpr std::uint64_t count = 200000;
+        std::atomic<bool> done{ false };
+        std::thread writer([&]() {
+            for (std::uint64_t sequence = 1; sequence <= count; ++sequence) {
+                buffer.back().fill(sequence);
+                buffer.publish();
+            }
+            done = true;
+        });
+        std::uint64_t last = 0;
+        bool consistent = true;
+        bool increasing = true;
+        for (;;) {
+            //read first, the last value was published before the flag was set
+            const bool finished = done;
+            if (!buffer.acquire()) {
+                if (finished) {
+                    break;
+                }
+                continue;
+            }
+            const auto& value = buffer.front();
+            for (const auto element : value) {
+                consistent = consistent && element == value[0];
+            }
+            increasing = increasing && value[0] > last;
+            last = value[0];
+        }
+        writer.join();
+        QVERIFY(consistent);
+        QVERIFY(increasing);
+        QCOMPARE(last, count);
+    }
+};
+
+QTEST_MAIN(TripleBufferTest)
+#include "TripleBuffer_test.moc"
@@ -0,0 +1,130 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QXmlStreamReader>
+
+#include <algorithm>
+#include <map>
+
+// Compares the QtTest xml output of the pipeline benchmark with the stored baseline and
+// fails when a stage got slower than the baseline plus the allowed margin. The benchmark runs
+// every row several times with -median, so both sides are medians of repeated samples.
+// An empty baseline and stages missing in it fail the gate, unless new stages are allowed.
+namespace {
+    constexpr double MIN_MEASURABLE_MS = 1.0;
+
+    // "benchmarkParse/sphere-tri-10k" -> milliseconds per iteration
+    bool readResults(const QString& path, std::map<QString, double>& results)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return false;
+        }
+        QXmlStreamReader xml(&file);
+        QString function;
+        while (!xml.atEnd()) {
+            if (!xml.readNextStartElement()) {
+                continue;
+            }
+            const auto attributes = xml.attributes();
+            if (xml.name() == QLatin1String("TestFunction")) {
+                function = attributes.value("name").toString();
+            }
+            else if (xml.name() == QLatin1String("BenchmarkResult") &&
+                attributes.value("metric") == QLatin1String("WalltimeMilliseconds")) {
+                const auto iterations = std::max(1, attributes.value("iterations").toInt());
+                results[function + "/" + attributes.value("tag").toString()] = attributes.value("value").toDouble() / iterations;
+            }
+        }
+        return !xml.hasError();
+    }
+}
+
+int main(int argc, char *argv[]) {
+
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmark regression gate.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("results", "QtTest xml output of the benchmark.");
+    parser.addPositionalArgument("baseline", "Baseline json file.");
+    QCommandLineOption margin_option("margin", "Allowed slowdown as a fraction of the baseline, 0.25 by default.", "fraction", "0.25");
+    QCommandLineOption update_option("update", "Write the results as the new baseline instead of comparing.");
+    QCommandLineOption allow_new_option("allow-new", "Stages missing in the baseline do not fail the gate.");
+    parser.addOptions({ margin_option, update_option, allow_new_option });
+    parser.process(app);
+
+    const auto positional = parser.positionalArguments();
+    if (positional.size() != 2) {
+        out << parser.helpText();
+        return 2;
+    }
+    std::map<QString, double> results;
+    if (!readResults(positional[0], results) || results.empty()) {
+        out << "cannot read benchmark results from " << positional[0] << "\n";
+        return 2;
+    }
+    if (parser.isSet(update_option)) {
+        QJsonObject stages;
+        for (const auto& result : results) {
+            stages.insert(result.first, result.second);
+        }
+        QSaveFile baseline_file(positional[1]);
+        if (!baseline_file.open(QIODevice::WriteOnly) ||
+            baseline_file.write(QJsonDocument(QJsonObject{ { "stages", stages } }).toJson()) < 0 || !baseline_file.commit()) {
+            out << "cannot write baseline " << positional[1] << "\n";
+            return 2;
+        }
+        out << "baseline of " << results.size() << " stages written to " << positional[1] << "\n";
+        return 0;
+    }
+
+    QFile baseline_file(positional[1]);
+    if (!baseline_file.open(QIODevice::ReadOnly)) {
+        out << "cannot read baseline " << positional[1] << "\n";
+        return 2;
+    }
+    const auto baseline = QJsonDocument::fromJson(baseline_file.readAll()).object()["stages"].toObject();
+    if (baseline.isEmpty()) {
+        //nothing to compare with would pass any slowdown
+        out << "baseline " << positional[1] << " has no stages, record it with --update on the reference machine\n";
+        return 2;
+    }
+    //environment wins so the margin can be relaxed on noisy machines without editing the test setup
+    bool margin_ok = false;
+    const auto env_margin = qEnvironmentVariable("VIEWER_BENCH_MARGIN");
+    const double margin = (env_margin.isEmpty() ? parser.value(margin_option) : env_margin).toDouble(&margin_ok);
+    if (!margin_ok || margin < 0.0) {
+        out << "invalid margin\n";
+        return 2;
+    }
+
+    const bool allow_new = parser.isSet(allow_new_option);
+    int regressions = 0;
+    int missing = 0;
+    for (const auto& result : results) {
+        if (!baseline.contains(result.first)) {
+            missing += allow_new ? 0 : 1;
+            out << "NEW   " << result.first << ": " << result.second << " ms\n";
+            continue;
+        }
+        const double reference = baseline[result.first].toDouble();
+        //sub-millisecond stages are pure timer noise
+        const double limit = std::max(reference, MIN_MEASURABLE_MS) * (1.0 + margin);
+        const bool regressed = result.second > limit;
+        regressions += regressed ? 1 : 0;
+        out << (regressed ? "SLOW  " : "OK    ") << result.first << ": " << result.second
+            << " ms (baseline " << reference << " ms, limit " << limit << " ms)\n";
+    }
+    out << regressions << " of " << results.size() << " stages regressed\n";
+    if (missing > 0) {
+        out << missing << " stages are not in the baseline, record it again with --update or pass --allow-new\n";
+    }
+    return 0 == regressions && 0 == missing ? 0 : 1;
+}
@@ -0,0 +1,161 @@
+#include <QFile>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <random>
+#include <string>
+
+#include "MeshGenerator.h"
+
+namespace {
+    constexpr double PI = 3.14159265358979323846;
+    constexpr std::size_t FLUSH_SIZE = 8 * 1024 * 1024;
+
+    // buffered text writer, QTextStream is too slow for tens of millions of lines
+    class ObjWriter {
+    public:
+        explicit ObjWriter(const QString& path) : m_file(path)
+        {
+            m_buffer.reserve(FLUSH_SIZE + 256);
+        }
+        bool open() { return m_file.open(QIODevice::WriteOnly | QIODevice::Truncate); }
+
+        void vertex(double x, double y, double z)
+        {
+            m_buffer += "v";
+            append(x);
+            append(y);
+            append(z);
+            m_buffer += '\n';
+            flushIfFull();
+        }
+        void face(std::initializer_list<std::uint64_t> indices)
+        {
+            m_buffer += "f";
+            for (const auto index : indices) {
+                char text[24];
+                const auto result = std::to_chars(text, text + sizeof(text), index + 1);
+                m_buffer += ' ';
+                m_buffer.append(text, result.ptr);
+            }
+            m_buffer += '\n';
+            flushIfFull();
+        }
+        // quad as is or split into two triangles
+        void quad(std::uint64_t a, std::uint64_t b, std::uint64_t c, std::uint64_t d, bool quads)
+        {
+            if (quads) {
+                face({ a, b, c, d });
+            }
+            else {
+                face({ a, b, c });
+                face({ a, c, d });
+            }
+        }
+        bool close()
+        {
+            const bool written = flush();
+            m_file.close();
+            return written;
+        }
+
+    private:
+        void append(double value)
+        {
+            char text[32];
+            const auto result = std::to_chars(text, text + sizeof(text), value, std::chars_format::fixed, 6);
+            m_buffer += ' ';
+            m_buffer.append(text, result.ptr);
+        }
+        void flushIfFull()
+        {
+            if (m_buffer.size() >= FLUSH_SIZE) {
+                flush();
+            }
+        }
+        bool flush()
+        {
+            const auto size = static_cast<qint64>(m_buffer.size());
+            const bool written = m_file.write(m_buffer.data(), size) == size;
+            m_buffer.clear();
+            return written;
+        }
+
+        QFile m_file;
+        std::string m_buffer;
+    };
+
+    void writeSphere(ObjWriter& writer, std::uint64_t targetTriangles, bool quads)
+    {
+        //~4 * rings^2 triangles with twice as many segments as rings
+        const auto rings = std::max<std::uint64_t>(3, static_cast<std::uint64_t>(std::sqrt(targetTriangles / 4.0)));
+        const auto segments = rings * 2;
+        writer.vertex(0.0, 1.0, 0.0);
+        for (std::uint64_t ring = 1; ring < rings; ++ring) {
+            const double phi = PI * ring / rings;
+            for (std::uint64_t segment = 0; segment < segments; ++segment) {
+                const double theta = 2.0 * PI * segment / segments;
+                writer.vertex(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta));
+            }
+        }
+        writer.vertex(0.0, -1.0, 0.0);
+        const std::uint64_t bottom = 1 + (rings - 1) * segments;
+        const auto ringVertex = [segments](std::uint64_t ring, std::uint64_t segment) {
+            return 1 + (ring - 1) * segments + segment % segments;
+        };
+        //counterclockwise seen from outside
+        for (std::uint64_t segment = 0; segment < segments; ++segment) {
+            writer.face({ 0, ringVertex(1, segment + 1), ringVertex(1, segment) });
+        }
+        for (std::uint64_t ring = 1; ring + 1 < rings; ++ring) {
+            for (std::uint64_t segment = 0; segment < segments; ++segment) {
+                writer.quad(ringVertex(ring, segment), ringVertex(ring, segment + 1),
+                    ringVertex(ring + 1, segment + 1), ringVertex(ring + 1, segment), quads);
+            }
+        }
+        for (std::uint64_t segment = 0; segment < segments; ++segment) {
+            writer.face({ bottom, ringVertex(rings - 1, segment), ringVertex(rings - 1, segment + 1) });
+        }
+    }
+
+    void writeGrid(ObjWriter& writer, std::uint64_t targetTriangles, bool quads, bool noisy)
+    {
+        const auto cells = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::sqrt(targetTriangles / 2.0)));
+        //fixed seed, the same model on every run
+        std::mt19937 generator(42);
+        std::normal_distribution<double> noise(0.0, 0.5 / cells);
+        for (std::uint64_t row = 0; row <= cells; ++row) {
+            for (std::uint64_t column = 0; column <= cells; ++column) {
+                const double x = static_cast<double>(column) / cells;
+                const double z = static_cast<double>(row) / cells;
+                const double y = noisy ? 0.1 * std::sin(6.0 * x) * std::cos(4.0 * z) + noise(generator) : 0.0;
+                writer.vertex(x, y, z);
+            }
+        }
+        const auto gridVertex = [cells](std::uint64_t row, std::uint64_t column) {
+            return row * (cells + 1) + column;
+        };
+        for (std::uint64_t row = 0; row < cells; ++row) {
+            for (std::uint64_t column = 0; column < cells; ++column) {
+                writer.quad(gridVertex(row, column), gridVertex(row + 1, column),
+                    gridVertex(row + 1, column + 1), gridVertex(row, column + 1), quads);
+            }
+        }
+    }
+}
+
+bool MESH_GENERATOR::writeObj(const QString& path, Shape shape, std::uint64_t targetTriangles, bool quads)
+{
+    ObjWriter writer(path);
+    if (!writer.open()) {
+        return false;
+    }
+    if (Shape::SPHERE == shape) {
+        writeSphere(writer, targetTriangles, quads);
+    }
+    else {
+        writeGrid(writer, targetTriangles, quads, Shape::SCAN == shape);
+    }
+    return writer.close();
+}
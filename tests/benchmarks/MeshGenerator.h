@@ -0,0 +1,20 @@
+#pragma once
+
+#include <QString>
+
+#include <cstdint>
+
+// Synthetic OBJ models of a requested size for the benchmarks. Every generator produces
+// a valid manifold, the triangle count is approximate, quads count as two triangles.
+namespace MESH_GENERATOR {
+	enum class Shape {
+		// closed UV sphere, triangle fans at the poles
+		SPHERE,
+		// flat open grid
+		GRID,
+		// grid with a noisy height field, like a range scan
+		SCAN
+	};
+
+	bool writeObj(const QString& path, Shape shape, std::uint64_t targetTriangles, bool quads);
+}
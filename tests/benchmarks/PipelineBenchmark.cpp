@@ -0,0 +1,259 @@
+#include <QtTest/QtTest>
+
+#include "CgalApi.h"
+#include "MeshCodec.h"
+#include "MeshExporter.h"
+#include "SceneObject.h"
+#include "MeshGenerator.h"
+
+// Every stage of the OBJ load path timed on its own. The input of a stage is prepared
+// outside of the measured block, run with "-o <file>,xml" to get the results for the gate.
+// A single run is too noisy to compare, "-median <n>" runs every row n times and reports the median.
+class PipelineBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    static void customMessageHandler(QtMsgType type, const QMessageLogContext& context, const QString& msg) {
+        if (type != QtDebugMsg) {
+            QTextStream(stdout) << msg << "\n";
+        }
+    }
+    void initTestCase() {
+        qInstallMessageHandler(customMessageHandler);
+        QVERIFY(m_dir.isValid());
+        //the biggest models take minutes, opt in with VIEWER_BENCH_MAX_TRIANGLES
+        const auto max_triangles = qEnvironmentVariable("VIEWER_BENCH_MAX_TRIANGLES").toULongLong();
+        m_maxTriangles = max_triangles > 0 ? max_triangles : DEFAULT_MAX_TRIANGLES;
+    }
+    void cleanupTestCase() {
+        qInstallMessageHandler(nullptr);
+    }
+
+    void benchmarkParse_data() { addMeshRows(); }
+    void benchmarkParse() {
+        const auto path = meshPath();
+        std::unique_ptr<Surface_mesh> mesh;
+        QBENCHMARK_ONCE {
+            mesh = CGAL_API::readMeshFromObj(path);
+        }
+        QVERIFY(nullptr != mesh);
+    }
+    void benchmarkValidate_data() { addMeshRows(); }
+    void benchmarkValidate() {
+        const auto path = meshPath();
+        const auto mesh = CGAL_API::readMeshFromObj(path);
+        QVERIFY(nullptr != mesh);
+        bool valid = false;
+        QBENCHMARK_ONCE {
+            valid = CGAL_API::checkConstructedMesh(mesh, path);
+        }
+        QVERIFY(valid);
+    }
+    void benchmarkTriangulate_data() { addMeshRows(); }
+    void benchmarkTriangulate() {
+        const auto mesh = CGAL_API::readMeshFromObj(meshPath());
+        QVERIFY(nullptr != mesh);
+        bool triangulated = false;
+        QBENCHMARK_ONCE {
+            triangulated = CGAL_API::triangulateMesh(mesh);
+        }
+        QVERIFY(triangulated);
+    }
+    void benchmarkNormals_data() { addMeshRows(); }
+    void benchmarkNormals() {
+        const auto mesh = CGAL_API::constructMeshFromObj(meshPath());
+        QVERIFY(nullptr != mesh);
+        std::vector<QVector3D> normals;
+        QBENCHMARK_ONCE {
+            normals = CGAL_API::computeVertexNormals(mesh);
+        }
+        QVERIFY(!normals.empty());
+    }
+    void benchmarkBufferBuild_data() { addMeshRows(); }
+    void benchmarkBufferBuild() {
+        const auto mesh = CGAL_API::constructMeshFromObj(meshPath());
+        QVERIFY(nullptr != mesh);
+        const auto normals = CGAL_API::computeVertexNormals(mesh);
+        MappedArray<Vertex> soup;
+        bool built = false;
+        QBENCHMARK_ONCE {
+            built = CGAL_API::buildTriangleSoup(mesh, normals, soup);
+        }
+        QVERIFY(built);
+    }
+    void benchmarkMakeObject_data() { addMeshRows(); }
+    void benchmarkMakeObject() {
+        const auto path = meshPath();
+        const auto mesh = CGAL_API::constructMeshFromObj(path);
+        QVERIFY(nullptr != mesh);
+        std::shared_ptr<SceneObject> obj;
+        QBENCHMARK_ONCE {
+            obj = SceneObject::makeObject(QFileInfo(QString::fromStdString(path)), mesh);
+        }
+        QVERIFY(nullptr != obj);
+    }
+    void benchmarkBoundingBox_data() { addMeshRows(); }
+    void benchmarkBoundingBox() {
+        const auto path = meshPath();
+        const auto obj = SceneObject::makeObject(QFileInfo(QString::fromStdString(path)), CGAL_API::constructMeshFromObj(path));
+        QVERIFY(nullptr != obj);
+        QBENCHMARK_ONCE {
+            obj->calculateBoundingBox();
+        }
+        QVERIFY(obj->getBoundingBoxLength() > 0.0f);
+    }
+
+    void benchmarkCodecEncode_data() { addSampleRows(); }
+    void benchmarkCodecEncode() {
+        QFETCH(QString, path);
+        const auto mesh = CGAL_API::constructMeshFromObj(path.toStdString());
+        QVERIFY(nullptr != mesh);
+        MappedArray<Vertex> soup;
+        QVERIFY(CGAL_API::buildTriangleSoup(mesh, CGAL_API::computeVertexNormals(mesh), soup));
+        const auto compressed = m_dir.filePath(QString(QTest::currentDataTag()) + "." + CODEC_API::FILE_SUFFIX);
+        bool written = false;
+        QBENCHMARK_ONCE {
+            written = CODEC_API::writeCompressedMesh(compressed, soup,
+                mesh->number_of_vertices(), mesh->number_of_faces(), mesh->number_of_edges());
+        }
+        QVERIFY(written);
+        const auto compressed_size = QFileInfo(compressed).size();
+        qInfo().noquote() << QString("%1: %2 bytes of vertices, %3 bytes compressed, ratio %4, %5 of the obj").arg(
+            QTest::currentDataTag(), QString::number(soup.sizeInBytes()), QString::number(compressed_size),
+            QString::number(static_cast<double>(soup.sizeInBytes()) / compressed_size, 'f', 1),
+            QString::number(static_cast<double>(compressed_size) / QFileInfo(path).size(), 'f', 3));
+    }
+    void benchmarkCodecDecode_data() { addSampleRows(); }
+    void benchmarkCodecDecode() {
+        QFETCH(QString, path);
+        //encoded by the encode benchmark, otherwise here
+        const auto compressed = m_dir.filePath(QString(QTest::currentDataTag()) + "." + CODEC_API::FILE_SUFFIX);
+        if (!QFileInfo::exists(compressed)) {
+            const auto mesh = CGAL_API::constructMeshFromObj(path.toStdString());
+            QVERIFY(nullptr != mesh);
+            MappedArray<Vertex> soup;
+            QVERIFY(CGAL_API::buildTriangleSoup(mesh, CGAL_API::computeVertexNormals(mesh), soup));
+            QVERIFY(CODEC_API::writeCompressedMesh(compressed, soup,
+                mesh->number_of_vertices(), mesh->number_of_faces(), mesh->number_of_edges()));
+        }
+        //decoded from memory, the disk is not part of the measurement
+        QFile file(compressed);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        const auto data = file.readAll();
+        std::unique_ptr<CachedMesh> decoded;
+        QElapsedTimer timer;
+        timer.start();
+        QBENCHMARK_ONCE {
+            decoded = CODEC_API::decodeCompressedMesh(reinterpret_cast<const uchar*>(data.constData()), data.size());
+        }
+        const double seconds = static_cast<double>(timer.nsecsElapsed()) / 1000000000.0;
+        QVERIFY(nullptr != decoded);
+        qInfo().noquote() << QString("%1: decoded %2 MB of vertices at %3 MB/s").arg(QTest::currentDataTag(),
+            QString::number(decoded->vertices.sizeInBytes() / 1048576.0, 'f', 1),
+            QString::number(decoded->vertices.sizeInBytes() / 1048576.0 / std::max(seconds, 1e-9), 'f', 0));
+    }
+    void benchmarkExport_data() { addExportRows(); }
+    void benchmarkExport() {
+        QFETCH(QString, path);
+        QFETCH(QString, suffix);
+        const auto mesh = CGAL_API::constructMeshFromObj(path.toStdString());
+        QVERIFY(nullptr != mesh);
+        MappedArray<Vertex> soup;
+        QVERIFY(CGAL_API::buildTriangleSoup(mesh, CGAL_API::computeVertexNormals(mesh), soup));
+        //placed off the origin so the transform is baked for real
+        ExportPart part;
+        part.name = QTest::currentDataTag();
+        part.soup = &soup;
+        part.model.translate(1.0f, 2.0f, 3.0f);
+        part.model.rotate(30.0f, 0.0f, 1.0f, 0.0f);
+        EXPORT_API::Format format;
+        QVERIFY(EXPORT_API::formatFromSuffix(suffix, format));
+        const auto exported = m_dir.filePath(QString(QTest::currentDataTag()) + "." + suffix);
+        bool written = false;
+        QElapsedTimer timer;
+        timer.start();
+        QBENCHMARK_ONCE {
+            written = EXPORT_API::exportMeshes(exported, format, { part });
+        }
+        const double seconds = static_cast<double>(timer.nsecsElapsed()) / 1000000000.0;
+        QVERIFY(written);
+        const auto size = QFileInfo(exported).size();
+        qInfo().noquote() << QString("%1: wrote %2 MB at %3 MB/s").arg(QTest::currentDataTag(),
+            QString::number(size / 1048576.0, 'f', 1), QString::number(size / 1048576.0 / std::max(seconds, 1e-9), 'f', 0));
+        QFile::remove(exported);
+    }
+
+private:
+    static constexpr std::uint64_t DEFAULT_MAX_TRIANGLES = 1000000;
+
+    // the models shipped in resources/objects
+    void addSampleRows() {
+        QTest::addColumn<QString>("path");
+        const QDir dir(VIEWER_OBJECTS_DIR);
+        for (const auto& info : dir.entryInfoList({ "*.obj" }, QDir::Files, QDir::Name)) {
+            if (info.size() > 0) {
+                QTest::newRow(info.baseName().toLatin1()) << info.absoluteFilePath();
+            }
+        }
+    }
+
+    // the sample models in every export format
+    void addExportRows() {
+        QTest::addColumn<QString>("path");
+        QTest::addColumn<QString>("suffix");
+        const QDir dir(VIEWER_OBJECTS_DIR);
+        for (const auto& info : dir.entryInfoList({ "*.obj" }, QDir::Files, QDir::Name)) {
+            if (info.size() > 0) {
+                for (const char* suffix : { "obj", "ply", "stl" }) {
+                    QTest::newRow(QString("%1-%2").arg(info.baseName(), suffix).toLatin1())
+                        << info.absoluteFilePath() << QString(suffix);
+                }
+            }
+        }
+    }
+
+    void addMeshRows() {
+        QTest::addColumn<int>("shape");
+        QTest::addColumn<qulonglong>("triangles");
+        QTest::addColumn<bool>("quads");
+        const std::pair<MESH_GENERATOR::Shape, const char*> shapes[] = {
+            { MESH_GENERATOR::Shape::SPHERE, "sphere" },
+            { MESH_GENERATOR::Shape::GRID,   "grid" },
+            { MESH_GENERATOR::Shape::SCAN,   "scan" }
+        };
+        const std::pair<std::uint64_t, const char*> sizes[] = {
+            { 10000, "10k" }, { 100000, "100k" }, { 1000000, "1M" }, { 5000000, "5M" }, { 20000000, "20M" }
+        };
+        for (const auto& size : sizes) {
+            if (size.first > m_maxTriangles) {
+                break;
+            }
+            for (const auto& shape : shapes) {
+                for (const bool quads : { false, true }) {
+                    QTest::newRow(QString("%1-%2-%3").arg(shape.second, quads ? "quad" : "tri", size.second).toLatin1())
+                        << static_cast<int>(shape.first) << static_cast<qulonglong>(size.first) << quads;
+                }
+            }
+        }
+    }
+    // generated once per data row and reused by all the stages
+    std::string meshPath() {
+        QFETCH(int, shape);
+        QFETCH(qulonglong, triangles);
+        QFETCH(bool, quads);
+        const auto path = m_dir.filePath(QString(QTest::currentDataTag()) + ".obj");
+        if (!QFileInfo::exists(path)) {
+            if (!MESH_GENERATOR::writeObj(path, static_cast<MESH_GENERATOR::Shape>(shape), triangles, quads)) {
+                qCritical() << "Critical: cannot generate " << path;
+            }
+        }
+        return path.toStdString();
+    }
+
+    QTemporaryDir m_dir;
+    std::uint64_t m_maxTriangles = DEFAULT_MAX_TRIANGLES;
+};
+
+QTEST_APPLESS_MAIN(PipelineBenchmark)
+#include "PipelineBenchmark.moc"